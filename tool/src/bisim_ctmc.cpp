@@ -25,9 +25,11 @@
 #include <bisimulation.hpp>
 #include <blocks.h>
 #include <getrss.h>
+#include <metrics.hpp>
 #include <refine.h>
 #include <sigref.h>
 #include <sigref_util.hpp>
+#include <table_sizes.hpp>
 #include <sylvan_gmp.h>
 
 namespace sigref {
@@ -37,17 +39,21 @@ using namespace sylvan;
 /**
  * Implementation of CTMC minimisation
  */
-TASK_IMPL_1(BDD, min_ctmc, CTMC&, ctmc)
+TASK_IMPL_2(BDD, min_ctmc, sigref_context*, ctx, CTMC&, ctmc)
 {
     /* Gather data, prepare block variables and signatures array */
 
     MTBDD transition_relation = ctmc.getMarkovTransitions().GetMTBDD();
     BDD state_variables = ctmc.getVarS().GetBDD();
     BDD prime_variables = ctmc.getVarT().GetBDD();
+    // compaction (--compact) only updates protected references
+    mtbdd_protect(&transition_relation);
+    sylvan_protect(&state_variables);
+    sylvan_protect(&prime_variables);
     int state_length = sylvan_set_count(state_variables);
 
-    prepare_blocks(state_length+1);
-    set_signatures_size(1ULL<<block_length);
+    prepare_blocks(ctx, state_length+1);
+    set_signatures_size(ctx, 1ULL<<ctx->block_length);
 
     /* Create initial partition */
 
@@ -59,7 +65,7 @@ TASK_IMPL_1(BDD, min_ctmc, CTMC&, ctmc)
         // note that our algorithms assume a partition is defined on s',b (not s,b)
         for (Bdd dd : ctmc.getInitialPartition()) {
             // encode next block number
-            BDD block = CALL(encode_block, get_next_block());
+            BDD block = CALL(encode_block, ctx, get_next_block(ctx));
             bdd_refs_push(block);
             // rename states from s to s'
             BDD states = swap_prime(dd.GetBDD());
@@ -73,27 +79,28 @@ TASK_IMPL_1(BDD, min_ctmc, CTMC&, ctmc)
         }
     } else {
         // just put all states in one block
-        partition = CALL(encode_block, get_next_block());
+        partition = CALL(encode_block, ctx, get_next_block(ctx));
     }
 
-    size_t n_blocks = count_blocks();
+    size_t n_blocks = count_blocks(ctx);
 
     /* Write some information */
 
-    double n_states = sylvan_satcount(partition, sylvan_and(prime_variables, block_variables));
-    double transitions_before = mtbdd_satcount(transition_relation, state_length*2);
+    double n_states = sylvan_satcount(partition, sylvan_and(prime_variables, ctx->block_variables));
+    double transitions_before = -1;
+    if (ctx->options.statistics >= 1) transitions_before = mtbdd_satcount(transition_relation, state_length*2);
 
     INFO("Number of state variables: %d.", state_length);
-    INFO("Number of block variables: %d.", block_length);
-    INFO("Number of Markovian transitions: %'0.0f", transitions_before);
+    INFO("Number of block variables: %d.", ctx->block_length);
+    if (transitions_before >= 0) INFO("Number of Markovian transitions: %'0.0f", transitions_before);
 
-    if (verbosity >= 2) {
+    if (ctx->options.verbosity >= 2) {
         INFO("Transition relation: %'zu MTBDD nodes.", mtbdd_nodecount(transition_relation));
     }
 
     INFO("Initial partition: %'0.0f states in %zu block(s).", n_states, n_blocks);
 
-    if (verbosity >= 2) {
+    if (ctx->options.verbosity >= 2) {
         INFO("Partition: %'zu BDD nodes.", sylvan_nodecount(partition));
     }
 
@@ -104,12 +111,19 @@ TASK_IMPL_1(BDD, min_ctmc, CTMC&, ctmc)
 
     double t1 = wctime();
 
+    // pin the relation and variables, which do not change during refinement, so garbage
+    // collection only marks the nodes of the current iteration
+    MTBDD static_dds[] = {transition_relation, state_variables, prime_variables, ctx->block_variables};
+    size_t pinned = big_pin(static_dds, 4);
+    if (ctx->options.verbosity >= 1) INFO("Pinned %'zu nodes of the transition relation and variables.", pinned);
+
     size_t iteration = 1;
     size_t old_n_blocks = 0;
     while (n_blocks != old_n_blocks) {
         old_n_blocks = n_blocks;
+        start_iteration(ctx);
 
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             INFO("");
             INFO("Iteration %zu", iteration);
         }
@@ -118,26 +132,30 @@ TASK_IMPL_1(BDD, min_ctmc, CTMC&, ctmc)
 
         // compute signature (s,b) => real/rational
         MTBDD signature;
-        if (leaftype == 2) signature = gmp_and_exists(transition_relation, partition, prime_variables);
+        if (ctx->options.leaftype == 2) signature = gmp_and_exists(transition_relation, partition, prime_variables);
         else signature = mtbdd_and_exists(transition_relation, partition, prime_variables);
 
         // print status
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Calculated signature: %'zu BDD nodes. Assigning blocks...", mtbdd_nodecount(signature));
-        } else if (verbosity == 1) {
+        } else if (ctx->options.verbosity == 1) {
             INFO("Calculated signature. Assigning blocks...");
         }
 
+        size_t signature_nodes = metrics_enabled() ? mtbdd_nodecount(signature) : 0;
+
         double i2 = wctime();
 
         // compute partition (s',b) from signature
         mtbdd_refs_push(signature);
-        partition = refine(signature, state_variables, partition);
-        n_blocks = count_blocks();
+        partition = refine(ctx, signature, state_variables, partition);
+        n_blocks = count_blocks(ctx);
         mtbdd_refs_pop(1);
 
         double i3 = wctime();
 
+        if (metrics_enabled()) metrics_iteration("ctmc", iteration, NULL, i2-i1, i3-i2, n_blocks, signature_nodes, mtbdd_nodecount(partition));
+
         INFO("After iteration %zu: %'zu blocks.", iteration++, n_blocks);
 
         // update timekeeping
@@ -145,20 +163,28 @@ TASK_IMPL_1(BDD, min_ctmc, CTMC&, ctmc)
         t_ref += (i3-i2);
 
         // print extra information
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Partition: %'zu BDD nodes.", sylvan_nodecount(partition));
             INFO("Current #nodes in table: %'zu of %'zu BDD nodes.", llmsset_count_marked(nodes), llmsset_get_size(nodes));
         }
 
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             INFO("Current/Max RSS: %'zu / %'zu bytes.", getCurrentRSS(), getPeakRSS());
         }
+
+        // respond to the memory limit (see table_sizes.hpp), the time limit and max_iterations
+        if (n_blocks != old_n_blocks && stop_refinement(ctx, iteration-1)) break;
     }
 
+    sylvan_scratch_end();
+
     double t2 = wctime();
 
-    // compute number of transitions
-    double transitions_after = count_transitions(0, n_blocks, block_length);
+    if (metrics_enabled()) metrics_phase("refinement", t2-t1, n_blocks, mtbdd_nodecount(partition));
+
+    // compute number of transitions (optional statistics)
+    double transitions_after = -1;
+    if (ctx->options.statistics == 2 && memory_pressure(ctx) < memory_no_stats) transitions_after = count_transitions(ctx, 0, n_blocks, ctx->block_length);
 
     INFO("");
     INFO("Time for computing the bisimulation relation: %'0.2f sec.", t2-t1);
@@ -168,10 +194,15 @@ TASK_IMPL_1(BDD, min_ctmc, CTMC&, ctmc)
     INFO("Number of iterations: %'zu.", iteration-1);
     INFO("Number of states before bisimulation minimisation: %'0.0f.", n_states);
     INFO("Number of blocks after bisimulation minimisation: %'zu.", n_blocks);
-    INFO("Number of transitions before bisimulation minimisation: %'0.0f.", transitions_before);
-    INFO("Number of transitions after bisimulation minimisation: %'0.0f.", transitions_after);
+    if (transitions_before >= 0) INFO("Number of transitions before bisimulation minimisation: %'0.0f.", transitions_before);
+    if (transitions_after >= 0) INFO("Number of transitions after bisimulation minimisation: %'0.0f.", transitions_after);
 
+    mtbdd_unprotect(&transition_relation);
+    sylvan_unprotect(&state_variables);
+    sylvan_unprotect(&prime_variables);
     sylvan_unprotect(&partition);
+    mtbdd_unpin_all();
+
     return partition;
 }
 
@@ -26,9 +26,11 @@
 #include <blocks.h>
 #include <getrss.h>
 #include <inert.h>
+#include <metrics.hpp>
 #include <refine.h>
 #include <sigref.h>
 #include <sigref_util.hpp>
+#include <table_sizes.hpp>
 #include <sylvan_gmp.h>
 
 namespace sigref {
@@ -68,8 +70,13 @@ TASK_4(MTBDD, equi, MTBDD, a, MTBDD, b, MTBDD, vars, MTBDD, neq)
         vv = mtbdd_getvar(vars);
     }
 
+    sigref_op_count(SIGREF_OP_EQUI);
+
     MTBDD result;
-    if (cache_get3(CACHE_EQUI, a, b, vars, &result)) return result;
+    if (cache_get3(CACHE_EQUI, a, b, vars, &result)) {
+        sigref_op_cached(SIGREF_OP_EQUI);
+        return result;
+    }
 
     MTBDD a0 = va == v ? mtbdd_getlow(a) : a;
     MTBDD a1 = va == v ? mtbdd_gethigh(a) : a;
@@ -84,7 +91,7 @@ TASK_4(MTBDD, equi, MTBDD, a, MTBDD, b, MTBDD, vars, MTBDD, neq)
     mtbdd_refs_pop(1);
     result = mtbdd_makenode(v, r0, r1);
 
-    cache_put3(CACHE_EQUI, a, b, vars, result);
+    if (cache_put3(CACHE_EQUI, a, b, vars, result)) sigref_op_cachedput(SIGREF_OP_EQUI);
     return result;
 }
 
@@ -120,9 +127,15 @@ TASK_3(MTBDD, relprev, MTBDD, a, MTBDD, b, MTBDD, vars)
         }
     }
 
+    /* Count operation */
+    sigref_op_count(SIGREF_OP_RELPREV);
+
     /* Consult cache */
     MTBDD result;
-    if (cache_get3(CACHE_BDD_RELPREV, a, b, vars, &result)) return result;
+    if (cache_get3(CACHE_RELPREV, a, b, vars, &result)) {
+        sigref_op_cached(SIGREF_OP_RELPREV);
+        return result;
+    }
 
     /* Get s and t */
     uint32_t s = level & (~1);
@@ -180,7 +193,7 @@ TASK_3(MTBDD, relprev, MTBDD, a, MTBDD, b, MTBDD, vars)
     mtbdd_refs_pop(5);
     result = mtbdd_makenode(s, r0, r1);
 
-    cache_put3(CACHE_BDD_RELPREV, a, b, vars, result);
+    if (cache_put3(CACHE_RELPREV, a, b, vars, result)) sigref_op_cachedput(SIGREF_OP_RELPREV);
     return result;
 }
 
@@ -189,7 +202,7 @@ TASK_3(MTBDD, relprev, MTBDD, a, MTBDD, b, MTBDD, vars)
  * Implementation of strong IMC minimisation
  */
 
-TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
+TASK_IMPL_2(BDD, min_imc_strong, sigref_context*, ctx, IMC&, imc)
 {
     /* Gather data, prepare block variables and signatures array */
 
@@ -201,6 +214,11 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
     BDD state_variables = imc.getVarS().GetBDD();
     BDD prime_variables = imc.getVarT().GetBDD();
     BDD action_variables = imc.getVarA().GetBDD();
+    // compaction (--compact) only updates protected references
+    sylvan_protect(&action_relation);
+    sylvan_protect(&state_variables);
+    sylvan_protect(&prime_variables);
+    sylvan_protect(&action_variables);
     int state_length = sylvan_set_count(state_variables);
     int action_length = sylvan_set_count(action_variables);
 
@@ -212,8 +230,8 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
     sylvan_ref(sta_variables);
     sylvan_ref(ta_variables);
 
-    prepare_blocks(state_length+1);
-    set_signatures_size(1ULL<<block_length);
+    prepare_blocks(ctx, state_length+1);
+    set_signatures_size(ctx, 1ULL<<ctx->block_length);
 
     /* Create initial partition */
 
@@ -225,7 +243,7 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
         // note that our algorithms assume a partition is defined on s',b (not s,b)
         for (Bdd dd : imc.getInitialPartition()) {
             // encode next block number
-            BDD block = CALL(encode_block, get_next_block());
+            BDD block = CALL(encode_block, ctx, get_next_block(ctx));
             bdd_refs_push(block);
             // rename states from s to s'
             BDD states = swap_prime(dd.GetBDD());
@@ -239,31 +257,34 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
         }
     } else {
         // just put all states in one block
-        partition = CALL(encode_block, get_next_block());
+        partition = CALL(encode_block, ctx, get_next_block(ctx));
     }
 
-    size_t n_blocks = count_blocks();
+    size_t n_blocks = count_blocks(ctx);
 
     /* Write some information */
 
-    double n_states = sylvan_satcount(partition, sylvan_and(prime_variables, block_variables));
-    double markov_transitions_before = mtbdd_satcount(markov_relation, state_length*2);
-    double action_transitions_before = mtbdd_satcount(action_relation, state_length*2 + action_length);
+    double n_states = sylvan_satcount(partition, sylvan_and(prime_variables, ctx->block_variables));
+    double markov_transitions_before = -1, action_transitions_before = -1;
+    if (ctx->options.statistics >= 1) {
+        markov_transitions_before = mtbdd_satcount(markov_relation, state_length*2);
+        action_transitions_before = mtbdd_satcount(action_relation, state_length*2 + action_length);
+    }
 
     INFO("Number of state variables: %d.", state_length);
     INFO("Number of action variables: %d.", action_length);
-    INFO("Number of block variables: %d.", block_length);
-    INFO("Number of Markovian transitions: %'0.0f", markov_transitions_before);
-    INFO("Number of interactive transitions: %'0.0f", action_transitions_before);
+    INFO("Number of block variables: %d.", ctx->block_length);
+    if (markov_transitions_before >= 0) INFO("Number of Markovian transitions: %'0.0f", markov_transitions_before);
+    if (action_transitions_before >= 0) INFO("Number of interactive transitions: %'0.0f", action_transitions_before);
 
-    if (verbosity >= 2) {
+    if (ctx->options.verbosity >= 2) {
         INFO("Markovian transition relation: %'zu MTBDD nodes.", mtbdd_nodecount(markov_relation));
         INFO("Interactive transition relation: %'zu BDD nodes.", mtbdd_nodecount(action_relation));
     }
 
     INFO("Initial partition: %'0.0f states in %zu block(s).", n_states, n_blocks);
 
-    if (verbosity >= 2) {
+    if (ctx->options.verbosity >= 2) {
         INFO("Partition: %'zu BDD nodes.", sylvan_nodecount(partition));
     }
 
@@ -278,23 +299,23 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
 
     /* Compute set of tau transitions */
 
-    if (verbosity >= 1) {
+    if (ctx->options.verbosity >= 1) {
         INFO("Computing tau transitions.");
     }
 
     BDD tau_transitions = sylvan_and(action_relation, imc.getTau().GetBDD());
     sylvan_protect(&tau_transitions);
 
-    if (verbosity >= 1) {
+    if (ctx->options.verbosity >= 1) {
         INFO("Number of tau transitions: %'0.0f", sylvan_satcount(tau_transitions, sta_variables));
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Tau transition relation: %'zu BDD nodes.", mtbdd_nodecount(tau_transitions));
         }
     }
 
     /* Compute set of states with outgoing tau transitions */
 
-    if (verbosity >= 1) {
+    if (ctx->options.verbosity >= 1) {
         INFO("Computing tau states.");
     }
 
@@ -303,9 +324,9 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
 
     /* Set default rate to 0 (when no rates) instead of False */
 
-    if (leaftype == 0) markov_relation = mtbdd_max(markov_relation, mtbdd_double(0));
-    else if (leaftype == 1) markov_relation = mtbdd_max(markov_relation, mtbdd_fraction(0, 1));
-    else if (leaftype == 2) {
+    if (ctx->options.leaftype == 0) markov_relation = mtbdd_max(markov_relation, mtbdd_double(0));
+    else if (ctx->options.leaftype == 1) markov_relation = mtbdd_max(markov_relation, mtbdd_fraction(0, 1));
+    else if (ctx->options.leaftype == 2) {
         mpq_t m_zero;
         mpq_init(m_zero);
         mpq_set_ui(m_zero, 0, 1);
@@ -317,24 +338,32 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
     /* Apply maximal progress cut */
 
     INFO("Computing maximal-progress cut.");
-    if (leaftype == 2) markov_relation = gmp_times(markov_relation, sylvan_not(tau_states));
+    if (ctx->options.leaftype == 2) markov_relation = gmp_times(markov_relation, sylvan_not(tau_states));
     else markov_relation = mtbdd_times(markov_relation, sylvan_not(tau_states));
 
-    if (verbosity >= 1) {
+    if (ctx->options.verbosity >= 1) {
         INFO("Number of Markovian transitions (mp): %'0.0f", mtbdd_satcount(markov_relation, state_length*2));
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Markovian transition relation (mp): %'zu MTBDD nodes.", mtbdd_nodecount(markov_relation));
         }
     }
 
+    /* Pin the relations and variables, which do not change during refinement */
+
+    MTBDD static_dds[] = {action_relation, markov_relation, tau_transitions, tau_states, state_variables,
+                          prime_variables, action_variables, st_variables, sta_variables, ta_variables, ctx->block_variables};
+    size_t pinned = big_pin(static_dds, 11);
+    if (ctx->options.verbosity >= 1) INFO("Pinned %'zu nodes of the transition relations and variables.", pinned);
+
     /* Start partition refinement */
 
     size_t iteration = 1;
     size_t old_n_blocks = 0, old_n_blocks2 = 0;
     while (n_blocks != old_n_blocks) {
         old_n_blocks = n_blocks;
+        start_iteration(ctx);
 
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             INFO("");
             INFO("Iteration %zu", iteration);
         }
@@ -343,23 +372,30 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
 
         // compute strong signature
         MTBDD signature;
-        if (leaftype == 2) signature = gmp_and_exists(markov_relation, partition, prime_variables);
+        if (ctx->options.leaftype == 2) signature = gmp_and_exists(markov_relation, partition, prime_variables);
         else signature = mtbdd_and_exists(markov_relation, partition, prime_variables);
 
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Calculated signature: %'zu BDD nodes. Assigning blocks...", mtbdd_nodecount(signature));
-        } else if (verbosity == 1) {
+        } else if (ctx->options.verbosity == 1) {
             INFO("Calculated signature. Assigning blocks...");
         }
 
+        size_t signature_nodes = metrics_enabled() ? mtbdd_nodecount(signature) : 0;
+
         double i2 = wctime();
 
         // compute partition (s',b) from signature
         mtbdd_refs_push(signature);
-        partition = refine(signature, state_variables, partition);
-        n_blocks = count_blocks();
+        partition = refine(ctx, signature, state_variables, partition);
+        n_blocks = count_blocks(ctx);
         mtbdd_refs_pop(1);
 
+        if (metrics_enabled()) {
+            double now = wctime();
+            metrics_iteration("imc-strong", iteration, "markov", i2-i1, now-i2, n_blocks, signature_nodes, mtbdd_nodecount(partition));
+        }
+
         INFO("After iteration %zu-a: %'zu blocks.", iteration, n_blocks);
 
         if (old_n_blocks2 == n_blocks) break;
@@ -370,16 +406,20 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
         // compute interactive strong signature
         signature = sylvan_and_exists(action_relation, partition, prime_variables);
 
+        signature_nodes = metrics_enabled() ? mtbdd_nodecount(signature) : 0;
+
         double i4 = wctime();
 
         // compute partition (s',b) from signature
         mtbdd_refs_push(signature);
-        partition = refine(signature, state_variables, partition);
-        n_blocks = count_blocks();
+        partition = refine(ctx, signature, state_variables, partition);
+        n_blocks = count_blocks(ctx);
         mtbdd_refs_pop(1);
 
         double i5 = wctime();
 
+        if (metrics_enabled()) metrics_iteration("imc-strong", iteration, "interactive", i4-i3, i5-i4, n_blocks, signature_nodes, mtbdd_nodecount(partition));
+
         // update timekeeping
         t_msig += i2-i1;
         t_mref += i3-i2;
@@ -388,18 +428,25 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
 
         INFO("After iteration %zu-b: %'zu blocks.", iteration++, n_blocks);
 
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Partition: %'zu BDD nodes.", sylvan_nodecount(partition));
             INFO("Current #nodes in table: %'zu of %'zu BDD nodes.", llmsset_count_marked(nodes), llmsset_get_size(nodes));
         }
 
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             INFO("Current/Max RSS: %'zu / %'zu bytes.", getCurrentRSS(), getPeakRSS());
         }
+
+        // respond to the memory limit (see table_sizes.hpp), the time limit and max_iterations
+        if (n_blocks != old_n_blocks && stop_refinement(ctx, iteration-1)) break;
     }
 
+    sylvan_scratch_end();
+
     double t2 = wctime();
 
+    if (metrics_enabled()) metrics_phase("refinement", t2-t1, n_blocks, mtbdd_nodecount(partition));
+
     INFO("");
     INFO("Time for computing the bisimulation relation: %'0.2f sec.", t2-t1);
     INFO("Time for Markovian signature computation: %'0.2f s.", t_msig);
@@ -412,6 +459,10 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
     INFO("Number of blocks after bisimulation minimisation: %'zu.", n_blocks);
 
     mtbdd_unprotect(&markov_relation); // markov_relation object might be changed
+    sylvan_unprotect(&action_relation);
+    sylvan_unprotect(&state_variables);
+    sylvan_unprotect(&prime_variables);
+    sylvan_unprotect(&action_variables);
     sylvan_deref(st_variables);
     sylvan_deref(sta_variables);
     sylvan_deref(ta_variables);
@@ -419,6 +470,8 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
     sylvan_unprotect(&tau_transitions);
     sylvan_unprotect(&tau_states);
 
+    mtbdd_unpin_all();
+
     return partition;
 }
 
@@ -427,7 +480,7 @@ TASK_IMPL_1(BDD, min_imc_strong, IMC&, imc)
  * Implementation of branching IMC minimisation
  */
 
-TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
+TASK_IMPL_2(BDD, min_imc_branching, sigref_context*, ctx, IMC&, imc)
 {
     /* Gather data, prepare block variables and signatures array */
 
@@ -439,6 +492,11 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
     BDD state_variables = imc.getVarS().GetBDD();
     BDD prime_variables = imc.getVarT().GetBDD();
     BDD action_variables = imc.getVarA().GetBDD();
+    // compaction (--compact) only updates protected references
+    sylvan_protect(&action_relation);
+    sylvan_protect(&state_variables);
+    sylvan_protect(&prime_variables);
+    sylvan_protect(&action_variables);
     int state_length = sylvan_set_count(state_variables);
     int action_length = sylvan_set_count(action_variables);
 
@@ -450,8 +508,8 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
     sylvan_ref(sta_variables);
     sylvan_ref(ta_variables);
 
-    prepare_blocks(state_length+1);
-    set_signatures_size(1ULL<<block_length);
+    prepare_blocks(ctx, state_length+1);
+    set_signatures_size(ctx, 1ULL<<ctx->block_length);
 
     /* Create initial partition */
 
@@ -463,7 +521,7 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
         // note that our algorithms assume a partition is defined on s',b (not s,b)
         for (Bdd dd : imc.getInitialPartition()) {
             // encode next block number
-            BDD block = CALL(encode_block, get_next_block());
+            BDD block = CALL(encode_block, ctx, get_next_block(ctx));
             bdd_refs_push(block);
             // rename states from s to s'
             BDD states = swap_prime(dd.GetBDD());
@@ -477,31 +535,34 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
         }
     } else {
         // just put all states in one block
-        partition = CALL(encode_block, get_next_block());
+        partition = CALL(encode_block, ctx, get_next_block(ctx));
     }
 
-    size_t n_blocks = count_blocks();
+    size_t n_blocks = count_blocks(ctx);
 
     /* Write some information */
  
-    double n_states = sylvan_satcount(partition, sylvan_and(prime_variables, block_variables));
-    double markov_transitions_before = mtbdd_satcount(markov_relation, state_length*2);
-    double action_transitions_before = mtbdd_satcount(action_relation, state_length*2 + action_length);
+    double n_states = sylvan_satcount(partition, sylvan_and(prime_variables, ctx->block_variables));
+    double markov_transitions_before = -1, action_transitions_before = -1;
+    if (ctx->options.statistics >= 1) {
+        markov_transitions_before = mtbdd_satcount(markov_relation, state_length*2);
+        action_transitions_before = mtbdd_satcount(action_relation, state_length*2 + action_length);
+    }
 
     INFO("Number of state variables: %d.", state_length);
     INFO("Number of action variables: %d.", action_length);
-    INFO("Number of block variables: %d.", block_length);
-    INFO("Number of Markovian transitions: %'0.0f", markov_transitions_before);
-    INFO("Number of interactive transitions: %'0.0f", action_transitions_before);
+    INFO("Number of block variables: %d.", ctx->block_length);
+    if (markov_transitions_before >= 0) INFO("Number of Markovian transitions: %'0.0f", markov_transitions_before);
+    if (action_transitions_before >= 0) INFO("Number of interactive transitions: %'0.0f", action_transitions_before);
 
-    if (verbosity >= 2) {
+    if (ctx->options.verbosity >= 2) {
         INFO("Markovian transition relation: %'zu MTBDD nodes.", mtbdd_nodecount(markov_relation));
         INFO("Interactive transition relation: %'zu BDD nodes.", mtbdd_nodecount(action_relation));
     }
 
     INFO("Initial partition: %'0.0f states in %zu block(s).", n_states, n_blocks);
 
-    if (verbosity >= 2) {
+    if (ctx->options.verbosity >= 2) {
         INFO("Partition: %'zu BDD nodes.", sylvan_nodecount(partition));
     }
 
@@ -516,23 +577,23 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
 
     /* Compute set of tau transitions */
 
-    if (verbosity >= 1) {
+    if (ctx->options.verbosity >= 1) {
         INFO("Computing tau transitions.");
     }
 
     BDD tau_transitions = sylvan_and(action_relation, imc.getTau().GetBDD());
     sylvan_protect(&tau_transitions);
 
-    if (verbosity >= 1) {
+    if (ctx->options.verbosity >= 1) {
         INFO("Number of tau transitions: %'0.0f", sylvan_satcount(tau_transitions, sta_variables));
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Tau transition relation: %'zu BDD nodes.", mtbdd_nodecount(tau_transitions));
         }
     }
 
     /* Compute set of states with outgoing tau transitions */
 
-    if (verbosity >= 1) {
+    if (ctx->options.verbosity >= 1) {
         INFO("Computing tau states.");
     }
 
@@ -541,9 +602,9 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
 
     /* Set default rate to 0 (when no rates) instead of False */
 
-    if (leaftype == 0) markov_relation = mtbdd_max(markov_relation, mtbdd_double(0));
-    else if (leaftype == 1) markov_relation = mtbdd_max(markov_relation, mtbdd_fraction(0, 1));
-    else if (leaftype == 2) {
+    if (ctx->options.leaftype == 0) markov_relation = mtbdd_max(markov_relation, mtbdd_double(0));
+    else if (ctx->options.leaftype == 1) markov_relation = mtbdd_max(markov_relation, mtbdd_fraction(0, 1));
+    else if (ctx->options.leaftype == 2) {
         mpq_t m_zero;
         mpq_init(m_zero);
         mpq_set_ui(m_zero, 0, 1);
@@ -555,19 +616,19 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
     /* Apply maximal progress cut */
 
     INFO("Computing maximal-progress cut.");
-    if (leaftype == 2) markov_relation = gmp_times(markov_relation, sylvan_not(tau_states));
+    if (ctx->options.leaftype == 2) markov_relation = gmp_times(markov_relation, sylvan_not(tau_states));
     else markov_relation = mtbdd_times(markov_relation, sylvan_not(tau_states));
 
-    if (verbosity >= 1) {
+    if (ctx->options.verbosity >= 1) {
         INFO("Number of Markovian transitions (mp): %'0.0f", mtbdd_satcount(markov_relation, state_length*2));
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Markovian transition relation (mp): %'zu MTBDD nodes.", mtbdd_nodecount(markov_relation));
         }
     }
 
     /* For branching bisimulation: make tau transition reflexive */
 
-    if (verbosity >= 1) {
+    if (ctx->options.verbosity >= 1) {
         INFO("Making tau transitions reflexive.");
     }
 
@@ -583,14 +644,22 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
 
     tau_transitions = sylvan_or(tau_transitions, eq);
 
+    /* Pin the relations and variables, which do not change during refinement */
+
+    MTBDD static_dds[] = {action_relation, markov_relation, tau_transitions, tau_states, state_variables,
+                          prime_variables, action_variables, st_variables, sta_variables, ta_variables, ctx->block_variables};
+    size_t pinned = big_pin(static_dds, 11);
+    if (ctx->options.verbosity >= 1) INFO("Pinned %'zu nodes of the transition relations and variables.", pinned);
+
     /* Start partition refinement */
 
     size_t iteration = 1;
     size_t old_n_blocks = 0, old_n_blocks2 = 0;
     while (n_blocks != old_n_blocks) {
         old_n_blocks = n_blocks;
+        start_iteration(ctx);
 
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             INFO("");
             INFO("Iteration %zu", iteration);
         }
@@ -598,17 +667,17 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
         double i1 = wctime();
 
         // compute branching signature
-        if (verbosity >= 1) INFO("Computing last step.");
+        if (ctx->options.verbosity >= 1) INFO("Computing last step.");
 
         MTBDD signature;
-        if (leaftype == 2) signature = gmp_and_exists(markov_relation, partition, prime_variables);
+        if (ctx->options.leaftype == 2) signature = gmp_and_exists(markov_relation, partition, prime_variables);
         else signature = mtbdd_and_exists(markov_relation, partition, prime_variables);
 
-        if (verbosity >= 2) INFO("Signature: %'zu BDD nodes.", mtbdd_nodecount(signature));
+        if (ctx->options.verbosity >= 2) INFO("Signature: %'zu BDD nodes.", mtbdd_nodecount(signature));
 
         mtbdd_refs_push(signature);
 
-        if (verbosity >= 1) INFO("Computing inert tau transitions.");
+        if (ctx->options.verbosity >= 1) INFO("Computing inert tau transitions.");
 
         BDD inert = compute_inert(tau_transitions, partition, partition, st_variables);
         bdd_refs_push(inert);
@@ -617,22 +686,22 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
 
         bdd_refs_push(inert);
 
-        if (closure == 0) {
-            if (verbosity >= 1) INFO("Computing backward reachability using tau steps.");
+        if (ctx->options.closure == 0) {
+            if (ctx->options.verbosity >= 1) INFO("Computing backward reachability using tau steps.");
 
             // now apply inert transitions repeatedly until fixpoint
             MTBDD old_sig = sylvan_false;
             while (old_sig != signature) {
                 old_sig = signature;
 
-                signature = CALL(relprev, inert, signature, st_variables);
+                signature = sigref_op_timed(SIGREF_OP_RELPREV, MTBDD, CALL(relprev, inert, signature, st_variables));
                 mtbdd_refs_pop(1);
                 mtbdd_refs_push(signature);
             }
         } else {
-            if (verbosity >= 1) INFO("Computing closure of inert tau transitions.");
+            if (ctx->options.verbosity >= 1) INFO("Computing closure of inert tau transitions.");
 
-            if (closure == 1) {
+            if (ctx->options.closure == 1) {
                 BDD old_inert = sylvan_false;
                 while (old_inert != inert) {
                     old_inert = inert;
@@ -646,26 +715,33 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
                 bdd_refs_push(inert);
             }
 
-            signature = CALL(relprev, inert, signature, st_variables);
+            signature = sigref_op_timed(SIGREF_OP_RELPREV, MTBDD, CALL(relprev, inert, signature, st_variables));
         }
 
         bdd_refs_pop(1); // inert
         mtbdd_refs_pop(1); // signature
 
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Calculated signature: %'zu BDD nodes. Assigning blocks...", mtbdd_nodecount(signature));
-        } else if (verbosity >= 1) {
+        } else if (ctx->options.verbosity >= 1) {
             INFO("Calculated signature. Assigning blocks...");
         }
 
+        size_t signature_nodes = metrics_enabled() ? mtbdd_nodecount(signature) : 0;
+
         double i2 = wctime();
 
         // compute partition (s',b) from signature
         mtbdd_refs_push(signature);
-        partition = refine(signature, state_variables, partition);
-        n_blocks = count_blocks();
+        partition = refine(ctx, signature, state_variables, partition);
+        n_blocks = count_blocks(ctx);
         mtbdd_refs_pop(1);
 
+        if (metrics_enabled()) {
+            double now = wctime();
+            metrics_iteration("imc-branching", iteration, "markov", i2-i1, now-i2, n_blocks, signature_nodes, mtbdd_nodecount(partition));
+        }
+
         INFO("After iteration %zu-a: %'zu blocks.", iteration, n_blocks);
 
         if (old_n_blocks2 == n_blocks) break;
@@ -674,7 +750,7 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
         double i3 = wctime();
 
         // compute interactive branching signature
-        if (verbosity >= 1) INFO("Computing inert tau transitions.");
+        if (ctx->options.verbosity >= 1) INFO("Computing inert tau transitions.");
 
         inert = compute_inert(tau_transitions, partition, partition, st_variables);
         bdd_refs_push(inert);
@@ -683,10 +759,10 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
         inert = sylvan_exists(inert, action_variables);
         bdd_refs_pop(2);
 
-        if (verbosity >= 1) INFO("Inert steps: %'0.0f transitions.", sylvan_satcount(inert, st_variables));
-        if (verbosity >= 1) INFO("Non-inert steps: %'0.0f transitions.", sylvan_satcount(noninert, sta_variables));
+        if (ctx->options.verbosity >= 1) INFO("Inert steps: %'0.0f transitions.", sylvan_satcount(inert, st_variables));
+        if (ctx->options.verbosity >= 1) INFO("Non-inert steps: %'0.0f transitions.", sylvan_satcount(noninert, sta_variables));
 
-        if (verbosity >= 1) INFO("Computing last step.");
+        if (ctx->options.verbosity >= 1) INFO("Computing last step.");
 
         bdd_refs_push(inert);
 
@@ -694,7 +770,7 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
         signature = sylvan_and_exists(noninert, partition, prime_variables);
         bdd_refs_pop(1); // noninert
 
-        if (verbosity >= 1) INFO("Computing backward reachability using tau steps.");
+        if (ctx->options.verbosity >= 1) INFO("Computing backward reachability using tau steps.");
 
         // now apply inert transitions repeatedly until fixpoint
         BDD old_sig = sylvan_false;
@@ -708,16 +784,20 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
 
         bdd_refs_pop(1); // inert
 
+        signature_nodes = metrics_enabled() ? mtbdd_nodecount(signature) : 0;
+
         double i4 = wctime();
 
         // compute partition (s',b) from signature
         mtbdd_refs_push(signature);
-        partition = refine(signature, state_variables, partition);
-        n_blocks = count_blocks();
+        partition = refine(ctx, signature, state_variables, partition);
+        n_blocks = count_blocks(ctx);
         mtbdd_refs_pop(1);
 
         double i5 = wctime();
 
+        if (metrics_enabled()) metrics_iteration("imc-branching", iteration, "interactive", i4-i3, i5-i4, n_blocks, signature_nodes, mtbdd_nodecount(partition));
+
         INFO("After iteration %zu-b: %'zu blocks.", iteration++, n_blocks);
 
         // update timekeeping
@@ -726,18 +806,25 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
         t_isig += i4-i3;
         t_iref += i5-i4;
 
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Partition: %'zu BDD nodes.", sylvan_nodecount(partition));
             INFO("Current #nodes in table: %'zu of %'zu BDD nodes.", llmsset_count_marked(nodes), llmsset_get_size(nodes));
         }
 
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             INFO("Current/Max RSS: %'zu / %'zu bytes.", getCurrentRSS(), getPeakRSS());
         }
+
+        // respond to the memory limit (see table_sizes.hpp), the time limit and max_iterations
+        if (n_blocks != old_n_blocks && stop_refinement(ctx, iteration-1)) break;
     }
 
+    sylvan_scratch_end();
+
     double t2 = wctime();
 
+    if (metrics_enabled()) metrics_phase("refinement", t2-t1, n_blocks, mtbdd_nodecount(partition));
+
     INFO("");
     INFO("Time for computing the bisimulation relation: %'0.2f sec.", t2-t1);
     INFO("Time for Markovian signature computation: %'0.2f s.", t_msig);
@@ -750,6 +837,10 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
     INFO("Number of blocks after bisimulation minimisation: %'zu.", n_blocks);
 
     mtbdd_unprotect(&markov_relation); // markov_relation object might be changed
+    sylvan_unprotect(&action_relation);
+    sylvan_unprotect(&state_variables);
+    sylvan_unprotect(&prime_variables);
+    sylvan_unprotect(&action_variables);
     sylvan_deref(st_variables);
     sylvan_deref(sta_variables);
     sylvan_deref(ta_variables);
@@ -757,6 +848,8 @@ TASK_IMPL_1(BDD, min_imc_branching, IMC&, imc)
     sylvan_unprotect(&tau_transitions);
     sylvan_unprotect(&tau_states);
 
+    mtbdd_unpin_all();
+
     return partition;
 }
 
@@ -25,9 +25,11 @@
 #include <blocks.h>
 #include <getrss.h>
 #include <inert.h>
+#include <metrics.hpp>
 #include <refine.h>
 #include <sigref.h>
 #include <sigref_util.hpp>
+#include <table_sizes.hpp>
 
 namespace sigref {
 
@@ -71,28 +73,32 @@ TASK_4(BDD, par_relprev, BDD, dd, BDD*, relations, int, count, BDD, st_variables
  * Implementation of strong LTS minimisation
  */
 
-TASK_IMPL_1(BDD, min_lts_strong, LTS&, lts)
+TASK_IMPL_2(BDD, min_lts_strong, sigref_context*, ctx, LTS&, lts)
 {
     /* Gather data, prepare block variables and signatures array */
 
     int n_relations = lts.getTransitions().size();
+    int n_partitioned = n_relations;
     BDD transition_relations[n_relations];
     BDD transition_variables[n_relations];
     for (int i=0; i<n_relations; i++) {
         transition_relations[i] = lts.getTransitions()[i].first.GetBDD();
         transition_variables[i] = lts.getTransitions()[i].second.GetBDD();
+        sylvan_protect(transition_variables+i); // compaction (--compact) only updates protected references
     }
 
     BDD state_variables = lts.getVarS().GetBDD();
     BDD prime_variables = lts.getVarT().GetBDD();
+    sylvan_protect(&state_variables);
+    sylvan_protect(&prime_variables);
     BDD st_variables = sylvan_and(state_variables, prime_variables);
     sylvan_ref(st_variables);
 
     int state_length = sylvan_set_count(state_variables);
     int action_length = sylvan_set_count(lts.getVarA().GetBDD());
 
-    prepare_blocks(state_length+1);
-    set_signatures_size(1ULL<<block_length);
+    prepare_blocks(ctx, state_length+1);
+    set_signatures_size(ctx, 1ULL<<ctx->block_length);
 
     /* Extending transition relations to full domain */
 
@@ -111,7 +117,7 @@ TASK_IMPL_1(BDD, min_lts_strong, LTS&, lts)
         // note that our algorithms assume a partition is defined on s',b (not s,b)
         for (Bdd dd : lts.getInitialPartition()) {
             // encode next block number
-            BDD block = CALL(encode_block, get_next_block());
+            BDD block = CALL(encode_block, ctx, get_next_block(ctx));
             bdd_refs_push(block);
             // rename states from s to s'
             BDD states = swap_prime(dd.GetBDD());
@@ -124,32 +130,45 @@ TASK_IMPL_1(BDD, min_lts_strong, LTS&, lts)
             bdd_refs_pop(3);
         }
     } else {
-        partition = CALL(encode_block, get_next_block());
+        partition = CALL(encode_block, ctx, get_next_block(ctx));
     }
 
-    size_t n_blocks = count_blocks();
+    size_t n_blocks = count_blocks(ctx);
 
     /* Write some information */
 
-    double n_states = sylvan_satcount(partition, sylvan_and(prime_variables, block_variables));
-    long double transitions_before = big_satcount(transition_relations, n_relations, state_length*2+action_length, mtbdd_true);
-    long double reachable_transitions_before = big_satcount(transition_relations, n_relations, state_length*2+action_length, lts.getStates().GetBDD());
+    double n_states = sylvan_satcount(partition, sylvan_and(prime_variables, ctx->block_variables));
+    long double transitions_before = -1;
+    if (ctx->options.statistics >= 1) transitions_before = big_satcount(transition_relations, n_relations, state_length*2+action_length, mtbdd_true);
+
+    // full statistics: count the reachable transitions concurrently with refinement, which may
+    // replace the transition relations, so on protected copies (synchronized after refinement);
+    // compaction (--compact) would move the nodes during the count, so then count them first
+    BDD counted_relations[n_relations];
+    long double reachable_transitions_before = -1;
+    if (ctx->options.statistics == 2) {
+        for (int i=0; i<n_relations; i++) {
+            counted_relations[i] = transition_relations[i];
+            sylvan_protect(counted_relations+i);
+        }
+        if (ctx->options.compaction) reachable_transitions_before = big_satcount(counted_relations, n_relations, state_length*2+action_length, lts.getStates().GetBDD());
+        else SPAWN(big_satcount, counted_relations, n_relations, state_length*2+action_length, lts.getStates().GetBDD());
+    }
 
     INFO("Number of state variables: %d.", state_length);
     INFO("Number of action variables: %d.", action_length);
-    INFO("Number of block variables: %d.", block_length);
+    INFO("Number of block variables: %d.", ctx->block_length);
     INFO("Number of transition relations: %d.", n_relations);
-    INFO("Number of transitions: %'0.0Lf.", transitions_before);
-    INFO("Number of reachable transitions: %'0.0Lf.", reachable_transitions_before);
+    if (transitions_before >= 0) INFO("Number of transitions: %'0.0Lf.", transitions_before);
 
-    if (verbosity >= 2) {
+    if (ctx->options.verbosity >= 2) {
         size_t node_count = mtbdd_nodecount_more(transition_relations, n_relations);
         INFO("Transition relation: %'zu BDD nodes.", node_count);
     }
 
     INFO("Initial partition: %'0.0f states in %zu block(s).", n_states, n_blocks);
 
-    if (verbosity >= 2) {
+    if (ctx->options.verbosity >= 2) {
         INFO("Partition: %'zu BDD nodes.", mtbdd_nodecount(partition));
     }
 
@@ -160,22 +179,29 @@ TASK_IMPL_1(BDD, min_lts_strong, LTS&, lts)
 
     double t1 = wctime();
 
-    if (merge_relations) {
+    if (ctx->options.merge_relations) {
         INFO("Taking the union of all transition relations.");
         transition_relations[0] = big_union(transition_relations, n_relations);
         for (int i=1;i<n_relations;i++) transition_relations[i] = sylvan_false;
         n_relations = 1;
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Monolithic transition relation: %'zu BDD nodes.", mtbdd_nodecount(transition_relations[0]));
         }
     }
 
+    // pin the relations and variables, which do not change during refinement, so garbage
+    // collection only marks the nodes of the current iteration
+    MTBDD static_dds[] = {state_variables, prime_variables, st_variables, ctx->block_variables};
+    size_t pinned = big_pin(transition_relations, n_relations) + big_pin(static_dds, 4);
+    if (ctx->options.verbosity >= 1) INFO("Pinned %'zu nodes of the transition relations and variables.", pinned);
+
     size_t iteration = 1;
     size_t old_n_blocks = 0;
     while (n_blocks != old_n_blocks) {
         old_n_blocks = n_blocks;
+        start_iteration(ctx);
 
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             INFO("");
             INFO("Iteration %zu", iteration);
         }
@@ -186,24 +212,28 @@ TASK_IMPL_1(BDD, min_lts_strong, LTS&, lts)
         BDD signature = sig_strong(transition_relations, n_relations, partition, prime_variables);
 
         // print status
-        if (verbosity >= 1) {
-            if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 1) {
+            if (ctx->options.verbosity >= 2) {
                 INFO("Calculated signature: %'zu BDD nodes. Assigning blocks...", sylvan_nodecount(signature));
             } else {
                 INFO("Calculated signature. Assigning blocks...");
             }
         }
 
+        size_t signature_nodes = metrics_enabled() ? mtbdd_nodecount(signature) : 0;
+
         double i2 = wctime();
 
         // compute partition (s',b) from signature
         bdd_refs_push(signature);
-        partition = refine(signature, state_variables, partition);
-        n_blocks = count_blocks();
+        partition = refine(ctx, signature, state_variables, partition);
+        n_blocks = count_blocks(ctx);
         bdd_refs_pop(1);
 
         double i3 = wctime();
 
+        if (metrics_enabled()) metrics_iteration("lts-strong", iteration, NULL, i2-i1, i3-i2, n_blocks, signature_nodes, mtbdd_nodecount(partition));
+
         INFO("After iteration %zu: %'zu blocks.", iteration++, n_blocks);
 
         // update timekeeping
@@ -211,20 +241,40 @@ TASK_IMPL_1(BDD, min_lts_strong, LTS&, lts)
         t_ref += (i3-i2);
 
         // print extra information
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Partition: %'zu BDD nodes.", sylvan_nodecount(partition));
             INFO("Current #nodes in table: %'zu of %'zu BDD nodes.", llmsset_count_marked(nodes), llmsset_get_size(nodes));
         }
 
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             INFO("Current/Max RSS: %'zu / %'zu bytes.", getCurrentRSS(), getPeakRSS());
         }
+
+        // respond to the memory limit (see table_sizes.hpp), the time limit and max_iterations
+        if (n_relations < n_partitioned && memory_pressure(ctx) >= memory_split_relations) {
+            INFO("Memory limit: using the %d transition relations instead of their union.", n_partitioned);
+            mtbdd_unpin_all(); // so the union can be freed
+            n_relations = n_partitioned;
+            for (int i=0; i<n_relations; i++) {
+                transition_relations[i] = extend_relation(lts.getTransitions()[i].first.GetBDD(), transition_variables[i], state_length);
+            }
+        }
+        if (n_blocks != old_n_blocks && stop_refinement(ctx, iteration-1)) break;
     }
 
+    sylvan_scratch_end();
+
     double t2 = wctime();
 
-    // compute number of transitions
-    double transitions_after = count_transitions(0, n_blocks, block_length + action_length);
+    if (metrics_enabled()) metrics_phase("refinement", t2-t1, n_blocks, mtbdd_nodecount(partition));
+
+    // compute number of transitions (optional statistics)
+    if (ctx->options.statistics == 2) {
+        if (!ctx->options.compaction) reachable_transitions_before = SYNC(big_satcount);
+        for (int i=0; i<n_partitioned; i++) sylvan_unprotect(counted_relations+i);
+    }
+    double transitions_after = -1;
+    if (ctx->options.statistics == 2 && memory_pressure(ctx) < memory_no_stats) transitions_after = count_transitions(ctx, 0, n_blocks, ctx->block_length + action_length);
 
     INFO("");
     INFO("Time for computing the bisimulation relation: %'0.2f sec.", t2-t1);
@@ -234,16 +284,21 @@ TASK_IMPL_1(BDD, min_lts_strong, LTS&, lts)
     INFO("Number of iterations: %'zu.", iteration-1);
     INFO("Number of states before bisimulation minimisation: %'0.0f.", n_states);
     INFO("Number of blocks after bisimulation minimisation: %'zu.", n_blocks);
-    INFO("Number of transitions before bisimulation minimisation: %'0.0Lf.", transitions_before);
-    INFO("Number of reachable transitions before bisimulation minimisation: %'0.0Lf.", reachable_transitions_before);
-    INFO("Number of transitions after bisimulation minimisation: %'0.0f.", transitions_after);
+    if (transitions_before >= 0) INFO("Number of transitions before bisimulation minimisation: %'0.0Lf.", transitions_before);
+    if (reachable_transitions_before >= 0) INFO("Number of reachable transitions before bisimulation minimisation: %'0.0Lf.", reachable_transitions_before);
+    if (transitions_after >= 0) INFO("Number of transitions after bisimulation minimisation: %'0.0f.", transitions_after);
 
     sylvan_deref(st_variables);
-    for (int i=0; i<n_relations; i++) {
+    for (int i=0; i<n_partitioned; i++) {
         sylvan_unprotect(transition_relations+i);
+        sylvan_unprotect(transition_variables+i);
     }
+    sylvan_unprotect(&state_variables);
+    sylvan_unprotect(&prime_variables);
     sylvan_unprotect(&partition);
 
+    mtbdd_unpin_all();
+
     return partition;
 }
 
@@ -252,29 +307,34 @@ TASK_IMPL_1(BDD, min_lts_strong, LTS&, lts)
  * Implementation of branching LTS minimisation
  */
 
-TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
+TASK_IMPL_2(BDD, min_lts_branching, sigref_context*, ctx, LTS&, lts)
 {
     /* Gather data, prepare block variables and signatures array */
 
     int n_relations = lts.getTransitions().size();
+    int n_partitioned = n_relations;
     BDD transition_relations[n_relations];
     BDD transition_variables[n_relations];
     for (int i=0; i<n_relations; i++) {
         transition_relations[i] = lts.getTransitions()[i].first.GetBDD();
         transition_variables[i] = lts.getTransitions()[i].second.GetBDD();
+        sylvan_protect(transition_variables+i); // compaction (--compact) only updates protected references
     }
 
     BDD state_variables = lts.getVarS().GetBDD();
     BDD prime_variables = lts.getVarT().GetBDD();
     BDD action_variables = lts.getVarA().GetBDD();
+    sylvan_protect(&state_variables);
+    sylvan_protect(&prime_variables);
+    sylvan_protect(&action_variables);
     BDD st_variables = sylvan_and(state_variables, prime_variables);
     sylvan_ref(st_variables);
 
     int state_length = sylvan_set_count(state_variables);
     int action_length = sylvan_set_count(action_variables);
 
-    prepare_blocks(state_length+1);
-    set_signatures_size(1ULL<<block_length);
+    prepare_blocks(ctx, state_length+1);
+    set_signatures_size(ctx, 1ULL<<ctx->block_length);
 
     /* Extending transition relations to full domain */
 
@@ -293,7 +353,7 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
         // note that our algorithms assume a partition is defined on s',b (not s,b)
         for (Bdd dd : lts.getInitialPartition()) {
             // encode next block number
-            BDD block = CALL(encode_block, get_next_block());
+            BDD block = CALL(encode_block, ctx, get_next_block(ctx));
             bdd_refs_push(block);
             // rename states from s to s'
             BDD states = swap_prime(dd.GetBDD());
@@ -306,32 +366,45 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
             bdd_refs_pop(3);
         }
     } else {
-        partition = CALL(encode_block, get_next_block());
+        partition = CALL(encode_block, ctx, get_next_block(ctx));
     }
 
-    size_t n_blocks = count_blocks();
+    size_t n_blocks = count_blocks(ctx);
 
     /* Write some information */
 
-    double n_states = sylvan_satcount(partition, sylvan_and(prime_variables, block_variables));
-    long double transitions_before = big_satcount(transition_relations, n_relations, state_length*2+action_length, mtbdd_true);
-    long double reachable_transitions_before = big_satcount(transition_relations, n_relations, state_length*2+action_length, lts.getStates().GetBDD());
+    double n_states = sylvan_satcount(partition, sylvan_and(prime_variables, ctx->block_variables));
+    long double transitions_before = -1;
+    if (ctx->options.statistics >= 1) transitions_before = big_satcount(transition_relations, n_relations, state_length*2+action_length, mtbdd_true);
+
+    // full statistics: count the reachable transitions concurrently with refinement, which may
+    // replace the transition relations, so on protected copies (synchronized after refinement);
+    // compaction (--compact) would move the nodes during the count, so then count them first
+    BDD counted_relations[n_relations];
+    long double reachable_transitions_before = -1;
+    if (ctx->options.statistics == 2) {
+        for (int i=0; i<n_relations; i++) {
+            counted_relations[i] = transition_relations[i];
+            sylvan_protect(counted_relations+i);
+        }
+        if (ctx->options.compaction) reachable_transitions_before = big_satcount(counted_relations, n_relations, state_length*2+action_length, lts.getStates().GetBDD());
+        else SPAWN(big_satcount, counted_relations, n_relations, state_length*2+action_length, lts.getStates().GetBDD());
+    }
 
     INFO("Number of state variables: %d.", state_length);
     INFO("Number of action variables: %d.", action_length);
-    INFO("Number of block variables: %d.", block_length);
+    INFO("Number of block variables: %d.", ctx->block_length);
     INFO("Number of transition relations: %d.", n_relations);
-    INFO("Number of transitions: %'0.0Lf.", transitions_before);
-    INFO("Number of reachable transitions: %'0.0Lf.", reachable_transitions_before);
+    if (transitions_before >= 0) INFO("Number of transitions: %'0.0Lf.", transitions_before);
 
-    if (verbosity >= 2) {
+    if (ctx->options.verbosity >= 2) {
         size_t node_count = mtbdd_nodecount_more(transition_relations, n_relations);
         INFO("Transition relation: %'zu BDD nodes.", node_count);
     }
 
     INFO("Initial partition: %'0.0f states in %zu block(s).", n_states, n_blocks);
 
-    if (verbosity >= 2) {
+    if (ctx->options.verbosity >= 2) {
         INFO("Partition: %'zu BDD nodes.", mtbdd_nodecount(partition));
     }
 
@@ -342,25 +415,25 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
 
     double t1 = wctime();
 
-    if (merge_relations || closure) {
+    if (ctx->options.merge_relations || ctx->options.closure) {
         INFO("Taking the union of all transition relations.");
         transition_relations[0] = big_union(transition_relations, n_relations);
         for (int i=1;i<n_relations;i++) transition_relations[i] = sylvan_false;
         n_relations = 1;
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Monolithic transition relation: %'zu BDD nodes.", mtbdd_nodecount(transition_relations[0]));
         }
     }
 
-    BDD tau_transitions[n_relations];
+    BDD tau_transitions[n_partitioned];
 
     INFO("Precomputing tau transitions for branching bisimulation.");
-    for (int i=0; i<n_relations; i++) {
-        tau_transitions[i] = sylvan_and(transition_relations[i], lts.getTau().GetBDD());
+    for (int i=0; i<n_partitioned; i++) {
+        tau_transitions[i] = i < n_relations ? sylvan_and(transition_relations[i], lts.getTau().GetBDD()) : sylvan_false;
         sylvan_protect(tau_transitions+i);
     }
 
-    if (closure) {
+    if (ctx->options.closure) {
         INFO("Precomputing closure of tau transition.");
 
         /* create s=s' */
@@ -378,7 +451,7 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
         BDD t = sylvan_or(tau_transitions[0], eq);
         bdd_refs_pop(1);
 
-        if (closure == 1) {
+        if (ctx->options.closure == 1) {
             BDD u = sylvan_false;
             int c=0;
             while (u != t) {
@@ -386,7 +459,7 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
                 bdd_refs_push(t);
                 t = sylvan_relprev(t, t, st_variables);
                 bdd_refs_pop(1);
-                if (verbosity >= 2) {
+                if (ctx->options.verbosity >= 2) {
                     INFO("Size of squaring %d times: %zu BDD nodes.", ++c, sylvan_nodecount(t));
                 }
             }
@@ -403,19 +476,26 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
             bdd_refs_pop(1);
         }
 
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Reflexive transitive closure: %'0.0f transitions using %zu BDD nodes.", sylvan_satcount(t, st_variables), sylvan_nodecount(tau_transitions[0]));
-        } else if (verbosity == 1) {
+        } else if (ctx->options.verbosity == 1) {
             INFO("Reflexive transitive closure: %'0.0f transitions.", sylvan_satcount(t, st_variables));
         }
     }
 
+    // pin the relations and variables, which do not change during refinement, so garbage
+    // collection only marks the nodes of the current iteration
+    MTBDD static_dds[] = {state_variables, prime_variables, action_variables, st_variables, ctx->block_variables};
+    size_t pinned = big_pin(transition_relations, n_relations) + big_pin(tau_transitions, n_relations) + big_pin(static_dds, 5);
+    if (ctx->options.verbosity >= 1) INFO("Pinned %'zu nodes of the transition relations and variables.", pinned);
+
     size_t iteration = 1;
     size_t old_n_blocks = 0;
     while (n_blocks != old_n_blocks) {
         old_n_blocks = n_blocks;
+        start_iteration(ctx);
 
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             INFO("");
             INFO("Iteration %zu", iteration);
         }
@@ -425,7 +505,7 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
         // compute signature
 
         // compute the set of inert tau transitions on (s,t,a)
-        if (verbosity >= 1) INFO("Computing inert tau transitions.");
+        if (ctx->options.verbosity >= 1) INFO("Computing inert tau transitions.");
 
         BDD inert[n_relations];
         for (int i=0; i<n_relations; i++) {
@@ -433,7 +513,7 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
             bdd_refs_push(inert[i]);
         }
 
-        if (verbosity >= 1) INFO("Computing non-inert tau transitions.");
+        if (ctx->options.verbosity >= 1) INFO("Computing non-inert tau transitions.");
 
         // remove all inert tau transitions from transition_relation
         BDD non_inert[n_relations];
@@ -442,7 +522,7 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
             bdd_refs_push(non_inert[i]);
         }
 
-        if (verbosity >= 1) INFO("Quantifying inert tau transitions");
+        if (ctx->options.verbosity >= 1) INFO("Quantifying inert tau transitions");
 
         // abstraction to obtain the set of inert tau transition on (s,t)
         for (int i=0; i<n_relations; i++) {
@@ -456,7 +536,7 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
             bdd_refs_push(non_inert[i]);
         }
 
-        if (verbosity >= 1) INFO("Computing last step.");
+        if (ctx->options.verbosity >= 1) INFO("Computing last step.");
 
         // compute last step of signature on (s,a,B)
         BDD signature = sig_strong(non_inert, n_relations, partition, prime_variables);
@@ -464,9 +544,9 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
         bdd_refs_pop(2*n_relations);
         for (int i=0; i<n_relations; i++) bdd_refs_push(inert[i]);
 
-        if (verbosity >= 1) INFO("Computing backward reachability using tau steps.");
+        if (ctx->options.verbosity >= 1) INFO("Computing backward reachability using tau steps.");
 
-        if (closure) {
+        if (ctx->options.closure) {
             bdd_refs_push(signature);
             signature = sylvan_relprev(inert[0], signature, st_variables);
             bdd_refs_pop(1);
@@ -484,28 +564,32 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
                 signature = sylvan_or(signature, sig_step);
                 bdd_refs_pop(2);
 
-                if (verbosity >= 1) {
+                if (ctx->options.verbosity >= 1) {
                     INFO("Iteration %d done.", ++count);
                 }
             }
         }
 
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Calculated signature: %'zu BDD nodes. Assigning blocks...", sylvan_nodecount(signature));
-        } else if (verbosity == 1) {
+        } else if (ctx->options.verbosity == 1) {
             INFO("Calculated signature. Assigning blocks...");
         }
 
+        size_t signature_nodes = metrics_enabled() ? mtbdd_nodecount(signature) : 0;
+
         double i2 = wctime();
 
         // compute partition (s',b) from signature
         bdd_refs_push(signature);
-        partition = refine(signature, state_variables, partition);
-        n_blocks = count_blocks();
+        partition = refine(ctx, signature, state_variables, partition);
+        n_blocks = count_blocks(ctx);
         bdd_refs_pop(1);
 
         double i3 = wctime();
 
+        if (metrics_enabled()) metrics_iteration("lts-branching", iteration, NULL, i2-i1, i3-i2, n_blocks, signature_nodes, mtbdd_nodecount(partition));
+
         INFO("After iteration %zu: %'zu blocks.", iteration++, n_blocks);
 
         // update timekeeping
@@ -513,20 +597,41 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
         t_ref += (i3-i2);
 
         // print extra information
-        if (verbosity >= 2) {
+        if (ctx->options.verbosity >= 2) {
             INFO("Partition: %'zu BDD nodes.", sylvan_nodecount(partition));
             INFO("Current #nodes in table: %'zu of %'zu BDD nodes.", llmsset_count_marked(nodes), llmsset_get_size(nodes));
         }
 
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             INFO("Current/Max RSS: %'zu / %'zu bytes.", getCurrentRSS(), getPeakRSS());
         }
+
+        // respond to the memory limit (see table_sizes.hpp), the closure needs the union
+        if (n_relations < n_partitioned && !ctx->options.closure && memory_pressure(ctx) >= memory_split_relations) {
+            INFO("Memory limit: using the %d transition relations instead of their union.", n_partitioned);
+            mtbdd_unpin_all(); // so the union can be freed
+            n_relations = n_partitioned;
+            for (int i=0; i<n_relations; i++) {
+                transition_relations[i] = extend_relation(lts.getTransitions()[i].first.GetBDD(), transition_variables[i], state_length);
+                tau_transitions[i] = sylvan_and(transition_relations[i], lts.getTau().GetBDD());
+            }
+        }
+        if (n_blocks != old_n_blocks && stop_refinement(ctx, iteration-1)) break;
     }
 
+    sylvan_scratch_end();
+
     double t2 = wctime();
 
-    // compute number of transitions
-    double transitions_after = count_transitions(0, n_blocks, block_length + action_length);
+    if (metrics_enabled()) metrics_phase("refinement", t2-t1, n_blocks, mtbdd_nodecount(partition));
+
+    // compute number of transitions (optional statistics)
+    if (ctx->options.statistics == 2) {
+        if (!ctx->options.compaction) reachable_transitions_before = SYNC(big_satcount);
+        for (int i=0; i<n_partitioned; i++) sylvan_unprotect(counted_relations+i);
+    }
+    double transitions_after = -1;
+    if (ctx->options.statistics == 2 && memory_pressure(ctx) < memory_no_stats) transitions_after = count_transitions(ctx, 0, n_blocks, ctx->block_length + action_length);
 
     INFO("");
     INFO("Time for computing the bisimulation relation: %'0.2f sec.", t2-t1);
@@ -536,17 +641,23 @@ TASK_IMPL_1(BDD, min_lts_branching, LTS&, lts)
     INFO("Number of iterations: %'zu.", iteration-1);
     INFO("Number of states before bisimulation minimisation: %'0.0f.", n_states);
     INFO("Number of blocks after bisimulation minimisation: %'zu.", n_blocks);
-    INFO("Number of transitions before bisimulation minimisation: %'0.0Lf.", transitions_before);
-    INFO("Number of reachable transitions before bisimulation minimisation: %'0.0Lf.", reachable_transitions_before);
-    INFO("Number of transitions after bisimulation minimisation: %'0.0f.", transitions_after);
+    if (transitions_before >= 0) INFO("Number of transitions before bisimulation minimisation: %'0.0Lf.", transitions_before);
+    if (reachable_transitions_before >= 0) INFO("Number of reachable transitions before bisimulation minimisation: %'0.0Lf.", reachable_transitions_before);
+    if (transitions_after >= 0) INFO("Number of transitions after bisimulation minimisation: %'0.0f.", transitions_after);
 
     sylvan_deref(st_variables);
-    for (int i=0; i<n_relations; i++) {
+    for (int i=0; i<n_partitioned; i++) {
         sylvan_unprotect(transition_relations+i);
+        sylvan_unprotect(transition_variables+i);
         sylvan_unprotect(tau_transitions+i);
     }
+    sylvan_unprotect(&state_variables);
+    sylvan_unprotect(&prime_variables);
+    sylvan_unprotect(&action_variables);
     sylvan_unprotect(&partition);
 
+    mtbdd_unpin_all();
+
     return partition;
 }
 
@@ -16,21 +16,26 @@
 
 #include <systems.hpp>
 #include <sylvan.h>
+#include <context.h>
 
 #ifndef BISIMULATION_H
 #define BISIMULATION_H
 
 namespace sigref {
 
-TASK_DECL_1(BDD, min_lts_strong, sigref::LTS&);
+/**
+ * Compute the partition of the system for the bisimulation of the options of <ctx>.
+ * The block encoding and the refinement data are stored in <ctx>.
+ */
+TASK_DECL_2(BDD, min_lts_strong, sigref_context*, sigref::LTS&);
 
-TASK_DECL_1(BDD, min_lts_branching, sigref::LTS&);
+TASK_DECL_2(BDD, min_lts_branching, sigref_context*, sigref::LTS&);
 
-TASK_DECL_1(BDD, min_ctmc, sigref::CTMC&);
+TASK_DECL_2(BDD, min_ctmc, sigref_context*, sigref::CTMC&);
 
-TASK_DECL_1(BDD, min_imc_strong, sigref::IMC&);
+TASK_DECL_2(BDD, min_imc_strong, sigref_context*, sigref::IMC&);
 
-TASK_DECL_1(BDD, min_imc_branching, sigref::IMC&);
+TASK_DECL_2(BDD, min_imc_branching, sigref_context*, sigref::IMC&);
 
 }
 
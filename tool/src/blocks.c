@@ -18,34 +18,33 @@
 #include <sigref.h>
 #include <blocks.h>
 
-uint32_t block_base = 2000000; // base for block variables
-int block_length; // number of block variables
-BDD block_variables;
-
-VOID_TASK_IMPL_1(prepare_blocks, int, nvars)
+VOID_TASK_IMPL_2(prepare_blocks, sigref_context*, ctx, int, nvars)
 {
-    if (ordering == 1) block_base = 900000; // before action variables
-    block_length = nvars < 25 ? nvars : 25; // Cap it on 2^25 : 33,554,432 blocks max
-    uint32_t block_vars[block_length];
-    for (int i=0; i<block_length; i++) block_vars[i] = block_base+2*i;
-    block_variables = sylvan_set_fromarray(block_vars, block_length);
-    sylvan_ref(block_variables);
+    if (ctx->options.ordering == 1) ctx->block_base = 900000; // before action variables
+    ctx->block_length = nvars < 25 ? nvars : 25; // Cap it on 2^25 : 33,554,432 blocks max
+    uint32_t block_vars[ctx->block_length];
+    for (int i=0; i<ctx->block_length; i++) block_vars[i] = ctx->block_base+2*i;
+    sylvan_deref(ctx->block_variables);
+    ctx->block_variables = sylvan_set_fromarray(block_vars, ctx->block_length);
+    sylvan_ref(ctx->block_variables);
 }
 
-TASK_IMPL_1(BDD, encode_block, uint64_t, b)
+TASK_IMPL_2(BDD, encode_block, sigref_context*, ctx, uint64_t, b)
 {
+    /* the block variables are part of the key, as contexts may encode blocks differently */
     BDD result;
-    if (cache_get3(CACHE_ENCODE_BLOCK, 0, b, 0, &result)) return result;
+    if (cache_get3(CACHE_ENCODE_BLOCK, ctx->block_variables, b, 0, &result)) return result;
 
     // for now, assume max 64 bits for a block....
-    uint8_t bl[block_length];
-    for (int i=0; i<block_length; i++) {
-        bl[i] = b & 1 ? 1 : 0;
-        b>>=1;
+    uint8_t bl[ctx->block_length];
+    uint64_t bits = b;
+    for (int i=0; i<ctx->block_length; i++) {
+        bl[i] = bits & 1 ? 1 : 0;
+        bits>>=1;
     }
 
-    result = sylvan_cube(block_variables, bl);
-    cache_put3(CACHE_ENCODE_BLOCK, 0, b, 0, result);
+    result = sylvan_cube(ctx->block_variables, bl);
+    cache_put3(CACHE_ENCODE_BLOCK, ctx->block_variables, b, 0, result);
     return result;
 }
 
@@ -15,6 +15,7 @@
  */
 
 #include <sylvan.h>
+#include <context.h>
 
 #ifndef SIGREF_BLOCKS_H
 #define SIGREF_BLOCKS_H
@@ -23,15 +24,11 @@
 extern "C" {
 #endif
 
-extern uint32_t block_base; // base for block variables
-extern int block_length; // number of block variables
-extern BDD block_variables;
+// initialize block_length and block_variables of <ctx> for <nvars> block variables
+#define prepare_blocks(ctx, nvars) CALL(prepare_blocks, ctx, nvars)
+VOID_TASK_DECL_2(prepare_blocks, sigref_context*, int);
 
-// initialize block_length and block_variables for <nvars> block variables
-#define prepare_blocks(nvars) CALL(prepare_blocks, nvars)
-VOID_TASK_DECL_1(prepare_blocks, int);
-
-TASK_DECL_1(BDD, encode_block, uint64_t);
+TASK_DECL_2(BDD, encode_block, sigref_context*, uint64_t);
 TASK_DECL_1(uint64_t, decode_block, BDD);
 
 #ifdef __cplusplus
@@ -0,0 +1,387 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+
+#include <compose.hpp>
+#include <input_stream.hpp>
+#include <labels.hpp>
+#include <parse_bdd.hpp>
+#include <parse_xml.hpp>
+#include <sigref.h>
+#include <sigref_util.hpp>
+
+namespace sigref {
+
+using namespace sylvan;
+
+CompositionSpec
+CompositionSpec::read(const char *filename)
+{
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) throw ParseError("[ERROR] Cannot open composition file " + std::string(filename));
+
+    /* Components are relative to the directory of the composition file */
+    std::string dir(filename);
+    size_t slash = dir.rfind('/');
+    dir = slash == std::string::npos ? "" : dir.substr(0, slash+1);
+
+    CompositionSpec spec;
+    char line[4096], keyword[16], model[4096];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        int n = 0;
+        if (sscanf(line, "%15s%n", keyword, &n) != 1 || keyword[0] == '#') continue;
+        if (strcmp(keyword, "component") == 0) {
+            if (sscanf(line+n, "%4095s", model) != 1) {
+                fclose(f);
+                throw ParseError("[ERROR] Expected a model after \"component\" in " + std::string(filename));
+            }
+            spec.components.push_back(model[0] == '/' ? std::string(model) : dir + model);
+        } else if (strcmp(keyword, "sync") == 0 || strcmp(keyword, "hide") == 0) {
+            /* The rest of the line is the action, as names of actions can contain spaces */
+            char *p = line + n + strspn(line+n, " \t");
+            size_t len = strcspn(p, "\r\n");
+            while (len > 0 && (p[len-1] == ' ' || p[len-1] == '\t')) len--;
+            if (len == 0) {
+                fclose(f);
+                throw ParseError("[ERROR] Expected an action after \"" + std::string(keyword) + "\" in " + std::string(filename));
+            }
+            (keyword[0] == 's' ? spec.sync : spec.hide).push_back(std::string(p, len));
+        } else {
+            fclose(f);
+            throw ParseError("[ERROR] Unknown keyword \"" + std::string(keyword) + "\" in " + std::string(filename));
+        }
+    }
+    fclose(f);
+
+    if (spec.components.size() == 0) throw ParseError("[ERROR] No components in " + std::string(filename));
+    return spec;
+}
+
+/**
+ * Helper: the cube of action <action> on the action variables <varA>, most significant bit first (as tau)
+ */
+static Bdd
+action_cube(const Bdd &varA, uint64_t action)
+{
+    int action_bits = sylvan_set_count(varA.GetBDD());
+    std::vector<uint8_t> value;
+    for (int i=0; i<action_bits; i++) value.push_back(action & (1ULL<<(action_bits-i-1)) ? 1 : 0);
+    return Bdd::bddCube(varA, value);
+}
+
+/**
+ * Helper: the set of actions <actions> as a BDD on the action variables <varA>, with action i called <names>[i]
+ */
+static Bdd
+action_set(const Bdd &varA, const std::vector<std::string> &names, const std::vector<std::string> &actions)
+{
+    Bdd result = Bdd::bddZero();
+    for (auto &action : actions) {
+        auto it = std::find(names.begin(), names.end(), action);
+        if (it == names.end()) throw ParseError("[ERROR] Unknown action " + action + " in the composition");
+        result += action_cube(varA, it - names.begin());
+    }
+    return result;
+}
+
+/**
+ * Helper: the names of the actions of <lts> by index, or the index itself if the model has no names.
+ * The actions of the tau set of <lts> are called "tau".
+ */
+static std::vector<std::string>
+action_names(const LTS &lts)
+{
+    std::vector<std::string> names = lts.getActions();
+    if (names.size() == 0) {
+        int action_bits = sylvan_set_count(lts.getVarA().GetBDD());
+        for (uint64_t i=0; i<(1ULL<<action_bits); i++) names.push_back(std::to_string(i));
+    }
+    for (size_t i=0; i<names.size(); i++) {
+        if ((action_cube(lts.getVarA(), i) * !lts.getTau()).isZero()) names[i] = "tau";
+    }
+    return names;
+}
+
+/**
+ * Helper: the actions of the transitions of <lts> from its (reachable) states
+ */
+static Bdd
+alphabet(const LTS &lts)
+{
+    Bdd st = lts.getVarS() * lts.getVarT();
+    Bdd result = Bdd::bddZero();
+    for (auto &rel : lts.getTransitions()) result += (rel.first * lts.getStates()).ExistAbstract(st);
+    return result;
+}
+
+/**
+ * Helper: move the state variables 2i and 2i+1 of <dd> (with i < <length>) to 2(i+offset) and 2(i+offset)+1
+ */
+static Bdd
+shift(const Bdd &dd, int length, int offset)
+{
+    if (offset == 0) return dd;
+    BddMap map;
+    for (int i=0; i<length; i++) {
+        map.put(2*i, Bdd::bddVar(2*(i+offset)));
+        map.put(2*i+1, Bdd::bddVar(2*(i+offset)+1));
+    }
+    return dd.Compose(map);
+}
+
+/**
+ * Helper: read the LTS <model> in the LTSmin or XML format
+ */
+static LTS
+read_component(const std::string &model, int tau)
+{
+    std::string model_name = InputStream::stripCompressionSuffix(model.c_str());
+    const char *dot = strrchr(model_name.c_str(), '.');
+    if (dot != NULL && strcmp(dot+1, "bdd") == 0) {
+        BddLtsParser parser(model.c_str(), tau);
+        return *parser.getLTS();
+    } else if (dot != NULL && (strcmp(dot+1, "xlts") == 0 || strcmp(dot+1, "xml") == 0)) {
+        SystemParser parser(model.c_str(), 0, float_type, tau);
+        return *parser.getLTS();
+    }
+    throw ParseError("[ERROR] Component " + model + " is not an LTS in the LTSmin or XML format");
+}
+
+void
+Composition::relabel(std::vector<LTS> &components, std::vector<std::string> &names)
+{
+    /* One table of action names for all components, with tau first */
+    std::vector<std::vector<std::string>> component_names;
+    std::map<std::string, size_t> index;
+    names.assign(1, "tau");
+    index["tau"] = 0;
+    for (const LTS &lts : components) {
+        component_names.push_back(action_names(lts));
+        for (auto &name : component_names.back()) {
+            if (index.count(name) == 0) {
+                index[name] = names.size();
+                names.push_back(name);
+            }
+        }
+    }
+
+    std::vector<uint32_t> action_vars;
+    for (int i=0; i == 0 || (1ULL<<i) < names.size(); i++) action_vars.push_back(1000000+i);
+    Bdd varA = Bdd::VariablesCube(action_vars);
+
+    for (size_t k=0; k<components.size(); k++) {
+        LTS &lts = components[k];
+        for (auto &rel : lts.transitions) {
+            Bdd result = Bdd::bddZero();
+            for (size_t i=0; i<component_names[k].size(); i++) {
+                Bdd part = rel.first * action_cube(lts.varA, i);
+                if (part.isZero()) continue;
+                result += part.ExistAbstract(lts.varA) * action_cube(varA, index[component_names[k][i]]);
+            }
+            rel.first = result;
+            rel.second = rel.second.ExistAbstract(lts.varA);
+        }
+        lts.varA = varA;
+        lts.tau = action_cube(varA, 0);
+        lts.actions = names;
+    }
+}
+
+void
+Composition::hideActions(LTS &lts, const Bdd &hidden)
+{
+    for (auto &rel : lts.transitions) {
+        Bdd renamed = (rel.first * hidden).ExistAbstract(lts.varA) * lts.tau;
+        rel.first = rel.first * !hidden + renamed;
+    }
+}
+
+LTS
+Composition::minimize(Context &context, const CompositionSpec &spec, int tau)
+{
+    /* Read all components first, to find the hidden actions that only one component has */
+    std::vector<LTS> components;
+    for (auto &model : spec.components) {
+        components.push_back(read_component(model, tau));
+        INFO("Composition: read component %s.", model.c_str());
+    }
+
+    /* The components number their actions differently, so use one table of action names */
+    std::vector<std::string> names;
+    relabel(components, names);
+
+    std::vector<Bdd> alphabets;
+    for (LTS &lts : components) alphabets.push_back(alphabet(lts));
+
+    Bdd varA = components[0].getVarA();
+    Bdd sync = action_set(varA, names, spec.sync);
+    Bdd hide = action_set(varA, names, spec.hide);
+
+    for (size_t k=0; k<components.size(); k++) {
+        /* Hide actions early that no other component has, so they do not hinder minimization */
+        Bdd local = hide * alphabets[k] * !sync;
+        for (size_t j=0; j<components.size(); j++) if (j != k) local *= !alphabets[j];
+        if (!local.isZero()) hideActions(components[k], local);
+
+        LACE_ME;
+        BDD states = components[k].getStates().GetBDD();
+        double n_states = sylvan_satcount(states, components[k].getVarS().GetBDD());
+
+        INFO("");
+        INFO("Composition: minimizing component %s.", spec.components[k].c_str());
+        Bdd partition = context.partition(components[k]);
+        size_t blocks = context.blocks();
+        if (!context.stable()) INFO("Composition: the partition of component %s is not stable.", spec.components[k].c_str());
+        context.quotient(components[k], partition);
+        INFO("Composition: component %s has %'0.0f states and %'zu blocks.", spec.components[k].c_str(), n_states, blocks);
+    }
+
+    INFO("");
+    INFO("Composition: computing the parallel composition of %'zu components.", components.size());
+    return compose(components, spec.sync, spec.hide);
+}
+
+LTS
+Composition::compose(const std::vector<LTS> &_components, const std::vector<std::string> &sync_actions,
+                     const std::vector<std::string> &hide_actions)
+{
+    LACE_ME;
+
+    std::vector<LTS> components = _components;
+    LTS result;
+    relabel(components, result.actions);
+    result.varA = components[0].varA;
+    result.tau = components[0].tau;
+
+    Bdd sync = action_set(result.varA, result.actions, sync_actions) * !result.tau;
+    Bdd hide = action_set(result.varA, result.actions, hide_actions);
+
+    /* The state variables of component k start after those of the components before it */
+    std::vector<int> length, offset;
+    int total = 0;
+    for (const LTS &lts : components) {
+        length.push_back(sylvan_set_count(lts.varS.GetBDD()));
+        offset.push_back(total);
+        total += length.back();
+    }
+
+    std::vector<uint32_t> state_vars, prime_vars;
+    for (int i=0; i<total; i++) {
+        state_vars.push_back(2*i);
+        prime_vars.push_back(2*i+1);
+    }
+    result.varS = Bdd::VariablesCube(state_vars);
+    result.varT = Bdd::VariablesCube(prime_vars);
+
+    /* Actions that no component synchronizes on: one relation per relation of each component */
+    for (size_t k=0; k<components.size(); k++) {
+        for (auto &rel : components[k].transitions) {
+            Bdd local = rel.first * !sync;
+            if (local.isZero()) continue;
+            result.transitions.push_back(std::make_pair(shift(local, length[k], offset[k]), shift(rel.second, length[k], offset[k])));
+        }
+    }
+
+    /* Synchronized actions: one relation per action, with all components that have the action */
+    for (auto &action : sync_actions) {
+        Bdd cube = action_set(result.varA, result.actions, {action}) * sync;
+        if (cube.isZero()) continue;
+        Bdd rel = Bdd::bddOne();
+        Bdd vars = Bdd::bddOne();
+        bool participates = false;
+        for (size_t k=0; k<components.size(); k++) {
+            /* The relations of the component on all its variables */
+            Bdd component_rel = Bdd::bddZero();
+            for (auto &r : components[k].transitions) {
+                Bdd part = r.first * cube;
+                if (part.isZero()) continue;
+                component_rel += Bdd(extend_relation(part.GetBDD(), r.second.GetBDD(), length[k]));
+            }
+            /* Only components that have the action in their (reachable) states take part */
+            if ((component_rel * components[k].states).isZero()) continue;
+            rel *= shift(component_rel, length[k], offset[k]);
+            vars *= shift(components[k].varS * components[k].varT, length[k], offset[k]);
+            participates = true;
+        }
+        if (participates && !rel.isZero()) result.transitions.push_back(std::make_pair(rel, vars));
+    }
+
+    /* Hide actions after composition */
+    if (!hide.isZero()) hideActions(result, hide);
+
+    /* The states of the composition are the states reachable from the initial states */
+    result.initialStates = Bdd::bddOne();
+    for (size_t k=0; k<components.size(); k++) {
+        /* A component without initial states (e.g. from an XML model) can start in any of its states */
+        const LTS &lts = components[k];
+        Bdd initial = lts.initialStates.isZero() ? lts.states : lts.initialStates;
+        result.initialStates *= shift(initial, length[k], offset[k]);
+    }
+
+    std::vector<Bdd> next_relations;
+    for (auto &rel : result.transitions) next_relations.push_back(rel.first.ExistAbstract(result.varA));
+
+    Bdd states = result.initialStates;
+    Bdd frontier = states;
+    while (!frontier.isZero()) {
+        Bdd next = Bdd::bddZero();
+        for (size_t i=0; i<next_relations.size(); i++) {
+            next += frontier.RelNext(next_relations[i], result.transitions[i].second);
+        }
+        frontier = next * !states;
+        states += frontier;
+    }
+    result.states = states;
+
+    /* The initial partition is the product of the labels (or initial partitions) of the components */
+    LabelSets labels;
+    for (size_t k=0; k<components.size(); k++) {
+        const LTS &lts = components[k];
+        if (lts.initialPartition.size() <= 1) continue;
+        if (lts.labels.size() > 0 && lts.initialPartitionLabels.size() == lts.initialPartition.size()) {
+            for (size_t l=0; l<lts.labels.size(); l++) {
+                Bdd set = Bdd::bddZero();
+                for (size_t b=0; b<lts.initialPartition.size(); b++) {
+                    for (size_t label : lts.initialPartitionLabels[b]) if (label == l) set += lts.initialPartition[b];
+                }
+                labels.push_back(std::make_pair(lts.labels[l], shift(set, length[k], offset[k])));
+            }
+        } else {
+            for (size_t b=0; b<lts.initialPartition.size(); b++) {
+                std::string name = "component " + std::to_string(k+1) + " block " + std::to_string(b+1);
+                labels.push_back(std::make_pair(name, shift(lts.initialPartition[b], length[k], offset[k])));
+            }
+        }
+    }
+    result.initialPartition.push_back(result.states);
+    if (labels.size() > 0) {
+        labelPartition(labels, result.initialPartition, result.initialPartitionLabels);
+        for (auto &label : labels) result.labels.push_back(label.first);
+    }
+
+    INFO("Composition: %'0.0f reachable states in %'zu transition relations.",
+         result.states.SatCount(result.varS), result.transitions.size());
+
+    return result;
+}
+
+}
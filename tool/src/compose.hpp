@@ -0,0 +1,75 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <libsigref.hpp>
+#include <systems.hpp>
+
+#ifndef SIGREF_COMPOSE_H
+#define SIGREF_COMPOSE_H
+
+namespace sigref {
+
+/**
+ * A parallel composition of LTSs, read from a composition file with the lines
+ *   component <model>       an LTS in the LTSmin or XML format (relative to the composition file)
+ *   sync <action>           an action on which all components that have it synchronize
+ *   hide <action>           an action that becomes tau in the composition
+ * Empty lines and lines starting with '#' are skipped. Actions are the names of the LTSmin models
+ * (the rest of the line), or the numbers of the actions for models without names (as with --tau).
+ */
+struct CompositionSpec {
+    std::vector<std::string> components;
+    std::vector<std::string> sync;
+    std::vector<std::string> hide;
+
+    /**
+     * Read the composition file <filename>. Throws ParseError if the file is invalid.
+     */
+    static CompositionSpec read(const char *filename);
+};
+
+class Composition {
+public:
+    /**
+     * Read the components of <spec>, minimize each of them with <context> (for the configured
+     * bisimulation) and return the parallel composition of the quotients.
+     * Hidden actions that only one component has are hidden before minimizing that component.
+     */
+    static LTS minimize(Context &context, const CompositionSpec &spec, int tau);
+
+    /**
+     * Compute the parallel composition of <components>, with the actions matched by name.
+     * Synchronized actions become one transition relation per action with all components that have
+     * the action; the other actions of each component become one relation of that component.
+     * The states are the reachable states; the initial partition is the product of the labels
+     * (or initial partitions) of the components.
+     */
+    static LTS compose(const std::vector<LTS> &components, const std::vector<std::string> &sync,
+                       const std::vector<std::string> &hide);
+
+private:
+    static void relabel(std::vector<LTS> &components, std::vector<std::string> &names);
+    static void hideActions(LTS &lts, const sylvan::Bdd &hidden);
+};
+
+}
+
+#endif
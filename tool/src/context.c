@@ -0,0 +1,79 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <sylvan.h>
+
+#include <context.h>
+#include <refine.h>
+
+double t_start;
+
+double
+wctime()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (tv.tv_sec + 1E-6 * tv.tv_usec);
+}
+
+void
+sigref_default_options(sigref_options *options)
+{
+    options->bisimulation = 1; // branching
+    options->leaftype = 2; // gmp
+    options->verbosity = 0; // default: no excessive node counting
+    options->merge_relations = 0;
+    options->closure = 0; // fixpoint
+    options->reachable = 0;
+    options->tau_action = 0;
+    options->ordering = 0; // s,t < a < B
+    options->max_iterations = 0; // until stable
+    options->time_limit = 0; // no limit
+    options->statistics = 2; // full
+    options->compaction = 0;
+    options->memory_limit = 0; // no limit
+}
+
+void
+sigref_context_init(sigref_context *ctx, const sigref_options *options)
+{
+    ctx->options = *options;
+    ctx->block_base = 2000000; // prepare_blocks moves this before the action variables for ordering 1
+    ctx->block_length = 0;
+    ctx->block_variables = sylvan_true;
+    ctx->refine = refine_data_create();
+    ctx->iteration_nodes = 0;
+    ctx->compacted_gc_count = 0;
+    ctx->time_limit_end = 0;
+    ctx->memory_pressure = 0;
+    ctx->memory_pressure_applied = 0;
+    ctx->stable = 1;
+    ctx->bound = 0;
+}
+
+void
+sigref_context_free(sigref_context *ctx)
+{
+    sylvan_deref(ctx->block_variables);
+    ctx->block_variables = sylvan_true;
+
+    free_refine_data(ctx);
+    free(ctx->refine);
+    ctx->refine = NULL;
+}
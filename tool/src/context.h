@@ -0,0 +1,85 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan.h>
+
+#ifndef SIGREF_CONTEXT_H
+#define SIGREF_CONTEXT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Options of a minimization
+ */
+typedef struct sigref_options
+{
+    int bisimulation; // 1 = branching, 2 = strong
+    int leaftype; // 0 = float, 1 = fraction, 2 = gmp
+    int verbosity; // 0 = default, 1 = more, 2 = too much
+    int merge_relations; // merge relations to 1 relation
+    int closure; // 0 = fixpoint, 1 = squaring, 2 = recursive
+    int reachable; // 0 = no, 1 = yes
+    int tau_action; // action label of tau
+    int ordering; // 0 = s,t < a < B, 1 = s,t < B < a
+    size_t max_iterations; // 0 = until stable, k = stop after k iterations (k-bisimulation)
+    double time_limit; // 0 = no limit, t = stop each refinement after t seconds (wall-clock time)
+    int statistics; // 0 = none, 1 = cheap, 2 = full (computed concurrently with refinement)
+    int compaction; // compact the nodes table after a garbage collection (--compact)
+    size_t memory_limit; // 0 = no limit, b = grow the tables within b bytes (see attach_memory_limit)
+} sigref_options;
+
+void sigref_default_options(sigref_options *options);
+
+/* Refinement data, defined by the refinement implementation (refine_sl.c or refine_ht.c) */
+typedef struct sigref_refine_data sigref_refine_data;
+
+/**
+ * All state of a minimization: the options, the encoding of block numbers and the
+ * data of the refinement procedure.
+ *
+ * Sylvan (nodes table, operation cache, Lace workers) is shared by all contexts,
+ * so contexts can be used one after the other, but not at the same time.
+ * The context is passed explicitly to the refinement and quotient functions.
+ */
+typedef struct sigref_context
+{
+    sigref_options options;
+
+    uint32_t block_base; // base for block variables
+    int block_length; // number of block variables
+    BDD block_variables; // cube of the block variables (referenced)
+
+    sigref_refine_data *refine;
+    size_t iteration_nodes; // nodes in the table at the start of the last iteration (start_iteration)
+    size_t compacted_gc_count; // sylvan_gc_count() after the last compaction (start_iteration)
+    double time_limit_end; // wctime() at which the running refinement stops (time_limit)
+    int memory_pressure; // step of the memory limit policy (MemoryPressure, see table_sizes.hpp)
+    int memory_pressure_applied; // the last step that the refinement loop applied
+
+    int stable; // 0 if the last refinement stopped before the partition was stable
+    size_t bound; // k if the last refinement stopped after max_iterations = k, 0 otherwise
+} sigref_context;
+
+void sigref_context_init(sigref_context *ctx, const sigref_options *options);
+void sigref_context_free(sigref_context *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -37,14 +37,17 @@ TASK_IMPL_4(BDD, compute_inert, BDD, dd, BDD, left, BDD, right, BDD, st_vars)
         return dd; // assuming pre-calculation of dd AND tau
     }
 
+    sylvan_gc_test();
+
+    sigref_op_count(SIGREF_OP_INERT);
+
     BDD result;
     /* assumption: st_vars does not change during program */
     if (cache_get3(CACHE_INERT, dd, left, right, &result)) {
+        sigref_op_cached(SIGREF_OP_INERT);
         return result;
     }
 
-    sylvan_gc_test();
-
     BDDVAR var = sylvan_set_first(st_vars);
 
     BDD dd_low, dd_high;
@@ -80,7 +83,7 @@ TASK_IMPL_4(BDD, compute_inert, BDD, dd, BDD, left, BDD, right, BDD, st_vars)
     bdd_refs_pop(1);
     result = sylvan_makenode(var, low, high);
 
-    cache_put3(CACHE_INERT, dd, left, right, result);
+    if (cache_put3(CACHE_INERT, dd, left, right, result)) sigref_op_cachedput(SIGREF_OP_INERT);
 
     return result;
 }
@@ -15,12 +15,11 @@
  */
 
 #include <sylvan.h>
+#include <sigref_ops.h>
 
 #ifndef SIGREF_INERT_H
 #define SIGREF_INERT_H
 
-#define CACHE_INERT (257LL<<42)
-
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -34,7 +33,7 @@ extern "C" {
  * @param st_vars the cube of variables s,t
  */
 TASK_DECL_4(BDD, compute_inert, BDD, BDD, BDD, BDD);
-#define compute_inert(dd, left, right, st_vars) CALL(compute_inert, dd, left, right, st_vars)
+#define compute_inert(dd, left, right, st_vars) sigref_op_timed(SIGREF_OP_INERT, BDD, CALL(compute_inert, dd, left, right, st_vars))
 
 #ifdef __cplusplus
 }
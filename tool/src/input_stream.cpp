@@ -0,0 +1,221 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <input_stream.hpp>
+
+namespace sigref {
+
+enum {
+    plain_file = 0,
+    gzip_file = 1,
+    zstd_file = 2,
+};
+
+/**
+ * Helper: write all <len> bytes to <fd>, returns false on error (e.g. the reader closed the pipe)
+ */
+static bool
+write_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+InputStream::InputStream(const char *filename) : file(NULL), failed(false)
+{
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) return;
+
+    /* Detect compression by the magic bytes */
+    unsigned char magic[4] = {0, 0, 0, 0};
+    size_t n = fread(magic, 1, 4, f);
+    int type = plain_file;
+    if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) type = gzip_file;
+    if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) type = zstd_file;
+
+    if (type == plain_file) {
+        rewind(f);
+        file = f;
+        return;
+    }
+    fclose(f);
+
+#ifndef HAVE_ZLIB
+    if (type == gzip_file) {
+        fprintf(stderr, "Cannot read '%s': compiled without gzip support!\n", filename);
+        return;
+    }
+#endif
+#ifndef HAVE_ZSTD
+    if (type == zstd_file) {
+        fprintf(stderr, "Cannot read '%s': compiled without zstd support!\n", filename);
+        return;
+    }
+#endif
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        fprintf(stderr, "Cannot create pipe for '%s'!\n", filename);
+        return;
+    }
+    file = fdopen(fds[0], "r");
+    helper = std::thread(&InputStream::decompress, this, type, std::string(filename), fds[1]);
+}
+
+InputStream::~InputStream()
+{
+    /* Closing the read end first lets the helper stop if the parser did not read everything */
+    if (file != NULL) fclose(file);
+    if (helper.joinable()) helper.join();
+}
+
+bool
+InputStream::readAll(std::string &contents)
+{
+    if (file == NULL) return false;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) contents.append(buf, n);
+    return finish();
+}
+
+bool
+InputStream::finish()
+{
+    if (file == NULL) return false;
+    char buf[65536];
+    while (fread(buf, 1, sizeof(buf), file) > 0) continue;
+    if (ferror(file)) return false;
+    if (helper.joinable()) helper.join();
+    return !failed;
+}
+
+std::string
+InputStream::stripCompressionSuffix(const char *filename)
+{
+    std::string name = filename;
+    if (name.size() > 3 && name.compare(name.size()-3, 3, ".gz") == 0) name.resize(name.size()-3);
+    else if (name.size() > 4 && name.compare(name.size()-4, 4, ".zst") == 0) name.resize(name.size()-4);
+    return name;
+}
+
+/**
+ * Runs on the helper thread: decompress <filename> into the pipe <out>
+ */
+void
+InputStream::decompress(int type, std::string filename, int out)
+{
+    /* A parser that stops early closes the pipe; report that as EPIPE, not as a signal */
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    bool ok = true;
+    static const size_t buf_size = 1<<17;
+    char *buf = new char[buf_size];
+
+#ifdef HAVE_ZLIB
+    if (type == gzip_file) {
+        gzFile gz = gzopen(filename.c_str(), "rb");
+        if (gz == NULL) {
+            ok = false;
+        } else {
+            int n;
+            while ((n = gzread(gz, buf, buf_size)) > 0) {
+                if (!write_all(out, buf, n)) break;
+            }
+            int err = Z_OK;
+            gzerror(gz, &err);
+            if (n < 0 || (err != Z_OK && err != Z_STREAM_END)) ok = false;
+            gzclose(gz);
+        }
+    }
+#endif
+
+#ifdef HAVE_ZSTD
+    if (type == zstd_file) {
+        FILE *in = fopen(filename.c_str(), "r");
+        ZSTD_DStream *stream = ZSTD_createDStream();
+        if (in == NULL || stream == NULL) {
+            ok = false;
+        } else {
+            ZSTD_initDStream(stream);
+            size_t in_size = ZSTD_DStreamInSize();
+            char *in_buf = new char[in_size];
+            size_t n;
+            size_t res = 1; // 0 when a frame is complete and flushed
+            bool stop = false;
+            while (!stop && (n = fread(in_buf, 1, in_size, in)) > 0) {
+                ZSTD_inBuffer input = { in_buf, n, 0 };
+                ZSTD_outBuffer output = { buf, buf_size, buf_size };
+                // also continue while the output is full, as the decoder may have more to flush
+                while (input.pos < input.size || output.pos == output.size) {
+                    output.pos = 0;
+                    res = ZSTD_decompressStream(stream, &output, &input);
+                    if (ZSTD_isError(res)) {
+                        ok = false;
+                        stop = true;
+                        break;
+                    }
+                    if (!write_all(out, buf, output.pos)) {
+                        stop = true;
+                        break;
+                    }
+                }
+            }
+            if (ferror(in)) ok = false;
+            // a stream that ends within a frame is truncated
+            if (!stop && res != 0) ok = false;
+            delete[] in_buf;
+        }
+        if (stream != NULL) ZSTD_freeDStream(stream);
+        if (in != NULL) fclose(in);
+    }
+#endif
+
+    if (!ok) {
+        fprintf(stderr, "Error decompressing '%s'!\n", filename.c_str());
+        failed = true;
+    }
+
+    delete[] buf;
+    close(out);
+    (void)type;
+}
+
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string>
+#include <thread>
+
+#ifndef SIGREF_INPUT_STREAM_H
+#define SIGREF_INPUT_STREAM_H
+
+namespace sigref {
+
+/**
+ * Input file that is transparently decompressed.
+ *
+ * Files compressed with gzip (or zstd, if available) are recognized by their magic bytes.
+ * They are decompressed by a helper thread that writes into a pipe, so decompression
+ * overlaps with the parser reading from get(). Other files are read directly.
+ */
+class InputStream {
+public:
+    InputStream(const char *filename);
+    ~InputStream();
+
+    /**
+     * The stream to read from, or NULL if the file could not be opened.
+     */
+    FILE *get() { return file; }
+
+    /**
+     * Read the remainder of the stream into <contents>.
+     * Returns false if reading or decompression failed.
+     */
+    bool readAll(std::string &contents);
+
+    /**
+     * Skip the remainder of the stream and wait for the decompression, for parsers that read
+     * from get(). Returns false if reading or decompression failed.
+     */
+    bool finish();
+
+    /**
+     * Returns <filename> without a .gz or .zst suffix, to determine the type of model.
+     */
+    static std::string stripCompressionSuffix(const char *filename);
+
+private:
+    void decompress(int type, std::string filename, int out);
+
+    FILE *file;
+    std::thread helper;
+    volatile bool failed;
+};
+
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+
+#include <input_stream.hpp>
+#include <labels.hpp>
+#include <parse_xml.hpp>
+
+namespace sigref {
+
+using namespace sylvan;
+
+void
+readLabelFile(const char *filename, const Bdd &varS, int slots, int slot_bits, LabelSets &labels)
+{
+    InputStream input(filename);
+    FILE *f = input.get();
+    if (f == NULL) throw ParseError("[ERROR] Cannot open label file " + std::string(filename));
+
+    std::map<std::string, size_t> label_index;
+    for (size_t i=0; i<labels.size(); i++) label_index[labels[i].first] = i;
+
+    std::vector<uint8_t> cube(slots * slot_bits);
+    char line[65536];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char *p = line + strspn(line, " \t");
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') continue;
+
+        char *colon = strchr(p, ':');
+        if (colon == NULL) throw ParseError("[ERROR] Expected \"<label>: <values>\" in label file " + std::string(filename));
+        std::string name(p, strcspn(p, " \t:"));
+
+        /* The values of the slots, most significant bit first; 2 means any value */
+        p = colon + 1;
+        for (int i=0; i<slots; i++) {
+            p += strspn(p, " \t");
+            if (*p == '*') {
+                for (int j=0; j<slot_bits; j++) cube[i*slot_bits+j] = 2;
+                p++;
+                continue;
+            }
+            char *end;
+            unsigned long value = strtoul(p, &end, 10);
+            if (end == p) {
+                throw ParseError("[ERROR] Expected " + std::to_string(slots) + " values for label " + name + " in label file " + std::string(filename));
+            }
+            if (slot_bits < 64 && (value >> slot_bits) != 0) {
+                throw ParseError("[ERROR] Invalid value for label " + name + " in label file " + std::string(filename));
+            }
+            for (int j=0; j<slot_bits; j++) cube[i*slot_bits+j] = (value >> (slot_bits-j-1)) & 1;
+            p = end;
+        }
+        if (p[strspn(p, " \t\r\n")] != '\0') {
+            throw ParseError("[ERROR] Expected " + std::to_string(slots) + " values for label " + name + " in label file " + std::string(filename));
+        }
+
+        auto it = label_index.find(name);
+        if (it == label_index.end()) {
+            it = label_index.insert(std::make_pair(name, labels.size())).first;
+            labels.push_back(std::make_pair(name, Bdd::bddZero()));
+        }
+        labels[it->second].second += Bdd::bddCube(varS, cube);
+    }
+    if (!input.finish()) throw ParseError("[ERROR] Could not load label file " + std::string(filename));
+}
+
+/**
+ * Split each block of blocks[0..count) by <label>, into out[2i] (the states with the label)
+ * and out[2i+1] (the other states). The results are referenced.
+ */
+VOID_TASK_4(split_blocks, const BDD*, blocks, size_t, count, BDD, label, BDD*, out)
+{
+    if (count == 1) {
+        BDD with = sylvan_and(blocks[0], label);
+        bdd_refs_push(with);
+        BDD without = sylvan_diff(blocks[0], label);
+        bdd_refs_pop(1);
+        out[0] = sylvan_ref(with);
+        out[1] = sylvan_ref(without);
+        return;
+    }
+
+    SPAWN(split_blocks, blocks, count/2, label, out);
+    CALL(split_blocks, blocks+count/2, count-count/2, label, out+2*(count/2));
+    SYNC(split_blocks);
+}
+
+void
+labelPartition(const LabelSets &labels, std::vector<Bdd> &partition, std::vector<std::vector<size_t>> &partition_labels)
+{
+    LACE_ME;
+
+    std::vector<BDD> blocks;
+    for (Bdd &block : partition) blocks.push_back(sylvan_ref(block.GetBDD()));
+    std::vector<std::vector<size_t>> combinations(blocks.size());
+
+    for (size_t l=0; l<labels.size() && blocks.size() > 0; l++) {
+        std::vector<BDD> out(2*blocks.size());
+        CALL(split_blocks, blocks.data(), blocks.size(), labels[l].second.GetBDD(), out.data());
+
+        /* Keep the nonempty halves, in the order of the blocks */
+        std::vector<BDD> next;
+        std::vector<std::vector<size_t>> next_combinations;
+        for (size_t i=0; i<blocks.size(); i++) {
+            for (int half=0; half<2; half++) {
+                if (out[2*i+half] == sylvan_false) continue;
+                next.push_back(out[2*i+half]);
+                next_combinations.push_back(combinations[i]);
+                if (half == 0) next_combinations.back().push_back(l);
+            }
+            sylvan_deref(blocks[i]);
+        }
+        blocks.swap(next);
+        combinations.swap(next_combinations);
+    }
+
+    partition.clear();
+    for (BDD block : blocks) {
+        partition.push_back(Bdd(block));
+        sylvan_deref(block);
+    }
+    partition_labels = combinations;
+}
+
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sylvan.h>
+#include <sylvan_obj.hpp>
+
+#ifndef SIGREF_LABELS_H
+#define SIGREF_LABELS_H
+
+namespace sigref {
+
+/**
+ * Atomic propositions of a model: the name and the set of states of each label.
+ */
+typedef std::vector<std::pair<std::string, sylvan::Bdd>> LabelSets;
+
+/**
+ * Read the label file <filename>. Every line "<label>: <v1> <v2> ... <vn>" adds the states
+ * with the values <v1> ... <vn> of the <slots> slots of the state vector to <label>, with "*"
+ * for any value. A slot is encoded by <slot_bits> variables of <varS>, most significant bit first.
+ * Empty lines and lines starting with '#' are skipped. Throws ParseError if the file is invalid.
+ */
+void readLabelFile(const char *filename, const sylvan::Bdd &varS, int slots, int slot_bits, LabelSets &labels);
+
+/**
+ * Refine <partition> by <labels>: every block is split into one block for each combination of
+ * labels that holds in some of its states. The blocks are split in parallel, one label at a time.
+ * Afterwards, <partition_labels> contains the labels (indices in <labels>) of each block.
+ */
+void labelPartition(const LabelSets &labels, std::vector<sylvan::Bdd> &partition,
+                    std::vector<std::vector<size_t>> &partition_labels);
+
+}
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdexcept>
+
+#include <libsigref.hpp>
+
+#include <sylvan_gmp.h>
+
+#include <bisimulation.hpp>
+#include <quotient.hpp>
+#include <refine.h>
+#include <sigref.h>
+#include <sigref_util.hpp>
+#include <table_sizes.hpp>
+
+using namespace sylvan;
+
+namespace sigref {
+
+void
+initialize(int tablesize, int maxtablesize, int cachesize, int maxcachesize)
+{
+    sylvan_init_package(1LL<<tablesize, 1LL<<maxtablesize, 1LL<<cachesize, 1LL<<maxcachesize);
+    sylvan_set_granularity(3);
+    sylvan_init_mtbdd();
+    gmp_init();
+    sigref_register_ops();
+}
+
+Context::Context(const Options &options) : quotient_type(options.quotient_type)
+{
+    sigref_context_init(&ctx, &options);
+}
+
+Context::~Context()
+{
+    detach_memory_limit(&ctx);
+    sigref_context_free(&ctx);
+}
+
+/**
+ * Helper: reset the refinement state of <ctx> before computing a new partition.
+ * The operation cache may contain results of an earlier context (the refine
+ * iteration is part of the cache keys), so it is cleared as well, and the costs of
+ * its entries (with CACHE_COST) are scaled to the state variables of <system>.
+ * Returns the verbosity, which the memory limit may lower during refinement.
+ */
+static int
+start_partition(sigref_context *ctx, const StateSystem &system)
+{
+    LACE_ME;
+    sylvan_clear_cache();
+    /* The state and next-state variables are at the top of the variable order */
+    mtbdd_set_cache_cost_vars(sylvan_set_count(system.getVarS().GetBDD()) + sylvan_set_count(system.getVarT().GetBDD()));
+    free_refine_data(ctx);
+    set_block_count(ctx, 0);
+    attach_memory_limit(ctx);
+    start_time_limit(ctx);
+    ctx->stable = 1;
+    ctx->bound = 0;
+    return ctx->options.verbosity;
+}
+
+Bdd
+Context::partition(LTS &lts)
+{
+    int saved_verbosity = start_partition(&ctx, lts);
+    LACE_ME;
+    BDD result = ctx.options.bisimulation == 1 ? CALL(min_lts_branching, &ctx, lts) : CALL(min_lts_strong, &ctx, lts);
+    ctx.options.verbosity = saved_verbosity;
+    return Bdd(result);
+}
+
+Bdd
+Context::partition(CTMC &ctmc)
+{
+    int saved_verbosity = start_partition(&ctx, ctmc);
+    LACE_ME;
+    BDD result = CALL(min_ctmc, &ctx, ctmc);
+    ctx.options.verbosity = saved_verbosity;
+    return Bdd(result);
+}
+
+Bdd
+Context::partition(IMC &imc)
+{
+    int saved_verbosity = start_partition(&ctx, imc);
+    LACE_ME;
+    BDD result = ctx.options.bisimulation == 1 ? CALL(min_imc_branching, &ctx, imc) : CALL(min_imc_strong, &ctx, imc);
+    ctx.options.verbosity = saved_verbosity;
+    return Bdd(result);
+}
+
+size_t
+Context::blocks()
+{
+    return count_blocks(&ctx);
+}
+
+bool
+Context::stable()
+{
+    return ctx.stable != 0;
+}
+
+size_t
+Context::bound()
+{
+    return ctx.bound;
+}
+
+/**
+ * Helper: compute the quotient of <system> with the quotient type <type>.
+ */
+template<class System>
+static void
+quotient_of(sigref_context *ctx, System &system, BDD partition, int type)
+{
+    /* The signatures are no longer needed */
+    free_refine_data(ctx);
+
+    LACE_ME;
+    partition = trim_block_variables(ctx, partition);
+    bdd_refs_push(partition);
+    if (type == 1) Minimizations::minimize1(ctx, system, partition, 0);
+    else if (type == 2) Minimizations::minimize1(ctx, system, partition, 1);
+    else if (type == 3) Minimizations::minimize2(ctx, system, partition);
+    else if (type == 4) Minimizations::minimize3(ctx, system, partition);
+    else throw std::invalid_argument("unknown quotient type");
+    bdd_refs_pop(1);
+}
+
+/* For CTMCs, minimize1 has no variant 2 */
+template<>
+void
+quotient_of(sigref_context *ctx, CTMC &ctmc, BDD partition, int type)
+{
+    free_refine_data(ctx);
+
+    LACE_ME;
+    partition = trim_block_variables(ctx, partition);
+    bdd_refs_push(partition);
+    if (type == 1 || type == 2) Minimizations::minimize1(ctx, ctmc, partition);
+    else if (type == 3) Minimizations::minimize2(ctx, ctmc, partition);
+    else if (type == 4) Minimizations::minimize3(ctx, ctmc, partition);
+    else throw std::invalid_argument("unknown quotient type");
+    bdd_refs_pop(1);
+}
+
+void
+Context::quotient(LTS &lts, const Bdd &partition)
+{
+    quotient_of(&ctx, lts, partition.GetBDD(), quotient_type);
+}
+
+void
+Context::quotient(CTMC &ctmc, const Bdd &partition)
+{
+    quotient_of(&ctx, ctmc, partition.GetBDD(), quotient_type);
+}
+
+void
+Context::quotient(IMC &imc, const Bdd &partition)
+{
+    quotient_of(&ctx, imc, partition.GetBDD(), quotient_type);
+}
+
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan.h>
+#include <sylvan_obj.hpp>
+
+#include <context.h>
+#include <systems.hpp>
+
+#ifndef LIBSIGREF_H
+#define LIBSIGREF_H
+
+namespace sigref {
+
+/**
+ * Initialize Sylvan for libsigref, with tables of the given sizes (powers of 2).
+ * Must be called from a Lace task, once per process.
+ */
+void initialize(int tablesize, int maxtablesize, int cachesize, int maxcachesize);
+
+/**
+ * Options of a minimization, see context.h; initialized to the defaults of sigrefmc.
+ */
+struct Options : sigref_options {
+    Options() { sigref_default_options(this); }
+
+    /* 1 = standard operations, 2 = standard operations variant 2, 3 = custom operations, 4 = pick-random */
+    int quotient_type = 3;
+};
+
+/**
+ * The result of a minimization: the partition and the quotient system.
+ */
+template<class System>
+struct Result {
+    sylvan::Bdd partition; // partition (block encoding), before trimming
+    size_t blocks;
+    System quotient;
+};
+
+/**
+ * Context of minimizations: the options, the block encoding and the refinement data.
+ *
+ * All functions must be called from a Lace task. Contexts share Sylvan, so they can
+ * be reused one after the other (without restarting Sylvan), but not used concurrently.
+ */
+class Context {
+public:
+    Context(const Options &options = Options());
+    ~Context();
+
+    /**
+     * Compute the partition of <system> for the configured bisimulation.
+     */
+    sylvan::Bdd partition(LTS &lts);
+    sylvan::Bdd partition(CTMC &ctmc);
+    sylvan::Bdd partition(IMC &imc);
+
+    /**
+     * Number of blocks of the last computed partition.
+     */
+    size_t blocks();
+
+    /**
+     * False if the last partition is not stable, because refinement stopped early
+     * (see the options memory_limit and time_limit).
+     */
+    bool stable();
+
+    /**
+     * k if the last partition is k-bounded, because refinement stopped after max_iterations = k
+     * (then stable() is false), 0 otherwise.
+     */
+    size_t bound();
+
+    /**
+     * Replace <system> by its quotient for the last computed <partition>.
+     */
+    void quotient(LTS &lts, const sylvan::Bdd &partition);
+    void quotient(CTMC &ctmc, const sylvan::Bdd &partition);
+    void quotient(IMC &imc, const sylvan::Bdd &partition);
+
+    /**
+     * Compute the partition and the quotient of <system>, leaving <system> untouched.
+     */
+    template<class System>
+    Result<System> minimize(System &system)
+    {
+        Result<System> result;
+        result.partition = partition(system);
+        result.blocks = blocks();
+        result.quotient = system;
+        quotient(result.quotient, result.partition);
+        return result;
+    }
+
+    /**
+     * The options of the context; changes apply to the next partition.
+     */
+    sigref_options &options() { return ctx.options; }
+
+    /**
+     * The state of the context, for the lower-level functions (bisimulation.hpp, quotient.hpp,
+     * writer.hpp) that continue with the last computed partition.
+     */
+    sigref_context *get() { return &ctx; }
+
+private:
+    Context(const Context&) = delete;
+    Context &operator=(const Context&) = delete;
+
+    int quotient_type;
+    sigref_context ctx;
+};
+
+/**
+ * Minimize <system> with a fresh context.
+ */
+template<class System>
+Result<System> minimize(System &system, const Options &options = Options())
+{
+    Context context(options);
+    return context.minimize(system);
+}
+
+}
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+#include <sylvan_gmp.h>
+
+#include <sigref.h>
+#include <matvec.h>
+
+/**
+ * Multiply the vector x (on s) with the matrix M (on s,t) and rename t to s
+ */
+TASK_IMPL_4(MTBDD, sigref_matvec, MTBDD, M, MTBDD, x, MTBDD, s_vars, int, gmp)
+{
+    /* missing entries are 0 */
+    if (M == mtbdd_false || x == mtbdd_false) return mtbdd_false;
+    if (mtbdd_set_isempty(s_vars)) {
+        /* now M and x are leaves */
+        if (gmp) return gmp_times(M, x);
+        else return mtbdd_times(M, x);
+    }
+
+    sylvan_gc_test();
+
+    sigref_op_count(SIGREF_OP_MATVEC);
+
+    MTBDD result;
+    /* assumption: s_vars is the cube of all s variables from some level */
+    if (cache_get3(CACHE_MATVEC, M, x, s_vars, &result)) {
+        sigref_op_cached(SIGREF_OP_MATVEC);
+        return result;
+    }
+
+    uint32_t var = mtbdd_set_first(s_vars);
+    MTBDD next = mtbdd_set_next(s_vars);
+
+    /* cofactors of x on s */
+    MTBDD x0 = x, x1 = x;
+    if (!mtbdd_isleaf(x) && mtbdd_getvar(x) == var) {
+        x0 = mtbdd_getlow(x);
+        x1 = mtbdd_gethigh(x);
+    }
+
+    /* cofactors of M on s, then on t */
+    MTBDD M0 = M, M1 = M;
+    if (!mtbdd_isleaf(M) && mtbdd_getvar(M) == var) {
+        M0 = mtbdd_getlow(M);
+        M1 = mtbdd_gethigh(M);
+    }
+    MTBDD M00 = M0, M01 = M0, M10 = M1, M11 = M1;
+    if (!mtbdd_isleaf(M0) && mtbdd_getvar(M0) == var+1) {
+        M00 = mtbdd_getlow(M0);
+        M01 = mtbdd_gethigh(M0);
+    }
+    if (!mtbdd_isleaf(M1) && mtbdd_getvar(M1) == var+1) {
+        M10 = mtbdd_getlow(M1);
+        M11 = mtbdd_gethigh(M1);
+    }
+
+    /* y0 = x0*M00 + x1*M10 and y1 = x0*M01 + x1*M11 */
+    mtbdd_refs_spawn(SPAWN(sigref_matvec, M00, x0, next, gmp));
+    mtbdd_refs_spawn(SPAWN(sigref_matvec, M10, x1, next, gmp));
+    mtbdd_refs_spawn(SPAWN(sigref_matvec, M01, x0, next, gmp));
+    MTBDD y11 = CALL(sigref_matvec, M11, x1, next, gmp);
+    mtbdd_refs_push(y11);
+    MTBDD y01 = mtbdd_refs_sync(SYNC(sigref_matvec));
+    mtbdd_refs_push(y01);
+    MTBDD y10 = mtbdd_refs_sync(SYNC(sigref_matvec));
+    mtbdd_refs_push(y10);
+    MTBDD y00 = mtbdd_refs_sync(SYNC(sigref_matvec));
+    mtbdd_refs_push(y00);
+
+    MTBDD low, high;
+    if (gmp) low = gmp_plus(y00, y10);
+    else low = mtbdd_plus(y00, y10);
+    mtbdd_refs_push(low);
+    if (gmp) high = gmp_plus(y01, y11);
+    else high = mtbdd_plus(y01, y11);
+    mtbdd_refs_push(high);
+
+    /* the result is defined on s */
+    result = mtbdd_makenode(var, low, high);
+    mtbdd_refs_pop(6);  // y11, y01, y10, y00, low, high
+
+    /* cache result */
+    if (cache_put3(CACHE_MATVEC, M, x, s_vars, result)) sigref_op_cachedput(SIGREF_OP_MATVEC);
+
+    return result;
+}
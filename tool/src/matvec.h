@@ -0,0 +1,45 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan.h>
+#include <sigref_ops.h>
+
+#ifndef SIGREF_MATVEC_H
+#define SIGREF_MATVEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Multiply the vector <x> with the matrix <M>: y(s) = sum over s' of x(s') * M(s',s).
+ * Missing entries (mtbdd_false) are 0. The leaves are doubles or fractions
+ * (with the operations of Sylvan) or GMP rationals.
+ *
+ * @param M the matrix defined on s,t (state bit j is variable 2j, successor bit j is variable 2j+1)
+ * @param x the vector defined on s
+ * @param s_vars the cube of variables s
+ * @param gmp nonzero if the leaves are GMP rationals
+ * @return the vector y defined on s
+ */
+TASK_DECL_4(MTBDD, sigref_matvec, MTBDD, MTBDD, MTBDD, int);
+#define sigref_matvec(M, x, s_vars, gmp) sigref_op_timed(SIGREF_OP_MATVEC, MTBDD, CALL(sigref_matvec, M, x, s_vars, gmp))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
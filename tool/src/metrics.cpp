@@ -0,0 +1,176 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+
+#include <string>
+
+#include <sylvan.h>
+#include <sylvan_int.h>
+
+#include <getrss.h>
+#include <metrics.hpp>
+#include <sigref.h>
+
+namespace sigref {
+
+static FILE *metrics_file = NULL;
+static std::string metrics_model_name;
+
+/* Garbage collections since the start, counted by the hooks below */
+static size_t gc_count = 0;
+static double gc_time = 0;
+static double gc_start_time = 0;
+
+/* Operation counters at the previous record, for the cache hit rate */
+static uint64_t last_calls = 0;
+static uint64_t last_hits = 0;
+
+VOID_TASK_0(metrics_gc_start)
+{
+    gc_start_time = wctime();
+}
+
+VOID_TASK_0(metrics_gc_end)
+{
+    gc_count++;
+    gc_time += wctime() - gc_start_time;
+}
+
+/**
+ * Helper: total number of calls and cache hits of all operations (see OPCOUNTER in sylvan_stats.h)
+ */
+static void
+count_operations(uint64_t *calls, uint64_t *hits)
+{
+    LACE_ME;
+    sylvan_stats_t stats;
+    sylvan_stats_snapshot(&stats);
+    *calls = *hits = 0;
+    for (int i=BDD_ITE; i<SYLVAN_GC_COUNT; i+=3) {
+        *calls += stats.counters[i];
+        *hits += stats.counters[i+2];
+    }
+}
+
+/**
+ * Helper: write <s> as a JSON string
+ */
+static void
+write_string(const char *s)
+{
+    fputc('"', metrics_file);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fprintf(metrics_file, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20) fprintf(metrics_file, "\\u%04x", *s);
+        else fputc(*s, metrics_file);
+    }
+    fputc('"', metrics_file);
+}
+
+/**
+ * Helper: start a record of type <type> with the common fields
+ */
+static void
+begin_record(const char *type)
+{
+    fprintf(metrics_file, "{\"type\":\"%s\",\"model\":", type);
+    write_string(metrics_model_name.c_str());
+    fprintf(metrics_file, ",\"time\":%.6f", wctime()-t_start);
+}
+
+/**
+ * Helper: finish a record with the fields of the nodes table, operation cache, GC and RSS
+ */
+static void
+end_record()
+{
+    LACE_ME;
+    fprintf(metrics_file, ",\"table_nodes\":%zu,\"table_size\":%zu", llmsset_count_marked(nodes), llmsset_get_size(nodes));
+
+    uint64_t calls, hits;
+    count_operations(&calls, &hits);
+    if (calls > last_calls) fprintf(metrics_file, ",\"cache_hit_rate\":%.4f", (double)(hits-last_hits)/(calls-last_calls));
+    else fprintf(metrics_file, ",\"cache_hit_rate\":null");
+    last_calls = calls;
+    last_hits = hits;
+
+    fprintf(metrics_file, ",\"gc_count\":%zu,\"gc_time\":%.6f,\"rss\":%zu}\n", gc_count, gc_time, getCurrentRSS());
+    fflush(metrics_file);
+}
+
+bool
+metrics_open(const char *filename)
+{
+    metrics_close();
+    metrics_file = fopen(filename, "w");
+    if (metrics_file == NULL) return false;
+
+    static bool hooks_installed = false;
+    if (!hooks_installed) {
+        sylvan_gc_hook_pregc(TASK(metrics_gc_start));
+        sylvan_gc_hook_postgc(TASK(metrics_gc_end));
+        hooks_installed = true;
+    }
+    count_operations(&last_calls, &last_hits);
+    return true;
+}
+
+void
+metrics_close()
+{
+    if (metrics_file != NULL) fclose(metrics_file);
+    metrics_file = NULL;
+}
+
+bool
+metrics_enabled()
+{
+    return metrics_file != NULL;
+}
+
+void
+metrics_model(const char *model)
+{
+    metrics_model_name = model;
+}
+
+void
+metrics_iteration(const char *engine, size_t iteration, const char *step,
+                  double signature_time, double refine_time, size_t blocks,
+                  size_t signature_nodes, size_t partition_nodes)
+{
+    if (metrics_file == NULL) return;
+    begin_record("iteration");
+    fprintf(metrics_file, ",\"engine\":\"%s\",\"iteration\":%zu", engine, iteration);
+    if (step != NULL) fprintf(metrics_file, ",\"step\":\"%s\"", step);
+    fprintf(metrics_file, ",\"signature_time\":%.6f,\"refine_time\":%.6f,\"blocks\":%zu", signature_time, refine_time, blocks);
+    fprintf(metrics_file, ",\"signature_nodes\":%zu,\"partition_nodes\":%zu", signature_nodes, partition_nodes);
+    end_record();
+}
+
+void
+metrics_phase(const char *phase, double seconds, size_t blocks, size_t nodes)
+{
+    if (metrics_file == NULL) return;
+    begin_record("phase");
+    fprintf(metrics_file, ",\"phase\":\"%s\",\"seconds\":%.6f", phase, seconds);
+    if (blocks != (size_t)-1) fprintf(metrics_file, ",\"blocks\":%zu", blocks);
+    if (nodes != (size_t)-1) fprintf(metrics_file, ",\"nodes\":%zu", nodes);
+    end_record();
+}
+
+}
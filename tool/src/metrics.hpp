@@ -0,0 +1,66 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+
+#ifndef SIGREF_METRICS_H
+#define SIGREF_METRICS_H
+
+namespace sigref {
+
+/**
+ * Machine-readable metrics, written as one JSON record per line.
+ *
+ * Every record has the fields "type" ("iteration" or "phase"), "model", "time" (seconds since
+ * the start), "table_nodes" and "table_size" (occupancy of the nodes table), "cache_hit_rate"
+ * (since the previous record, null unless Sylvan is compiled with SYLVAN_STATS), "gc_count"
+ * and "gc_time" (since the start) and "rss" (bytes).
+ */
+
+/**
+ * Start writing metrics to <filename>; returns false if the file cannot be opened.
+ * Must be called from a Lace task, after sylvan_init_package.
+ */
+bool metrics_open(const char *filename);
+void metrics_close();
+
+/**
+ * True if metrics are written (use this to skip computing node counts otherwise).
+ */
+bool metrics_enabled();
+
+/**
+ * Set the model of the following records.
+ */
+void metrics_model(const char *model);
+
+/**
+ * Record an iteration of the refinement engine <engine>, with <step> "markov" or "interactive"
+ * for the two halves of an IMC iteration (NULL otherwise).
+ */
+void metrics_iteration(const char *engine, size_t iteration, const char *step,
+                       double signature_time, double refine_time, size_t blocks,
+                       size_t signature_nodes, size_t partition_nodes);
+
+/**
+ * Record the phase <phase> (e.g. "read", "refinement", "quotient-transitions") that took <seconds>.
+ * The number of <blocks> and <nodes> of the result are written unless they are (size_t)-1.
+ */
+void metrics_phase(const char *phase, double seconds, size_t blocks = (size_t)-1, size_t nodes = (size_t)-1);
+
+}
+
+#endif
@@ -17,17 +17,20 @@
 #include <sylvan.h>
 #include <sigref.h>
 #include <parse_bdd.hpp>
+#include <parse_xml.hpp>
+#include <input_stream.hpp>
+#include <labels.hpp>
 
 namespace sigref {
 
 using namespace sylvan;
 
-BddLtsParser::BddLtsParser(const char* filename)
+BddLtsParser::BddLtsParser(const char* filename, int tau, const char* label_filename)
 {
-    FILE *f = fopen(filename, "r");
+    InputStream input(filename);
+    FILE *f = input.get();
     if (f == NULL) {
-        fprintf(stderr, "Cannot open file '%s'!\n", filename);
-        return;
+        throw ParseError("[ERROR] Cannot open file " + std::string(filename));
     }
 
     /* Load domain information */
@@ -35,12 +38,15 @@ BddLtsParser::BddLtsParser(const char* filename)
     if ((fread(&numS, sizeof(int), 1, f) != 1) ||
         (fread(&statebits, sizeof(int), 1, f) != 1) ||
         (fread(&numA, sizeof(int), 1, f) != 1)) {
-        fprintf(stderr, "Invalid file format.\n");
-        return;
+        throw ParseError("[ERROR] Invalid file format.");
     }
 
+    int slots = numS;
     numS *= statebits;
 
+    /* The node numbers in the file start at 1, forget those of any previously read file */
+    sylvan_serialize_reset();
+
     /* Compute state, prime, action variables */
     std::vector<uint32_t> bdd_state_vars;
     std::vector<uint32_t> bdd_prime_vars;
@@ -66,8 +72,7 @@ BddLtsParser::BddLtsParser(const char* filename)
     if ((fread(&set_bdd, sizeof(size_t), 1, f) != 1) ||
         (fread(&set_vector_size, sizeof(size_t), 1, f) != 1) ||
         (fread(&set_state_vars, sizeof(size_t), 1, f) != 1)) {
-        fprintf(stderr, "Invalid file format.\n");
-        return;
+        throw ParseError("[ERROR] Invalid file format.");
     }
 
     lts.initialStates = sylvan_serialize_get_reversed(set_bdd);
@@ -76,8 +81,7 @@ BddLtsParser::BddLtsParser(const char* filename)
     /* Load number of transition relations */
     int n_relations;
     if (fread(&n_relations, sizeof(int), 1, f) != 1) {
-        fprintf(stderr, "Invalid file format.\n");
-        return;
+        throw ParseError("[ERROR] Invalid file format.");
     }
 
     /* Load each relation */
@@ -87,8 +91,7 @@ BddLtsParser::BddLtsParser(const char* filename)
         size_t rel_bdd, rel_vars;
         if ((fread(&rel_bdd, sizeof(size_t), 1, f) != 1) ||
             (fread(&rel_vars, sizeof(size_t), 1, f) != 1)) {
-            fprintf(stderr, "Invalid file format.\n");
-            return;
+            throw ParseError("[ERROR] Invalid file format.");
         }
 
         BDD rel = sylvan_serialize_get_reversed(rel_bdd);
@@ -109,8 +112,7 @@ BddLtsParser::BddLtsParser(const char* filename)
         if ((fread(&set_bdd, sizeof(size_t), 1, f) != 1) ||
             (fread(&set_vector_size, sizeof(size_t), 1, f) != 1) ||
             (fread(&set_state_vars, sizeof(size_t), 1, f) != 1)) {
-            fprintf(stderr, "Invalid file format.\n");
-            return;
+            throw ParseError("[ERROR] Invalid file format.");
         }
 
         lts.states = sylvan_serialize_get_reversed(set_bdd);
@@ -123,32 +125,43 @@ BddLtsParser::BddLtsParser(const char* filename)
         for (int i=0; i<actions; i++) {
             uint32_t len;
             if (fread(&len, sizeof(uint32_t), 1, f) != 1) {
-                fprintf(stderr, "Invalid file format.\n");
-                return;
+                throw ParseError("[ERROR] Invalid file format.");
             }
             char s[len+1];
             s[len] = 0;
             if (fread(s, sizeof(char), len, f) != len) {
-                fprintf(stderr, "Invalid file format.\n");
+                throw ParseError("[ERROR] Invalid file format.");
             }
             if (strcmp(s, "tau") == 0) {
-                tau_action = i;
+                tau = i;
             }
+            lts.actions.push_back(s);
         }
     }
 
-    fclose(f);
+    /* A truncated or corrupt compressed file may still contain a complete model */
+    if (!input.finish()) {
+        throw ParseError("[ERROR] Could not load the input file.");
+    }
 
-    /* Compute tau from tau_action (default: 0) */
+    /* Compute tau from the tau action (default: 0) */
     int action_bits = sylvan_set_count(lts.varA.GetBDD());
     std::vector<uint8_t> tau_value;
     for (int i=0; i<action_bits; i++) {
-        tau_value.push_back(tau_action & (1LL<<(action_bits-i-1)) ? 1 : 0);
+        tau_value.push_back(tau & (1LL<<(action_bits-i-1)) ? 1 : 0);
     }
     lts.tau = Bdd::bddCube(lts.varA, tau_value);
 
     /* Default initial partition: just 1 block containing the reachable states */
     lts.initialPartition.push_back(lts.states);
+
+    /* With a label file, one block per combination of labels */
+    if (label_filename != NULL) {
+        LabelSets labels;
+        readLabelFile(label_filename, lts.varS, slots, statebits, labels);
+        labelPartition(labels, lts.initialPartition, lts.initialPartitionLabels);
+        for (auto &label : labels) lts.labels.push_back(label.first);
+    }
 }
 
 BddLtsParser::~BddLtsParser()
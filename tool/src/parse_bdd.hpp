@@ -29,9 +29,15 @@
 
 namespace sigref {
 
+/**
+ * Reader for LTSs in the binary BDD format of LTSmin.
+ *
+ * The initial partition has one block with the reachable states; with a label file
+ * (see readLabelFile), one block for each combination of labels.
+ */
 class BddLtsParser {
 public:
-    BddLtsParser(const char* _filename);
+    BddLtsParser(const char* _filename, int _tau = 0, const char* _label_filename = NULL);
     ~BddLtsParser();
 
     LTS* getLTS() {
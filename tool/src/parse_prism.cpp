@@ -0,0 +1,470 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm> // for std::sort
+#include <cstddef> // to fix errors with gmp
+#include <map>
+#include <string.h>
+#include <unistd.h>
+#include <gmp.h>
+#include <sylvan_gmp.h>
+#include <input_stream.hpp>
+#include <parse_prism.hpp>
+#include <sigref.h>
+
+namespace sigref {
+
+using namespace sylvan;
+
+/**
+ * Read the entire (possibly compressed) file into memory, terminated by a 0 character.
+ * Returns false if the file does not exist.
+ */
+static bool
+read_file(const std::string& filename, std::vector<char>& buffer)
+{
+    InputStream input(filename.c_str());
+    if (input.get() == NULL) return false;
+    std::string contents;
+    if (!input.readAll(contents)) throw ParseError("[ERROR] Could not read " + filename);
+    buffer.assign(contents.begin(), contents.end());
+    buffer.push_back(0);
+    return true;
+}
+
+/**
+ * The file <base><ext>, compressed like the transition matrix (<suffix>) if that file exists.
+ */
+static std::string
+companion_file(const std::string& base, const char *ext, const std::string& suffix)
+{
+    std::string name = base + ext + suffix;
+    if (!suffix.empty() && access(name.c_str(), F_OK) == 0) return name;
+    return base + ext;
+}
+
+static inline void
+skip_spaces(char *&p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+}
+
+static inline void
+skip_line(char *&p)
+{
+    while (*p != 0 && *p != '\n') p++;
+    if (*p == '\n') p++;
+}
+
+static bool
+read_number(char *&p, uint64_t *result)
+{
+    skip_spaces(p);
+    if (*p < '0' || *p > '9') return false;
+    char *end;
+    *result = strtoull(p, &end, 10);
+    p = end;
+    return true;
+}
+
+/**
+ * Parse a rate as written by PRISM ("0.5", "2", "1.0E-4") or a fraction "a/b" into <q>.
+ * The decimal notation is converted exactly, without intermediate floating point.
+ */
+static bool
+parse_rate(const char *s, mpq_t q)
+{
+    if (strchr(s, '/') != NULL) {
+        if (mpq_set_str(q, s, 10) != 0 || mpz_sgn(mpq_denref(q)) == 0) return false;
+        mpq_canonicalize(q);
+        return true;
+    }
+
+    std::string digits;
+    long exponent = 0;
+    const char *p = s;
+    if (*p == '-' || *p == '+') digits.push_back(*p++);
+    bool any = false;
+    while (*p >= '0' && *p <= '9') { digits.push_back(*p++); any = true; }
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') { digits.push_back(*p++); exponent--; any = true; }
+    }
+    if (!any) return false;
+    if (*p == 'e' || *p == 'E') {
+        char *end;
+        exponent += strtol(p+1, &end, 10);
+        if (end == p+1) return false;
+        p = end;
+    }
+    if (*p != 0) return false;
+
+    mpz_t ten;
+    mpz_init(ten);
+    mpq_set_str(q, digits.c_str(), 10);
+    mpz_ui_pow_ui(ten, 10, exponent < 0 ? -exponent : exponent);
+    if (exponent < 0) mpz_mul(mpq_denref(q), mpq_denref(q), ten);
+    else mpz_mul(mpq_numref(q), mpq_numref(q), ten);
+    mpz_clear(ten);
+    mpq_canonicalize(q);
+    return true;
+}
+
+/**
+ * Create the leaf for the rate <s>, which has been validated before.
+ */
+static MTBDD
+make_rate_leaf(const char *s, int leaf_type)
+{
+    if (leaf_type == float_type) return mtbdd_double(strtod(s, NULL));
+
+    mpq_t q;
+    mpq_init(q);
+    parse_rate(s, q);
+    MTBDD result;
+    if (leaf_type == mpq_type) {
+        result = mtbdd_gmp(q);
+    } else {
+        result = mtbdd_fraction(mpz_get_si(mpq_numref(q)), mpz_get_ui(mpq_denref(q)));
+    }
+    mpq_clear(q);
+    return result;
+}
+
+struct prism_transition
+{
+    uint64_t from;
+    uint64_t to;
+    const char *rate;
+};
+
+/**
+ * Build the rate MTBDD of <count> transitions, in parallel by divide and conquer.
+ * State bit i is variable 2*i (from) and 2*i+1 (to).
+ */
+TASK_5(MTBDD, prism_build_rates, prism_transition*, trans, size_t, count, MTBDD, vars, int, bits, int, leaf_type)
+{
+    if (count == 1) {
+        uint8_t arr[2*bits];
+        for (int i=0; i<bits; i++) {
+            arr[2*i] = (trans->from >> i) & 1;
+            arr[2*i+1] = (trans->to >> i) & 1;
+        }
+        MTBDD leaf = make_rate_leaf(trans->rate, leaf_type);
+        mtbdd_refs_push(leaf);
+        MTBDD result = mtbdd_cube(vars, arr, leaf);
+        mtbdd_refs_pop(1);
+        return result;
+    }
+
+    mtbdd_refs_spawn(SPAWN(prism_build_rates, trans, count/2, vars, bits, leaf_type));
+    MTBDD right = mtbdd_refs_push(CALL(prism_build_rates, trans+count/2, count-count/2, vars, bits, leaf_type));
+    MTBDD left = mtbdd_refs_push(mtbdd_refs_sync(SYNC(prism_build_rates)));
+    MTBDD result = leaf_type == mpq_type ? gmp_plus(left, right) : mtbdd_plus(left, right);
+    mtbdd_refs_pop(2);
+    return result;
+}
+
+/**
+ * Build the BDD of a set of <count> states, in parallel by divide and conquer.
+ */
+TASK_4(BDD, prism_build_states, uint64_t*, states, size_t, count, BDD, vars, int, bits)
+{
+    if (count == 0) return sylvan_false;
+    if (count == 1) {
+        uint8_t arr[bits];
+        for (int i=0; i<bits; i++) arr[i] = (*states >> i) & 1;
+        return sylvan_cube(vars, arr);
+    }
+
+    bdd_refs_spawn(SPAWN(prism_build_states, states, count/2, vars, bits));
+    BDD right = bdd_refs_push(CALL(prism_build_states, states+count/2, count-count/2, vars, bits));
+    BDD left = bdd_refs_push(bdd_refs_sync(SYNC(prism_build_states)));
+    BDD result = sylvan_or(left, right);
+    bdd_refs_pop(2);
+    return result;
+}
+
+/**
+ * The BDD of all states with index smaller than <n>.
+ */
+static Bdd
+states_below(uint64_t n, int bits)
+{
+    if (bits >= 64 || n >= (1ULL<<bits)) return Bdd::bddOne();
+    Bdd lt = Bdd::bddZero();
+    Bdd eq = Bdd::bddOne();
+    for (int i=bits-1; i>=0; i--) {
+        Bdd x = Bdd::bddVar(2*i);
+        if ((n >> i) & 1) {
+            lt = lt + (eq * !x);
+            eq = eq * x;
+        } else {
+            eq = eq * !x;
+        }
+    }
+    return lt;
+}
+
+PrismCtmcParser::PrismCtmcParser(const char* filename, LeafType leaf_type) : leaf_type(leaf_type)
+{
+    std::string base = InputStream::stripCompressionSuffix(filename);
+    std::string suffix = std::string(filename).substr(base.size());
+    if (base.size() > 4 && base.compare(base.size()-4, 4, ".tra") == 0) base.resize(base.size()-4);
+
+    /* Read the transition matrix */
+
+    std::string tra = base + ".tra" + suffix;
+    std::vector<char> buffer;
+    if (!read_file(tra, buffer)) {
+        throw ParseError("[ERROR] Could not load the input file.");
+    }
+
+    char *p = buffer.data();
+    uint64_t n_transitions;
+    if (!read_number(p, &n_states) || !read_number(p, &n_transitions) || n_states == 0) {
+        throw ParseError("[ERROR] Invalid header in " + tra);
+    }
+    skip_line(p);
+
+    state_bits = 1;
+    while (state_bits < 64 && (1ULL<<state_bits) < n_states) state_bits++;
+
+    std::vector<prism_transition> transitions;
+    transitions.reserve(n_transitions);
+
+    mpq_t q;
+    mpq_init(q);
+    while (*p != 0) {
+        skip_spaces(p);
+        if (*p == '\n' || *p == 0) {
+            skip_line(p);
+            continue;
+        }
+        prism_transition t;
+        if (!read_number(p, &t.from) || !read_number(p, &t.to)) {
+            mpq_clear(q);
+            throw ParseError("[ERROR] Invalid transition in " + tra);
+        }
+        skip_spaces(p);
+        t.rate = p;
+        while (*p != 0 && *p != '\n' && *p != ' ' && *p != '\t' && *p != '\r') p++;
+        char *end = p;
+        skip_line(p);
+        *end = 0;
+
+        if (t.from >= n_states || t.to >= n_states) {
+            mpq_clear(q);
+            throw ParseError("[ERROR] State out of range in " + tra);
+        }
+
+        /* validate the rate here, so the parallel build does not have to */
+        if (leaf_type == float_type) {
+            char *rate_end;
+            double value = strtod(t.rate, &rate_end);
+            if (rate_end == t.rate || *rate_end != 0) {
+                mpq_clear(q);
+                throw ParseError("[ERROR] String " + std::string(t.rate) + " is not a number");
+            }
+            if (value == 0.0) continue;
+        } else {
+            if (!parse_rate(t.rate, q)) {
+                mpq_clear(q);
+                throw ParseError("[ERROR] String " + std::string(t.rate) + " is not a number");
+            }
+            if (mpq_sgn(q) == 0) continue;
+            if (leaf_type == simple_fraction_type &&
+                    (!mpz_fits_sint_p(mpq_numref(q)) || !mpz_fits_uint_p(mpq_denref(q)))) {
+                mpq_clear(q);
+                throw ParseError("[ERROR] Fraction " + std::string(t.rate) + " does not fit in 32-bit integers");
+            }
+        }
+        transitions.push_back(t);
+    }
+    mpq_clear(q);
+
+    /* Create the variables */
+
+    std::vector<uint32_t> bdd_state_vars;
+    std::vector<uint32_t> bdd_prime_vars;
+    for (int i=0; i<state_bits; i++) {
+        bdd_state_vars.push_back(i*2);
+        bdd_prime_vars.push_back(i*2+1);
+    }
+    ctmc.varS = Bdd::VariablesCube(bdd_state_vars);
+    ctmc.varT = Bdd::VariablesCube(bdd_prime_vars);
+    ctmc.varA = Bdd::bddOne();
+
+    /* Build the rate MTBDD */
+
+    LACE_ME;
+    if (transitions.size() == 0) {
+        ctmc.markov_transitions = Mtbdd::mtbddZero();
+    } else {
+        Bdd vars = ctmc.varS * ctmc.varT;
+        ctmc.markov_transitions = CALL(prism_build_rates, transitions.data(), transitions.size(), vars.GetBDD(), state_bits, leaf_type);
+    }
+    ctmc.states = states_below(n_states, state_bits);
+
+    /* Read the labels and the initial states */
+
+    std::vector<uint32_t> state_combination;
+    std::vector<std::vector<size_t>> combinations;
+    std::vector<uint64_t> initial;
+    readLabels(companion_file(base, ".lab", suffix), state_combination, combinations, initial);
+    checkStates(companion_file(base, ".sta", suffix));
+
+    if (initial.size() == 0) initial.push_back(0);
+    ctmc.initialStates = CALL(prism_build_states, initial.data(), initial.size(), ctmc.varS.GetBDD(), state_bits);
+
+    /* Create one block of the initial partition per combination of labels */
+
+    if (combinations.size() <= 1) {
+        ctmc.initialPartition.push_back(ctmc.states);
+        ctmc.initialPartitionLabels.push_back(combinations.size() == 1 ? combinations[0] : std::vector<size_t>());
+    } else {
+        /* counting sort of the states by combination */
+        std::vector<uint64_t> start(combinations.size()+1, 0);
+        for (uint64_t s=0; s<n_states; s++) start[state_combination[s]+1]++;
+        for (size_t c=0; c<combinations.size(); c++) start[c+1] += start[c];
+        std::vector<uint64_t> sorted(n_states);
+        std::vector<uint64_t> next(start.begin(), start.end()-1);
+        for (uint64_t s=0; s<n_states; s++) sorted[next[state_combination[s]]++] = s;
+
+        for (size_t c=0; c<combinations.size(); c++) {
+            BDD block = CALL(prism_build_states, sorted.data()+start[c], start[c+1]-start[c], ctmc.varS.GetBDD(), state_bits);
+            ctmc.initialPartition.push_back(Bdd(block));
+            ctmc.initialPartitionLabels.push_back(combinations[c]);
+        }
+    }
+
+    INFO("Read %'zu states, %'zu transitions and %'zu labels from %s.", (size_t)n_states, transitions.size(), ctmc.labels.size(), filename);
+}
+
+PrismCtmcParser::~PrismCtmcParser()
+{
+}
+
+/**
+ * Read the labels file, if it exists.
+ * Every state gets the index of its combination of labels in <state_combination>.
+ * The label "init" is not part of a combination; its states are added to <initial>.
+ */
+void
+PrismCtmcParser::readLabels(const std::string& filename, std::vector<uint32_t>& state_combination,
+                            std::vector<std::vector<size_t>>& combinations, std::vector<uint64_t>& initial)
+{
+    std::vector<char> buffer;
+    if (!read_file(filename, buffer)) return;
+
+    /* Header: 0="init" 1="deadlock" ... */
+    char *p = buffer.data();
+    std::map<uint64_t, size_t> label_index; // PRISM label number to index in ctmc.labels
+    uint64_t init_label = (uint64_t)-1;
+    for (;;) {
+        uint64_t number;
+        if (!read_number(p, &number)) break;
+        if (p[0] != '=' || p[1] != '"') throw ParseError("[ERROR] Invalid header in " + filename);
+        p += 2;
+        char *name = p;
+        while (*p != 0 && *p != '"' && *p != '\n') p++;
+        if (*p != '"') throw ParseError("[ERROR] Invalid header in " + filename);
+        std::string label(name, p-name);
+        p++;
+        if (label == "init") {
+            init_label = number;
+        } else {
+            label_index[number] = ctmc.labels.size();
+            ctmc.labels.push_back(label);
+        }
+    }
+    skip_line(p);
+
+    /* Lines: <state>: <label> <label> ... */
+    std::map<std::vector<size_t>, uint32_t> combination_index;
+    const uint32_t none = (uint32_t)-1;
+    state_combination.assign(n_states, none);
+    std::vector<size_t> combination;
+    while (*p != 0) {
+        uint64_t state;
+        if (!read_number(p, &state)) {
+            skip_line(p);
+            continue;
+        }
+        if (*p != ':' || state >= n_states) throw ParseError("[ERROR] Invalid line in " + filename);
+        p++;
+        combination.clear();
+        uint64_t number;
+        while (read_number(p, &number)) {
+            if (number == init_label) {
+                initial.push_back(state);
+                continue;
+            }
+            auto it = label_index.find(number);
+            if (it == label_index.end()) throw ParseError("[ERROR] Unknown label in " + filename);
+            combination.push_back(it->second);
+        }
+        skip_line(p);
+
+        std::sort(combination.begin(), combination.end());
+        auto it = combination_index.find(combination);
+        if (it == combination_index.end()) {
+            it = combination_index.insert(std::make_pair(combination, (uint32_t)combinations.size())).first;
+            combinations.push_back(combination);
+        }
+        state_combination[state] = it->second;
+    }
+
+    /* States without a line have no labels */
+    uint32_t empty = none;
+    for (uint64_t s=0; s<n_states; s++) {
+        if (state_combination[s] != none) continue;
+        if (empty == none) {
+            auto it = combination_index.find(std::vector<size_t>());
+            if (it != combination_index.end()) {
+                empty = it->second;
+            } else {
+                empty = combinations.size();
+                combinations.push_back(std::vector<size_t>());
+            }
+        }
+        state_combination[s] = empty;
+    }
+}
+
+/**
+ * Check the number of states in the states file, if it exists.
+ */
+void
+PrismCtmcParser::checkStates(const std::string& filename)
+{
+    std::vector<char> buffer;
+    if (!read_file(filename, buffer)) return;
+
+    char *p = buffer.data();
+    skip_line(p); // header with the variable names
+    uint64_t count = 0;
+    while (*p != 0) {
+        uint64_t state;
+        if (read_number(p, &state)) count++;
+        skip_line(p);
+    }
+    if (count != n_states) {
+        throw ParseError("[ERROR] Number of states in " + filename + " does not match the transition matrix");
+    }
+}
+
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PARSER_PRISM__HPP__
+#define __PARSER_PRISM__HPP__
+
+#include <string>
+#include <vector>
+
+#include <sylvan.h>
+#include <sylvan_obj.hpp>
+#include <parse_xml.hpp>
+#include <systems.hpp>
+
+namespace sigref {
+
+/**
+ * Reader for CTMCs in the explicit format of PRISM (-exportmodel).
+ *
+ * The transition matrix is read from <base>.tra; labels are read from <base>.lab and
+ * the state count is checked against <base>.sta, if these files exist.
+ * The files may be compressed (.tra.gz or .tra.zst, see InputStream); the .lab and .sta
+ * files are then read with the same suffix if they exist, else without it.
+ * State i is encoded in binary on the state variables, least significant bit first.
+ * The label "init" defines the initial states (default: state 0); all other labels
+ * define the initial partition, with one block per combination of labels.
+ */
+class PrismCtmcParser {
+public:
+    PrismCtmcParser(const char* _filename, LeafType leaf_type);
+    ~PrismCtmcParser();
+
+    CTMC* getCTMC() {
+        return &ctmc;
+    }
+
+private:
+    void readLabels(const std::string& filename, std::vector<uint32_t>& state_combination,
+                    std::vector<std::vector<size_t>>& combinations, std::vector<uint64_t>& initial);
+    void checkStates(const std::string& filename);
+
+    CTMC ctmc;
+    LeafType leaf_type;
+    uint64_t n_states;
+    int state_bits;
+};
+
+} // end namespace sigref
+
+#endif
@@ -7,6 +7,8 @@
 #include <iomanip>
 #include <boost/lexical_cast.hpp>
 #include "parse_xml.hpp"
+#include <input_stream.hpp>
+#include <labels.hpp>
 #include <gmp.h>
 #include <sylvan_gmp.h>
 #include <sigref.h>
@@ -141,12 +143,21 @@ readSimpleFractionAttribute(const TiXmlNode* node, const char* att)
     }
 }
 
-SystemParser::SystemParser(const char* filename, unsigned int verbosity, LeafType leaf_type)
+SystemParser::SystemParser(const char* filename, unsigned int verbosity, LeafType leaf_type, int tau_label,
+                           const char* label_filename)
 {
-    // Open the document
-    TiXmlDocument document = TiXmlDocument(filename);
-    if (!document.LoadFile()) {
-        throw ParseError("[ERROR] Could not load the input file.");
+    // Read the (possibly compressed) document and parse it
+    std::string text;
+    {
+        InputStream input(filename);
+        if (!input.readAll(text)) {
+            throw ParseError("[ERROR] Could not load the input file.");
+        }
+    }
+    TiXmlDocument document;
+    document.Parse(text.c_str());
+    if (document.Error()) {
+        throw ParseError("[ERROR] Could not parse the input file.");
     }
 
     // Get the root node of the XML-document
@@ -171,6 +182,7 @@ SystemParser::SystemParser(const char* filename, unsigned int verbosity, LeafTyp
     TiXmlNode* markovtransNode = NULL;
     TiXmlNode* initialpartitionNode = NULL;
     TiXmlNode* tauNode = NULL;
+    std::vector<TiXmlNode*> labelNodes;
 
     for (TiXmlNode* currentNode = rootNode->FirstChild();
          currentNode != NULL;
@@ -192,6 +204,8 @@ SystemParser::SystemParser(const char* filename, unsigned int verbosity, LeafTyp
                 markovtransNode = currentNode;
             } else if (bdd_type == "tau") {
                 tauNode = currentNode;
+            } else if (bdd_type == "label") {
+                labelNodes.push_back(currentNode);
             }
         } else if (strcmp(name, "initial_partition") == 0) {
             initialpartitionNode = currentNode;
@@ -257,7 +271,7 @@ SystemParser::SystemParser(const char* filename, unsigned int verbosity, LeafTyp
             int action_bits = sylvan_set_count(varA.GetBDD());
             std::vector<uint8_t> tau_value;
             for (int i=0; i<action_bits; i++) {
-                tau_value.push_back(tau_action & (1LL<<(action_bits-i-1)) ? 1 : 0);
+                tau_value.push_back(tau_label & (1LL<<(action_bits-i-1)) ? 1 : 0);
             }
             tau = Bdd::bddCube(varA, tau_value);
         }
@@ -275,6 +289,19 @@ SystemParser::SystemParser(const char* filename, unsigned int verbosity, LeafTyp
             }
         }
         if (initial_partition.size() == 0) initial_partition.push_back(states);
+
+        // Split the initial partition by the labels
+        LabelSets labels;
+        for (TiXmlNode* labelNode : labelNodes) {
+            labels.push_back(std::make_pair(readStringAttribute(labelNode, "name"), nodeToBdd(labelNode)));
+        }
+        if (label_filename != NULL) readLabelFile(label_filename, varS, sylvan_set_count(varS.GetBDD()), 1, labels);
+        std::vector<std::string> label_names;
+        std::vector<std::vector<size_t>> initial_partition_labels;
+        if (labels.size() > 0) {
+            labelPartition(labels, initial_partition, initial_partition_labels);
+            for (auto &label : labels) label_names.push_back(label.first);
+        }
         if (verbosity > 0) std::cout << "finished." << std::endl;
 
         // Fill the right system with information
@@ -285,6 +312,8 @@ SystemParser::SystemParser(const char* filename, unsigned int verbosity, LeafTyp
             lts.tau = tau;
             lts.initialStates = initial_state;
             lts.initialPartition = initial_partition;
+            lts.labels = label_names;
+            lts.initialPartitionLabels = initial_partition_labels;
             lts.varS = varS;
             lts.varT = varT;
             lts.varA = varA;
@@ -297,6 +326,8 @@ SystemParser::SystemParser(const char* filename, unsigned int verbosity, LeafTyp
             imc.tau = tau;
             imc.initialStates = initial_state;
             imc.initialPartition = initial_partition;
+            imc.labels = label_names;
+            imc.initialPartitionLabels = initial_partition_labels;
             imc.varS = varS;
             imc.varT = varT;
             imc.varA = varA;
@@ -307,6 +338,8 @@ SystemParser::SystemParser(const char* filename, unsigned int verbosity, LeafTyp
             ctmc.states = states;
             ctmc.initialStates = initial_state;
             ctmc.initialPartition = initial_partition;
+            ctmc.labels = label_names;
+            ctmc.initialPartitionLabels = initial_partition_labels;
             ctmc.varS = varS;
             ctmc.varT = varT;
             break;
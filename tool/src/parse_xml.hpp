@@ -53,9 +53,17 @@ typedef enum {
     mpq_type = 2,
 } LeafType;
 
+/**
+ * Reader for LTSs, CTMCs and IMCs in the XML format of SigrefMC.
+ *
+ * The initial partition is given by <initial_partition> (default: one block with all states).
+ * Labels, given as <dd type="label" name="..."> or in a label file (see readLabelFile),
+ * split the initial partition into one block for each combination of labels.
+ */
 class SystemParser {
 public:
-    SystemParser(const char* _filename, unsigned int _verbosity, LeafType leaf_type);
+    SystemParser(const char* _filename, unsigned int _verbosity, LeafType leaf_type, int _tau_label = 0,
+                 const char* _label_filename = NULL);
     ~SystemParser();
 
     SystemType getType() const {
@@ -21,6 +21,7 @@
 #include <quotient.hpp>
 #include <refine.h>
 #include <blocks.h>
+#include <metrics.hpp>
 #include <sigref_util.hpp>
 
 namespace sigref {
@@ -44,7 +45,7 @@ TASK_DECL_4(MTBDD, cubes_to_st, MTBDD, MTBDD, MTBDD, int);
  * Also removes tau steps if tau is not set to False but to the tau action.
  */
 TASK_DECL_5(BDD, compute_trans_quotient, BDD, BDD, BDD, BDD, BDD);
-#define compute_trans_quotient(dd, left, right, st_vars, tau) CALL(compute_trans_quotient, dd, left, right, st_vars, tau)
+#define compute_trans_quotient(dd, left, right, st_vars, tau) sigref_op_timed(SIGREF_OP_TRANS_QUOTIENT, BDD, CALL(compute_trans_quotient, dd, left, right, st_vars, tau))
 
 /**
  * Perform several steps for Markov computation in one step.
@@ -60,8 +61,8 @@ TASK_DECL_5(BDD, compute_trans_quotient, BDD, BDD, BDD, BDD, BDD);
  * map_b_to_t: mapping (for compose) from B to t
  * map_b_to_s: mapping (for compose) from B to s
  */
-TASK_DECL_5(MTBDD, compute_markov_quotient, MTBDD, BDD, BDD, BDD, BDD);
-#define compute_markov_quotient(dd, left, s_vars, map_b_to_t, map_b_to_s) CALL(compute_markov_quotient, dd, left, s_vars, map_b_to_t, map_b_to_s)
+TASK_DECL_6(MTBDD, compute_markov_quotient, sigref_context*, MTBDD, BDD, BDD, BDD, BDD);
+#define compute_markov_quotient(ctx, dd, left, s_vars, map_b_to_t, map_b_to_s) sigref_op_timed(SIGREF_OP_MARKOV_QUOTIENT, MTBDD, CALL(compute_markov_quotient, ctx, dd, left, s_vars, map_b_to_t, map_b_to_s))
 
 /**
  * Our custom algorithm to minimize a set of states.
@@ -76,26 +77,26 @@ TASK_DECL_4(BDD, compute_states_quotient, BDD, BDD, BDD, BDD);
 /**
  * Wimmer's algorithm to minimize a Markov transition relation
  */
-TASK_DECL_3(MTBDD, translate_markov, StateSystem&, MTBDD, BDD);
-#define translate_markov(system, markov_trans, partition) CALL(translate_markov, system, markov_trans, partition)
+TASK_DECL_4(MTBDD, translate_markov, sigref_context*, StateSystem&, MTBDD, BDD);
+#define translate_markov(ctx, system, markov_trans, partition) CALL(translate_markov, ctx, system, markov_trans, partition)
 
 /**
  * Wimmer's old algorithm to minimize an interactive transition relation
  */
-TASK_DECL_4(MTBDD, translate_trans_1, LTS&, BDD, BDD, BDD);
-#define translate_trans_1(system, trans, partition, tau) CALL(translate_trans_1, system, trans, partition, tau)
+TASK_DECL_5(MTBDD, translate_trans_1, sigref_context*, LTS&, BDD, BDD, BDD);
+#define translate_trans_1(ctx, system, trans, partition, tau) CALL(translate_trans_1, ctx, system, trans, partition, tau)
 
 /**
  * Wimmer's improved algorithm to minimize an interactive transition relation
  */
-TASK_DECL_4(MTBDD, translate_trans_2, LTS&, BDD, BDD, BDD);
-#define translate_trans_2(system, trans, partition, tau) CALL(translate_trans_2, system, trans, partition, tau)
+TASK_DECL_5(MTBDD, translate_trans_2, sigref_context*, LTS&, BDD, BDD, BDD);
+#define translate_trans_2(ctx, system, trans, partition, tau) CALL(translate_trans_2, ctx, system, trans, partition, tau)
 
 /**
  * Wimmer's algorithm to minimize a set of states
  */
-TASK_DECL_3(BDD, translate_states, StateSystem&, BDD, BDD);
-#define translate_states(system, states, partition) CALL(translate_states, system, states, partition)
+TASK_DECL_4(BDD, translate_states, sigref_context*, StateSystem&, BDD, BDD);
+#define translate_states(ctx, system, states, partition) CALL(translate_states, ctx, system, states, partition)
 
 /**
  * Print all states to stdout
@@ -110,21 +111,22 @@ void enumerate_markov_transitions(MTBDD trans, StateSystem &system);
 /**
  * Print the partition to stdout
  */
-VOID_TASK_DECL_2(enumerate_partition, BDD, BDD);
-#define enumerate_partition(partition, prime_vars) CALL(enumerate_partition, partition, prime_vars)
+VOID_TASK_DECL_3(enumerate_partition, sigref_context*, BDD, BDD);
+#define enumerate_partition(ctx, partition, prime_vars) CALL(enumerate_partition, ctx, partition, prime_vars)
 
 /*
  * Implementations for internal methods that implement minimization
  */
 
 static BDD *block_encoding = NULL;
+static size_t be_block_count;
 static int be_state_length;
 static BDD be_state_variables;
 
 /**
  * Helper function to pick a state for each block.
  */
-VOID_TASK_2(partition_enum, MTBDD, dd, mtbdd_enum_trace_t, trace)
+VOID_TASK_3(partition_enum, sigref_context*, ctx, MTBDD, dd, mtbdd_enum_trace_t, trace)
 {
     if (dd == mtbdd_false) return;
 
@@ -135,7 +137,7 @@ VOID_TASK_2(partition_enum, MTBDD, dd, mtbdd_enum_trace_t, trace)
     mtbddnode_t ndd = MTBDD_GETNODE(dd);
     uint32_t var = mtbddnode_getvariable(ndd);
 
-    if (var >= block_base) {
+    if (var >= ctx->block_base) {
         uint64_t block = CALL(decode_block, dd);
 
         uint8_t new_state[be_state_length];
@@ -157,8 +159,8 @@ VOID_TASK_2(partition_enum, MTBDD, dd, mtbdd_enum_trace_t, trace)
 
     struct mtbdd_enum_trace t0 = (struct mtbdd_enum_trace){trace, var, 0};
     struct mtbdd_enum_trace t1 = (struct mtbdd_enum_trace){trace, var, 1};
-    SPAWN(partition_enum, node_getlow(dd, ndd), &t0);
-    CALL(partition_enum, node_gethigh(dd, ndd), &t1);
+    SPAWN(partition_enum, ctx, node_getlow(dd, ndd), &t0);
+    CALL(partition_enum, ctx, node_gethigh(dd, ndd), &t1);
     SYNC(partition_enum);
 }
 
@@ -170,7 +172,7 @@ TASK_1(MTBDD, convert_partition, MTBDD, block)
 {
     if (block == mtbdd_false) return mtbdd_false;
     uint64_t block_number = CALL(decode_block, block);
-    assert(block_number > 0 && block_number <= count_blocks());
+    assert(block_number > 0 && block_number <= be_block_count);
     assert(block_encoding[block_number] != mtbdd_false);
     return block_encoding[block_number];
 }
@@ -178,37 +180,38 @@ TASK_1(MTBDD, convert_partition, MTBDD, block)
 /**
  * Convert a partition from block encoding to random-state encoding.
  */
-TASK_2(MTBDD, create_pick_partition, BDD, partition, BDD, t_vars)
+TASK_3(MTBDD, create_pick_partition, sigref_context*, ctx, BDD, partition, BDD, t_vars)
 {
     INFO("Picking a state for each block...");
 
     /* allocate some memory and prepare variables */
-    size_t n_blocks = count_blocks();
+    size_t n_blocks = count_blocks(ctx);
     block_encoding = (BDD*)calloc(sizeof(BDD), n_blocks + 1);
+    be_block_count = n_blocks;
     be_state_length = sylvan_set_count(t_vars);
-    BDD tb_vars = sylvan_and(t_vars, block_variables);
+    BDD tb_vars = sylvan_and(t_vars, ctx->block_variables);
     mtbdd_refs_push(tb_vars);
 
     /* create new state variables (using block number variables) */
     be_state_variables = mtbdd_true;
     for (int i=0; i<be_state_length; i++) {
         mtbdd_refs_push(be_state_variables);
-        be_state_variables = mtbdd_makenode(block_base+2*(be_state_length-i-1), mtbdd_false, be_state_variables);
+        be_state_variables = mtbdd_makenode(ctx->block_base+2*(be_state_length-i-1), mtbdd_false, be_state_variables);
         mtbdd_refs_pop(1);
     }
     mtbdd_refs_push(be_state_variables);
 
     /* pick a random state for each block */
-    CALL(partition_enum, partition, NULL);
+    CALL(partition_enum, ctx, partition, NULL);
     //mtbdd_enum_par(partition, TASK(partition_enum), NULL);
 
     mtbdd_refs_pop(2);  // be_state_variables, tb_vars
 
     /* set block info to new be_state info */
-    block_length = be_state_length;
-    sylvan_deref(block_variables);
-    block_variables = be_state_variables;
-    sylvan_ref(block_variables);
+    ctx->block_length = be_state_length;
+    sylvan_deref(ctx->block_variables);
+    ctx->block_variables = be_state_variables;
+    sylvan_ref(ctx->block_variables);
 
     INFO("Converting the partition...");
 
@@ -300,9 +303,12 @@ TASK_IMPL_5(BDD, compute_trans_quotient, BDD, dd, BDD, left, BDD, right, BDD, st
 
     sylvan_gc_test();
 
+    sigref_op_count(SIGREF_OP_TRANS_QUOTIENT);
+
     BDD result;
     /* assumption: st_vars does not change during quotient computation */
     if (cache_get3(CACHE_TRANS_QUOTIENT, dd, left, right, &result)) {
+        sigref_op_cached(SIGREF_OP_TRANS_QUOTIENT);
         return result;
     }
 
@@ -338,7 +344,7 @@ TASK_IMPL_5(BDD, compute_trans_quotient, BDD, dd, BDD, left, BDD, right, BDD, st
         result = cubes_to_st(left, right, result);
 
         /* cache and return */
-        cache_put3(CACHE_TRANS_QUOTIENT, dd, left, right, result);
+        if (cache_put3(CACHE_TRANS_QUOTIENT, dd, left, right, result)) sigref_op_cachedput(SIGREF_OP_TRANS_QUOTIENT);
         return result;
     }
 
@@ -385,7 +391,7 @@ TASK_IMPL_5(BDD, compute_trans_quotient, BDD, dd, BDD, left, BDD, right, BDD, st
     mtbdd_refs_pop(2);
 
     /* cache result */
-    cache_put3(CACHE_TRANS_QUOTIENT, dd, left, right, result);
+    if (cache_put3(CACHE_TRANS_QUOTIENT, dd, left, right, result)) sigref_op_cachedput(SIGREF_OP_TRANS_QUOTIENT);
 
     return result;
 }
@@ -401,7 +407,7 @@ TASK_IMPL_5(BDD, compute_trans_quotient, BDD, dd, BDD, left, BDD, right, BDD, st
  * s_vars: all s variables
  * map: mapping (for compose) from B to t
  */
-TASK_IMPL_5(MTBDD, compute_markov_quotient, MTBDD, dd, BDD, left, BDD, s_vars, BDD, map_b_to_t, BDD, map_b_to_s)
+TASK_IMPL_6(MTBDD, compute_markov_quotient, sigref_context*, ctx, MTBDD, dd, BDD, left, BDD, s_vars, BDD, map_b_to_t, BDD, map_b_to_s)
 {
     /* left follows source state, right follows target state */
     /* left/right defined on t and B, dd defined on s,t and then a or rate */
@@ -427,9 +433,12 @@ TASK_IMPL_5(MTBDD, compute_markov_quotient, MTBDD, dd, BDD, left, BDD, s_vars, B
 
     sylvan_gc_test();
 
+    sigref_op_count(SIGREF_OP_MARKOV_QUOTIENT);
+
     BDD result;
     /* assume maps are stable */
     if (cache_get3(CACHE_MARKOV_QUOTIENT, dd, left, s_vars, &result)) {
+        sigref_op_cached(SIGREF_OP_MARKOV_QUOTIENT);
         return result;
     }
 
@@ -449,7 +458,7 @@ TASK_IMPL_5(MTBDD, compute_markov_quotient, MTBDD, dd, BDD, left, BDD, s_vars, B
         mtbdd_refs_pop(2);  // part, result
 
         /* cache and return */
-        cache_put3(CACHE_MARKOV_QUOTIENT, dd, left, s_vars, result);
+        if (cache_put3(CACHE_MARKOV_QUOTIENT, dd, left, s_vars, result)) sigref_op_cachedput(SIGREF_OP_MARKOV_QUOTIENT);
         return result;
     }
 
@@ -471,20 +480,20 @@ TASK_IMPL_5(MTBDD, compute_markov_quotient, MTBDD, dd, BDD, left, BDD, s_vars, B
     }
 
     /* compute recursive results */
-    mtbdd_refs_spawn(SPAWN(compute_markov_quotient, dd_low, left_low, sylvan_set_next(s_vars), map_b_to_t, map_b_to_s));
-    MTBDD high = CALL(compute_markov_quotient, dd_high, left_high, sylvan_set_next(s_vars), map_b_to_t, map_b_to_s);
+    mtbdd_refs_spawn(SPAWN(compute_markov_quotient, ctx, dd_low, left_low, sylvan_set_next(s_vars), map_b_to_t, map_b_to_s));
+    MTBDD high = CALL(compute_markov_quotient, ctx, dd_high, left_high, sylvan_set_next(s_vars), map_b_to_t, map_b_to_s);
     mtbdd_refs_push(high);
     MTBDD low = mtbdd_refs_sync(SYNC(compute_markov_quotient));
     mtbdd_refs_push(low);
 
     /* unprimed, so take the max */
-    if (leaftype == 2) result = gmp_max(low, high);
+    if (ctx->options.leaftype == 2) result = gmp_max(low, high);
     else result = mtbdd_max(low, high);
 
     mtbdd_refs_pop(2);  // low, high
 
     /* cache result */
-    cache_put3(CACHE_MARKOV_QUOTIENT, dd, left, s_vars, result);
+    if (cache_put3(CACHE_MARKOV_QUOTIENT, dd, left, s_vars, result)) sigref_op_cachedput(SIGREF_OP_MARKOV_QUOTIENT);
 
     return result;
 }
@@ -574,7 +583,7 @@ TASK_IMPL_4(BDD, compute_states_quotient, BDD, dd, BDD, part, BDD, s_vars, BDD,
 /**
  * Minimize a Markov transition relation using the same algorithm as Wimmer
  */
-TASK_IMPL_3(MTBDD, translate_markov, StateSystem&, system, MTBDD, markov_trans, BDD, partition)
+TASK_IMPL_4(MTBDD, translate_markov, sigref_context*, ctx, StateSystem&, system, MTBDD, markov_trans, BDD, partition)
 {
     /* markov_trans ::= (s, t) => Rate, partition ::= (t, B) */
 
@@ -582,15 +591,15 @@ TASK_IMPL_3(MTBDD, translate_markov, StateSystem&, system, MTBDD, markov_trans,
 
     /* r1 := \exists_sum t: T(s, t) \and P(t, B) */
     MTBDD r1;
-    if (leaftype == 2) r1 = gmp_and_exists(markov_trans, partition, system.getVarT().GetBDD());
+    if (ctx->options.leaftype == 2) r1 = gmp_and_exists(markov_trans, partition, system.getVarT().GetBDD());
     else r1 = mtbdd_and_exists(markov_trans, partition, system.getVarT().GetBDD());
     mtbdd_refs_push(r1);
 
     /* r1 := r1[B -> t] */
     MTBDDMAP map = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map);
-        map = mtbdd_map_add(map, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2+1));
+        map = mtbdd_map_add(map, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2+1));
         mtbdd_refs_pop(1);
     }
 
@@ -604,16 +613,16 @@ TASK_IMPL_3(MTBDD, translate_markov, StateSystem&, system, MTBDD, markov_trans,
     mtbdd_refs_push(ps);
 
     /* r1 := \exists_max s: T(s, t) \and P(s, B) */
-    if (leaftype == 2) r1 = gmp_and_abstract_max(r1, ps, system.getVarS().GetBDD());
+    if (ctx->options.leaftype == 2) r1 = gmp_and_abstract_max(r1, ps, system.getVarS().GetBDD());
     else r1 = mtbdd_and_abstract_max(r1, ps, system.getVarS().GetBDD());
     mtbdd_refs_pop(2);
     mtbdd_refs_push(r1);
 
     /* r1 := r1[B -> s] */
     map = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map);
-        map = mtbdd_map_add(map, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2));
+        map = mtbdd_map_add(map, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2));
         mtbdd_refs_pop(1);
     }
 
@@ -627,7 +636,7 @@ TASK_IMPL_3(MTBDD, translate_markov, StateSystem&, system, MTBDD, markov_trans,
 /**
  * Minimize an interactive transition relation using the same algorithm as Wimmer (variant 1)
  */
-TASK_IMPL_4(MTBDD, translate_trans_1, LTS&, system, BDD, trans, BDD, partition, BDD, tau)
+TASK_IMPL_5(MTBDD, translate_trans_1, sigref_context*, ctx, LTS&, system, BDD, trans, BDD, partition, BDD, tau)
 {
     /* trans ::= (s, t, a), partition ::= (t, B) */
 
@@ -637,9 +646,9 @@ TASK_IMPL_4(MTBDD, translate_trans_1, LTS&, system, BDD, trans, BDD, partition,
 
     /* r1 := r1[B -> t] */
     MTBDDMAP map = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map);
-        map = mtbdd_map_add(map, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2+1));
+        map = mtbdd_map_add(map, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2+1));
         mtbdd_refs_pop(1);
     }
 
@@ -659,9 +668,9 @@ TASK_IMPL_4(MTBDD, translate_trans_1, LTS&, system, BDD, trans, BDD, partition,
 
     /* r1 := r1[B -> s] */
     map = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map);
-        map = mtbdd_map_add(map, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2));
+        map = mtbdd_map_add(map, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2));
         mtbdd_refs_pop(1);
     }
 
@@ -673,10 +682,10 @@ TASK_IMPL_4(MTBDD, translate_trans_1, LTS&, system, BDD, trans, BDD, partition,
     /* remove tau self-loops */
     if (tau != mtbdd_false) {
         BDD inerttau = tau;
-        for (int i=0; i<block_length; i++) {
-            BDD low = sylvan_makenode((block_length-i-1)*2+1, inerttau, sylvan_false);
-            BDD high = sylvan_makenode((block_length-i-1)*2+1, sylvan_false, inerttau);
-            inerttau = sylvan_makenode((block_length-i-1)*2, low, high);
+        for (int i=0; i<ctx->block_length; i++) {
+            BDD low = sylvan_makenode((ctx->block_length-i-1)*2+1, inerttau, sylvan_false);
+            BDD high = sylvan_makenode((ctx->block_length-i-1)*2+1, sylvan_false, inerttau);
+            inerttau = sylvan_makenode((ctx->block_length-i-1)*2, low, high);
         }
         mtbdd_refs_push(inerttau);
         r1 = sylvan_and(r1, sylvan_not(inerttau));
@@ -690,7 +699,7 @@ TASK_IMPL_4(MTBDD, translate_trans_1, LTS&, system, BDD, trans, BDD, partition,
 /**
  * Minimize an interactive transition relation using the same algorithm as Wimmer (variant 2)
  */
-TASK_IMPL_4(MTBDD, translate_trans_2, LTS&, system, BDD, trans, BDD, partition, BDD, tau)
+TASK_IMPL_5(MTBDD, translate_trans_2, sigref_context*, ctx, LTS&, system, BDD, trans, BDD, partition, BDD, tau)
 {
     /* trans ::= (s, t, a), partition ::= (t, B) */
 
@@ -717,8 +726,8 @@ TASK_IMPL_4(MTBDD, translate_trans_2, LTS&, system, BDD, trans, BDD, partition,
 
     /* r1 := r1[s->t, B -> B'] */
     MTBDDMAP map = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
-        map = mtbdd_map_add(map, block_base + 2*(block_length-i-1), sylvan_ithvar(block_base + 2*(block_length-i-1)+1));
+    for (int i=0; i<ctx->block_length; i++) {
+        map = mtbdd_map_add(map, ctx->block_base + 2*(ctx->block_length-i-1), sylvan_ithvar(ctx->block_base + 2*(ctx->block_length-i-1)+1));
     }
     for (int i=0; i<state_length; i++) {
         map = mtbdd_map_add(map, 2*(state_length-i-1), sylvan_ithvar(2*(state_length-i-1)+1));
@@ -731,9 +740,9 @@ TASK_IMPL_4(MTBDD, translate_trans_2, LTS&, system, BDD, trans, BDD, partition,
 
     /* r1 := r1[B -> s, B' -> t] */
     map = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
-        map = mtbdd_map_add(map, block_base+2*(block_length-i-1)+1, sylvan_ithvar((block_length-i-1)*2+1));
-        map = mtbdd_map_add(map, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2));
+    for (int i=0; i<ctx->block_length; i++) {
+        map = mtbdd_map_add(map, ctx->block_base+2*(ctx->block_length-i-1)+1, sylvan_ithvar((ctx->block_length-i-1)*2+1));
+        map = mtbdd_map_add(map, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2));
     }
 
     r1 = sylvan_compose(r1, map);
@@ -741,10 +750,10 @@ TASK_IMPL_4(MTBDD, translate_trans_2, LTS&, system, BDD, trans, BDD, partition,
     /* remove tau self-loops */
     if (tau != mtbdd_false) {
         BDD inerttau = tau;
-        for (int i=0; i<block_length; i++) {
-            BDD low = sylvan_makenode((block_length-i-1)*2+1, inerttau, sylvan_false);
-            BDD high = sylvan_makenode((block_length-i-1)*2+1, sylvan_false, inerttau);
-            inerttau = sylvan_makenode((block_length-i-1)*2, low, high);
+        for (int i=0; i<ctx->block_length; i++) {
+            BDD low = sylvan_makenode((ctx->block_length-i-1)*2+1, inerttau, sylvan_false);
+            BDD high = sylvan_makenode((ctx->block_length-i-1)*2+1, sylvan_false, inerttau);
+            inerttau = sylvan_makenode((ctx->block_length-i-1)*2, low, high);
         }
         r1 = sylvan_and(r1, sylvan_not(inerttau));
     }
@@ -752,7 +761,7 @@ TASK_IMPL_4(MTBDD, translate_trans_2, LTS&, system, BDD, trans, BDD, partition,
     return r1;
 }
 
-TASK_IMPL_3(BDD, translate_states, StateSystem&, system, BDD, states, BDD, partition)
+TASK_IMPL_4(BDD, translate_states, sigref_context*, ctx, StateSystem&, system, BDD, states, BDD, partition)
 {
     /* ps := P(s, B) */
     /* note that this step is probably free (in cache) */
@@ -766,9 +775,9 @@ TASK_IMPL_3(BDD, translate_states, StateSystem&, system, BDD, states, BDD, parti
 
     /* r1 := r1[B -> s] */
     MTBDDMAP map = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map);
-        map = mtbdd_map_add(map, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2));
+        map = mtbdd_map_add(map, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2));
         mtbdd_refs_pop(1);
     }
 
@@ -783,7 +792,7 @@ TASK_IMPL_3(BDD, translate_states, StateSystem&, system, BDD, states, BDD, parti
 /**
  * Trim unneeded block variables from the partition.
  */
-TASK_IMPL_1(BDD, trim_block_variables, BDD, partition)
+TASK_IMPL_2(BDD, trim_block_variables, sigref_context*, ctx, BDD, partition)
 {
     INFO("Trimming unneeded block variables...");
 
@@ -791,7 +800,7 @@ TASK_IMPL_1(BDD, trim_block_variables, BDD, partition)
      * compute new block length
      */
     int new_block_length = 0;
-    size_t block_bits = count_blocks();  // highest number
+    size_t block_bits = count_blocks(ctx);  // highest number
     while (block_bits != 0) {
         new_block_length++;
         block_bits>>=1;
@@ -801,20 +810,20 @@ TASK_IMPL_1(BDD, trim_block_variables, BDD, partition)
      * update partition to lose excessive block variables
      */
     BDD constraint = mtbdd_true;
-    for (int i=new_block_length; i<block_length; i++) {
-        constraint = mtbdd_makenode(block_base+2*(new_block_length+block_length-i-1), constraint, mtbdd_false);
+    for (int i=new_block_length; i<ctx->block_length; i++) {
+        constraint = mtbdd_makenode(ctx->block_base+2*(new_block_length+ctx->block_length-i-1), constraint, mtbdd_false);
     }
-    block_length = new_block_length;
+    ctx->block_length = new_block_length;
 
     /*
      * create new block_variables
      */
-    sylvan_deref(block_variables);
-    block_variables = mtbdd_true;
-    for (int i=0; i<block_length; i++) {
-        block_variables = mtbdd_makenode(block_base+2*(block_length-i-1), mtbdd_false, block_variables);
+    sylvan_deref(ctx->block_variables);
+    ctx->block_variables = mtbdd_true;
+    for (int i=0; i<ctx->block_length; i++) {
+        ctx->block_variables = mtbdd_makenode(ctx->block_base+2*(ctx->block_length-i-1), mtbdd_false, ctx->block_variables);
     }
-    sylvan_ref(block_variables);
+    sylvan_ref(ctx->block_variables);
 
     mtbdd_refs_push(constraint);
     partition = sylvan_constrain(partition, constraint);
@@ -826,7 +835,7 @@ TASK_IMPL_1(BDD, trim_block_variables, BDD, partition)
 /**
  * Compute the new state space for block encoding using a fast method.
  */
-TASK_1(BDD, new_state_space, uint64_t, highest_block)
+TASK_2(BDD, new_state_space, sigref_context*, ctx, uint64_t, highest_block)
 {
     /* block encoding is: first variable is lowest */
 
@@ -857,15 +866,15 @@ TASK_1(BDD, new_state_space, uint64_t, highest_block)
     //                         100001
 
     BDD result = mtbdd_false;  // everything... except block 0
-    for (int i=0; i<block_length; i++) {
-        result = mtbdd_makenode(2*(block_length-i-1), result, mtbdd_true);
+    for (int i=0; i<ctx->block_length; i++) {
+        result = mtbdd_makenode(2*(ctx->block_length-i-1), result, mtbdd_true);
     }
 
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         if ((highest_block & (1ULL<<i)) == 0) {
             /* take all higher as they are, and set ith to "1" */
             BDD exception = mtbdd_true;
-            for (int j=block_length-1; j>i; j--) {
+            for (int j=ctx->block_length-1; j>i; j--) {
                 /* begin with highest */
                 if (highest_block & (1ULL<<j)) {
                     exception = mtbdd_makenode(2*j, mtbdd_false, exception);
@@ -885,7 +894,7 @@ TASK_1(BDD, new_state_space, uint64_t, highest_block)
 /**
  * Minimize a CTMC using standard BDD operations
  */
-void Minimizations::minimize1(CTMC &ctmc, BDD partition)
+void Minimizations::minimize1(sigref_context *ctx, CTMC &ctmc, BDD partition)
 {
     LACE_ME;
 
@@ -898,7 +907,7 @@ void Minimizations::minimize1(CTMC &ctmc, BDD partition)
     double t1 = wctime();
 
     /* compute using standard operations */
-    ctmc.markov_transitions = translate_markov(ctmc, ctmc.getMarkovTransitions().GetMTBDD(), partition);
+    ctmc.markov_transitions = translate_markov(ctx, ctmc, ctmc.getMarkovTransitions().GetMTBDD(), partition);
 
     double t2 = wctime();
 
@@ -907,8 +916,8 @@ void Minimizations::minimize1(CTMC &ctmc, BDD partition)
 
     INFO("Computing new states, initial states, initial partition...");
 
-    ctmc.initialStates = CALL(translate_states, ctmc, ctmc.getInitialStates().GetBDD(), partition);
-    ctmc.states = CALL(new_state_space, count_blocks());
+    ctmc.initialStates = CALL(translate_states, ctx, ctmc, ctmc.getInitialStates().GetBDD(), partition);
+    ctmc.states = CALL(new_state_space, ctx, count_blocks(ctx));
 
     int ip_size = ctmc.initialPartition.size();
     if (ip_size == 0) {
@@ -918,42 +927,46 @@ void Minimizations::minimize1(CTMC &ctmc, BDD partition)
     } else if (ip_size == 2) {
         /* only compute first block, then second block is the rest */
         Bdd first = ctmc.initialPartition[0];
-        first = CALL(translate_states, ctmc, first.GetBDD(), partition);
+        first = CALL(translate_states, ctx, ctmc, first.GetBDD(), partition);
         ctmc.initialPartition[0] = first;
         ctmc.initialPartition[1] = ctmc.states * !first;
     } else {
         /* translate each set of states */
         for (int i=0; i<ip_size; i++) {
-            ctmc.initialPartition[i] = CALL(translate_states, ctmc, ctmc.initialPartition[i].GetBDD(), partition);
+            ctmc.initialPartition[i] = CALL(translate_states, ctx, ctmc, ctmc.initialPartition[i].GetBDD(), partition);
         }
     }
 
     /* recreate variable sets */
     MTBDD state_vars = mtbdd_true;
     MTBDD prime_vars = mtbdd_true;
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(state_vars);
         mtbdd_refs_push(prime_vars);
-        state_vars = mtbdd_set_add(state_vars, (block_length-i-1)*2);
-        prime_vars = mtbdd_set_add(prime_vars, (block_length-i-1)*2+1);
+        state_vars = mtbdd_set_add(state_vars, (ctx->block_length-i-1)*2);
+        prime_vars = mtbdd_set_add(prime_vars, (ctx->block_length-i-1)*2+1);
         mtbdd_refs_pop(2);  // state_vars, prime_vars
     }
     ctmc.varS = state_vars;
     ctmc.varT = prime_vars;
 
+    double t3 = wctime();
+
     sylvan_stats_t s3;
     sylvan_stats_snapshot(&s3);
 
     /* report times */
     INFO("");
     INFO("Time for computing the quotient of the transition relation: %'0.2f sec.", t2-t1);
+    metrics_phase("quotient-transitions", t2-t1, count_blocks(ctx));
+    metrics_phase("quotient-states", t3-t2);
 
     /* report number of created/reused nodes */
     {
         size_t created_nodes = s2.counters[BDD_NODES_CREATED] - s1.counters[BDD_NODES_CREATED];
         size_t reused_nodes = s2.counters[BDD_NODES_REUSED] - s1.counters[BDD_NODES_REUSED];
         INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             size_t created_nodes = s3.counters[BDD_NODES_CREATED] - s2.counters[BDD_NODES_CREATED];
             size_t reused_nodes = s3.counters[BDD_NODES_REUSED] - s2.counters[BDD_NODES_REUSED];
             INFO("Number of MTBDD nodes created: %'zu (%'zu new, %'zu reused).", created_nodes + reused_nodes, created_nodes, reused_nodes);
@@ -963,21 +976,21 @@ void Minimizations::minimize1(CTMC &ctmc, BDD partition)
     /* report sizes of new ctmc */
     {
         MTBDD trans = ctmc.markov_transitions.GetMTBDD();
-        double trans_count = mtbdd_satcount(trans, block_length * 2);
+        double trans_count = mtbdd_satcount(trans, ctx->block_length * 2);
         size_t node_count = mtbdd_nodecount(trans);
         INFO("New Markov transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
-        if (verbosity >= 1) {
-            INFO("New initial states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.initialStates.GetBDD(), block_length), mtbdd_nodecount(ctmc.initialStates.GetBDD()));
-            INFO("New states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.states.GetBDD(), block_length), mtbdd_nodecount(ctmc.states.GetBDD()));
+        if (ctx->options.verbosity >= 1) {
+            INFO("New initial states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.initialStates.GetBDD(), ctx->block_length), mtbdd_nodecount(ctmc.initialStates.GetBDD()));
+            INFO("New states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.states.GetBDD(), ctx->block_length), mtbdd_nodecount(ctmc.states.GetBDD()));
             int ip_size = ctmc.initialPartition.size();
             for (int i=0; i<ip_size; i++) {
-                INFO("New initial partition [%d]: %'0.0f states, %'zu MTBDD nodes.", i, mtbdd_satcount(ctmc.initialPartition[i].GetBDD(), block_length), mtbdd_nodecount(ctmc.initialPartition[i].GetBDD()));
+                INFO("New initial partition [%d]: %'0.0f states, %'zu MTBDD nodes.", i, mtbdd_satcount(ctmc.initialPartition[i].GetBDD(), ctx->block_length), mtbdd_nodecount(ctmc.initialPartition[i].GetBDD()));
             }
         }
     }
 }
 
-void Minimizations::minimize1(LTS& lts, BDD partition, int improved)
+void Minimizations::minimize1(sigref_context *ctx, LTS& lts, BDD partition, int improved)
 {
     LACE_ME;
 
@@ -995,7 +1008,7 @@ void Minimizations::minimize1(LTS& lts, BDD partition, int improved)
     BDD trans[n_relations];
 
     /* get tau if branching bisimulation */
-    BDD tau = bisimulation == 1 ? lts.getTau().GetBDD() : mtbdd_false;
+    BDD tau = ctx->options.bisimulation == 1 ? lts.getTau().GetBDD() : mtbdd_false;
 
     /* translate all relations */
     for (int i=0; i<n_relations; i++) {
@@ -1009,10 +1022,10 @@ void Minimizations::minimize1(LTS& lts, BDD partition, int improved)
         mtbdd_refs_push(trans[i]);
         if (!improved) {
             /* use first algorithm */
-            trans[i] = translate_trans_1(lts, trans[i], partition, tau);
+            trans[i] = translate_trans_1(ctx, lts, trans[i], partition, tau);
         } else {
             /* use improved algorithm */
-            trans[i] = translate_trans_2(lts, trans[i], partition, tau);
+            trans[i] = translate_trans_2(ctx, lts, trans[i], partition, tau);
         }
         mtbdd_refs_pop(1);
         mtbdd_refs_push(trans[i]);
@@ -1025,8 +1038,8 @@ void Minimizations::minimize1(LTS& lts, BDD partition, int improved)
 
     INFO("Computing new states, initial states, inital partition...");
 
-    lts.initialStates = CALL(translate_states, lts, lts.getInitialStates().GetBDD(), partition);
-    lts.states = CALL(new_state_space, count_blocks());
+    lts.initialStates = CALL(translate_states, ctx, lts, lts.getInitialStates().GetBDD(), partition);
+    lts.states = CALL(new_state_space, ctx, count_blocks(ctx));
 
     int ip_size = lts.initialPartition.size();
     if (ip_size == 0) {
@@ -1036,13 +1049,13 @@ void Minimizations::minimize1(LTS& lts, BDD partition, int improved)
     } else if (ip_size == 2) {
         /* only compute first block, then second block is the rest */
         Bdd first = lts.initialPartition[0];
-        first = CALL(translate_states, lts, first.GetBDD(), partition);
+        first = CALL(translate_states, ctx, lts, first.GetBDD(), partition);
         lts.initialPartition[0] = first;
         lts.initialPartition[1] = lts.states * !first;
     } else {
         /* translate each set of states */
         for (int i=0; i<ip_size; i++) {
-            lts.initialPartition[i] = CALL(translate_states, lts, lts.initialPartition[i].GetBDD(), partition);
+            lts.initialPartition[i] = CALL(translate_states, ctx, lts, lts.initialPartition[i].GetBDD(), partition);
         }
     }
 
@@ -1050,15 +1063,15 @@ void Minimizations::minimize1(LTS& lts, BDD partition, int improved)
     MTBDD state_vars = mtbdd_true;
     MTBDD prime_vars = mtbdd_true;
     MTBDD st_vars = mtbdd_true;
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(state_vars);
         mtbdd_refs_push(prime_vars);
         mtbdd_refs_push(st_vars);
-        state_vars = mtbdd_set_add(state_vars, (block_length-i-1)*2);
-        prime_vars = mtbdd_set_add(prime_vars, (block_length-i-1)*2+1);
-        st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2+1);
+        state_vars = mtbdd_set_add(state_vars, (ctx->block_length-i-1)*2);
+        prime_vars = mtbdd_set_add(prime_vars, (ctx->block_length-i-1)*2+1);
+        st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2+1);
         mtbdd_refs_push(st_vars);
-        st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2);
+        st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2);
         mtbdd_refs_pop(4);  // state_vars, prime_vars, two times st_vars
     }
     lts.varS = state_vars;
@@ -1070,19 +1083,23 @@ void Minimizations::minimize1(LTS& lts, BDD partition, int improved)
     }
     mtbdd_refs_pop(n_relations);
 
+    double t3 = wctime();
+
     sylvan_stats_t s3;
     sylvan_stats_snapshot(&s3);
 
     /* report times */
     INFO("");
     INFO("Time for computing the quotient of the transition relation: %'0.2f sec.", t2-t1);
+    metrics_phase("quotient-transitions", t2-t1, count_blocks(ctx));
+    metrics_phase("quotient-states", t3-t2);
 
     /* report number of created/reused nodes */
     {
         size_t created_nodes = s2.counters[BDD_NODES_CREATED] - s1.counters[BDD_NODES_CREATED];
         size_t reused_nodes = s2.counters[BDD_NODES_REUSED] - s1.counters[BDD_NODES_REUSED];
         INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             size_t created_nodes = s3.counters[BDD_NODES_CREATED] - s2.counters[BDD_NODES_CREATED];
             size_t reused_nodes = s3.counters[BDD_NODES_REUSED] - s2.counters[BDD_NODES_REUSED];
             INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
@@ -1093,7 +1110,7 @@ void Minimizations::minimize1(LTS& lts, BDD partition, int improved)
     {
         int action_length = sylvan_set_count(lts.getVarA().GetBDD());
         double trans_count = 0;
-        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], block_length * 2 + action_length);
+        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], ctx->block_length * 2 + action_length);
         size_t node_count = mtbdd_nodecount_more(trans, n_relations);
         INFO("New interactive transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
     }
@@ -1102,7 +1119,7 @@ void Minimizations::minimize1(LTS& lts, BDD partition, int improved)
 /**
  * Minimize an IMC using standard BDD operations
  */
-void Minimizations::minimize1(IMC &imc, BDD partition, int improved)
+void Minimizations::minimize1(sigref_context *ctx, IMC &imc, BDD partition, int improved)
 {
     LACE_ME;
 
@@ -1115,7 +1132,7 @@ void Minimizations::minimize1(IMC &imc, BDD partition, int improved)
     double t1 = wctime();
 
     /* compute using standard operations */
-    imc.markov_transitions = translate_markov(imc, imc.getMarkovTransitions().GetMTBDD(), partition);
+    imc.markov_transitions = translate_markov(ctx, imc, imc.getMarkovTransitions().GetMTBDD(), partition);
 
     INFO("Computing new interactive transition relations (using standard operations)...");
 
@@ -1125,7 +1142,7 @@ void Minimizations::minimize1(IMC &imc, BDD partition, int improved)
     BDD trans[n_relations];
 
     /* get tau if branching bisimulation */
-    BDD tau = bisimulation == 1 ? imc.getTau().GetBDD() : mtbdd_false;
+    BDD tau = ctx->options.bisimulation == 1 ? imc.getTau().GetBDD() : mtbdd_false;
 
     /* translate all relations */
     for (int i=0; i<n_relations; i++) {
@@ -1139,10 +1156,10 @@ void Minimizations::minimize1(IMC &imc, BDD partition, int improved)
         mtbdd_refs_push(trans[i]);
         if (!improved) {
             /* use first algorithm */
-            trans[i] = translate_trans_1(imc, trans[i], partition, tau);
+            trans[i] = translate_trans_1(ctx, imc, trans[i], partition, tau);
         } else {
             /* use improved algorithm */
-            trans[i] = translate_trans_2(imc, trans[i], partition, tau);
+            trans[i] = translate_trans_2(ctx, imc, trans[i], partition, tau);
         }
         mtbdd_refs_pop(1);
         mtbdd_refs_push(trans[i]);
@@ -1155,8 +1172,8 @@ void Minimizations::minimize1(IMC &imc, BDD partition, int improved)
 
     INFO("Computing new states, initial states, initial partition...");
 
-    imc.initialStates = CALL(translate_states, imc, imc.getInitialStates().GetBDD(), partition);
-    imc.states = CALL(new_state_space, count_blocks());
+    imc.initialStates = CALL(translate_states, ctx, imc, imc.getInitialStates().GetBDD(), partition);
+    imc.states = CALL(new_state_space, ctx, count_blocks(ctx));
 
     int ip_size = imc.initialPartition.size();
     if (ip_size == 0) {
@@ -1166,13 +1183,13 @@ void Minimizations::minimize1(IMC &imc, BDD partition, int improved)
     } else if (ip_size == 2) {
         /* only compute first block, then second block is the rest */
         Bdd first = imc.initialPartition[0];
-        first = CALL(translate_states, imc, first.GetBDD(), partition);
+        first = CALL(translate_states, ctx, imc, first.GetBDD(), partition);
         imc.initialPartition[0] = first;
         imc.initialPartition[1] = imc.states * !first;
     } else {
         /* translate each set of states */
         for (int i=0; i<ip_size; i++) {
-            imc.initialPartition[i] = CALL(translate_states, imc, imc.initialPartition[i].GetBDD(), partition);
+            imc.initialPartition[i] = CALL(translate_states, ctx, imc, imc.initialPartition[i].GetBDD(), partition);
         }
     }
 
@@ -1180,11 +1197,11 @@ void Minimizations::minimize1(IMC &imc, BDD partition, int improved)
     MTBDD state_vars = mtbdd_true;
     MTBDD prime_vars = mtbdd_true;
     MTBDD st_vars = mtbdd_true;
-    for (int i=0; i<block_length; i++) {
-        state_vars = mtbdd_set_add(state_vars, (block_length-i-1)*2);
-        prime_vars = mtbdd_set_add(prime_vars, (block_length-i-1)*2+1);
-        st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2+1);
-        st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2);
+    for (int i=0; i<ctx->block_length; i++) {
+        state_vars = mtbdd_set_add(state_vars, (ctx->block_length-i-1)*2);
+        prime_vars = mtbdd_set_add(prime_vars, (ctx->block_length-i-1)*2+1);
+        st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2+1);
+        st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2);
     }
     imc.varS = state_vars;
     imc.varT = prime_vars;
@@ -1195,19 +1212,23 @@ void Minimizations::minimize1(IMC &imc, BDD partition, int improved)
     }
     mtbdd_refs_pop(n_relations);
 
+    double t3 = wctime();
+
     sylvan_stats_t s3;
     sylvan_stats_snapshot(&s3);
 
     /* report times */
     INFO("");
     INFO("Time for computing the quotient of the transition relation: %'0.2f sec.", t2-t1);
+    metrics_phase("quotient-transitions", t2-t1, count_blocks(ctx));
+    metrics_phase("quotient-states", t3-t2);
 
     /* report number of created/reused nodes */
     {
         size_t created_nodes = s2.counters[BDD_NODES_CREATED] - s1.counters[BDD_NODES_CREATED];
         size_t reused_nodes = s2.counters[BDD_NODES_REUSED] - s1.counters[BDD_NODES_REUSED];
         INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             size_t created_nodes = s3.counters[BDD_NODES_CREATED] - s2.counters[BDD_NODES_CREATED];
             size_t reused_nodes = s3.counters[BDD_NODES_REUSED] - s2.counters[BDD_NODES_REUSED];
             INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
@@ -1217,7 +1238,7 @@ void Minimizations::minimize1(IMC &imc, BDD partition, int improved)
     /* report data */
     {
         MTBDD trans = imc.markov_transitions.GetMTBDD();
-        double trans_count = mtbdd_satcount(trans, block_length * 2);
+        double trans_count = mtbdd_satcount(trans, ctx->block_length * 2);
         size_t node_count = mtbdd_nodecount(trans);
         INFO("New Markov transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
     }
@@ -1225,13 +1246,13 @@ void Minimizations::minimize1(IMC &imc, BDD partition, int improved)
     {
         int action_length = sylvan_set_count(imc.getVarA().GetBDD());
         double trans_count = 0;
-        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], block_length * 2 + action_length);
+        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], ctx->block_length * 2 + action_length);
         size_t node_count = mtbdd_nodecount_more(trans, n_relations);
         INFO("New interactive transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
     }
 }
 
-void Minimizations::minimize2(CTMC &ctmc, BDD partition)
+void Minimizations::minimize2(sigref_context *ctx, CTMC &ctmc, BDD partition)
 {
     LACE_ME;
 
@@ -1245,18 +1266,18 @@ void Minimizations::minimize2(CTMC &ctmc, BDD partition)
 
     /* create [B -> t] */
     MTBDDMAP map_b_to_t = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map_b_to_t);
-        map_b_to_t = mtbdd_map_add(map_b_to_t, block_base+2*(block_length-i-1), sylvan_ithvar(2*(block_length-i-1)+1));
+        map_b_to_t = mtbdd_map_add(map_b_to_t, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar(2*(ctx->block_length-i-1)+1));
         mtbdd_refs_pop(1);
     }
     mtbdd_refs_push(map_b_to_t);
 
     /* create [B -> s] */
     MTBDDMAP map_b_to_s = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map_b_to_s);
-        map_b_to_s = mtbdd_map_add(map_b_to_s, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2));
+        map_b_to_s = mtbdd_map_add(map_b_to_s, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2));
         mtbdd_refs_pop(1);
     }
     mtbdd_refs_push(map_b_to_s);
@@ -1266,13 +1287,13 @@ void Minimizations::minimize2(CTMC &ctmc, BDD partition)
 
     /* step 1: compute R(s,B) using AndAbstractPlus */
     // INFO("Step 1/2...");
-    if (leaftype == 2) trans = gmp_and_exists(trans, partition, ctmc.getVarT().GetBDD());
+    if (ctx->options.leaftype == 2) trans = gmp_and_exists(trans, partition, ctmc.getVarT().GetBDD());
     else trans = mtbdd_and_exists(trans, partition, ctmc.getVarT().GetBDD());
     mtbdd_refs_push(trans);
 
     /* step 2: compute R(s,t) result in one step */
     // INFO("Step 2/2...");
-    trans = compute_markov_quotient(trans, partition, ctmc.getVarS().GetBDD(), map_b_to_t, map_b_to_s);
+    trans = compute_markov_quotient(ctx, trans, partition, ctmc.getVarS().GetBDD(), map_b_to_t, map_b_to_s);
     ctmc.markov_transitions = trans;
     mtbdd_refs_pop(1);  // trans
 
@@ -1285,7 +1306,7 @@ void Minimizations::minimize2(CTMC &ctmc, BDD partition)
 
     BDD state_vars = ctmc.getVarS().GetBDD();
     ctmc.initialStates = compute_states_quotient(ctmc.getInitialStates().GetBDD(), partition, state_vars, map_b_to_s);
-    ctmc.states = CALL(new_state_space, count_blocks());
+    ctmc.states = CALL(new_state_space, ctx, count_blocks(ctx));
 
     int ip_size = ctmc.initialPartition.size();
     if (ip_size == 0) {
@@ -1311,30 +1332,34 @@ void Minimizations::minimize2(CTMC &ctmc, BDD partition)
     {
         MTBDD state_vars = mtbdd_true;
         MTBDD prime_vars = mtbdd_true;
-        for (int i=0; i<block_length; i++) {
+        for (int i=0; i<ctx->block_length; i++) {
             mtbdd_refs_push(state_vars);
             mtbdd_refs_push(prime_vars);
-            state_vars = mtbdd_set_add(state_vars, (block_length-i-1)*2);
-            prime_vars = mtbdd_set_add(prime_vars, (block_length-i-1)*2+1);
+            state_vars = mtbdd_set_add(state_vars, (ctx->block_length-i-1)*2);
+            prime_vars = mtbdd_set_add(prime_vars, (ctx->block_length-i-1)*2+1);
             mtbdd_refs_pop(2);  // state_vars, prime_vars
         }
         ctmc.varS = state_vars;
         ctmc.varT = prime_vars;
     }
 
+    double t3 = wctime();
+
     sylvan_stats_t s3;
     sylvan_stats_snapshot(&s3);
 
     /* report times */
     INFO("");
     INFO("Time for computing the quotient of the transition relation: %'0.2f sec.", t2-t1);
+    metrics_phase("quotient-transitions", t2-t1, count_blocks(ctx));
+    metrics_phase("quotient-states", t3-t2);
 
     /* report number of created/reused nodes */
     {
         size_t created_nodes = s2.counters[BDD_NODES_CREATED] - s1.counters[BDD_NODES_CREATED];
         size_t reused_nodes = s2.counters[BDD_NODES_REUSED] - s1.counters[BDD_NODES_REUSED];
         INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             size_t created_nodes = s3.counters[BDD_NODES_CREATED] - s2.counters[BDD_NODES_CREATED];
             size_t reused_nodes = s3.counters[BDD_NODES_REUSED] - s2.counters[BDD_NODES_REUSED];
             INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
@@ -1344,21 +1369,21 @@ void Minimizations::minimize2(CTMC &ctmc, BDD partition)
     /* report data */
     {
         MTBDD trans = ctmc.markov_transitions.GetMTBDD();
-        double trans_count = mtbdd_satcount(trans, block_length * 2);
+        double trans_count = mtbdd_satcount(trans, ctx->block_length * 2);
         size_t node_count = mtbdd_nodecount(trans);
         INFO("New Markov transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
-        if (verbosity >= 1) {
-            INFO("New initial states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.initialStates.GetBDD(), block_length), mtbdd_nodecount(ctmc.initialStates.GetBDD()));
-            INFO("New states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.states.GetBDD(), block_length), mtbdd_nodecount(ctmc.states.GetBDD()));
+        if (ctx->options.verbosity >= 1) {
+            INFO("New initial states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.initialStates.GetBDD(), ctx->block_length), mtbdd_nodecount(ctmc.initialStates.GetBDD()));
+            INFO("New states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.states.GetBDD(), ctx->block_length), mtbdd_nodecount(ctmc.states.GetBDD()));
             int ip_size = ctmc.initialPartition.size();
             for (int i=0; i<ip_size; i++) {
-                INFO("New initial partition [%d]: %'0.0f states, %'zu MTBDD nodes.", i, mtbdd_satcount(ctmc.initialPartition[i].GetBDD(), block_length), mtbdd_nodecount(ctmc.initialPartition[i].GetBDD()));
+                INFO("New initial partition [%d]: %'0.0f states, %'zu MTBDD nodes.", i, mtbdd_satcount(ctmc.initialPartition[i].GetBDD(), ctx->block_length), mtbdd_nodecount(ctmc.initialPartition[i].GetBDD()));
             }
         }
     }
 }
 
-void Minimizations::minimize2(LTS& lts, BDD partition)
+void Minimizations::minimize2(sigref_context *ctx, LTS& lts, BDD partition)
 {
     LACE_ME;
 
@@ -1376,7 +1401,7 @@ void Minimizations::minimize2(LTS& lts, BDD partition)
     BDD trans[n_relations];
 
     /* get tau if branching bisimulation */
-    BDD tau = bisimulation == 1 ? lts.getTau().GetBDD() : mtbdd_false;
+    BDD tau = ctx->options.bisimulation == 1 ? lts.getTau().GetBDD() : mtbdd_false;
 
     BDD st_vars = (lts.getVarS() * lts.getVarT()).GetBDD();
 
@@ -1390,7 +1415,7 @@ void Minimizations::minimize2(LTS& lts, BDD partition)
             trans[i] = CALL(extend_relation, trans[i], transitions[i].second.GetBDD(), state_length);
         }
         mtbdd_refs_push(trans[i]);
-        trans[i] = CALL(compute_trans_quotient, trans[i], partition, partition, st_vars, tau);
+        trans[i] = compute_trans_quotient(trans[i], partition, partition, st_vars, tau);
         mtbdd_refs_pop(1);
         mtbdd_refs_push(trans[i]);
     }
@@ -1404,9 +1429,9 @@ void Minimizations::minimize2(LTS& lts, BDD partition)
 
     /* create [B -> s] */
     MTBDD map = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map);
-        map = mtbdd_map_add(map, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2));
+        map = mtbdd_map_add(map, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2));
         mtbdd_refs_pop(1);
     }
     mtbdd_refs_push(map);
@@ -1414,7 +1439,7 @@ void Minimizations::minimize2(LTS& lts, BDD partition)
     {
         BDD state_vars = lts.getVarS().GetBDD();
         lts.initialStates = compute_states_quotient(lts.getInitialStates().GetBDD(), partition, state_vars, map);
-        lts.states = CALL(new_state_space, count_blocks());
+        lts.states = CALL(new_state_space, ctx, count_blocks(ctx));
 
         int ip_size = lts.initialPartition.size();
         if (ip_size == 0) {
@@ -1440,15 +1465,15 @@ void Minimizations::minimize2(LTS& lts, BDD partition)
         MTBDD state_vars = mtbdd_true;
         MTBDD prime_vars = mtbdd_true;
         MTBDD st_vars = mtbdd_true;
-        for (int i=0; i<block_length; i++) {
+        for (int i=0; i<ctx->block_length; i++) {
             mtbdd_refs_push(state_vars);
             mtbdd_refs_push(prime_vars);
             mtbdd_refs_push(st_vars);
-            state_vars = mtbdd_set_add(state_vars, (block_length-i-1)*2);
-            prime_vars = mtbdd_set_add(prime_vars, (block_length-i-1)*2+1);
-            st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2+1);
+            state_vars = mtbdd_set_add(state_vars, (ctx->block_length-i-1)*2);
+            prime_vars = mtbdd_set_add(prime_vars, (ctx->block_length-i-1)*2+1);
+            st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2+1);
             mtbdd_refs_push(st_vars);
-            st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2);
+            st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2);
             mtbdd_refs_pop(4);  // state_vars, prime_vars, two times st_vars
         }
         lts.varS = state_vars;
@@ -1461,19 +1486,23 @@ void Minimizations::minimize2(LTS& lts, BDD partition)
         mtbdd_refs_pop(n_relations);
     }
 
+    double t3 = wctime();
+
     sylvan_stats_t s3;
     sylvan_stats_snapshot(&s3);
 
     /* report times */
     INFO("");
     INFO("Time for computing the quotient of the transition relation: %'0.2f sec.", t2-t1);
+    metrics_phase("quotient-transitions", t2-t1, count_blocks(ctx));
+    metrics_phase("quotient-states", t3-t2);
 
     /* report number of created/reused nodes */
     {
         size_t created_nodes = s2.counters[BDD_NODES_CREATED] - s1.counters[BDD_NODES_CREATED];
         size_t reused_nodes = s2.counters[BDD_NODES_REUSED] - s1.counters[BDD_NODES_REUSED];
         INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             size_t created_nodes = s3.counters[BDD_NODES_CREATED] - s2.counters[BDD_NODES_CREATED];
             size_t reused_nodes = s3.counters[BDD_NODES_REUSED] - s2.counters[BDD_NODES_REUSED];
             INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
@@ -1484,13 +1513,13 @@ void Minimizations::minimize2(LTS& lts, BDD partition)
     {
         int action_length = sylvan_set_count(lts.getVarA().GetBDD());
         double trans_count = 0;
-        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], block_length * 2 + action_length);
+        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], ctx->block_length * 2 + action_length);
         size_t node_count = mtbdd_nodecount_more(trans, n_relations);
         INFO("New interactive transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
     }
 }
 
-void Minimizations::minimize2(IMC &imc, BDD partition)
+void Minimizations::minimize2(sigref_context *ctx, IMC &imc, BDD partition)
 {
     LACE_ME;
 
@@ -1504,18 +1533,18 @@ void Minimizations::minimize2(IMC &imc, BDD partition)
 
     /* create [B -> t] */
     MTBDDMAP map_b_to_t = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map_b_to_t);
-        map_b_to_t = mtbdd_map_add(map_b_to_t, block_base+2*(block_length-i-1), sylvan_ithvar(2*(block_length-i-1)+1));
+        map_b_to_t = mtbdd_map_add(map_b_to_t, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar(2*(ctx->block_length-i-1)+1));
         mtbdd_refs_pop(1);
     }
     mtbdd_refs_push(map_b_to_t);
 
     /* create [B -> s] */
     MTBDDMAP map_b_to_s = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map_b_to_s);
-        map_b_to_s = mtbdd_map_add(map_b_to_s, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2));
+        map_b_to_s = mtbdd_map_add(map_b_to_s, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2));
         mtbdd_refs_pop(1);
     }
     mtbdd_refs_push(map_b_to_s);
@@ -1526,13 +1555,13 @@ void Minimizations::minimize2(IMC &imc, BDD partition)
         /* step 1: compute R(s,B) using AndAbstractPlus */
         // INFO("Step 1/2...");
         MTBDD trans = imc.getMarkovTransitions().GetMTBDD();
-        if (leaftype == 2) trans = gmp_and_exists(trans, partition, imc.getVarT().GetBDD());
+        if (ctx->options.leaftype == 2) trans = gmp_and_exists(trans, partition, imc.getVarT().GetBDD());
         else trans = mtbdd_and_exists(trans, partition, imc.getVarT().GetBDD());
         mtbdd_refs_push(trans);
 
         /* step 2: compute R(s,t) result in one step */
         // INFO("Step 2/2...");
-        trans = compute_markov_quotient(trans, partition, imc.getVarS().GetBDD(), map_b_to_t, map_b_to_s);
+        trans = compute_markov_quotient(ctx, trans, partition, imc.getVarS().GetBDD(), map_b_to_t, map_b_to_s);
         imc.markov_transitions = trans;
         mtbdd_refs_pop(1);  // trans
     }
@@ -1547,7 +1576,7 @@ void Minimizations::minimize2(IMC &imc, BDD partition)
         BDD trans[n_relations];
 
         /* get tau if branching bisimulation */
-        BDD tau = bisimulation == 1 ? imc.getTau().GetBDD() : mtbdd_false;
+        BDD tau = ctx->options.bisimulation == 1 ? imc.getTau().GetBDD() : mtbdd_false;
 
         BDD st_vars = (imc.getVarS() * imc.getVarT()).GetBDD();
 
@@ -1561,7 +1590,7 @@ void Minimizations::minimize2(IMC &imc, BDD partition)
                 trans[i] = CALL(extend_relation, trans[i], transitions[i].second.GetBDD(), state_length);
             }
             mtbdd_refs_push(trans[i]);
-            imc.transitions[i].first = CALL(compute_trans_quotient, trans[i], partition, partition, st_vars, tau);
+            imc.transitions[i].first = compute_trans_quotient(trans[i], partition, partition, st_vars, tau);
             mtbdd_refs_pop(1);
         }
     }
@@ -1577,7 +1606,7 @@ void Minimizations::minimize2(IMC &imc, BDD partition)
         {
             BDD state_vars = imc.getVarS().GetBDD();
             imc.initialStates = compute_states_quotient(imc.getInitialStates().GetBDD(), partition, state_vars, map_b_to_s);
-            imc.states = CALL(new_state_space, count_blocks());
+            imc.states = CALL(new_state_space, ctx, count_blocks(ctx));
 
             int ip_size = imc.initialPartition.size();
             if (ip_size == 0) {
@@ -1604,11 +1633,11 @@ void Minimizations::minimize2(IMC &imc, BDD partition)
         MTBDD state_vars = mtbdd_true;
         MTBDD prime_vars = mtbdd_true;
         MTBDD st_vars = mtbdd_true;
-        for (int i=0; i<block_length; i++) {
-            state_vars = mtbdd_set_add(state_vars, (block_length-i-1)*2);
-            prime_vars = mtbdd_set_add(prime_vars, (block_length-i-1)*2+1);
-            st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2+1);
-            st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2);
+        for (int i=0; i<ctx->block_length; i++) {
+            state_vars = mtbdd_set_add(state_vars, (ctx->block_length-i-1)*2);
+            prime_vars = mtbdd_set_add(prime_vars, (ctx->block_length-i-1)*2+1);
+            st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2+1);
+            st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2);
         }
         imc.varS = state_vars;
         imc.varT = prime_vars;
@@ -1616,9 +1645,10 @@ void Minimizations::minimize2(IMC &imc, BDD partition)
         for (int i=0; i<n_relations; i++) {
             imc.transitions[i].second = st_vars;
         }
-        mtbdd_refs_pop(n_relations);
     }
 
+    double t3 = wctime();
+
     sylvan_stats_t s3;
     sylvan_stats_snapshot(&s3);
 
@@ -1627,13 +1657,15 @@ void Minimizations::minimize2(IMC &imc, BDD partition)
     /* report times */
     INFO("");
     INFO("Time for computing the quotient of the transition relation: %'0.2f sec.", t2-t1);
+    metrics_phase("quotient-transitions", t2-t1, count_blocks(ctx));
+    metrics_phase("quotient-states", t3-t2);
 
     /* report number of created/reused nodes */
     {
         size_t created_nodes = s2.counters[BDD_NODES_CREATED] - s1.counters[BDD_NODES_CREATED];
         size_t reused_nodes = s2.counters[BDD_NODES_REUSED] - s1.counters[BDD_NODES_REUSED];
         INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             size_t created_nodes = s3.counters[BDD_NODES_CREATED] - s2.counters[BDD_NODES_CREATED];
             size_t reused_nodes = s3.counters[BDD_NODES_REUSED] - s2.counters[BDD_NODES_REUSED];
             INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
@@ -1642,7 +1674,7 @@ void Minimizations::minimize2(IMC &imc, BDD partition)
 
     /* report data */
     {
-        double trans_count = mtbdd_satcount(imc.getMarkovTransitions().GetMTBDD(), block_length * 2);
+        double trans_count = mtbdd_satcount(imc.getMarkovTransitions().GetMTBDD(), ctx->block_length * 2);
         size_t node_count = mtbdd_nodecount(imc.getMarkovTransitions().GetMTBDD());
         INFO("New Markov transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
     }
@@ -1652,13 +1684,13 @@ void Minimizations::minimize2(IMC &imc, BDD partition)
         double trans_count = 0;
         MTBDD trans[n_relations];
         for (int i=0; i<n_relations; i++) trans[i] = imc.transitions[i].first.GetBDD();
-        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], block_length * 2 + action_length);
+        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], ctx->block_length * 2 + action_length);
         size_t node_count = mtbdd_nodecount_more(trans, n_relations);
         INFO("New interactive transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
     }
 }
 
-void Minimizations::minimize3(CTMC &ctmc, BDD partition)
+void Minimizations::minimize3(sigref_context *ctx, CTMC &ctmc, BDD partition)
 {
     LACE_ME;
 
@@ -1671,25 +1703,25 @@ void Minimizations::minimize3(CTMC &ctmc, BDD partition)
     double t1 = wctime();
 
     /* pick a random state for each block */
-    partition = CALL(create_pick_partition, partition, ctmc.getVarT().GetBDD());
+    partition = CALL(create_pick_partition, ctx, partition, ctmc.getVarT().GetBDD());
     mtbdd_refs_push(partition);
 
     INFO("Computing the new transition relation...");
 
     /* create [B -> t] */
     MTBDDMAP map_b_to_t = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map_b_to_t);
-        map_b_to_t = mtbdd_map_add(map_b_to_t, block_base+2*(block_length-i-1), sylvan_ithvar(2*(block_length-i-1)+1));
+        map_b_to_t = mtbdd_map_add(map_b_to_t, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar(2*(ctx->block_length-i-1)+1));
         mtbdd_refs_pop(1);
     }
     mtbdd_refs_push(map_b_to_t);
 
     /* create [B -> s] */
     MTBDDMAP map_b_to_s = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map_b_to_s);
-        map_b_to_s = mtbdd_map_add(map_b_to_s, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2));
+        map_b_to_s = mtbdd_map_add(map_b_to_s, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2));
         mtbdd_refs_pop(1);
     }
     mtbdd_refs_push(map_b_to_s);
@@ -1699,13 +1731,13 @@ void Minimizations::minimize3(CTMC &ctmc, BDD partition)
     /* step 1: compute R(s,B) using AndAbstractPlus */
     // INFO("Step 1/2...");
     MTBDD trans = ctmc.getMarkovTransitions().GetMTBDD();
-    if (leaftype == 2) trans = gmp_and_exists(trans, partition, ctmc.getVarT().GetBDD());
+    if (ctx->options.leaftype == 2) trans = gmp_and_exists(trans, partition, ctmc.getVarT().GetBDD());
     else trans = mtbdd_and_exists(trans, partition, ctmc.getVarT().GetBDD());
     mtbdd_refs_push(trans);
 
     /* step 2: compute R(s,t) result in one step */
     // INFO("Step 2/2...");
-    trans = compute_markov_quotient(trans, partition, ctmc.getVarS().GetBDD(), map_b_to_t, map_b_to_s);
+    trans = compute_markov_quotient(ctx, trans, partition, ctmc.getVarS().GetBDD(), map_b_to_t, map_b_to_s);
     ctmc.markov_transitions = trans;
     mtbdd_refs_pop(1);  // trans
 
@@ -1718,7 +1750,7 @@ void Minimizations::minimize3(CTMC &ctmc, BDD partition)
 
     BDD state_vars = ctmc.getVarS().GetBDD();
     ctmc.initialStates = compute_states_quotient(ctmc.getInitialStates().GetBDD(), partition, state_vars, map_b_to_s);
-    ctmc.states = CALL(new_state_space, count_blocks());
+    ctmc.states = CALL(new_state_space, ctx, count_blocks(ctx));
 
     int ip_size = ctmc.initialPartition.size();
     if (ip_size == 0) {
@@ -1745,30 +1777,34 @@ void Minimizations::minimize3(CTMC &ctmc, BDD partition)
     {
         MTBDD state_vars = mtbdd_true;
         MTBDD prime_vars = mtbdd_true;
-        for (int i=0; i<block_length; i++) {
+        for (int i=0; i<ctx->block_length; i++) {
             mtbdd_refs_push(state_vars);
             mtbdd_refs_push(prime_vars);
-            state_vars = mtbdd_set_add(state_vars, (block_length-i-1)*2);
-            prime_vars = mtbdd_set_add(prime_vars, (block_length-i-1)*2+1);
+            state_vars = mtbdd_set_add(state_vars, (ctx->block_length-i-1)*2);
+            prime_vars = mtbdd_set_add(prime_vars, (ctx->block_length-i-1)*2+1);
             mtbdd_refs_pop(2);  // state_vars, prime_vars
         }
         ctmc.varS = state_vars;
         ctmc.varT = prime_vars;
     }
 
+    double t3 = wctime();
+
     sylvan_stats_t s3;
     sylvan_stats_snapshot(&s3);
 
     /* report times */
     INFO("");
     INFO("Time for computing the quotient of the transition relation: %'0.2f sec.", t2-t1);
+    metrics_phase("quotient-transitions", t2-t1, count_blocks(ctx));
+    metrics_phase("quotient-states", t3-t2);
 
     /* report number of created/reused nodes */
     {
         size_t created_nodes = s2.counters[BDD_NODES_CREATED] - s1.counters[BDD_NODES_CREATED];
         size_t reused_nodes = s2.counters[BDD_NODES_REUSED] - s1.counters[BDD_NODES_REUSED];
         INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             size_t created_nodes = s3.counters[BDD_NODES_CREATED] - s2.counters[BDD_NODES_CREATED];
             size_t reused_nodes = s3.counters[BDD_NODES_REUSED] - s2.counters[BDD_NODES_REUSED];
             INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
@@ -1777,21 +1813,21 @@ void Minimizations::minimize3(CTMC &ctmc, BDD partition)
 
     /* report data */
     {
-        double trans_count = mtbdd_satcount(trans, block_length * 2);
+        double trans_count = mtbdd_satcount(trans, ctx->block_length * 2);
         size_t node_count = mtbdd_nodecount(trans);
         INFO("New Markov transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
-        if (verbosity >= 1) {
-            INFO("New initial states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.initialStates.GetBDD(), block_length), mtbdd_nodecount(ctmc.initialStates.GetBDD()));
-            INFO("New states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.states.GetBDD(), block_length), mtbdd_nodecount(ctmc.states.GetBDD()));
+        if (ctx->options.verbosity >= 1) {
+            INFO("New initial states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.initialStates.GetBDD(), ctx->block_length), mtbdd_nodecount(ctmc.initialStates.GetBDD()));
+            INFO("New states: %'0.0f states, %'zu MTBDD nodes.", mtbdd_satcount(ctmc.states.GetBDD(), ctx->block_length), mtbdd_nodecount(ctmc.states.GetBDD()));
             int ip_size = ctmc.initialPartition.size();
             for (int i=0; i<ip_size; i++) {
-                INFO("New initial partition [%d]: %'0.0f states, %'zu MTBDD nodes.", i, mtbdd_satcount(ctmc.initialPartition[i].GetBDD(), block_length), mtbdd_nodecount(ctmc.initialPartition[i].GetBDD()));
+                INFO("New initial partition [%d]: %'0.0f states, %'zu MTBDD nodes.", i, mtbdd_satcount(ctmc.initialPartition[i].GetBDD(), ctx->block_length), mtbdd_nodecount(ctmc.initialPartition[i].GetBDD()));
             }
         }
     }
 }
 
-void Minimizations::minimize3(LTS& lts, BDD partition)
+void Minimizations::minimize3(sigref_context *ctx, LTS& lts, BDD partition)
 {
     LACE_ME;
 
@@ -1804,7 +1840,7 @@ void Minimizations::minimize3(LTS& lts, BDD partition)
     double t1 = wctime();
 
     /* pick a random state for each block */
-    partition = CALL(create_pick_partition, partition, lts.getVarT().GetBDD());
+    partition = CALL(create_pick_partition, ctx, partition, lts.getVarT().GetBDD());
     mtbdd_refs_push(partition);
 
     INFO("Computing new interactive transition relations...");
@@ -1815,7 +1851,7 @@ void Minimizations::minimize3(LTS& lts, BDD partition)
     BDD trans[n_relations];
 
     /* get tau if branching bisimulation */
-    BDD tau = bisimulation == 1 ? lts.getTau().GetBDD() : mtbdd_false;
+    BDD tau = ctx->options.bisimulation == 1 ? lts.getTau().GetBDD() : mtbdd_false;
 
     BDD st_vars = (lts.getVarS() * lts.getVarT()).GetBDD();
 
@@ -1829,7 +1865,7 @@ void Minimizations::minimize3(LTS& lts, BDD partition)
             trans[i] = CALL(extend_relation, trans[i], transitions[i].second.GetBDD(), state_length);
         }
         mtbdd_refs_push(trans[i]);
-        trans[i] = CALL(compute_trans_quotient, trans[i], partition, partition, st_vars, tau);
+        trans[i] = compute_trans_quotient(trans[i], partition, partition, st_vars, tau);
         mtbdd_refs_pop(1);
         mtbdd_refs_push(trans[i]);
     }
@@ -1843,9 +1879,9 @@ void Minimizations::minimize3(LTS& lts, BDD partition)
 
     /* create [B -> s] */
     MTBDD map = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map);
-        map = mtbdd_map_add(map, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2));
+        map = mtbdd_map_add(map, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2));
         mtbdd_refs_pop(1);
     }
     mtbdd_refs_push(map);
@@ -1853,7 +1889,7 @@ void Minimizations::minimize3(LTS& lts, BDD partition)
     {
         BDD state_vars = lts.getVarS().GetBDD();
         lts.initialStates = compute_states_quotient(lts.getInitialStates().GetBDD(), partition, state_vars, map);
-        lts.states = CALL(new_state_space, count_blocks());
+        lts.states = CALL(new_state_space, ctx, count_blocks(ctx));
 
         int ip_size = lts.initialPartition.size();
         if (ip_size == 0) {
@@ -1881,15 +1917,15 @@ void Minimizations::minimize3(LTS& lts, BDD partition)
         MTBDD state_vars = mtbdd_true;
         MTBDD prime_vars = mtbdd_true;
         MTBDD st_vars = mtbdd_true;
-        for (int i=0; i<block_length; i++) {
+        for (int i=0; i<ctx->block_length; i++) {
             mtbdd_refs_push(state_vars);
             mtbdd_refs_push(prime_vars);
             mtbdd_refs_push(st_vars);
-            state_vars = mtbdd_set_add(state_vars, (block_length-i-1)*2);
-            prime_vars = mtbdd_set_add(prime_vars, (block_length-i-1)*2+1);
-            st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2+1);
+            state_vars = mtbdd_set_add(state_vars, (ctx->block_length-i-1)*2);
+            prime_vars = mtbdd_set_add(prime_vars, (ctx->block_length-i-1)*2+1);
+            st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2+1);
             mtbdd_refs_push(st_vars);
-            st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2);
+            st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2);
             mtbdd_refs_pop(4);  // state_vars, prime_vars, two times st_vars
         }
         lts.varS = state_vars;
@@ -1902,19 +1938,23 @@ void Minimizations::minimize3(LTS& lts, BDD partition)
         mtbdd_refs_pop(n_relations);
     }
 
+    double t3 = wctime();
+
     sylvan_stats_t s3;
     sylvan_stats_snapshot(&s3);
 
     /* report times */
     INFO("");
     INFO("Time for computing the quotient of the transition relation: %'0.2f sec.", t2-t1);
+    metrics_phase("quotient-transitions", t2-t1, count_blocks(ctx));
+    metrics_phase("quotient-states", t3-t2);
 
     /* report number of created/reused nodes */
     {
         size_t created_nodes = s2.counters[BDD_NODES_CREATED] - s1.counters[BDD_NODES_CREATED];
         size_t reused_nodes = s2.counters[BDD_NODES_REUSED] - s1.counters[BDD_NODES_REUSED];
         INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             size_t created_nodes = s3.counters[BDD_NODES_CREATED] - s2.counters[BDD_NODES_CREATED];
             size_t reused_nodes = s3.counters[BDD_NODES_REUSED] - s2.counters[BDD_NODES_REUSED];
             INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
@@ -1925,13 +1965,13 @@ void Minimizations::minimize3(LTS& lts, BDD partition)
     {
         int action_length = sylvan_set_count(lts.getVarA().GetBDD());
         double trans_count = 0;
-        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], block_length * 2 + action_length);
+        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], ctx->block_length * 2 + action_length);
         size_t node_count = mtbdd_nodecount_more(trans, n_relations);
         INFO("New interactive transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
     }
 }
 
-void Minimizations::minimize3(IMC &imc, BDD partition)
+void Minimizations::minimize3(sigref_context *ctx, IMC &imc, BDD partition)
 {
     LACE_ME;
 
@@ -1944,25 +1984,25 @@ void Minimizations::minimize3(IMC &imc, BDD partition)
     double t1 = wctime();
 
     /* pick a random state for each block */
-    partition = CALL(create_pick_partition, partition, imc.getVarT().GetBDD());
+    partition = CALL(create_pick_partition, ctx, partition, imc.getVarT().GetBDD());
     mtbdd_refs_push(partition);
 
     INFO("Computing the new transition relation...");
 
     /* create [B -> t] */
     MTBDDMAP map_b_to_t = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map_b_to_t);
-        map_b_to_t = mtbdd_map_add(map_b_to_t, block_base+2*(block_length-i-1), sylvan_ithvar(2*(block_length-i-1)+1));
+        map_b_to_t = mtbdd_map_add(map_b_to_t, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar(2*(ctx->block_length-i-1)+1));
         mtbdd_refs_pop(1);
     }
     mtbdd_refs_push(map_b_to_t);
 
     /* create [B -> s] */
     MTBDDMAP map_b_to_s = mtbdd_map_empty();
-    for (int i=0; i<block_length; i++) {
+    for (int i=0; i<ctx->block_length; i++) {
         mtbdd_refs_push(map_b_to_s);
-        map_b_to_s = mtbdd_map_add(map_b_to_s, block_base+2*(block_length-i-1), sylvan_ithvar((block_length-i-1)*2));
+        map_b_to_s = mtbdd_map_add(map_b_to_s, ctx->block_base+2*(ctx->block_length-i-1), sylvan_ithvar((ctx->block_length-i-1)*2));
         mtbdd_refs_pop(1);
     }
     mtbdd_refs_push(map_b_to_s);
@@ -1973,13 +2013,13 @@ void Minimizations::minimize3(IMC &imc, BDD partition)
         /* step 1: compute R(s,B) using AndAbstractPlus */
         // INFO("Step 1/2...");
         MTBDD trans = imc.getMarkovTransitions().GetMTBDD();
-        if (leaftype == 2) trans = gmp_and_exists(trans, partition, imc.getVarT().GetBDD());
+        if (ctx->options.leaftype == 2) trans = gmp_and_exists(trans, partition, imc.getVarT().GetBDD());
         else trans = mtbdd_and_exists(trans, partition, imc.getVarT().GetBDD());
         mtbdd_refs_push(trans);
 
         /* step 2: compute R(s,t) result in one step */
         // INFO("Step 2/2...");
-        trans = compute_markov_quotient(trans, partition, imc.getVarS().GetBDD(), map_b_to_t, map_b_to_s);
+        trans = compute_markov_quotient(ctx, trans, partition, imc.getVarS().GetBDD(), map_b_to_t, map_b_to_s);
         imc.markov_transitions = trans;
         mtbdd_refs_pop(1);  // trans
     }
@@ -1994,7 +2034,7 @@ void Minimizations::minimize3(IMC &imc, BDD partition)
         BDD trans[n_relations];
 
         /* get tau if branching bisimulation */
-        BDD tau = bisimulation == 1 ? imc.getTau().GetBDD() : mtbdd_false;
+        BDD tau = ctx->options.bisimulation == 1 ? imc.getTau().GetBDD() : mtbdd_false;
 
         BDD st_vars = (imc.getVarS() * imc.getVarT()).GetBDD();
 
@@ -2008,7 +2048,7 @@ void Minimizations::minimize3(IMC &imc, BDD partition)
                 trans[i] = CALL(extend_relation, trans[i], transitions[i].second.GetBDD(), state_length);
             }
             mtbdd_refs_push(trans[i]);
-            imc.transitions[i].first = CALL(compute_trans_quotient, trans[i], partition, partition, st_vars, tau);
+            imc.transitions[i].first = compute_trans_quotient(trans[i], partition, partition, st_vars, tau);
             mtbdd_refs_pop(1);
         }
     }
@@ -2024,7 +2064,7 @@ void Minimizations::minimize3(IMC &imc, BDD partition)
         {
             BDD state_vars = imc.getVarS().GetBDD();
             imc.initialStates = compute_states_quotient(imc.getInitialStates().GetBDD(), partition, state_vars, map_b_to_s);
-            imc.states = CALL(new_state_space, count_blocks());
+            imc.states = CALL(new_state_space, ctx, count_blocks(ctx));
 
             int ip_size = imc.initialPartition.size();
             if (ip_size == 0) {
@@ -2051,11 +2091,11 @@ void Minimizations::minimize3(IMC &imc, BDD partition)
         MTBDD state_vars = mtbdd_true;
         MTBDD prime_vars = mtbdd_true;
         MTBDD st_vars = mtbdd_true;
-        for (int i=0; i<block_length; i++) {
-            state_vars = mtbdd_set_add(state_vars, (block_length-i-1)*2);
-            prime_vars = mtbdd_set_add(prime_vars, (block_length-i-1)*2+1);
-            st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2+1);
-            st_vars = mtbdd_set_add(st_vars, (block_length-i-1)*2);
+        for (int i=0; i<ctx->block_length; i++) {
+            state_vars = mtbdd_set_add(state_vars, (ctx->block_length-i-1)*2);
+            prime_vars = mtbdd_set_add(prime_vars, (ctx->block_length-i-1)*2+1);
+            st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2+1);
+            st_vars = mtbdd_set_add(st_vars, (ctx->block_length-i-1)*2);
         }
         imc.varS = state_vars;
         imc.varT = prime_vars;
@@ -2065,6 +2105,8 @@ void Minimizations::minimize3(IMC &imc, BDD partition)
         }
     }
 
+    double t3 = wctime();
+
     sylvan_stats_t s3;
     sylvan_stats_snapshot(&s3);
 
@@ -2073,13 +2115,15 @@ void Minimizations::minimize3(IMC &imc, BDD partition)
     /* report times */
     INFO("");
     INFO("Time for computing the quotient of the transition relation: %'0.2f sec.", t2-t1);
+    metrics_phase("quotient-transitions", t2-t1, count_blocks(ctx));
+    metrics_phase("quotient-states", t3-t2);
 
     /* report number of created/reused nodes */
     {
         size_t created_nodes = s2.counters[BDD_NODES_CREATED] - s1.counters[BDD_NODES_CREATED];
         size_t reused_nodes = s2.counters[BDD_NODES_REUSED] - s1.counters[BDD_NODES_REUSED];
         INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
-        if (verbosity >= 1) {
+        if (ctx->options.verbosity >= 1) {
             size_t created_nodes = s3.counters[BDD_NODES_CREATED] - s2.counters[BDD_NODES_CREATED];
             size_t reused_nodes = s3.counters[BDD_NODES_REUSED] - s2.counters[BDD_NODES_REUSED];
             INFO("Number of MTBDD nodes created: %'zu. (%'zu new, %'zu reused)", created_nodes + reused_nodes, created_nodes, reused_nodes);
@@ -2088,7 +2132,7 @@ void Minimizations::minimize3(IMC &imc, BDD partition)
 
     /* report data */
     {
-        double trans_count = mtbdd_satcount(imc.getMarkovTransitions().GetMTBDD(), block_length * 2);
+        double trans_count = mtbdd_satcount(imc.getMarkovTransitions().GetMTBDD(), ctx->block_length * 2);
         size_t node_count = mtbdd_nodecount(imc.getMarkovTransitions().GetMTBDD());
         INFO("New Markov transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
     }
@@ -2098,7 +2142,7 @@ void Minimizations::minimize3(IMC &imc, BDD partition)
         double trans_count = 0;
         MTBDD trans[n_relations];
         for (int i=0; i<n_relations; i++) trans[i] = imc.transitions[i].first.GetBDD();
-        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], block_length * 2 + action_length);
+        for (int i=0; i<n_relations; i++) trans_count += mtbdd_satcount(trans[i], ctx->block_length * 2 + action_length);
         size_t node_count = mtbdd_nodecount_more(trans, n_relations);
         INFO("New interactive transition relation: %'0.0f transitions, %'zu MTBDD nodes.", trans_count, node_count);
     }
@@ -2108,18 +2152,18 @@ void Minimizations::minimize3(IMC &imc, BDD partition)
 /**
  * Print the partition to stdout
  */
-VOID_TASK_IMPL_2(enumerate_partition, BDD, partition, BDD, varT)
+VOID_TASK_IMPL_3(enumerate_partition, sigref_context*, ctx, BDD, partition, BDD, varT)
 {
     int state_length = sylvan_set_count(varT);
-    MTBDD vars = sylvan_and(varT, block_variables);
-    uint8_t arr[state_length + block_length];
+    MTBDD vars = sylvan_and(varT, ctx->block_variables);
+    uint8_t arr[state_length + ctx->block_length];
     printf("State    Block\n");
     MTBDD leaf = mtbdd_enum_all_first(partition, vars, arr, NULL);
     while (leaf != mtbdd_false) {
         uint64_t state = 0;
         for (int i=0; i<state_length; i++) if (arr[i]) state |= 1ULL<<i;
         uint64_t block = 0;
-        for (int i=0; i<block_length; i++) if (arr[state_length+i]) block |= 1ULL<<i;
+        for (int i=0; i<ctx->block_length; i++) if (arr[state_length+i]) block |= 1ULL<<i;
         printf("%-8zu %zu\n", state, block);
         leaf = mtbdd_enum_all_next(partition, vars, arr, NULL);
     }
@@ -25,59 +25,63 @@
 namespace sigref {
 
 /**
- * Trim unneeded block variables from the partition.
+ * Trim unneeded block variables from the partition, and from the block encoding of <ctx>.
  */
-TASK_DECL_1(BDD, trim_block_variables, BDD);
-#define trim_block_variables(partition) CALL(trim_block_variables, partition)
+TASK_DECL_2(BDD, trim_block_variables, sigref_context*, BDD);
+#define trim_block_variables(ctx, partition) CALL(trim_block_variables, ctx, partition)
 
+/**
+ * The functions below compute the quotient for the last partition computed with <ctx>,
+ * using its block encoding and its options (bisimulation and leaf type).
+ */
 class Minimizations {
 public:
     /**
      * Minimize a CTMC using the given partition and standard BDD operations.
      */
-    static void minimize1(CTMC &ctmc, BDD partition);
+    static void minimize1(sigref_context *ctx, CTMC &ctmc, BDD partition);
 
     /**
      * Minimize an LTS using the given partition and standard BDD operations.
      * If <improved> is non-zero, use the 'optimized' variation of Wimmer's sigref.
      */
-    static void minimize1(LTS &lts, BDD partition, int improved);
+    static void minimize1(sigref_context *ctx, LTS &lts, BDD partition, int improved);
 
     /**
      * Minimize an IMC using the given partition and custom BDD operations.
      * If <improved> is non-zero, use the 'optimized' variation of Wimmer's sigref.
      */
-    static void minimize1(IMC &imc, BDD partition, int improved);
+    static void minimize1(sigref_context *ctx, IMC &imc, BDD partition, int improved);
 
     /**
      * Minimize a CTMC using the given partition and custom BDD operations.
      */
-    static void minimize2(CTMC &ctmc, BDD partition);
+    static void minimize2(sigref_context *ctx, CTMC &ctmc, BDD partition);
 
     /**
      * Minimize an LTS using the given partition and custom BDD operations.
      */
-    static void minimize2(LTS &lts, BDD partition);
+    static void minimize2(sigref_context *ctx, LTS &lts, BDD partition);
 
     /**
      * Minimize an IMC using the given partition and custom BDD operations.
      */
-    static void minimize2(IMC &imc, BDD partition);
+    static void minimize2(sigref_context *ctx, IMC &imc, BDD partition);
 
     /**
      * Minimize a CTMC using the given partition and pick-random encoding.
      */
-    static void minimize3(CTMC &ctmc, BDD partition);
+    static void minimize3(sigref_context *ctx, CTMC &ctmc, BDD partition);
 
     /**
      * Minimize an LTS using the given partition and pick-random encoding.
      */
-    static void minimize3(LTS &lts, BDD partition);
+    static void minimize3(sigref_context *ctx, LTS &lts, BDD partition);
 
     /**
      * Minimize an IMC using the given partition and pick-random encoding.
      */
-    static void minimize3(IMC &imc, BDD partition);
+    static void minimize3(sigref_context *ctx, IMC &imc, BDD partition);
 };
 
 }
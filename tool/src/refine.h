@@ -15,6 +15,7 @@
  */
 
 #include <sylvan.h>
+#include <context.h>
 
 #ifndef SIGREF_REFINE_H
 #define SIGREF_REFINE_H
@@ -23,14 +24,18 @@
 extern "C" {
 #endif
 
-#define refine(signatures, vars, partition) CALL(refine, signature, vars, partition)
-TASK_DECL_3(BDD, refine, MTBDD, BDD, BDD);
+#define refine(ctx, signature, vars, partition) CALL(refine, ctx, signature, vars, partition)
+TASK_DECL_4(BDD, refine, sigref_context*, MTBDD, BDD, BDD);
 
-size_t count_blocks();
-void set_signatures_size(size_t count);
-size_t get_next_block();
-BDD get_signature(size_t index);
-void free_refine_data();
+size_t count_blocks(sigref_context *ctx);
+void set_block_count(sigref_context *ctx, size_t count);
+void set_signatures_size(sigref_context *ctx, size_t count);
+size_t get_next_block(sigref_context *ctx);
+BDD get_signature(sigref_context *ctx, size_t index);
+void free_refine_data(sigref_context *ctx);
+
+/* Allocate refinement data for a new context; freed by sigref_context_free */
+sigref_refine_data *refine_data_create();
 
 #ifdef __cplusplus
 }
@@ -16,7 +16,7 @@
 
 #include <assert.h>
 #include <stdio.h>
-#include <sys/mman.h> // for mmap, munmap, etc
+#include <stdlib.h>
 
 #include <sylvan_int.h>
 
@@ -30,36 +30,47 @@
  * In practice, we will run out of memory and time way before this.
  */
 
-static BDD *signatures = NULL;
-static size_t signatures_size = 0;
-static uint32_t next_block = 1;
-static size_t refine_iteration = 0;
+struct sigref_refine_data
+{
+    BDD *signatures;
+    size_t signatures_size;
+    uint32_t next_block;
+    size_t refine_iteration;
 
-static uint64_t *table = NULL;
-static size_t table_size = 0;
+    uint64_t *table;
+    size_t table_size;
 
-static uint64_t *old_table = NULL;
-static size_t old_table_size = 0;
-static int go_resize = 0;
+    uint64_t *old_table;
+    size_t old_table_size;
+    int go_resize;
+};
 
-void
-prepare_refine()
+sigref_refine_data *
+refine_data_create()
 {
-    if (signatures != NULL) {
-        munmap(signatures, sizeof(BDD)*signatures_size);
+    sigref_refine_data *data = (sigref_refine_data*)calloc(1, sizeof(sigref_refine_data));
+    data->next_block = 1;
+    return data;
+}
+
+static void
+prepare_refine(sigref_refine_data *data)
+{
+    if (data->signatures != NULL) {
+        pages_unmap(data->signatures, sizeof(BDD)*data->signatures_size);
     }
-    signatures = (BDD*)mmap(0, sizeof(BDD)*signatures_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, 0, 0);
-    if (signatures == (BDD*)-1) {
-        fprintf(stderr, "sigref: Unable to allocate memory (%'zu bytes) for the signatures!\n", signatures_size*sizeof(BDD));
+    data->signatures = (BDD*)pages_map(sizeof(BDD)*data->signatures_size, 0);
+    if (data->signatures == NULL) {
+        fprintf(stderr, "sigref: Unable to allocate memory (%'zu bytes) for the signatures!\n", data->signatures_size*sizeof(BDD));
         exit(1);
     }
-    refine_iteration++;
+    data->refine_iteration++;
 
-    if (table != NULL) munmap(table, 3*8*table_size);
-    table_size = 1ULL<<14;
-    table = (uint64_t*)mmap(0, 3*8*table_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, 0, 0);
-    if (table == (uint64_t*)-1) {
-        fprintf(stderr, "sigref: Unable to allocate memory (%'zu bytes) for the table!\n", 3*8*table_size);
+    if (data->table != NULL) pages_unmap(data->table, 3*8*data->table_size);
+    data->table_size = 1ULL<<14;
+    data->table = (uint64_t*)pages_map(3*8*data->table_size, 0);
+    if (data->table == NULL) {
+        fprintf(stderr, "sigref: Unable to allocate memory (%'zu bytes) for the table!\n", 3*8*data->table_size);
         exit(1);
     }
 }
@@ -76,27 +87,27 @@ _hash(uint64_t a, uint64_t b)
     return hash ^ (hash>>32);
 }
 
-VOID_TASK_2(rehash, size_t, first, size_t, count)
+VOID_TASK_3(rehash, sigref_refine_data*, data, size_t, first, size_t, count)
 {
     if (count > 128) {
-        SPAWN(rehash, first, count/2);
-        CALL(rehash, first+count/2, count-count/2);
+        SPAWN(rehash, data, first, count/2);
+        CALL(rehash, data, first+count/2, count-count/2);
         SYNC(rehash);
         return;
     }
 
     while (count--) {
-        uint64_t *old_ptr = old_table + first*3;
+        uint64_t *old_ptr = data->old_table + first*3;
         uint64_t a = old_ptr[0];
         uint64_t b = old_ptr[1];
         uint64_t c = old_ptr[2];
 
         uint64_t hash = _hash(a, b);
-        uint64_t pos = hash % table_size;
+        uint64_t pos = hash % data->table_size;
 
         volatile uint64_t *ptr = 0;
         for (;;) {
-            ptr = table + pos*3;
+            ptr = data->table + pos*3;
             if (*ptr == 0) {
                 if (cas(ptr, 0, a)) {
                     ptr[1] = b;
@@ -105,35 +116,35 @@ VOID_TASK_2(rehash, size_t, first, size_t, count)
                 }
             }
             pos++;
-            if (pos >= table_size) pos = 0;
+            if (pos >= data->table_size) pos = 0;
         }
 
         first++;
     }
 }
 
-VOID_TASK_0(grow_it)
+VOID_TASK_1(grow_it, sigref_refine_data*, data)
 {
-    old_table = table;
-    old_table_size = table_size;
+    data->old_table = data->table;
+    data->old_table_size = data->table_size;
 
-    table_size = old_table_size*2;
-    table = (uint64_t*)mmap(0, 3*8*table_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, 0, 0);
-    if (table == (uint64_t*)-1) {
-        fprintf(stderr, "sigref: Unable to allocate memory (%'zu bytes) for the table!\n", 3*8*table_size);
+    data->table_size = data->old_table_size*2;
+    data->table = (uint64_t*)pages_map(3*8*data->table_size, 0);
+    if (data->table == NULL) {
+        fprintf(stderr, "sigref: Unable to allocate memory (%'zu bytes) for the table!\n", 3*8*data->table_size);
         exit(1);
     }
 
-    CALL(rehash, 0, old_table_size);
+    CALL(rehash, data, 0, data->old_table_size);
 
-    munmap(old_table, 3*8*old_table_size);
+    pages_unmap(data->old_table, 3*8*data->old_table_size);
 }
 
-VOID_TASK_0(grow)
+VOID_TASK_1(grow, sigref_refine_data*, data)
 {
-    if (cas(&go_resize, 0, 1)) {
-        NEWFRAME(grow_it);
-        go_resize = 0;
+    if (cas(&data->go_resize, 0, 1)) {
+        NEWFRAME(grow_it, data);
+        data->go_resize = 0;
     } else {
         /* wait for new frame to appear */
         while (*(Task* volatile*)&(lace_newframe.t) == 0) {}
@@ -142,16 +153,16 @@ VOID_TASK_0(grow)
 }
 
 static uint64_t
-search_or_insert(uint64_t sig, uint64_t previous_block)
+search_or_insert(sigref_refine_data *data, uint64_t sig, uint64_t previous_block)
 {
     uint64_t hash = _hash(sig, previous_block);
-    uint64_t pos = hash % table_size;
+    uint64_t pos = hash % data->table_size;
 
     volatile uint64_t *ptr = 0;
     uint64_t a, b, c;
     int count = 0;
     for (;;) {
-        ptr = table + pos*3;
+        ptr = data->table + pos*3;
         a = *ptr;
         if (a == sig) {
             while ((b=ptr[1]) == 0) continue;
@@ -161,7 +172,7 @@ search_or_insert(uint64_t sig, uint64_t previous_block)
             }
         } else if (a == 0) {
             if (cas(ptr, 0, sig)) {
-                c = ptr[2] = __sync_fetch_and_add(&next_block, 1);
+                c = ptr[2] = __sync_fetch_and_add(&data->next_block, 1);
                 ptr[1] = previous_block;
                 return c;
             } else {
@@ -169,13 +180,15 @@ search_or_insert(uint64_t sig, uint64_t previous_block)
             }
         }
         pos++;
-        if (pos >= table_size) pos = 0;
+        if (pos >= data->table_size) pos = 0;
         if (++count >= 128) return 0;
     }
 }
 
-TASK_2(BDD, assign_block, BDD, sig, BDD, previous_block)
+TASK_3(BDD, assign_block, sigref_context*, ctx, BDD, sig, BDD, previous_block)
 {
+    sigref_refine_data *data = ctx->refine;
+
     assert(previous_block != mtbdd_false); // if so, incorrect call!
 
     // maybe do garbage collection
@@ -191,26 +204,28 @@ TASK_2(BDD, assign_block, BDD, sig, BDD, previous_block)
     assert(p_b != 0);
 
     for (;;) {
-        BDD cur = *(volatile BDD*)&signatures[p_b];
+        BDD cur = *(volatile BDD*)&data->signatures[p_b];
         if (cur == sig) return previous_block;
         if (cur != 0) break;
-        if (cas(&signatures[p_b], 0, sig)) return previous_block;
+        if (cas(&data->signatures[p_b], 0, sig)) return previous_block;
     }
 
     // no previous block number, search or insert
     uint64_t c;
-    while ((c = search_or_insert(sig, previous_block)) == 0) CALL(grow);
+    while ((c = search_or_insert(data, sig, previous_block)) == 0) CALL(grow, data);
 
-    if (c >= signatures_size) {
+    if (c >= data->signatures_size) {
         fprintf(stderr, "Out of cheese exception, no more blocks available\n");
         exit(1);
     }
 
-    return CALL(encode_block, c);
+    return CALL(encode_block, ctx, c);
 }
 
-TASK_3(BDD, refine_partition, BDD, dd, BDD, vars, BDD, previous_partition)
+TASK_4(BDD, refine_partition, sigref_context*, ctx, BDD, dd, BDD, vars, BDD, previous_partition)
 {
+    const size_t refine_iteration = ctx->refine->refine_iteration;
+
     /* expecting dd as in s,a,B */
     /* expecting vars to be conjunction of variables in s */
     /* expecting previous_partition as in t,B */
@@ -221,10 +236,14 @@ TASK_3(BDD, refine_partition, BDD, dd, BDD, vars, BDD, previous_partition)
     }
 
     if (sylvan_set_isempty(vars)) {
+        sigref_op_count(SIGREF_OP_REFINE);
         BDD result;
-        if (cache_get3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), &result)) return result;
-        result = CALL(assign_block, dd, previous_partition);
-        cache_put3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), result);
+        if (cache_get3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), &result)) {
+            sigref_op_cached(SIGREF_OP_REFINE);
+            return result;
+        }
+        result = CALL(assign_block, ctx, dd, previous_partition);
+        if (cache_put3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), result)) sigref_op_cachedput(SIGREF_OP_REFINE);
         return result;
     }
 
@@ -239,13 +258,16 @@ TASK_3(BDD, refine_partition, BDD, dd, BDD, vars, BDD, previous_partition)
 
     while (vars_var < dd_var && vars_var+1 < pp_var) {
         vars = sylvan_set_next(vars);
-        if (sylvan_set_isempty(vars)) return CALL(refine_partition, dd, vars, previous_partition);
+        if (sylvan_set_isempty(vars)) return CALL(refine_partition, ctx, dd, vars, previous_partition);
         vars_var = sylvan_set_first(vars);
     }
 
+    sigref_op_count(SIGREF_OP_REFINE);
+
     /* Consult cache */
     BDD result;
     if (cache_get3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), &result)) {
+        sigref_op_cached(SIGREF_OP_REFINE);
         return result;
     }
 
@@ -268,8 +290,8 @@ TASK_3(BDD, refine_partition, BDD, dd, BDD, vars, BDD, previous_partition)
 
     /* Recursive steps */
     BDD next_vars = sylvan_set_next(vars);
-    bdd_refs_spawn(SPAWN(refine_partition, dd_low, next_vars, pp_low));
-    BDD high = bdd_refs_push(CALL(refine_partition, dd_high, next_vars, pp_high));
+    bdd_refs_spawn(SPAWN(refine_partition, ctx, dd_low, next_vars, pp_low));
+    BDD high = bdd_refs_push(CALL(refine_partition, ctx, dd_high, next_vars, pp_high));
     BDD low = bdd_refs_sync(SYNC(refine_partition));
     bdd_refs_pop(1);
 
@@ -277,52 +299,64 @@ TASK_3(BDD, refine_partition, BDD, dd, BDD, vars, BDD, previous_partition)
     result = sylvan_makenode(vars_var+1, low, high);
 
     /* Write to cache */
-    cache_put3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), result);
+    if (cache_put3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), result)) sigref_op_cachedput(SIGREF_OP_REFINE);
     return result;
 }
 
-TASK_IMPL_3(BDD, refine, MTBDD, signature, BDD, vars, BDD, previous_partition)
+TASK_IMPL_4(BDD, refine, sigref_context*, ctx, MTBDD, signature, BDD, vars, BDD, previous_partition)
 {
-    prepare_refine();
-    return CALL(refine_partition, signature, vars, previous_partition);
+    prepare_refine(ctx->refine);
+    return sigref_op_timed(SIGREF_OP_REFINE, BDD, CALL(refine_partition, ctx, signature, vars, previous_partition));
 }
 
 size_t
-count_blocks()
+count_blocks(sigref_context *ctx)
+{
+    sigref_refine_data *data = ctx->refine;
+    return data->next_block - 1;
+}
+
+void
+set_block_count(sigref_context *ctx, size_t count)
 {
-    return next_block - 1;
+    sigref_refine_data *data = ctx->refine;
+    data->next_block = count + 1;
 }
 
 void
-set_signatures_size(size_t count)
+set_signatures_size(sigref_context *ctx, size_t count)
 {
-    signatures_size = count;
+    sigref_refine_data *data = ctx->refine;
+    data->signatures_size = count;
 }
 
 size_t
-get_next_block()
+get_next_block(sigref_context *ctx)
 {
-    return next_block++;
+    sigref_refine_data *data = ctx->refine;
+    return data->next_block++;
 }
 
 BDD
-get_signature(size_t index)
+get_signature(sigref_context *ctx, size_t index)
 {
-    BDD result = signatures[index+1];
+    sigref_refine_data *data = ctx->refine;
+    BDD result = data->signatures[index+1];
     if (result == (uint64_t)-1) return sylvan_false;
     else return result;
 }
 
 void
-free_refine_data()
+free_refine_data(sigref_context *ctx)
 {
-    if (signatures != NULL) {
-        munmap(signatures, sizeof(BDD)*signatures_size);
-        signatures = NULL;
+    sigref_refine_data *data = ctx->refine;
+    if (data->signatures != NULL) {
+        pages_unmap(data->signatures, sizeof(BDD)*data->signatures_size);
+        data->signatures = NULL;
     }
 
-    if (table != NULL) {
-        munmap(table, 3*8*table_size);
-        table = NULL;
+    if (data->table != NULL) {
+        pages_unmap(data->table, 3*8*data->table_size);
+        data->table = NULL;
     }
 }
@@ -16,7 +16,7 @@
 
 #include <assert.h>
 #include <stdio.h>
-#include <sys/mman.h> // for mmap, munmap, etc
+#include <stdlib.h>
 
 #include <sylvan_int.h>
 
@@ -38,27 +38,40 @@ typedef struct
     uint32_t next[SL_DEPTH];
 } signature_elem;
 
-static signature_elem *signatures = NULL;
-static size_t signatures_size = 0;
-static uint32_t next_block = 1;
-static size_t refine_iteration = 0;
+struct sigref_refine_data
+{
+    signature_elem *signatures;
+    size_t signatures_size;
+    uint32_t next_block;
+    size_t refine_iteration;
+};
+
+sigref_refine_data *
+refine_data_create()
+{
+    sigref_refine_data *data = (sigref_refine_data*)calloc(1, sizeof(sigref_refine_data));
+    data->next_block = 1;
+    return data;
+}
 
-void
-prepare_refine()
+static void
+prepare_refine(sigref_refine_data *data)
 {
-    if (signatures != NULL) {
-        munmap(signatures, sizeof(signature_elem)*signatures_size);
+    if (data->signatures != NULL) {
+        pages_unmap(data->signatures, sizeof(signature_elem)*data->signatures_size);
     }
-    signatures = (signature_elem*)mmap(0, sizeof(signature_elem)*signatures_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, 0, 0);
-    if (signatures == (signature_elem*)-1) {
-        fprintf(stderr, "sigref: Unable to allocate memory (%'zu bytes) for the signatures!\n", signatures_size*sizeof(signature_elem));
+    data->signatures = (signature_elem*)pages_map(sizeof(signature_elem)*data->signatures_size, 0);
+    if (data->signatures == NULL) {
+        fprintf(stderr, "sigref: Unable to allocate memory (%'zu bytes) for the signatures!\n", data->signatures_size*sizeof(signature_elem));
         exit(1);
     }
-    refine_iteration++;
+    data->refine_iteration++;
 }
 
-TASK_2(BDD, assign_block, BDD, sig, BDD, previous_block)
+TASK_3(BDD, assign_block, sigref_context*, ctx, BDD, sig, BDD, previous_block)
 {
+    sigref_refine_data *data = ctx->refine;
+
     assert(previous_block != mtbdd_false); // if so, incorrect call!
 
     // maybe do garbage collection
@@ -74,10 +87,10 @@ TASK_2(BDD, assign_block, BDD, sig, BDD, previous_block)
     assert(p_b != 0);
 
     for (;;) {
-        BDD cur = *(volatile BDD*)&signatures[p_b].sig;
+        BDD cur = *(volatile BDD*)&data->signatures[p_b].sig;
         if (cur == sig) return previous_block;
         if (cur != 0) break;
-        if (cas(&signatures[p_b].sig, 0, sig)) return previous_block;
+        if (cas(&data->signatures[p_b].sig, 0, sig)) return previous_block;
     }
 
     /* claim unsuccesful, find newly added */
@@ -86,15 +99,15 @@ TASK_2(BDD, assign_block, BDD, sig, BDD, previous_block)
     for (;;) {
         /* invariant: [loc].sig < sig */
         /* note: this is always true for loc==0 */
-        signature_elem *e = &signatures[loc];
+        signature_elem *e = &data->signatures[loc];
         loc_next = (*(volatile uint32_t*)&e->next[k]) & 0x7fffffff;
-        if (loc_next != 0 && signatures[loc_next].sig == sig && signatures[loc_next].prev == p_b) {
+        if (loc_next != 0 && data->signatures[loc_next].sig == sig && data->signatures[loc_next].prev == p_b) {
             /* found */
-            return CALL(encode_block, loc_next);
-        } else if (loc_next != 0 && signatures[loc_next].sig == sig && signatures[loc_next].prev < p_b) {
+            return CALL(encode_block, ctx, loc_next);
+        } else if (loc_next != 0 && data->signatures[loc_next].sig == sig && data->signatures[loc_next].prev < p_b) {
             /* go right */
             loc = loc_next;
-        } else if (loc_next != 0 && signatures[loc_next].sig < sig) {
+        } else if (loc_next != 0 && data->signatures[loc_next].sig < sig) {
             /* go right */
             loc = loc_next;
         } else if (k > 0) {
@@ -108,20 +121,20 @@ TASK_2(BDD, assign_block, BDD, sig, BDD, previous_block)
     }
 
     /* claim next item */
-    const uint32_t b_nr = __sync_fetch_and_add(&next_block, 1);
+    const uint32_t b_nr = __sync_fetch_and_add(&data->next_block, 1);
 
-    if (b_nr >= signatures_size) {
+    if (b_nr >= data->signatures_size) {
         fprintf(stderr, "Out of cheese exception, no more blocks available\n");
         exit(1);
     }
 
     /* fill next item */
-    signature_elem *a = &signatures[b_nr];
+    signature_elem *a = &data->signatures[b_nr];
     a->sig = sig;
     a->prev = p_b;
     a->next[0] = loc_next;
     compiler_barrier();
-    signatures[loc].next[0] = b_nr;
+    data->signatures[loc].next[0] = b_nr;
 
     /* determine height */
     uint64_t h = 1 + __builtin_clz(LACE_TRNG) / 2;
@@ -131,12 +144,12 @@ TASK_2(BDD, assign_block, BDD, sig, BDD, previous_block)
     for (k=1;k<h;k++) {
         loc = trace[k];
         for (;;) {
-            signature_elem *e = &signatures[loc];
+            signature_elem *e = &data->signatures[loc];
             /* note, at k>0, no locks on edges */
             uint32_t loc_next = *(volatile uint32_t*)&e->next[k];
-            if (loc_next != 0 && signatures[loc_next].sig == sig && signatures[loc_next].prev < p_b) {
+            if (loc_next != 0 && data->signatures[loc_next].sig == sig && data->signatures[loc_next].prev < p_b) {
                 loc = loc_next;
-            } else if (loc_next != 0 && signatures[loc_next].sig < sig) {
+            } else if (loc_next != 0 && data->signatures[loc_next].sig < sig) {
                 loc = loc_next;
             } else {
                 a->next[k] = loc_next;
@@ -145,11 +158,13 @@ TASK_2(BDD, assign_block, BDD, sig, BDD, previous_block)
         }
     }
 
-    return CALL(encode_block, b_nr);
+    return CALL(encode_block, ctx, b_nr);
 }
 
-TASK_3(BDD, refine_partition, BDD, dd, BDD, vars, BDD, previous_partition)
+TASK_4(BDD, refine_partition, sigref_context*, ctx, BDD, dd, BDD, vars, BDD, previous_partition)
 {
+    const size_t refine_iteration = ctx->refine->refine_iteration;
+
     /* expecting dd as in s,a,B */
     /* expecting vars to be conjunction of variables in s */
     /* expecting previous_partition as in t,B */
@@ -160,10 +175,14 @@ TASK_3(BDD, refine_partition, BDD, dd, BDD, vars, BDD, previous_partition)
     }
 
     if (sylvan_set_isempty(vars)) {
+        sigref_op_count(SIGREF_OP_REFINE);
         BDD result;
-        if (cache_get3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), &result)) return result;
-        result = CALL(assign_block, dd, previous_partition);
-        cache_put3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), result);
+        if (cache_get3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), &result)) {
+            sigref_op_cached(SIGREF_OP_REFINE);
+            return result;
+        }
+        result = CALL(assign_block, ctx, dd, previous_partition);
+        if (cache_put3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), result)) sigref_op_cachedput(SIGREF_OP_REFINE);
         return result;
     }
 
@@ -178,13 +197,16 @@ TASK_3(BDD, refine_partition, BDD, dd, BDD, vars, BDD, previous_partition)
 
     while (vars_var < dd_var && vars_var+1 < pp_var) {
         vars = sylvan_set_next(vars);
-        if (sylvan_set_isempty(vars)) return CALL(refine_partition, dd, vars, previous_partition);
+        if (sylvan_set_isempty(vars)) return CALL(refine_partition, ctx, dd, vars, previous_partition);
         vars_var = sylvan_set_first(vars);
     }
 
+    sigref_op_count(SIGREF_OP_REFINE);
+
     /* Consult cache */
     BDD result;
     if (cache_get3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), &result)) {
+        sigref_op_cached(SIGREF_OP_REFINE);
         return result;
     }
 
@@ -207,8 +229,8 @@ TASK_3(BDD, refine_partition, BDD, dd, BDD, vars, BDD, previous_partition)
 
     /* Recursive steps */
     BDD next_vars = sylvan_set_next(vars);
-    bdd_refs_spawn(SPAWN(refine_partition, dd_low, next_vars, pp_low));
-    BDD high = bdd_refs_push(CALL(refine_partition, dd_high, next_vars, pp_high));
+    bdd_refs_spawn(SPAWN(refine_partition, ctx, dd_low, next_vars, pp_low));
+    BDD high = bdd_refs_push(CALL(refine_partition, ctx, dd_high, next_vars, pp_high));
     BDD low = bdd_refs_sync(SYNC(refine_partition));
     bdd_refs_pop(1);
 
@@ -216,47 +238,59 @@ TASK_3(BDD, refine_partition, BDD, dd, BDD, vars, BDD, previous_partition)
     result = sylvan_makenode(vars_var+1, low, high);
 
     /* Write to cache */
-    cache_put3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), result);
+    if (cache_put3(CACHE_REFINE, dd, vars, previous_partition|(refine_iteration<<40), result)) sigref_op_cachedput(SIGREF_OP_REFINE);
     return result;
 }
 
-TASK_IMPL_3(BDD, refine, MTBDD, signature, BDD, vars, BDD, previous_partition)
+TASK_IMPL_4(BDD, refine, sigref_context*, ctx, MTBDD, signature, BDD, vars, BDD, previous_partition)
 {
-    prepare_refine();
-    return CALL(refine_partition, signature, vars, previous_partition);
+    prepare_refine(ctx->refine);
+    return sigref_op_timed(SIGREF_OP_REFINE, BDD, CALL(refine_partition, ctx, signature, vars, previous_partition));
 }
 
 size_t
-count_blocks()
+count_blocks(sigref_context *ctx)
+{
+    sigref_refine_data *data = ctx->refine;
+    return data->next_block - 1;
+}
+
+void
+set_block_count(sigref_context *ctx, size_t count)
 {
-    return next_block - 1;
+    sigref_refine_data *data = ctx->refine;
+    data->next_block = count + 1;
 }
 
 void
-set_signatures_size(size_t count)
+set_signatures_size(sigref_context *ctx, size_t count)
 {
-    signatures_size = count;
+    sigref_refine_data *data = ctx->refine;
+    data->signatures_size = count;
 }
 
 size_t
-get_next_block()
+get_next_block(sigref_context *ctx)
 {
-    return next_block++;
+    sigref_refine_data *data = ctx->refine;
+    return data->next_block++;
 }
 
 BDD
-get_signature(size_t index)
+get_signature(sigref_context *ctx, size_t index)
 {
-    BDD result = signatures[index+1].sig;
+    sigref_refine_data *data = ctx->refine;
+    BDD result = data->signatures[index+1].sig;
     if (result == (uint64_t)-1) return sylvan_false;
     else return result;
 }
 
 void
-free_refine_data()
+free_refine_data(sigref_context *ctx)
 {
-    if (signatures != NULL) {
-        munmap(signatures, sizeof(signature_elem)*signatures_size);
-        signatures = NULL;
+    sigref_refine_data *data = ctx->refine;
+    if (data->signatures != NULL) {
+        pages_unmap(data->signatures, sizeof(signature_elem)*data->signatures_size);
+        data->signatures = NULL;
     }
 }
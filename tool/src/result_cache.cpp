@@ -0,0 +1,252 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sylvan.h>
+#include <sha2.h>
+
+#include <blocks.h>
+#include <refine.h>
+#include <result_cache.hpp>
+#include <sigref.h>
+
+namespace sigref {
+
+using namespace sylvan;
+
+/* Bump this whenever the format of the cached files or the meaning of the partition changes */
+#define RESULT_CACHE_VERSION 1
+
+static const char result_cache_magic[8] = {'s','i','g','r','e','f','p','\0'};
+
+/**
+ * Helpers to feed decision diagrams and configuration to the hash
+ */
+static void
+sha_add_dd(SHA256_CTX *ctx, MTBDD dd)
+{
+    char buf[SHA256_DIGEST_STRING_LENGTH];
+    mtbdd_getsha(dd, buf);
+    SHA256_Update(ctx, (const uint8_t*)buf, strlen(buf));
+}
+
+static void
+sha_add_int(SHA256_CTX *ctx, int value)
+{
+    SHA256_Update(ctx, (const uint8_t*)&value, sizeof(int));
+}
+
+static void
+sha_add_state_system(SHA256_CTX *ctx, const sigref_options &options, StateSystem &system, int type)
+{
+    sha_add_int(ctx, RESULT_CACHE_VERSION);
+    sha_add_int(ctx, type);
+    sha_add_int(ctx, options.ordering);
+    sha_add_int(ctx, options.reachable);
+    sha_add_dd(ctx, system.getVarS().GetBDD());
+    sha_add_dd(ctx, system.getVarT().GetBDD());
+    sha_add_dd(ctx, system.getVarA().GetBDD());
+    sha_add_dd(ctx, system.getStates().GetBDD());
+    sha_add_dd(ctx, system.getInitialStates().GetBDD());
+    std::vector<Bdd> initial_partition = system.getInitialPartition();
+    sha_add_int(ctx, initial_partition.size());
+    for (Bdd &block : initial_partition) sha_add_dd(ctx, block.GetBDD());
+}
+
+static void
+sha_add_transitions(SHA256_CTX *ctx, LTS &lts)
+{
+    std::vector<std::pair<Bdd, Bdd>> transitions = lts.getTransitions();
+    sha_add_int(ctx, transitions.size());
+    for (auto &rel : transitions) {
+        sha_add_dd(ctx, rel.first.GetBDD());
+        sha_add_dd(ctx, rel.second.GetBDD());
+    }
+    sha_add_dd(ctx, lts.getTau().GetBDD());
+}
+
+std::string
+ResultCache::fingerprint(const sigref_options &options, LTS &lts)
+{
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    sha_add_state_system(&ctx, options, lts, 0);
+    sha_add_transitions(&ctx, lts);
+    sha_add_int(&ctx, options.bisimulation);
+    sha_add_int(&ctx, options.merge_relations);
+    sha_add_int(&ctx, options.closure);
+    char buf[SHA256_DIGEST_STRING_LENGTH];
+    SHA256_End(&ctx, buf);
+    return std::string(buf);
+}
+
+std::string
+ResultCache::fingerprint(const sigref_options &options, CTMC &ctmc)
+{
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    sha_add_state_system(&ctx, options, ctmc, 1);
+    sha_add_dd(&ctx, ctmc.getMarkovTransitions().GetMTBDD());
+    sha_add_int(&ctx, options.leaftype);
+    char buf[SHA256_DIGEST_STRING_LENGTH];
+    SHA256_End(&ctx, buf);
+    return std::string(buf);
+}
+
+std::string
+ResultCache::fingerprint(const sigref_options &options, IMC &imc)
+{
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    sha_add_state_system(&ctx, options, imc, 2);
+    sha_add_transitions(&ctx, imc);
+    sha_add_dd(&ctx, imc.getMarkovTransitions().GetMTBDD());
+    sha_add_int(&ctx, options.bisimulation);
+    sha_add_int(&ctx, options.leaftype);
+    sha_add_int(&ctx, options.merge_relations);
+    sha_add_int(&ctx, options.closure);
+    char buf[SHA256_DIGEST_STRING_LENGTH];
+    SHA256_End(&ctx, buf);
+    return std::string(buf);
+}
+
+ResultCache::ResultCache(const char *directory) : directory(directory)
+{
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Cannot create result cache directory '%s': %s!\n", directory, strerror(errno));
+    }
+}
+
+std::string
+ResultCache::entry(const std::string &fp, const std::string &suffix) const
+{
+    return directory + "/" + fp + "." + suffix;
+}
+
+/**
+ * Copy file <from> to <to>, via a temporary file and rename, so concurrent
+ * readers never observe a partially written file.
+ */
+static bool
+copy_file(const std::string &from, const std::string &to)
+{
+    FILE *in = fopen(from.c_str(), "rb");
+    if (in == NULL) return false;
+
+    std::string tmp = to + ".tmp." + std::to_string(getpid());
+    FILE *out = fopen(tmp.c_str(), "wb");
+    if (out == NULL) {
+        fclose(in);
+        return false;
+    }
+
+    bool ok = true;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+        if (fwrite(buf, 1, n, out) != n) {
+            ok = false;
+            break;
+        }
+    }
+    if (ferror(in)) ok = false;
+    fclose(in);
+    if (fclose(out) != 0) ok = false;
+
+    if (ok && rename(tmp.c_str(), to.c_str()) == 0) return true;
+    unlink(tmp.c_str());
+    return false;
+}
+
+bool
+ResultCache::loadPartition(sigref_context *ctx, const std::string &fp, BDD *partition)
+{
+    std::string filename = entry(fp, "partition");
+    FILE *f = fopen(filename.c_str(), "rb");
+    if (f == NULL) return false;
+
+    char magic[8];
+    uint64_t n_blocks;
+    int stored_block_length;
+    if (fread(magic, sizeof(magic), 1, f) != 1 ||
+        memcmp(magic, result_cache_magic, sizeof(magic)) != 0 ||
+        fread(&n_blocks, sizeof(uint64_t), 1, f) != 1 ||
+        fread(&stored_block_length, sizeof(int), 1, f) != 1 ||
+        stored_block_length != ctx->block_length) {
+        fprintf(stderr, "Ignoring invalid result cache entry '%s'.\n", filename.c_str());
+        fclose(f);
+        return false;
+    }
+
+    LACE_ME;
+    MTBDD result;
+    if (mtbdd_reader_frombinary(f, &result, 1) != 0) {
+        fprintf(stderr, "Ignoring invalid result cache entry '%s'.\n", filename.c_str());
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+
+    *partition = result;
+    set_block_count(ctx, n_blocks);
+    return true;
+}
+
+void
+ResultCache::storePartition(sigref_context *ctx, const std::string &fp, BDD partition)
+{
+    std::string filename = entry(fp, "partition");
+    std::string tmp = filename + ".tmp." + std::to_string(getpid());
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot write result cache entry '%s'!\n", filename.c_str());
+        return;
+    }
+
+    uint64_t n_blocks = count_blocks(ctx);
+    fwrite(result_cache_magic, sizeof(result_cache_magic), 1, f);
+    fwrite(&n_blocks, sizeof(uint64_t), 1, f);
+    fwrite(&ctx->block_length, sizeof(int), 1, f);
+
+    LACE_ME;
+    mtbdd_writer_tobinary(f, &partition, 1);
+
+    if (fclose(f) != 0 || rename(tmp.c_str(), filename.c_str()) != 0) {
+        fprintf(stderr, "Cannot write result cache entry '%s'!\n", filename.c_str());
+        unlink(tmp.c_str());
+    }
+}
+
+bool
+ResultCache::loadQuotient(const std::string &fp, const std::string &key, const char *filename)
+{
+    return copy_file(entry(fp, key), filename);
+}
+
+void
+ResultCache::storeQuotient(const std::string &fp, const std::string &key, const char *filename)
+{
+    if (!copy_file(filename, entry(fp, key))) {
+        fprintf(stderr, "Cannot write result cache entry '%s'!\n", entry(fp, key).c_str());
+    }
+}
+
+}
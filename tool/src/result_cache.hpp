@@ -0,0 +1,81 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+
+#include <sylvan.h>
+#include <context.h>
+#include <systems.hpp>
+
+#ifndef SIGREF_RESULT_CACHE_H
+#define SIGREF_RESULT_CACHE_H
+
+namespace sigref {
+
+/**
+ * On-disk cache of minimization results.
+ *
+ * Each entry is identified by the fingerprint of the loaded system, which is a SHA-256
+ * hash over the SHA-256 hashes of all decision diagrams of the system (see mtbdd_getsha)
+ * and the configuration that influences the result (bisimulation type, leaf type, ordering,
+ * reachable, and for LTSs and IMCs merge_relations and closure).
+ *
+ * For each fingerprint, the cache stores the final partition (in Sylvan binary format)
+ * and, if it was written, the quotient output file for each quotient/output type.
+ */
+class ResultCache {
+public:
+    ResultCache(const char *directory);
+
+    /**
+     * Compute the fingerprint of the given system, minimized with <options>.
+     */
+    static std::string fingerprint(const sigref_options &options, LTS &lts);
+    static std::string fingerprint(const sigref_options &options, CTMC &ctmc);
+    static std::string fingerprint(const sigref_options &options, IMC &imc);
+
+    /**
+     * Load the partition stored for <fp>.
+     * On success, sets <partition> and the number of blocks of <ctx> and returns true.
+     * Requires that prepare_blocks has been called for the system with <ctx>.
+     */
+    bool loadPartition(sigref_context *ctx, const std::string &fp, BDD *partition);
+
+    /**
+     * Store the (untrimmed) partition for <fp>, with the number of blocks of <ctx>.
+     */
+    void storePartition(sigref_context *ctx, const std::string &fp, BDD partition);
+
+    /**
+     * Copy the stored quotient for <fp> with type <key> to <filename>.
+     * Returns true if the cache contained this quotient.
+     */
+    bool loadQuotient(const std::string &fp, const std::string &key, const char *filename);
+
+    /**
+     * Store the quotient written to <filename> for <fp> with type <key>.
+     */
+    void storeQuotient(const std::string &fp, const std::string &key, const char *filename);
+
+private:
+    std::string entry(const std::string &fp, const std::string &suffix) const;
+
+    std::string directory;
+};
+
+}
+
+#endif
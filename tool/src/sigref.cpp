@@ -15,21 +15,39 @@
  */
 
 #include <argp.h>
+#include <errno.h>
 #include <locale.h>
+#include <signal.h>
 #include <stddef.h>
 #include <stdio.h>
-#include <sys/time.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 #ifdef HAVE_PROFILER
 #include <gperftools/profiler.h>
 #endif
 
 #include <bisimulation.hpp>
+#include <blocks.h>
+#include <compose.hpp>
 #include <parse_bdd.hpp>
+#include <parse_prism.hpp>
+#include <input_stream.hpp>
+#include <libsigref.hpp>
 #include <parse_xml.hpp>
 #include <sigref.h>
+#include <sigref_util.hpp>
+#include <sylvan_cache.h>
 #include <sylvan_gmp.h>
+#include <metrics.hpp>
 #include <refine.h>
+#include <result_cache.hpp>
+#include <steady_state.hpp>
+#include <symbolic_analysis.hpp>
+#include <table_sizes.hpp>
 #include <writer.hpp>
 #include <quotient.hpp>
 
@@ -39,22 +57,28 @@ using namespace sigref;
 /* Configuration */
 static char* model_filename = NULL;
 static char* output_filename = NULL;
+static char* result_cache_dir = NULL;
+static char* batch_filename = NULL;
+static char* daemon_socket = NULL;
+static char* metrics_filename = NULL;
+static char* trace_filename = NULL;
+static char* label_filename = NULL;
 #ifdef HAVE_PROFILER
 static char* profile_filename = NULL;
 #endif
 static int workers = 0; // autodetect
+static int exit_code = 0;
+static SteadyStateMethod steady_method = steady_none;
+static AnalysisMode analysis_mode = analysis_none;
+static double analysis_time = 0;
+static int numa_report = 0; // report the NUMA domains of the tables (--numa)
+static int huge_pages_report = 0; // report the huge pages of the tables (--huge-pages)
+static int cache_regions_report = 0; // report the hit rates of the cache regions (--cache-regions)
 
-int bisimulation = 1; // branching
-int leaftype = 2; // 0 = float, 1 = fraction, 2 = gmp
-int verbosity = 0; // default: no excessive node counting
-int merge_relations = 0; // merge relations to 1 relation
-int closure = 0; // 0 = fixpoint, 1 = squaring, 2 = recursive
-int reachable = 0; // 0 = no, 1 = yes
-int tau_action = 0; // default: 0
-int ordering = 0; // 0 = s,t < a < B, 1 = s,t < B < a, default: 0
+static Options context_options; // the options of the minimization (bisimulation, leaftype, ...), see context.h
 int quotient_type = 0; // 0 = no quotient, 1 = standard operations, 2 = standard operations variant 2, 3 = custom operations, 4 = pick-random, 5 = test (generate explicit output file for each type except pick-random)
-int output_type = 0; // 0 = no output, 1 = explicit output, 2 = symbolic output
-const char *table_sizes = "26,31,25,30"; // default table sizes (powers of 2)
+int output_type = 0; // 0 = no output, 1 = explicit output, 2 = symbolic output, 3 = PRISM explicit output
+const char *table_sizes = "26,31,25,30"; // default table sizes (powers of 2), or "auto"
 
 /* argp configuration */
 static struct argp_option options[] =
@@ -68,15 +92,57 @@ static struct argp_option options[] =
     {"reachable", 'r', 0, 0, "Limit partition to reachable states", 0},
     {"tau", 't', "<tau-action>", 0, "Which action is tau (default=0)", 0},
     {"blocks-first", 1, 0, 0, "Order block variables before action variables", 0},
-    {"table-sizes", 2, "<tablesize,tablemax,cachesize,cachemax>", 0, "Nodes table and operation cache sizes as powers of 2", 0},
+    {"table-sizes", 2, "<tablesize,tablemax,cachesize,cachemax>", 0, "Nodes table and operation cache sizes as powers of 2, or \"auto\"", 0},
+    {"result-cache", 3, "<directory>", 0, "Directory for caching minimization results", 0},
+    {"batch", 4, "<manifest>", 0, "Minimize all models listed in the manifest, one per line (model [output])", 0},
+    {"daemon", 5, "<socket>", 0, "Run as daemon, accepting jobs on the Unix domain socket", 0},
+    {"metrics", 7, "<filename>", 0, "Write metrics per iteration and per phase as JSON lines", 0},
+    {"trace", 8, "<filename>", 0, "Write a timeline of the workers as Chrome trace-event JSON", 0},
+    {"memory-limit", 6, "<bytes>", 0, "Keep the nodes table and operation cache within this limit (suffix K, M, G or T)", 0},
+    {"time-limit", 9, "<seconds>", 0, "Stop refinement after this time and use the partition so far (not stable)", 0},
+    {"max-iterations", 10, "<k>", 0, "Stop refinement after k iterations (k-bisimulation)", 0},
+    {"labels", 11, "<filename>", 0, "Label file; the initial partition has one block per combination of labels", 0},
+    {"steady-state", 12, "<method>", 0, "Stationary distribution of the quotient CTMC (\"jacobi\", \"gauss-seidel\", \"power\")", 0},
+    {"analysis", 13, "<mode>", 0, "Symbolic analysis of the quotient CTMC (\"steady\", \"transient:<time>\")", 0},
+    {"stats", 14, "<statistics>", 0, "Statistics of the transitions (\"none\", \"cheap\", \"full\" (default))", 0},
+    {"compact", 15, 0, 0, "Compact the nodes table after garbage collection, storing the nodes by variable", 0},
+    {"numa", 16, "<placement>", 0, "NUMA placement of the nodes table and operation cache (\"default\", \"interleave\", \"owner\")", 0},
+    {"huge-pages", 17, "<pages>", 0, "Huge pages for the nodes table, operation cache and signatures (\"none\", \"transparent\", \"hugetlb\")", 0},
+    {"cache-regions", 18, "<refine,signature,quotient>", 0, "Percentages of the operation cache for refinement, signature and quotient operations (the rest is for other operations)", 0},
 #ifdef HAVE_PROFILER
     {"profiler", 'p', "<filename>", 0, "Filename for profiling", 0},
 #endif
     {"quotient", 'q', "<quotient type>", 0, "Quotient (type: \"pick-random\", \"block\", \"block-s1\", \"block-s2\")", 0},
-    {"output-type", 'o', "<output type>", 0, "Output type (\"explicit\", \"symbolic\")", 0},
+    {"output-type", 'o', "<output type>", 0, "Output type (\"explicit\", \"symbolic\", \"prism\")", 0},
     {0, 0, 0, 0, 0, 0}
 };
 
+/**
+ * Helper: bisimulation from "branching"/"1" or "strong"/"2", or -1 if invalid
+ */
+static int
+bisimulation_from_string(const char *arg)
+{
+    if (strcmp(arg, "1") == 0 || strcmp(arg, "branching") == 0) return 1;
+    if (strcmp(arg, "2") == 0 || strcmp(arg, "strong") == 0) return 2;
+    return -1;
+}
+
+/**
+ * Helper: quotient type from its name (see -q), or -1 if invalid
+ */
+static int
+quotient_from_string(const char *arg)
+{
+    if (strncmp(arg, "pick", 4) == 0) return 4;
+    if (strcmp(arg, "block") == 0) return 3;
+    if (strcmp(arg, "block-s1") == 0) return 1;
+    if (strcmp(arg, "block-s2") == 0) return 2;
+    if (strcmp(arg, "test") == 0) return 5;
+    if (strcmp(arg, "none") == 0) return 0;
+    return -1;
+}
+
 static error_t
 parse_opt(int key, char *arg, struct argp_state *state)
 {
@@ -85,72 +151,144 @@ parse_opt(int key, char *arg, struct argp_state *state)
         workers = atoi(arg);
         break;
     case 'b':
-        bisimulation = atoi(arg);
-        if (bisimulation<1 || bisimulation>2) argp_usage(state);
+        context_options.bisimulation = bisimulation_from_string(arg);
+        if (context_options.bisimulation == -1) argp_usage(state);
         break;
     case 'l':
         if (arg[0] == 'f' && arg[1] == 'l') {
-            leaftype = 0;
+            context_options.leaftype = 0;
         } else if (arg[0] == 'f' && arg[1] == 'r') {
-            leaftype = 1;
+            context_options.leaftype = 1;
         } else if (arg[0] == 'g') {
-            leaftype = 2;
+            context_options.leaftype = 2;
         } else {
             argp_usage(state);
         }
         break;
     case 'v':
-        verbosity = atoi(arg);
-        if (verbosity<0 || verbosity>2) argp_usage(state);
+        context_options.verbosity = atoi(arg);
+        if (context_options.verbosity<0 || context_options.verbosity>2) argp_usage(state);
         break;
     case 'm':
-        merge_relations = 1;
+        context_options.merge_relations = 1;
         break;
     case 'r':
-        reachable = 1;
+        context_options.reachable = 1;
         break;
     case 't':
-        tau_action = atoi(arg);
+        context_options.tau_action = atoi(arg);
         break;
     case 1:
-        ordering = 1;
+        context_options.ordering = 1;
         break;
     case 2:
         table_sizes = arg;
         break;
+    case 3:
+        result_cache_dir = arg;
+        break;
+    case 4:
+        batch_filename = arg;
+        break;
+    case 5:
+        daemon_socket = arg;
+        break;
+    case 6:
+        context_options.memory_limit = parse_memory_size(arg);
+        if (context_options.memory_limit == 0) argp_usage(state);
+        break;
+    case 7:
+        metrics_filename = arg;
+        break;
+    case 8:
+        trace_filename = arg;
+        break;
+    case 9:
+        if (atof(arg) <= 0) argp_usage(state);
+        context_options.time_limit = atof(arg);
+        break;
+    case 10:
+        if (atoi(arg) <= 0) argp_usage(state);
+        context_options.max_iterations = atoi(arg);
+        break;
+    case 11:
+        label_filename = arg;
+        break;
+    case 12:
+        if (strcmp(arg, "jacobi") == 0) steady_method = steady_jacobi;
+        else if (strcmp(arg, "gauss-seidel") == 0) steady_method = steady_gauss_seidel;
+        else if (strcmp(arg, "power") == 0) steady_method = steady_power;
+        else argp_usage(state);
+        break;
+    case 13:
+        if (strcmp(arg, "steady") == 0) {
+            analysis_mode = analysis_steady;
+        } else if (strncmp(arg, "transient:", 10) == 0 && atof(arg+10) > 0) {
+            analysis_mode = analysis_transient;
+            analysis_time = atof(arg+10);
+        } else {
+            argp_usage(state);
+        }
+        break;
+    case 14:
+        if (strcmp(arg, "none") == 0) context_options.statistics = 0;
+        else if (strcmp(arg, "cheap") == 0) context_options.statistics = 1;
+        else if (strcmp(arg, "full") == 0) context_options.statistics = 2;
+        else argp_usage(state);
+        break;
+    case 15:
+        context_options.compaction = 1;
+        break;
+    case 16:
+        if (strcmp(arg, "default") == 0) sylvan_set_numa_policy(numa_default);
+        else if (strcmp(arg, "interleave") == 0) sylvan_set_numa_policy(numa_interleave);
+        else if (strcmp(arg, "owner") == 0) sylvan_set_numa_policy(numa_owner);
+        else argp_usage(state);
+        numa_report = 1;
+        break;
+    case 17:
+        if (strcmp(arg, "none") == 0) sylvan_set_huge_pages(pages_normal);
+        else if (strcmp(arg, "transparent") == 0) sylvan_set_huge_pages(pages_transparent);
+        else if (strcmp(arg, "hugetlb") == 0) sylvan_set_huge_pages(pages_hugetlb);
+        else argp_usage(state);
+        huge_pages_report = 1;
+        break;
+    case 18:
+    {
+        unsigned shares[SIGREF_REGION_COUNT] = {0};
+        char end;
+        if (sscanf(arg, "%u,%u,%u%c", &shares[SIGREF_REGION_REFINE], &shares[SIGREF_REGION_SIGNATURE], &shares[SIGREF_REGION_QUOTIENT], &end) != 3 ||
+            shares[SIGREF_REGION_REFINE] + shares[SIGREF_REGION_SIGNATURE] + shares[SIGREF_REGION_QUOTIENT] >= 100) {
+            argp_usage(state);
+        }
+        cache_set_regions(SIGREF_REGION_COUNT, shares);
+        cache_regions_report = 1;
+        break;
+    }
     case 'c':
         if (arg[0] == 'f') {
-            closure = 0;
+            context_options.closure = 0;
         } else if (arg[0] == 's') {
-            closure = 1;
-            merge_relations = 1;
+            context_options.closure = 1;
+            context_options.merge_relations = 1;
         } else if (arg[0] == 'r') {
-            closure = 2;
-            merge_relations = 1;
+            context_options.closure = 2;
+            context_options.merge_relations = 1;
         } else {
             argp_usage(state);
         }
         break;
     case 'q':
-        if (strncmp(arg, "pick", 4) == 0) {
-            quotient_type = 4;
-        } else if (strcmp(arg, "block") == 0) {
-            quotient_type = 3;
-        } else if (strcmp(arg, "block-s1") == 0) {
-            quotient_type = 1;
-        } else if (strcmp(arg, "block-s2") == 0) {
-            quotient_type = 2;
-        } else if (strcmp(arg, "test") == 0) {
-            quotient_type = 5;
-        } else {
-            argp_usage(state);
-        }
+        quotient_type = quotient_from_string(arg);
+        if (quotient_type == -1) argp_usage(state);
         break;
     case 'o':
         if (arg[0] == 'e') {
             output_type = 1;
         } else if (arg[0] == 's') {
             output_type = 2;
+        } else if (arg[0] == 'p') {
+            output_type = 3;
         } else {
             argp_usage(state);
         }
@@ -166,7 +304,9 @@ parse_opt(int key, char *arg, struct argp_state *state)
         else argp_usage(state);
         break;
     case ARGP_KEY_END:
-        if (state->arg_num < 1) argp_usage(state);
+        if (batch_filename != NULL && daemon_socket != NULL) argp_error(state, "Please give either --batch or --daemon.");
+        if ((batch_filename != NULL || daemon_socket != NULL) && state->arg_num > 0) argp_error(state, "Please give either a model or --batch/--daemon.");
+        if (batch_filename == NULL && daemon_socket == NULL && state->arg_num < 1) argp_usage(state);
         if (output_filename != NULL && output_type == 0) argp_error(state, "Please set an output type with -o.");
         break;
     default:
@@ -177,16 +317,6 @@ parse_opt(int key, char *arg, struct argp_state *state)
 
 static struct argp argp = {options, parse_opt, "<model>", 0, 0, 0, 0};
 
-double t_start;
-
-double
-wctime()
-{
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (tv.tv_sec + 1E-6 * tv.tv_usec);
-}
-
 /**
  * Small helper function
  */
@@ -210,141 +340,213 @@ VOID_TASK_0(gc_end)
     INFO("(GC) Garbage collection done.");
 }
 
-VOID_TASK_1(main_lace, void*, arg)
+/**
+ * Span of a phase in the timeline of --trace (see lace_trace_begin)
+ */
+struct TraceSpan
 {
-    setlocale(LC_NUMERIC, "en_US.utf-8");
-
-    t_start = wctime();
-
-    int tablesize, maxtablesize, cachesize, maxcachesize;
-    if (sscanf(table_sizes, "%d,%d,%d,%d", &tablesize, &maxtablesize, &cachesize, &maxcachesize) != 4) {
-        INFO("Invalid string for --table-sizes, try e.g. --table-sizes=23,28,22,27");
-        return;
-    }
-    if (tablesize < 10 || maxtablesize < 10 || cachesize < 10 || maxcachesize < 10 ||
-            tablesize > 40 || maxtablesize > 40 || cachesize > 40 || maxcachesize > 40) {
-        INFO("Invalid string for --table-sizes, must be between 10 and 40");
-        return;
-    }
-    if (tablesize > maxtablesize) {
-        INFO("Invalid string for --table-sizes, tablesize is larger than maxtablesize");
-        return;
-    }
-    if (cachesize > maxcachesize) {
-        INFO("Invalid string for --table-sizes, cachesize is larger than maxcachesize");
-        return;
-    }
-
-    char buf[32];
-    to_h((1ULL<<maxtablesize)*24+(1ULL<<maxcachesize)*36, buf);
-    INFO("Sylvan allocates %s virtual memory for nodes table and operation cache.", buf);
-    to_h((1ULL<<tablesize)*24+(1ULL<<cachesize)*36, buf);
-    INFO("Initial nodes table and operation cache requires %s.", buf);
-
-    sylvan_init_package(1LL<<tablesize, 1LL<<maxtablesize, 1LL<<cachesize, 1LL<<maxcachesize);
-    sylvan_set_granularity(3);
-    sylvan_init_mtbdd();
-    gmp_init();
-    sylvan_gc_hook_pregc(TASK(gc_start));
-    sylvan_gc_hook_postgc(TASK(gc_end));
+    TraceSpan(const char *name) { lace_trace_begin(name); }
+    ~TraceSpan() { lace_trace_end(); }
+};
 
-    /* Initialization done, now read model from file */
+/**
+ * Result record of a model in batch mode
+ */
+struct model_result
+{
+    double states;
+    size_t blocks;
+    double time;
+};
 
+/**
+ * Read the model <model>, minimize it with <context> and write the quotient to <output> (if not NULL).
+ * If <result> is not NULL, the numbers of states and blocks are stored there.
+ * Returns 0 on success (also for a k-bounded partition), 2 if the partition is not stable (time limit), 1 otherwise.
+ */
+TASK_4(int, minimize_model, Context*, context, const char*, model, const char*, output, struct model_result*, result)
+{
     SystemType sysType;
     LTS lts;
     CTMC ctmc;
     IMC imc;
+    sigref_context *ctx = context->get();
 
-    const char *dot = strrchr(model_filename, '.');
-    if (dot) {
-        if (strcmp(dot+1, "bdd") == 0) {
-            BddLtsParser parser(model_filename);
-            sysType = lts_type;
-            lts = *parser.getLTS();
-        } else if ((strcmp(dot+1, "xlts") == 0) || (strcmp(dot+1, "xctmc") == 0) || (strcmp(dot+1, "ximc") == 0) || (strcmp(dot+1, "xml") == 0)) {
-            LeafType lt = float_type;
-            if (leaftype == 1) lt = simple_fraction_type;
-            if (leaftype == 2) lt = mpq_type;
-            SystemParser reader(model_filename, 0, lt);
-            sysType = reader.getType();
-            if (sysType == lts_type) {
-                lts = *reader.getLTS();
-            } else if (sysType == ctmc_type) {
-                ctmc = *reader.getCTMC();
+    metrics_model(model);
+    double t_read = wctime();
+
+    try {
+        TraceSpan span("read");
+        std::string model_name = InputStream::stripCompressionSuffix(model);
+        const char *dot = strrchr(model_name.c_str(), '.');
+        if (dot) {
+            if (strcmp(dot+1, "compose") == 0) {
+                CompositionSpec spec = CompositionSpec::read(model);
+                sysType = lts_type;
+                lts = Composition::minimize(*context, spec, ctx->options.tau_action);
+            } else if (strcmp(dot+1, "bdd") == 0) {
+                BddLtsParser parser(model, ctx->options.tau_action, label_filename);
+                sysType = lts_type;
+                lts = *parser.getLTS();
+            } else if (strcmp(dot+1, "tra") == 0) {
+                if (label_filename != NULL) {
+                    fprintf(stderr, "Labels of PRISM models are read from the .lab file, not from --labels!\n");
+                    return 1;
+                }
+                LeafType lt = float_type;
+                if (ctx->options.leaftype == 1) lt = simple_fraction_type;
+                if (ctx->options.leaftype == 2) lt = mpq_type;
+                PrismCtmcParser parser(model, lt);
+                sysType = ctmc_type;
+                ctmc = *parser.getCTMC();
+            } else if ((strcmp(dot+1, "xlts") == 0) || (strcmp(dot+1, "xctmc") == 0) || (strcmp(dot+1, "ximc") == 0) || (strcmp(dot+1, "xml") == 0)) {
+                LeafType lt = float_type;
+                if (ctx->options.leaftype == 1) lt = simple_fraction_type;
+                if (ctx->options.leaftype == 2) lt = mpq_type;
+                SystemParser reader(model, 0, lt, ctx->options.tau_action, label_filename);
+                sysType = reader.getType();
+                if (sysType == lts_type) {
+                    lts = *reader.getLTS();
+                } else if (sysType == ctmc_type) {
+                    ctmc = *reader.getCTMC();
+                } else {
+                    imc = *reader.getIMC();
+                }
             } else {
-                imc = *reader.getIMC();
+                fprintf(stderr, "Unknown extension '%s'!\n", dot+1);
+                return 1;
             }
         } else {
-            fprintf(stderr, "Unknown extension '%s'!\n", dot+1);
-            return;
+            fprintf(stderr, "Unknown extension ''!\n");
+            return 1;
         }
-    } else {
-        fprintf(stderr, "Unknown extension ''!\n");
-        return;
+    } catch (ParseError&) {
+        return 1;
     }
 
-    INFO("Finished reading system from %s.", model_filename);
+    INFO("Finished reading system from %s.", model);
+    metrics_phase("read", wctime()-t_read);
 
 #ifdef HAVE_PROFILER
     if (profile_filename != NULL) ProfilerStart(profile_filename);
 #endif
 
+    /* Look up the system in the result cache (not in test mode, and not for k-bounded bisimulation,
+       as the cache only holds stable partitions) */
+
+    ResultCache *cache = NULL;
+    std::string fingerprint;
+    bool cache_hit = false;
+
     BDD partition = mtbdd_false;
-    if (sysType == lts_type && bisimulation == 1) {
-        partition = CALL(min_lts_branching, lts);
-    } else if (sysType == lts_type && bisimulation == 2) {
-        partition = CALL(min_lts_strong, lts);
-    } else if (sysType == ctmc_type) {
-        partition = CALL(min_ctmc, ctmc);
-    } else if (sysType == imc_type && bisimulation == 1) {
-        partition = CALL(min_imc_branching, imc);
-    } else if (sysType == imc_type && bisimulation == 2) {
-        partition = CALL(min_imc_strong, imc);
-    } else {
-        fprintf(stderr, "Unsupported system/bisimulation combination!\n");
-        return;
+
+    if (result_cache_dir != NULL && quotient_type != 5 && ctx->options.max_iterations == 0) {
+        cache = new ResultCache(result_cache_dir);
+        StateSystem *system;
+        if (sysType == lts_type) {
+            fingerprint = ResultCache::fingerprint(ctx->options, lts);
+            system = &lts;
+        } else if (sysType == ctmc_type) {
+            fingerprint = ResultCache::fingerprint(ctx->options, ctmc);
+            system = &ctmc;
+        } else {
+            fingerprint = ResultCache::fingerprint(ctx->options, imc);
+            system = &imc;
+        }
+        INFO("Fingerprint of system: %s.", fingerprint.c_str());
+
+        prepare_blocks(ctx, sylvan_set_count(system->getVarS().GetBDD())+1);
+        cache_hit = cache->loadPartition(ctx, fingerprint, &partition);
+        if (cache_hit) {
+            INFO("Result cache hit, partition has %'zu blocks.", count_blocks(ctx));
+        } else {
+            INFO("Result cache miss.");
+        }
     }
 
     sylvan_protect(&partition);
 
+    if (cache_hit) {
+        /* Partition loaded from the result cache */
+        ctx->stable = 1;
+        ctx->bound = 0;
+    } else {
+        TraceSpan span("refinement");
+        if (sysType == lts_type) {
+            partition = context->partition(lts).GetBDD();
+        } else if (sysType == ctmc_type) {
+            partition = context->partition(ctmc).GetBDD();
+        } else {
+            partition = context->partition(imc).GetBDD();
+        }
+    }
+
 #ifdef HAVE_PROFILER
     if (profile_filename != NULL) ProfilerStop();
 #endif
 
+    if (!context->stable() && memory_pressure(ctx) == memory_exhausted) {
+        /* Refinement stopped at the memory limit: write the current partition and fail */
+        const char *base = strrchr(model, '/');
+        std::string filename = std::string(output != NULL ? output : base != NULL ? base+1 : model) + ".partition";
+        writePartition(ctx, filename.c_str(), partition);
+        sylvan_unprotect(&partition);
+        if (cache != NULL) delete cache;
+        return 1;
+    }
+
+    /* Refinement stopped at the time limit or max_iterations: continue with the partition so far, which is coarser */
+    if (context->bound() != 0) {
+        INFO("The partition is %zu-bounded, the quotient is coarser than the bisimulation quotient.", context->bound());
+    } else if (!context->stable()) {
+        INFO("The partition is not stable, the quotient is coarser than the bisimulation quotient.");
+    }
+
+    if (cache != NULL && !cache_hit && context->stable()) cache->storePartition(ctx, fingerprint, partition);
+
+    if (result != NULL) {
+        StateSystem &system = sysType == lts_type ? (StateSystem&)lts : sysType == ctmc_type ? (StateSystem&)ctmc : (StateSystem&)imc;
+        BDD vars = sylvan_and(system.getVarT().GetBDD(), ctx->block_variables);
+        bdd_refs_push(vars);
+        result->states = sylvan_satcount(partition, vars);
+        bdd_refs_pop(1);
+        result->blocks = count_blocks(ctx);
+    }
+
     /* With "-q test" we dump the output from different algorithms that should produce
        the same results. This is a feature for testing/debugging. */
     if (quotient_type == 5) {
         if (sysType == ctmc_type) {
-            writeSignatures("test-signatures", ctmc);
+            writeSignatures(ctx, "test-signatures", ctmc);
 
             INFO("");
-            partition = trim_block_variables(partition);
+            partition = trim_block_variables(ctx, partition);
 
             CTMC copy(ctmc), copy2(ctmc);
-            Minimizations::minimize1(copy, partition);
-            Minimizations::minimize2(copy2, partition);
+            Minimizations::minimize1(ctx, copy, partition);
+            Minimizations::minimize2(ctx, copy2, partition);
 
-            writeExplicitOutput("test-explicit1", copy);
-            writeExplicitOutput("test-explicit2", copy2);
+            writeExplicitOutput(ctx, "test-explicit1", copy);
+            writeExplicitOutput(ctx, "test-explicit2", copy2);
 
             INFO("");
             INFO("Now use the following two commands to test that the output is correct:");
             INFO("diff <(tail -n +3 test-signatures|sort) <(tail -n +5 test-explicit1|sort)");
             INFO("diff test-explicit1 test-explicit2");
         } else if (sysType == lts_type) {
-            writeSignatures("test-signatures", lts);
+            writeSignatures(ctx, "test-signatures", lts);
 
             INFO("");
-            partition = trim_block_variables(partition);
+            partition = trim_block_variables(ctx, partition);
 
             LTS copy(lts), copy2(lts), copy3(lts);
-            Minimizations::minimize1(copy, partition, 0);
-            Minimizations::minimize1(copy2, partition, 1);
-            Minimizations::minimize2(copy3, partition);
+            Minimizations::minimize1(ctx, copy, partition, 0);
+            Minimizations::minimize1(ctx, copy2, partition, 1);
+            Minimizations::minimize2(ctx, copy3, partition);
 
-            writeExplicitOutput("test-explicit1", copy);
-            writeExplicitOutput("test-explicit2", copy2);
-            writeExplicitOutput("test-explicit3", copy3);
+            writeExplicitOutput(ctx, "test-explicit1", copy);
+            writeExplicitOutput(ctx, "test-explicit2", copy2);
+            writeExplicitOutput(ctx, "test-explicit3", copy3);
 
             INFO("");
             INFO("Now use the following three commands to test that the output is correct:");
@@ -354,12 +556,14 @@ VOID_TASK_1(main_lace, void*, arg)
         } else {
             fprintf(stderr, "You cannot test IMCs at this moment!\n");
         }
-        return;
+        sylvan_unprotect(&partition);
+        return 0;
     }
 
     /* At this point, the signatures are not protected against garbage collection.
        We might as well free the memory. */
-    free_refine_data();
+    if (huge_pages_report) report_huge_pages();
+    free_refine_data(ctx);
 
     /* Run garbage collection, to remove influence from caching in the first part
        from measurements of the second part. */
@@ -372,70 +576,465 @@ VOID_TASK_1(main_lace, void*, arg)
      * 4 = symbolic (by pick one)
      */
 
+    if (steady_method != steady_none && quotient_type == 0) quotient_type = 3;
+    if (analysis_mode != analysis_none && quotient_type == 0) quotient_type = 3;
     if (output_type == 1 && quotient_type == 0) quotient_type = 3;
     if (output_type == 2 && quotient_type == 0) quotient_type = 4;
+    if (output_type == 3 && quotient_type == 0) quotient_type = 3;
+
+    if (output_type == 3 && sysType != ctmc_type) {
+        fprintf(stderr, "PRISM output is only supported for CTMCs!\n");
+        sylvan_unprotect(&partition);
+        if (cache != NULL) delete cache;
+        return 1;
+    }
+
+    if (steady_method != steady_none && sysType != ctmc_type) {
+        fprintf(stderr, "The steady state is only supported for CTMCs!\n");
+        sylvan_unprotect(&partition);
+        if (cache != NULL) delete cache;
+        return 1;
+    }
+
+    if (analysis_mode != analysis_none && sysType != ctmc_type) {
+        fprintf(stderr, "The analysis is only supported for CTMCs!\n");
+        sylvan_unprotect(&partition);
+        if (cache != NULL) delete cache;
+        return 1;
+    }
+
+    /* Quotients are cached per quotient type and output type (not for PRISM output, which consists of several files) */
+    std::string quotient_key = "q" + std::to_string(quotient_type) + (output_type == 1 ? "-explicit" : "-symbolic");
+    if (output_type == 3) quotient_key.clear();
+    if (cache_hit && output != NULL && !quotient_key.empty() && steady_method == steady_none && analysis_mode == analysis_none && cache->loadQuotient(fingerprint, quotient_key, output)) {
+        INFO("Result cache hit, copied quotient to %s.", output);
+        sylvan_unprotect(&partition);
+        delete cache;
+        return 0;
+    }
+
+    lace_trace_begin("quotient");
 
     if (quotient_type != 0) {
         INFO("");
-        partition = trim_block_variables(partition);
+        partition = trim_block_variables(ctx, partition);
     }
 
     if (quotient_type == 1) {
         /* Standard operations, block encoding, variant 1 */
-        if (sysType == ctmc_type) Minimizations::minimize1(ctmc, partition);
-        if (sysType == lts_type) Minimizations::minimize1(lts, partition, 0);
-        if (sysType == imc_type) Minimizations::minimize1(imc, partition, 0);
+        if (sysType == ctmc_type) Minimizations::minimize1(ctx, ctmc, partition);
+        if (sysType == lts_type) Minimizations::minimize1(ctx, lts, partition, 0);
+        if (sysType == imc_type) Minimizations::minimize1(ctx, imc, partition, 0);
     } else if (quotient_type == 2) {
         /* Standard operations, block encoding, variant 2 */
-        if (sysType == ctmc_type) Minimizations::minimize1(ctmc, partition);
-        if (sysType == lts_type) Minimizations::minimize1(lts, partition, 1);
-        if (sysType == imc_type) Minimizations::minimize1(imc, partition, 1);
+        if (sysType == ctmc_type) Minimizations::minimize1(ctx, ctmc, partition);
+        if (sysType == lts_type) Minimizations::minimize1(ctx, lts, partition, 1);
+        if (sysType == imc_type) Minimizations::minimize1(ctx, imc, partition, 1);
     } else if (quotient_type == 3) {
         /* Custom operations, block encoding */
-        if (sysType == ctmc_type) Minimizations::minimize2(ctmc, partition);
-        if (sysType == lts_type) Minimizations::minimize2(lts, partition);
-        if (sysType == imc_type) Minimizations::minimize2(imc, partition);
+        if (sysType == ctmc_type) Minimizations::minimize2(ctx, ctmc, partition);
+        if (sysType == lts_type) Minimizations::minimize2(ctx, lts, partition);
+        if (sysType == imc_type) Minimizations::minimize2(ctx, imc, partition);
     } else if (quotient_type == 4) {
         /* Custom operations, pick-random encoding */
-        if (sysType == ctmc_type) Minimizations::minimize3(ctmc, partition);
-        if (sysType == lts_type) Minimizations::minimize3(lts, partition);
-        if (sysType == imc_type) Minimizations::minimize3(imc, partition);
+        if (sysType == ctmc_type) Minimizations::minimize3(ctx, ctmc, partition);
+        if (sysType == lts_type) Minimizations::minimize3(ctx, lts, partition);
+        if (sysType == imc_type) Minimizations::minimize3(ctx, imc, partition);
     }
 
-    if (output_filename != NULL) {
+    lace_trace_end();
+
+    if (steady_method != steady_none) {
+        /* Solve the quotient CTMC and write the stationary distribution next to the quotient */
+        TraceSpan span("steady-state");
+        double t_steady = wctime();
+        if (sylvan_set_count(ctmc.getVarS().GetBDD()) > 64) {
+            fprintf(stderr, "The steady state needs a quotient with at most 64 state variables (-q block)!\n");
+            sylvan_unprotect(&partition);
+            if (cache != NULL) delete cache;
+            return 1;
+        }
+        SteadyState steady = solveSteadyState(ctmc, steady_method, 1e-6, 100000, ctx->options.verbosity);
+        const char *base = strrchr(model, '/');
+        std::string filename = std::string(output != NULL ? output : base != NULL ? base+1 : model) + ".steady";
+        writeSteadyState(ctx, filename.c_str(), steady);
+        metrics_phase("steady-state", wctime()-t_steady);
+    }
+
+    if (analysis_mode != analysis_none) {
+        /* Analyze the quotient CTMC symbolically and write the probabilities of the labels */
+        TraceSpan span("analysis");
+        double t_analysis = wctime();
+        AnalysisResult analysis = analyzeSymbolic(ctmc, analysis_mode, analysis_time, 1e-8, 100000, ctx->options.verbosity);
+        const char *base = strrchr(model, '/');
+        std::string filename = std::string(output != NULL ? output : base != NULL ? base+1 : model) + ".analysis";
+        writeAnalysis(ctx, filename.c_str(), analysis);
+        metrics_phase("analysis", wctime()-t_analysis);
+    }
+
+    if (output != NULL) {
         /* Write output to file */
+        TraceSpan span("write");
+        double t_write = wctime();
+        bool written = true;
         if (output_type == 1) {
             if (sysType == ctmc_type) {
-                writeExplicitOutput(output_filename, ctmc);
+                writeExplicitOutput(ctx, output, ctmc);
             } else if (sysType == lts_type) {
-                writeExplicitOutput(output_filename, lts);
+                writeExplicitOutput(ctx, output, lts);
             } else if (sysType == imc_type) {
-                writeExplicitOutput(output_filename, imc);
+                writeExplicitOutput(ctx, output, imc);
             }
+        } else if (output_type == 3) {
+            written = writePrismOutput(ctx, output, ctmc);
         } else {
             if (sysType == ctmc_type) {
-                writeSymbolicOutput(output_filename, ctmc);
+                written = writeSymbolicOutput(ctx, output, ctmc);
             } else if (sysType == lts_type) {
-                writeSymbolicOutput(output_filename, lts);
+                written = writeSymbolicOutput(ctx, output, lts);
             } else if (sysType == imc_type) {
-                writeSymbolicOutput(output_filename, imc);
+                written = writeSymbolicOutput(ctx, output, imc);
             }
-       }
+        }
+        metrics_phase("write", wctime()-t_write);
+        if (!written) {
+            sylvan_unprotect(&partition);
+            if (cache != NULL) delete cache;
+            return 1;
+        }
+        if (cache != NULL && !quotient_key.empty() && context->stable()) cache->storeQuotient(fingerprint, quotient_key, output);
     }
 
-    sylvan_stats_report(stdout);
+    if (cache != NULL) delete cache;
+
+    sylvan_unprotect(&partition);
+    return context->stable() || context->bound() != 0 ? 0 : 2;
+}
+
+/**
+ * Helper: status of a job from the result of minimize_model
+ */
+static const char*
+job_status(int res)
+{
+    return res == 0 ? "ok" : res == 2 ? "not-stable" : "failed";
+}
+
+/**
+ * Minimize <model> as one job of a batch or of the daemon.
+ * minimize_model may choose a quotient type for the job, which is restored afterwards.
+ * The operation cache is cleared and garbage collection is run, so every job starts
+ * with the same (warm) tables.
+ */
+TASK_4(int, run_job, Context*, context, const char*, model, const char*, output, struct model_result*, result)
+{
+    int saved_quotient = quotient_type;
+    double t_job = wctime();
+    int res = CALL(minimize_model, context, model, output, result);
+    result->time = wctime() - t_job;
+    quotient_type = saved_quotient;
+
+    sylvan_clear_cache();
+    sylvan_gc();
+
+    return res;
+}
+
+/**
+ * Minimize the models listed in the manifest <batch_filename>, one after the other.
+ *
+ * Each line of the manifest contains a model and optionally an output file,
+ * separated by whitespace. Empty lines and lines starting with '#' are skipped.
+ */
+VOID_TASK_1(run_batch, Context*, context)
+{
+    FILE *f = fopen(batch_filename, "r");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot open manifest '%s'!\n", batch_filename);
+        return;
+    }
+
+    size_t n_models = 0, n_failed = 0, n_not_stable = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char model[4096], output[4096];
+        int n = sscanf(line, "%4095s %4095s", model, output);
+        if (n < 1 || model[0] == '#') continue;
+        if (n == 2 && output_type == 0) {
+            fprintf(stderr, "Manifest entry '%s' has an output file, please set an output type with -o.\n", model);
+            n_models++;
+            n_failed++;
+            continue;
+        }
+
+        INFO("");
+        INFO("Batch: minimizing %s.", model);
+
+        struct model_result result = {0, 0, 0};
+        int res = CALL(run_job, context, model, n == 2 ? output : NULL, &result);
+
+        n_models++;
+        if (res == 2) n_not_stable++;
+        else if (res != 0) n_failed++;
+        INFO("Batch result: %s, %s, %'0.0f states, %'zu blocks, %'0.2f sec.", model, job_status(res),
+             result.states, result.blocks, result.time);
+    }
+    fclose(f);
+
+    INFO("");
+    INFO("Batch: %'zu models, %'zu failed, %'zu not stable.", n_models, n_failed, n_not_stable);
+}
+
+/**
+ * Run one job of the daemon, given as the line "<model> <bisimulation> <quotient> [<output>]".
+ * Writes the reply line to <fd>.
+ */
+VOID_TASK_3(daemon_job, Context*, context, char*, line, int, fd)
+{
+    char model[4096], bisi[32], quotient[32], output[4096];
+    int n = sscanf(line, "%4095s %31s %31s %4095s", model, bisi, quotient, output);
+    int job_bisimulation = n >= 3 ? bisimulation_from_string(bisi) : -1;
+    int job_quotient = n >= 3 ? quotient_from_string(quotient) : -1;
+    if (n < 3 || job_bisimulation == -1 || job_quotient == -1 || job_quotient == 5) {
+        dprintf(fd, "error invalid job, expected: <model> branching|strong none|block|block-s1|block-s2|pick [<output>]\n");
+        return;
+    }
+
+    INFO("");
+    INFO("Daemon: minimizing %s.", model);
+
+    /* Jobs override the bisimulation and quotient type of the command line */
+    int saved_bisimulation = context->options().bisimulation, saved_quotient = quotient_type, saved_output = output_type;
+    context->options().bisimulation = job_bisimulation;
+    quotient_type = job_quotient;
+    if (n == 4 && output_type == 0) output_type = 1;
+
+    struct model_result result = {0, 0, 0};
+    int res = CALL(run_job, context, model, n == 4 ? output : NULL, &result);
+
+    context->options().bisimulation = saved_bisimulation;
+    quotient_type = saved_quotient;
+    output_type = saved_output;
+
+    INFO("Daemon result: %s, %s, %'0.0f states, %'zu blocks, %'0.2f sec.", model, job_status(res),
+         result.states, result.blocks, result.time);
+    if (res == 0) dprintf(fd, "ok %.0f states %zu blocks %.3f sec\n", result.states, result.blocks, result.time);
+    else if (res == 2) dprintf(fd, "ok %.0f states %zu blocks %.3f sec not-stable\n", result.states, result.blocks, result.time);
+    else dprintf(fd, "error minimization of %s failed\n", model);
+}
+
+/**
+ * Accept jobs on the Unix domain socket <daemon_socket>, one connection at a time.
+ *
+ * A client sends one job per line (see daemon_job) and receives one reply line per job.
+ * Jobs run back to back with the same Context, workers and Sylvan tables.
+ * The line "quit" stops the daemon.
+ */
+VOID_TASK_1(run_daemon, Context*, context)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(daemon_socket) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path '%s' is too long!\n", daemon_socket);
+        exit_code = 1;
+        return;
+    }
+    strcpy(addr.sun_path, daemon_socket);
+
+    /* Remove the socket of an earlier daemon */
+    struct stat st;
+    if (stat(daemon_socket, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(daemon_socket);
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0 || bind(server, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(server, 8) != 0) {
+        fprintf(stderr, "Cannot listen on socket '%s'!\n", daemon_socket);
+        if (server >= 0) close(server);
+        exit_code = 1;
+        return;
+    }
+
+    /* A client that disconnects early should not stop the daemon */
+    signal(SIGPIPE, SIG_IGN);
+
+    INFO("Daemon: listening on %s.", daemon_socket);
+
+    bool quit = false;
+    size_t n_jobs = 0;
+    while (!quit) {
+        int fd = accept(server, NULL, NULL);
+        if (fd < 0) continue;
+        FILE *in = fdopen(fd, "r");
+        if (in == NULL) {
+            dprintf(fd, "error cannot read from the connection: %s\n", strerror(errno));
+            close(fd);
+            continue;
+        }
+        char line[8192];
+        while (fgets(line, sizeof(line), in) != NULL) {
+            char first[8];
+            if (sscanf(line, "%7s", first) != 1) continue;
+            if (strcmp(first, "quit") == 0) {
+                dprintf(fd, "ok bye\n");
+                quit = true;
+                break;
+            }
+            CALL(daemon_job, context, line, fd);
+            n_jobs++;
+        }
+        fclose(in);
+    }
+
+    close(server);
+    unlink(daemon_socket);
+
+    INFO("");
+    INFO("Daemon: stopped after %'zu jobs.", n_jobs);
+}
 
-    (void)arg;
+/**
+ * Estimate the number of nodes of the input for --table-sizes=auto;
+ * in batch mode, of the largest model of the manifest.
+ */
+static size_t
+estimate_input_nodes()
+{
+    if (model_filename != NULL) return estimate_model_nodes(model_filename);
+
+    size_t result = 0;
+    FILE *f = batch_filename != NULL ? fopen(batch_filename, "r") : NULL;
+    if (f == NULL) return 0;
+    char line[4096], model[4096];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (sscanf(line, "%4095s", model) != 1 || model[0] == '#') continue;
+        size_t nodes = estimate_model_nodes(model);
+        if (nodes > result) result = nodes;
+    }
+    fclose(f);
+    return result;
+}
+
+VOID_TASK_1(main_lace, void*, arg)
+{
+    setlocale(LC_NUMERIC, "en_US.utf-8");
+
+    t_start = wctime();
+
+    const size_t memory_limit = context_options.memory_limit;
+    if (strcmp(table_sizes, "auto") == 0) {
+        const char *source = NULL;
+        size_t memory = available_memory(&source);
+        if (memory_limit != 0 && (memory == 0 || memory_limit < memory)) {
+            memory = memory_limit;
+            source = "--memory-limit";
+        }
+        if (memory == 0) {
+            INFO("Cannot determine the available memory for --table-sizes=auto, please give the sizes.");
+            exit_code = 1;
+            return;
+        }
+        size_t nodes = estimate_input_nodes();
+        TableSizes sizes = auto_table_sizes(nodes, memory);
+
+        static char auto_sizes[64];
+        sprintf(auto_sizes, "%d,%d,%d,%d", sizes.tablesize, sizes.maxtablesize, sizes.cachesize, sizes.maxcachesize);
+        table_sizes = auto_sizes;
+
+        char buf[32];
+        INFO("Memory available (from %s): %s.", source, to_h(memory, buf));
+        INFO("Estimated number of nodes of the input: %'zu.", nodes);
+        INFO("Automatic table sizes: %s.", table_sizes);
+    }
+
+    int tablesize, maxtablesize, cachesize, maxcachesize;
+    if (sscanf(table_sizes, "%d,%d,%d,%d", &tablesize, &maxtablesize, &cachesize, &maxcachesize) != 4) {
+        INFO("Invalid string for --table-sizes, try e.g. --table-sizes=23,28,22,27");
+        exit_code = 1;
+        return;
+    }
+    if (tablesize < 10 || maxtablesize < 10 || cachesize < 10 || maxcachesize < 10 ||
+            tablesize > 40 || maxtablesize > 40 || cachesize > 40 || maxcachesize > 40) {
+        INFO("Invalid string for --table-sizes, must be between 10 and 40");
+        exit_code = 1;
+        return;
+    }
+    if (tablesize > maxtablesize) {
+        INFO("Invalid string for --table-sizes, tablesize is larger than maxtablesize");
+        exit_code = 1;
+        return;
+    }
+    if (cachesize > maxcachesize) {
+        INFO("Invalid string for --table-sizes, cachesize is larger than maxcachesize");
+        exit_code = 1;
+        return;
+    }
+
+    char buf[32];
+    if (memory_limit != 0) {
+        /* Start within the memory limit, the garbage collection hook grows the tables within the limit */
+        while ((1ULL<<tablesize)*24+(1ULL<<cachesize)*36 > memory_limit && tablesize > 10) {
+            tablesize--;
+            if (cachesize > 10) cachesize--;
+        }
+        INFO("Memory limit: %s.", to_h(memory_limit, buf));
+    }
+
+    to_h((1ULL<<maxtablesize)*24+(1ULL<<maxcachesize)*36, buf);
+    INFO("Sylvan allocates %s virtual memory for nodes table and operation cache.", buf);
+    to_h((1ULL<<tablesize)*24+(1ULL<<cachesize)*36, buf);
+    INFO("Initial nodes table and operation cache requires %s.", buf);
+
+    sigref::initialize(tablesize, maxtablesize, cachesize, maxcachesize);
+    sylvan_gc_hook_pregc(TASK(gc_start));
+    sylvan_gc_hook_postgc(TASK(gc_end));
+    if (metrics_filename != NULL && !metrics_open(metrics_filename)) {
+        INFO("Cannot open metrics file %s.", metrics_filename);
+        exit_code = 1;
+        return;
+    }
+    FILE *trace_file = NULL;
+    if (trace_filename != NULL) {
+        trace_file = fopen(trace_filename, "w");
+        if (trace_file == NULL) {
+            INFO("Cannot open trace file %s.", trace_filename);
+            exit_code = 1;
+            return;
+        }
+        if (!lace_trace_start(1ULL<<20)) {
+            INFO("Cannot allocate memory for the trace.");
+            fclose(trace_file);
+            exit_code = 1;
+            return;
+        }
+    }
+
+    if (batch_filename != NULL) {
+        CALL(run_batch, (Context*)arg);
+    } else if (daemon_socket != NULL) {
+        CALL(run_daemon, (Context*)arg);
+    } else {
+        exit_code = CALL(minimize_model, (Context*)arg, model_filename, output_filename, NULL);
+    }
+
+    if (trace_file != NULL) {
+        lace_trace_stop(trace_file);
+        fclose(trace_file);
+    }
+    if (numa_report) report_numa();
+    if (cache_regions_report) report_cache_regions();
+    sylvan_stats_report(stdout);
+    metrics_close();
 }
 
 int
 main(int argc, char **argv)
 {
     argp_parse(&argp, argc, argv, 0, 0, 0);
+    Context context(context_options);
 
     // boot program
     lace_init(workers, 1024*1024*16);
-    lace_startup(0, TASK(main_lace), NULL);
+    lace_startup(0, TASK(main_lace), &context);
 
-    return 0;
+    return exit_code;
 }
@@ -17,32 +17,18 @@
 #ifndef SIGREF_H
 #define SIGREF_H
 
-/* Cache identifiers */
-#define CACHE_REFINE            (256LL<<42)
-#define CACHE_INERT             (257LL<<42)
-#define CACHE_SWAPPRIME         (258LL<<42)
-#define CACHE_THREEAND          (259LL<<42)
-#define CACHE_EQUI              (260LL<<42)
-#define CACHE_ENCODE_BLOCK      (261LL<<42)
-#define CACHE_DECODE_BLOCK      (262LL<<42)
-#define CACHE_MARKOV_QUOTIENT   (263LL<<42)
-#define CACHE_TRANS_QUOTIENT    (264LL<<42)
-#define CACHE_STATES_QUOTIENT   (265LL<<42)
-#define CACHE_PARTITION_ENUM    (266LL<<42)
-
-/* Configuration */
-extern int bisimulation; // branching
-extern int leaftype; // 0 = float, 1 = fraction, 2 = gmp
-extern int verbosity; // default: no excessive node counting
-extern int merge_relations; // merge relations to 1 relation
-extern int closure; // 0 = fixpoint, 1 = squaring, 2 = recursive
-extern int reachable; // 0 = no, 1 = yes
-extern int tau_action; // action label of tau
-extern int ordering; // 0 = s,t < a < B, 1 = s,t < B < a, default: 0
+#include <context.h>
+#include <sigref_ops.h>
 
 /* Obtain current wallclock time */
+#ifdef __cplusplus
+extern "C" {
+#endif
 extern double t_start;
 double wctime();
+#ifdef __cplusplus
+}
+#endif
 #define INFO(s, ...) { fprintf(stdout, "[% 8.2f] " s "\n", wctime()-t_start, ##__VA_ARGS__); fflush(stdout); }
 
 #ifndef cas
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_int.h>
+
+#include <sigref_ops.h>
+
+uint64_t sigref_opid[SIGREF_OP_COUNT];
+int sigref_opstats[SIGREF_OP_COUNT];
+
+const char *sigref_op_names[SIGREF_OP_COUNT] = {
+    "sigref refine",
+    "sigref inert",
+    "sigref swapprime",
+    "sigref threeand",
+    "sigref equi",
+    "sigref relprev",
+    "sigref encode block",
+    "sigref decode block",
+    "sigref markov quot",
+    "sigref trans quot",
+    "sigref states quot",
+    "sigref enum blocks",
+    "sigref matvec",
+    "sigref satcount filtered",
+};
+
+static const sigref_region sigref_op_regions[SIGREF_OP_COUNT] = {
+    SIGREF_REGION_REFINE,       // refine
+    SIGREF_REGION_SIGNATURE,    // inert
+    SIGREF_REGION_SIGNATURE,    // swapprime
+    SIGREF_REGION_SIGNATURE,    // threeand
+    SIGREF_REGION_SIGNATURE,    // equi
+    SIGREF_REGION_SIGNATURE,    // relprev
+    SIGREF_REGION_REFINE,       // encode block
+    SIGREF_REGION_REFINE,       // decode block
+    SIGREF_REGION_QUOTIENT,     // markov quot
+    SIGREF_REGION_QUOTIENT,     // trans quot
+    SIGREF_REGION_QUOTIENT,     // states quot
+    SIGREF_REGION_QUOTIENT,     // enum blocks
+    SIGREF_REGION_GENERIC,      // matvec
+    SIGREF_REGION_GENERIC,      // satcount filtered
+};
+
+const char *sigref_region_names[SIGREF_REGION_COUNT] = {
+    "generic",
+    "refinement",
+    "signature",
+    "quotient",
+};
+
+void
+sigref_register_ops(void)
+{
+    for (int op=0; op<SIGREF_OP_COUNT; op++) {
+        sigref_opid[op] = cache_next_opid();
+        sigref_opstats[op] = sylvan_stats_register_op(sigref_op_names[op]);
+        cache_set_op_region(sigref_opid[op], sigref_op_regions[op]);
+    }
+
+    /* the operations of Sylvan that compute the signatures */
+    cache_set_op_region(CACHE_BDD_RELPREV, SIGREF_REGION_SIGNATURE);
+    cache_set_op_region(CACHE_BDD_AND_EXISTS, SIGREF_REGION_SIGNATURE);
+    cache_set_op_region(CACHE_MTBDD_ABSTRACT, SIGREF_REGION_SIGNATURE);
+    cache_set_op_region(CACHE_MTBDD_AND_ABSTRACT_PLUS, SIGREF_REGION_SIGNATURE);
+    cache_set_op_region(CACHE_MTBDD_AND_ABSTRACT_MAX, SIGREF_REGION_SIGNATURE);
+}
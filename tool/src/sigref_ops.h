@@ -0,0 +1,119 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan.h>
+
+#ifndef SIGREF_OPS_H
+#define SIGREF_OPS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Operations of sigref that use the operation cache of Sylvan
+ */
+typedef enum sigref_op
+{
+    SIGREF_OP_REFINE,
+    SIGREF_OP_INERT,
+    SIGREF_OP_SWAPPRIME,
+    SIGREF_OP_THREEAND,
+    SIGREF_OP_EQUI,
+    SIGREF_OP_RELPREV,
+    SIGREF_OP_ENCODE_BLOCK,
+    SIGREF_OP_DECODE_BLOCK,
+    SIGREF_OP_MARKOV_QUOTIENT,
+    SIGREF_OP_TRANS_QUOTIENT,
+    SIGREF_OP_STATES_QUOTIENT,
+    SIGREF_OP_PARTITION_ENUM,
+    SIGREF_OP_MATVEC,
+    SIGREF_OP_SATCOUNT_FILTERED,
+    SIGREF_OP_COUNT
+} sigref_op;
+
+/**
+ * Operation identifiers for the cache (from cache_next_opid) and indices of the custom
+ * operations in the statistics of Sylvan (from sylvan_stats_register_op).
+ */
+extern uint64_t sigref_opid[SIGREF_OP_COUNT];
+extern int sigref_opstats[SIGREF_OP_COUNT];
+extern const char *sigref_op_names[SIGREF_OP_COUNT];
+
+/**
+ * Regions of the operation cache for the classes of operations (--cache-regions); the operations of
+ * Sylvan that compute signatures are in the signature region, the other operations of Sylvan are
+ * generic operations.
+ */
+typedef enum sigref_region
+{
+    SIGREF_REGION_GENERIC,
+    SIGREF_REGION_REFINE,
+    SIGREF_REGION_SIGNATURE,
+    SIGREF_REGION_QUOTIENT,
+    SIGREF_REGION_COUNT
+} sigref_region;
+
+extern const char *sigref_region_names[SIGREF_REGION_COUNT];
+
+/**
+ * Register all operations. Call after sylvan_init_package, which clears the custom operations
+ * of the statistics.
+ */
+void sigref_register_ops(void);
+
+/* Cache identifiers */
+#define CACHE_REFINE            (sigref_opid[SIGREF_OP_REFINE])
+#define CACHE_INERT             (sigref_opid[SIGREF_OP_INERT])
+#define CACHE_SWAPPRIME         (sigref_opid[SIGREF_OP_SWAPPRIME])
+#define CACHE_THREEAND          (sigref_opid[SIGREF_OP_THREEAND])
+#define CACHE_EQUI              (sigref_opid[SIGREF_OP_EQUI])
+#define CACHE_RELPREV           (sigref_opid[SIGREF_OP_RELPREV])
+#define CACHE_ENCODE_BLOCK      (sigref_opid[SIGREF_OP_ENCODE_BLOCK])
+#define CACHE_DECODE_BLOCK      (sigref_opid[SIGREF_OP_DECODE_BLOCK])
+#define CACHE_MARKOV_QUOTIENT   (sigref_opid[SIGREF_OP_MARKOV_QUOTIENT])
+#define CACHE_TRANS_QUOTIENT    (sigref_opid[SIGREF_OP_TRANS_QUOTIENT])
+#define CACHE_STATES_QUOTIENT   (sigref_opid[SIGREF_OP_STATES_QUOTIENT])
+#define CACHE_PARTITION_ENUM    (sigref_opid[SIGREF_OP_PARTITION_ENUM])
+#define CACHE_MATVEC            (sigref_opid[SIGREF_OP_MATVEC])
+#define CACHE_SATCOUNT_FILTERED (sigref_opid[SIGREF_OP_SATCOUNT_FILTERED])
+
+/**
+ * Statistics of the operations (only if compiled with SYLVAN_STATS), like sylvan_stats_count
+ * for the operations of Sylvan: calls, results found in the cache, results written to the cache.
+ */
+#define sigref_op_count(op) sylvan_stats_count(SYLVAN_CUSTOM_OP(sigref_opstats[op]))
+#define sigref_op_cached(op) sylvan_stats_count(SYLVAN_CUSTOM_OP_CACHED(sigref_opstats[op]))
+#define sigref_op_cachedput(op) sylvan_stats_count(SYLVAN_CUSTOM_OP_CACHEDPUT(sigref_opstats[op]))
+
+/**
+ * Evaluate <call> (of type <type>), add its time to the timer of <op> and record it as a span
+ * of the trace (see lace_trace_begin).
+ * Only for calls from outside the operation, as the timers are not reentrant.
+ */
+#define sigref_op_timed(op, type, call) ({ \
+    lace_trace_begin(sigref_op_names[op]); \
+    sylvan_timer_start(SYLVAN_CUSTOM_TIMER(sigref_opstats[op])); \
+    type _op_result = call; \
+    sylvan_timer_stop(SYLVAN_CUSTOM_TIMER(sigref_opstats[op])); \
+    lace_trace_end(); \
+    _op_result; })
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -16,6 +16,7 @@
 
 #include <sigref.h>
 #include <sigref_util.hpp>
+#include <table_sizes.hpp>
 #include <sylvan_int.h>
 #include <refine.h>
 
@@ -98,12 +99,57 @@ TASK_IMPL_1(MTBDD, swap_prime, MTBDD, set)
     return result;
 }
 
-TASK_IMPL_4(long double, big_satcount, MTBDD*, dds, size_t, count, size_t, nvars, MTBDD, filter)
+TASK_IMPL_3(double, satcount_filtered, MTBDD, dd, MTBDD, filter, size_t, nvars)
 {
-    if (count == 1) {
-        MTBDD dd = filter == mtbdd_true ? *dds : mtbdd_times(*dds, filter);
-        return (long double)mtbdd_satcount(dd, nvars);
+    /* Trivial cases */
+    if (dd == mtbdd_false || filter == mtbdd_false) return 0.0;
+    if (filter == mtbdd_true) return mtbdd_satcount(dd, nvars);
+    if (mtbdd_isleaf(dd)) return mtbdd_satcount(filter, nvars);
+
+    sylvan_gc_test();
+
+    sigref_op_count(SIGREF_OP_SATCOUNT_FILTERED);
+
+    union {
+        double d;
+        uint64_t s;
+    } hack;
+
+    if (cache_get3(CACHE_SATCOUNT_FILTERED, dd, filter, nvars, &hack.s)) {
+        sigref_op_cached(SIGREF_OP_SATCOUNT_FILTERED);
+        return hack.d;
+    }
+
+    uint32_t dd_var = mtbdd_getvar(dd);
+    uint32_t filter_var = mtbdd_getvar(filter);
+    uint32_t var = dd_var < filter_var ? dd_var : filter_var;
+
+    MTBDD dd_low = dd, dd_high = dd;
+    if (dd_var == var) {
+        dd_low = mtbdd_getlow(dd);
+        dd_high = mtbdd_gethigh(dd);
+    }
+
+    MTBDD filter_low = filter, filter_high = filter;
+    if (filter_var == var) {
+        filter_low = mtbdd_getlow(filter);
+        filter_high = mtbdd_gethigh(filter);
+    }
+
+    SPAWN(satcount_filtered, dd_high, filter_high, nvars-1);
+    double low = CALL(satcount_filtered, dd_low, filter_low, nvars-1);
+    hack.d = low + SYNC(satcount_filtered);
+
+    if (cache_put3(CACHE_SATCOUNT_FILTERED, dd, filter, nvars, hack.s)) {
+        sigref_op_cachedput(SIGREF_OP_SATCOUNT_FILTERED);
     }
+
+    return hack.d;
+}
+
+TASK_IMPL_4(long double, big_satcount, MTBDD*, dds, size_t, count, size_t, nvars, MTBDD, filter)
+{
+    if (count == 1) return (long double)satcount_filtered(*dds, filter, nvars);
     SPAWN(big_satcount, dds, count/2, nvars, filter);
     long double result = big_satcount(dds+count/2, count-count/2, nvars, filter);
     return result + SYNC(big_satcount);
@@ -120,11 +166,20 @@ TASK_IMPL_2(MTBDD, big_union, MTBDD*, sets, size_t, count)
     return result;
 }
 
-TASK_IMPL_3(double, count_transitions, size_t, first, size_t, count, size_t, nvars)
+TASK_IMPL_2(size_t, big_pin, MTBDD*, dds, size_t, count)
 {
-    if (count == 1) return mtbdd_satcount(get_signature(first), nvars);
-    SPAWN(count_transitions, first, count/2, nvars);
-    double result = CALL(count_transitions, first+count/2, count-count/2, nvars);
+    if (count == 0) return 0;
+    if (count == 1) return mtbdd_pin(*dds);
+    SPAWN(big_pin, dds, count/2);
+    size_t result = CALL(big_pin, dds+count/2, count-count/2);
+    return result + SYNC(big_pin);
+}
+
+TASK_IMPL_4(double, count_transitions, sigref_context*, ctx, size_t, first, size_t, count, size_t, nvars)
+{
+    if (count == 1) return mtbdd_satcount(get_signature(ctx, first), nvars);
+    SPAWN(count_transitions, ctx, first, count/2, nvars);
+    double result = CALL(count_transitions, ctx, first+count/2, count-count/2, nvars);
     return result + SYNC(count_transitions);
 }
 
@@ -162,4 +217,111 @@ TASK_IMPL_3(BDD, extend_relation, BDD, relation, BDD, variables, int, state_leng
     return result;
 }
 
+void
+start_time_limit(sigref_context *ctx)
+{
+    ctx->time_limit_end = wctime() + ctx->options.time_limit;
+}
+
+void
+start_iteration(sigref_context *ctx)
+{
+    LACE_ME;
+    bool compacted = false;
+    if (ctx->options.compaction && sylvan_gc_count() != ctx->compacted_gc_count) {
+        double t = wctime();
+        sylvan_compact();
+        ctx->compacted_gc_count = sylvan_gc_count();
+        compacted = true;
+        if (ctx->options.verbosity >= 1) INFO("Compacted the nodes table in %.2f sec.", wctime()-t);
+    }
+    sylvan_scratch_begin();
+    size_t filled = llmsset_count_marked(nodes);
+    size_t growth = filled > ctx->iteration_nodes ? filled - ctx->iteration_nodes : 0;
+    if (sylvan_scratch_size() > 0 && filled + growth > llmsset_get_size(nodes)) {
+        if (ctx->options.verbosity >= 1) INFO("Discarding the unreferenced nodes of earlier iterations.");
+        sylvan_scratch_discard();
+        filled = llmsset_count_marked(nodes);
+    }
+    // compaction clears the operation cache, so the next iteration recreates the nodes of the
+    // last one and its growth says nothing about the iteration after it
+    ctx->iteration_nodes = compacted ? SIZE_MAX : filled;
+}
+
+bool
+stop_refinement(sigref_context *ctx, size_t iterations)
+{
+    MemoryPressure step = memory_pressure(ctx);
+    if (step >= memory_no_stats && ctx->options.verbosity > 0) {
+        INFO("Memory limit: continuing with verbosity 0.");
+        ctx->options.verbosity = 0;
+    }
+    memory_pressure_applied(ctx);
+
+    if (step == memory_exhausted) {
+        INFO("Memory limit: stopping refinement, the partition is not stable.");
+        ctx->stable = 0;
+        return true;
+    }
+
+    if (ctx->options.time_limit != 0 && wctime() >= ctx->time_limit_end) {
+        INFO("Time limit: stopping refinement, the partition is not stable.");
+        ctx->stable = 0;
+        return true;
+    }
+
+    if (ctx->options.max_iterations != 0 && iterations >= ctx->options.max_iterations) {
+        INFO("Stopping refinement after %'zu iterations, the partition is %zu-bounded.", iterations, iterations);
+        ctx->stable = 0;
+        ctx->bound = iterations;
+        return true;
+    }
+    return false;
+}
+
+void
+report_numa()
+{
+    static const char *policies[] = {"default", "interleave", "owner"};
+    int n = numa_domain_count();
+    INFO("NUMA placement: %s, %d domain(s).", policies[sylvan_get_numa_policy()], n);
+
+    const char *tables[] = {"nodes table", "operation cache"};
+    size_t counts[n];
+    for (int t=0; t<2; t++) {
+        size_t sampled = t == 0 ? llmsset_numa_distribution(nodes, counts, n) : cache_numa_distribution(counts, n);
+        if (sampled == 0) {
+            INFO("NUMA domains of the %s: unknown.", tables[t]);
+            continue;
+        }
+        char buf[256];
+        int len = 0;
+        for (int i=0; i<n && len < 200; i++) {
+            len += snprintf(buf+len, sizeof(buf)-len, "%s%d: %.1f%%", i ? ", " : "", i, 100.0*counts[i]/sampled);
+        }
+        INFO("NUMA domains of the %s (%'zu sampled pages): %s.", tables[t], sampled, buf);
+    }
+}
+
+void
+report_huge_pages()
+{
+    static const char *backings[] = {"none", "transparent", "hugetlb"};
+    size_t resident, hugetlb;
+    size_t huge = pages_huge_bytes(&resident, &hugetlb);
+    INFO("Huge pages: %s; %'zu of %'zu resident bytes of the tables are backed by huge pages (%'zu bytes mapped with hugetlb).",
+         backings[sylvan_get_huge_pages()], huge, resident, hugetlb);
+}
+
+void
+report_cache_regions()
+{
+    for (int r=0; r<cache_get_region_count() && r<SIGREF_REGION_COUNT; r++) {
+        uint64_t gets, hits;
+        size_t buckets = cache_region_stats(r, &gets, &hits);
+        INFO("Cache region %s: %'zu buckets, %'zu of %'zu lookups hit (%.1f%%).",
+             sigref_region_names[r], buckets, (size_t)hits, (size_t)gets, gets ? 100.0*hits/gets : 0.0);
+    }
+}
+
 }
@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 #include <sylvan.h>
+#include <context.h>
 
 #ifndef SIGREF_UTIL_H
 #define SIGREF_UTIL_H
@@ -35,7 +36,14 @@ TASK_DECL_1(MTBDD, swap_prime, MTBDD);
 #define swap_prime(set) CALL(swap_prime, set)
 
 /**
- * Compute \BigSatCount sets
+ * Count the assignments to <nvars> variables of <dd> (not false) restricted to the BDD <filter>,
+ * without computing the product of <dd> and <filter>
+ */
+TASK_DECL_3(double, satcount_filtered, MTBDD, MTBDD, size_t);
+#define satcount_filtered(dd, filter, nvars) CALL(satcount_filtered, dd, filter, nvars)
+
+/**
+ * Compute \BigSatCount sets, restricted to the BDD <filter>
  */
 TASK_DECL_4(long double, big_satcount, MTBDD*, size_t, size_t, MTBDD);
 #define big_satcount(sets, count, nvars, filter) CALL(big_satcount, sets, count, nvars, filter)
@@ -47,10 +55,17 @@ TASK_DECL_2(MTBDD, big_union, MTBDD*, size_t)
 #define big_union(sets, count) CALL(big_union, sets, count)
 
 /**
- * Count number of transitions using the signatures
+ * Pin the <count> DDs <dds> in the nodes table (see mtbdd_pin), so garbage collection neither
+ * frees nor marks their nodes until mtbdd_unpin_all. Returns the number of newly pinned nodes.
+ */
+TASK_DECL_2(size_t, big_pin, MTBDD*, size_t);
+#define big_pin(dds, count) CALL(big_pin, dds, count)
+
+/**
+ * Count number of transitions using the signatures of <ctx>
  */
-TASK_DECL_3(double, count_transitions, size_t, size_t, size_t);
-#define count_transitions(first, count, nvars) CALL(count_transitions, first, count, nvars)
+TASK_DECL_4(double, count_transitions, sigref_context*, size_t, size_t, size_t);
+#define count_transitions(ctx, first, count, nvars) CALL(count_transitions, ctx, first, count, nvars)
 
 /**
  * Extend a relation <rel> defined on variables <vars> to the full domain,
@@ -59,6 +74,51 @@ TASK_DECL_3(double, count_transitions, size_t, size_t, size_t);
 TASK_DECL_3(BDD, extend_relation, BDD, BDD, int);
 #define extend_relation(rel, vars, state_length) CALL(extend_relation, rel, vars, state_length)
 
+/**
+ * Start the time limit of <ctx> (the option time_limit), before each refinement.
+ */
+void start_time_limit(sigref_context *ctx);
+
+/**
+ * Called by the refinement loops at the start of every iteration. Nodes that are created during
+ * refinement are scratch nodes (see sylvan_scratch_begin); when the nodes table would fill up
+ * if the next iteration creates as many nodes as the last one, the unreferenced ones (the
+ * signatures and inert sets of earlier iterations) are freed with sylvan_scratch_discard instead
+ * of a garbage collection of the whole table. Discarding earlier would lose the cache entries of
+ * these nodes, which later iterations often reuse.
+ * With --compact, the nodes table is first compacted (sylvan_compact) if a garbage collection
+ * happened since the last compaction; only protected references are updated, so the refinement
+ * loops protect the decision diagrams they keep in local variables.
+ * The refinement loops call sylvan_scratch_end after the last iteration.
+ */
+void start_iteration(sigref_context *ctx);
+
+/**
+ * Called by the refinement loops after <iterations> iterations, if the last one changed the
+ * partition: applies the steps of the memory limit (see table_sizes.hpp) and returns true if
+ * refinement must stop, at the memory limit, at the time limit or after max_iterations.
+ * Merged transition relations are split by the caller before. The result is recorded in
+ * ctx->stable and ctx->bound.
+ */
+bool stop_refinement(sigref_context *ctx, size_t iterations);
+
+/**
+ * Report the placement policy (--numa) and the share of the sampled pages of the nodes table and
+ * the operation cache on every NUMA domain.
+ */
+void report_numa();
+
+/**
+ * Report the huge page backing (--huge-pages) and how many resident bytes of the nodes table,
+ * the operation cache and the arrays of refine are backed by huge pages.
+ */
+void report_huge_pages();
+
+/**
+ * Report the size and the hit rate of every region of the operation cache (--cache-regions).
+ */
+void report_cache_regions();
+
 } // namespace sigref
 
 #endif
@@ -0,0 +1,349 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <cstddef> // to fix errors with gmp
+#include <utility>
+
+#include <gmp.h>
+
+#include <sigref.h>
+#include <steady_state.hpp>
+
+namespace sigref {
+
+using namespace sylvan;
+
+/* Rows per chunk of an iteration; Gauss-Seidel uses the new values within a chunk */
+#define STEADY_CHUNK 1024
+
+/* Relaxation of Jacobi: the weight of the new value against the previous one. Without it, Jacobi
+   does not converge on chains with a periodic structure (e.g. kanban-3) */
+#define STEADY_RELAX 0.9
+
+/**
+ * A transition of the rate matrix (or a state, with from = the state)
+ */
+struct rate_entry {
+    uint64_t from;
+    uint64_t to;
+    double rate;
+};
+
+/**
+ * The rate matrix in compressed rows by target state: the transitions into state j are
+ * entries[row_start[j]..row_start[j+1]), as pairs of the source state and the rate (without self-loops).
+ * States are numbered by their index in <states>. Also the vectors of the iterations.
+ */
+struct rate_matrix {
+    std::vector<uint64_t> states;
+    std::vector<size_t> row_start;
+    std::vector<size_t> row_fill;
+    std::vector<std::pair<size_t, double>> entries;
+    std::vector<double> exit_rate;
+    std::vector<std::vector<rate_entry>> buffers; // per worker, for the enumeration
+
+    SteadyStateMethod method;
+    double lambda; // uniformization rate (power iteration)
+    std::vector<double> p, q; // the current and the next distribution
+};
+
+/**
+ * Helper: the rate of a leaf as a double
+ */
+static double
+leaf_rate(MTBDD leaf)
+{
+    if (leaf == mtbdd_true) return 1.0;
+    uint32_t type = mtbdd_gettype(leaf);
+    if (type == 1) return mtbdd_getdouble(leaf);
+    if (type == 2) return (double)mtbdd_getnumer(leaf) / (double)mtbdd_getdenom(leaf);
+    // otherwise a GMP leaf
+    return mpq_get_d((mpq_ptr)mtbdd_getvalue(leaf));
+}
+
+/**
+ * Enumerate <dd> on the variables <vars> into the buffer of the worker, in parallel.
+ * State bit j is variable 2j (added to <from>) and successor bit j is variable 2j+1 (added to <to>).
+ */
+VOID_TASK_5(collect_rates, MTBDD, dd, MTBDD, vars, uint64_t, from, uint64_t, to, rate_matrix*, m)
+{
+    if (dd == mtbdd_false) return;
+    if (mtbdd_set_isempty(vars)) {
+        m->buffers[LACE_WORKER_ID].push_back({from, to, leaf_rate(dd)});
+        return;
+    }
+
+    uint32_t var = mtbdd_set_first(vars);
+    MTBDD next = mtbdd_set_next(vars);
+    MTBDD low = dd, high = dd;
+    if (!mtbdd_isleaf(dd) && mtbdd_getvar(dd) == var) {
+        low = mtbdd_getlow(dd);
+        high = mtbdd_gethigh(dd);
+    }
+
+    uint64_t bit = 1ULL << (var/2);
+    if (var & 1) {
+        SPAWN(collect_rates, low, next, from, to, m);
+        CALL(collect_rates, high, next, from, to | bit, m);
+    } else {
+        SPAWN(collect_rates, low, next, from, to, m);
+        CALL(collect_rates, high, next, from | bit, to, m);
+    }
+    SYNC(collect_rates);
+}
+
+/**
+ * Helper: the index of state <state>
+ */
+static inline size_t
+state_index(const rate_matrix *m, uint64_t state)
+{
+    return std::lower_bound(m->states.begin(), m->states.end(), state) - m->states.begin();
+}
+
+/**
+ * Replace the states of the transitions in buffers[first..first+count) by their indices and count
+ * the transitions into every state in row_start[j+1]. Self-loops (and transitions from or to
+ * unreachable states) get the index of no state.
+ */
+VOID_TASK_3(count_rows, rate_matrix*, m, size_t, first, size_t, count)
+{
+    if (count > 1) {
+        SPAWN(count_rows, m, first, count/2);
+        CALL(count_rows, m, first+count/2, count-count/2);
+        SYNC(count_rows);
+        return;
+    }
+
+    size_t n = m->states.size();
+    for (rate_entry &e : m->buffers[first]) {
+        size_t from = state_index(m, e.from);
+        size_t to = state_index(m, e.to);
+        if (from == n || m->states[from] != e.from || to == n || m->states[to] != e.to || from == to) {
+            e.to = n;
+            continue;
+        }
+        e.from = from;
+        e.to = to;
+        __sync_fetch_and_add(&m->row_start[to+1], 1);
+    }
+}
+
+/**
+ * Put the transitions in buffers[first..first+count) in their rows
+ */
+VOID_TASK_3(fill_rows, rate_matrix*, m, size_t, first, size_t, count)
+{
+    if (count > 1) {
+        SPAWN(fill_rows, m, first, count/2);
+        CALL(fill_rows, m, first+count/2, count-count/2);
+        SYNC(fill_rows);
+        return;
+    }
+
+    size_t n = m->states.size();
+    for (rate_entry &e : m->buffers[first]) {
+        if (e.to == n) continue;
+        size_t pos = __sync_fetch_and_add(&m->row_fill[e.to], 1);
+        m->entries[pos] = std::make_pair((size_t)e.from, e.rate);
+    }
+}
+
+/**
+ * Sort the rows first..first+count by source, so iterations do not depend on the enumeration order
+ */
+VOID_TASK_3(sort_rows, rate_matrix*, m, size_t, first, size_t, count)
+{
+    if (count > STEADY_CHUNK) {
+        SPAWN(sort_rows, m, first, count/2);
+        CALL(sort_rows, m, first+count/2, count-count/2);
+        SYNC(sort_rows);
+        return;
+    }
+
+    for (size_t j=first; j<first+count; j++) {
+        std::sort(m->entries.begin()+m->row_start[j], m->entries.begin()+m->row_start[j+1]);
+    }
+}
+
+/**
+ * Compute the next distribution q of the rows first..first+count from p.
+ * For Gauss-Seidel, the rows of the chunk use the new values of the rows before them in the chunk.
+ * Returns the sum of the new values.
+ */
+TASK_3(double, update_rows, rate_matrix*, m, size_t, first, size_t, count)
+{
+    if (count > STEADY_CHUNK) {
+        SPAWN(update_rows, m, first, count/2);
+        double right = CALL(update_rows, m, first+count/2, count-count/2);
+        double left = SYNC(update_rows);
+        return left + right;
+    }
+
+    const double *p = m->p.data();
+    double *q = m->q.data();
+    double sum = 0;
+    for (size_t j=first; j<first+count; j++) {
+        double in = 0;
+        for (size_t k=m->row_start[j]; k<m->row_start[j+1]; k++) {
+            size_t i = m->entries[k].first;
+            double value = (m->method == steady_gauss_seidel && i >= first && i < j) ? q[i] : p[i];
+            in += value * m->entries[k].second;
+        }
+        if (m->method == steady_power) {
+            q[j] = p[j] * (1.0 - m->exit_rate[j] / m->lambda) + in / m->lambda;
+        } else if (m->method == steady_jacobi) {
+            q[j] = (1.0 - STEADY_RELAX) * p[j] + STEADY_RELAX * in / m->exit_rate[j];
+        } else {
+            q[j] = in / m->exit_rate[j];
+        }
+        sum += q[j];
+    }
+    return sum;
+}
+
+/**
+ * Scale the rows first..first+count of q by <scale> and return the largest change from p
+ */
+TASK_4(double, normalize_rows, rate_matrix*, m, size_t, first, size_t, count, double, scale)
+{
+    if (count > STEADY_CHUNK) {
+        SPAWN(normalize_rows, m, first, count/2, scale);
+        double right = CALL(normalize_rows, m, first+count/2, count-count/2, scale);
+        double left = SYNC(normalize_rows);
+        return left > right ? left : right;
+    }
+
+    double change = 0;
+    for (size_t j=first; j<first+count; j++) {
+        double value = m->q[j] * scale;
+        m->q[j] = value;
+        double diff = fabs(value - m->p[j]);
+        if (diff > change) change = diff;
+    }
+    return change;
+}
+
+SteadyState
+solveSteadyState(CTMC &ctmc, SteadyStateMethod method, double epsilon, size_t limit, int verbosity)
+{
+    LACE_ME;
+
+    double t_start_matrix = wctime();
+
+    rate_matrix m;
+    m.buffers.resize(lace_workers());
+
+    /* The states, in increasing order */
+    CALL(collect_rates, ctmc.getStates().GetBDD(), ctmc.getVarS().GetBDD(), 0, 0, &m);
+    for (auto &buffer : m.buffers) {
+        for (rate_entry &e : buffer) m.states.push_back(e.from);
+        buffer.clear();
+    }
+    std::sort(m.states.begin(), m.states.end());
+    size_t n = m.states.size();
+
+    /* The rate matrix, in compressed rows by target state */
+    MTBDD st_vars = (ctmc.getVarS() * ctmc.getVarT()).GetBDD();
+    CALL(collect_rates, ctmc.getMarkovTransitions().GetMTBDD(), st_vars, 0, 0, &m);
+    m.row_start.assign(n+1, 0);
+    CALL(count_rows, &m, 0, m.buffers.size());
+    for (size_t j=0; j<n; j++) m.row_start[j+1] += m.row_start[j];
+    m.row_fill.assign(m.row_start.begin(), m.row_start.end()-1);
+    m.entries.resize(m.row_start[n]);
+    CALL(fill_rows, &m, 0, m.buffers.size());
+    m.buffers.clear();
+    if (n > 0) CALL(sort_rows, &m, 0, n);
+
+    m.exit_rate.assign(n, 0.0);
+    for (auto &e : m.entries) m.exit_rate[e.first] += e.second;
+
+    INFO("Steady state: %'zu states and %'zu transitions in %.2f sec.", n, m.entries.size(), wctime()-t_start_matrix);
+
+    /* Jacobi and Gauss-Seidel divide by the exit rate, so absorbing states need power iteration */
+    double max_exit = 0;
+    bool absorbing = false;
+    for (double rate : m.exit_rate) {
+        if (rate > max_exit) max_exit = rate;
+        if (rate == 0) absorbing = true;
+    }
+    if (absorbing && method != steady_power) {
+        INFO("Steady state: the CTMC has absorbing states, using power iteration.");
+        method = steady_power;
+    }
+    m.method = method;
+    m.lambda = max_exit > 0 ? max_exit * 1.02 : 1.0;
+
+    /* Power iteration starts with the uniform distribution on the initial states; Jacobi and
+       Gauss-Seidel start with the uniform distribution on all states, as the initial states
+       may have no incoming transitions, which would make every value 0 */
+    m.p.assign(n, 0.0);
+    m.q.assign(n, 0.0);
+    if (method != steady_power) {
+        std::fill(m.p.begin(), m.p.end(), n > 0 ? 1.0/n : 0.0);
+    } else {
+        rate_matrix init;
+        init.buffers.resize(lace_workers());
+        CALL(collect_rates, ctmc.getInitialStates().GetBDD(), ctmc.getVarS().GetBDD(), 0, 0, &init);
+        size_t count = 0;
+        for (auto &buffer : init.buffers) {
+            for (rate_entry &e : buffer) {
+                size_t i = state_index(&m, e.from);
+                if (i < n && m.states[i] == e.from) {
+                    m.p[i] = 1.0;
+                    count++;
+                }
+            }
+        }
+        if (count == 0) std::fill(m.p.begin(), m.p.end(), 1.0);
+        double sum = count == 0 ? n : count;
+        for (double &value : m.p) value /= sum;
+    }
+
+    double t_start_solve = wctime();
+    SteadyState result;
+    result.method = method;
+    result.iterations = 0;
+    result.converged = n == 0;
+    while (!result.converged && result.iterations < limit) {
+        double sum = CALL(update_rows, &m, 0, n);
+        double change = CALL(normalize_rows, &m, 0, n, sum > 0 ? 1.0/sum : 1.0);
+        m.p.swap(m.q);
+        result.iterations++;
+        // relative to the largest probability, as transient states may decay towards 0
+        double largest = *std::max_element(m.p.begin(), m.p.end());
+        if (change <= epsilon * largest && sum > 0) result.converged = true;
+        if (verbosity >= 1 && result.iterations % 1000 == 0) {
+            INFO("Steady state: after iteration %zu, the largest change is %g.", result.iterations, change);
+        }
+    }
+
+    if (result.converged) {
+        INFO("Steady state: converged after %zu iterations in %.2f sec.", result.iterations, wctime()-t_start_solve);
+    } else {
+        INFO("Steady state: not converged after %zu iterations in %.2f sec.", result.iterations, wctime()-t_start_solve);
+    }
+
+    result.states.swap(m.states);
+    result.probabilities.swap(m.p);
+    return result;
+}
+
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <systems.hpp>
+
+#ifndef SIGREF_STEADY_STATE_H
+#define SIGREF_STEADY_STATE_H
+
+namespace sigref {
+
+/**
+ * Iterative methods for the stationary distribution of a CTMC (--steady-state)
+ */
+typedef enum {
+    steady_none = 0,
+    steady_jacobi = 1,
+    steady_gauss_seidel = 2,
+    steady_power = 3,
+} SteadyStateMethod;
+
+/**
+ * The stationary distribution of a CTMC
+ */
+struct SteadyState {
+    SteadyStateMethod method;           // the method that was used
+    std::vector<uint64_t> states;       // the states (block numbers of a quotient), in increasing order
+    std::vector<double> probabilities;  // the probability of each state
+    size_t iterations;
+    bool converged;
+};
+
+/**
+ * Compute the stationary distribution of <ctmc> (with at most 64 state variables) with <method>,
+ * starting from the uniform distribution on the initial states (power iteration) or on all states
+ * (Jacobi and Gauss-Seidel), until the largest change of a probability in one iteration is at most
+ * <epsilon> times the largest probability, or after <limit> iterations.
+ *
+ * The rate matrix is enumerated in parallel into compressed rows by target state, and every
+ * iteration updates the rows in parallel on the Lace workers. Gauss-Seidel uses the new values
+ * within each chunk of rows, so the result does not depend on the number of workers; Jacobi
+ * is under-relaxed (the new value is averaged with the previous one), so it also converges on
+ * periodic chains.
+ * Jacobi and Gauss-Seidel assume an irreducible CTMC; with absorbing states, power iteration is
+ * used instead, which gives the limit of the uniformized chain from the initial states.
+ * With <verbosity> 1 or more, reports the progress every 1000 iterations.
+ * Must be called from a Lace task.
+ */
+SteadyState solveSteadyState(CTMC &ctmc, SteadyStateMethod method, double epsilon = 1e-6, size_t limit = 100000, int verbosity = 0);
+
+}
+
+#endif
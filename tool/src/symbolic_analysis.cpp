@@ -0,0 +1,276 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <cstddef> // to fix errors with gmp
+
+#include <gmp.h>
+#include <sylvan_gmp.h>
+
+#include <matvec.h>
+#include <sigref.h>
+#include <symbolic_analysis.hpp>
+
+namespace sigref {
+
+using namespace sylvan;
+
+/**
+ * Helper: the value of a leaf as a double (missing values are 0)
+ */
+static double
+leaf_value(MTBDD leaf)
+{
+    if (leaf == mtbdd_false) return 0.0;
+    if (leaf == mtbdd_true) return 1.0;
+    uint32_t type = mtbdd_gettype(leaf);
+    if (type == 1) return mtbdd_getdouble(leaf);
+    if (type == 2) return (double)mtbdd_getnumer(leaf) / (double)mtbdd_getdenom(leaf);
+    // otherwise a GMP leaf
+    return mpq_get_d((mpq_ptr)mtbdd_getvalue(leaf));
+}
+
+/**
+ * Helper: true if the leaves of <dd> are GMP leaves (see leaf_value)
+ */
+static bool
+has_gmp_leaves(MTBDD dd)
+{
+    while (!mtbdd_isleaf(dd)) dd = mtbdd_getlow(dd) != mtbdd_false ? mtbdd_getlow(dd) : mtbdd_gethigh(dd);
+    return dd != mtbdd_false && dd != mtbdd_true && mtbdd_gettype(dd) > 2;
+}
+
+/**
+ * Operation for mtbdd_uapply: convert fractions to doubles
+ */
+TASK_2(MTBDD, fraction_to_double, MTBDD, dd, size_t, param)
+{
+    if (dd == mtbdd_false || dd == mtbdd_true) return dd;
+    if (!mtbdd_isleaf(dd)) return mtbdd_invalid;
+    if (mtbdd_gettype(dd) != 2) return dd;
+    return mtbdd_double((double)mtbdd_getnumer(dd) / (double)mtbdd_getdenom(dd));
+    (void)param;
+}
+
+/**
+ * Operation for mtbdd_uapply: round GMP leaves to the nearest double
+ */
+TASK_2(MTBDD, round_gmp, MTBDD, dd, size_t, param)
+{
+    if (dd == mtbdd_false || dd == mtbdd_true) return dd;
+    if (!mtbdd_isleaf(dd)) return mtbdd_invalid;
+    mpq_t q;
+    mpq_init(q);
+    mpq_set_d(q, mpq_get_d((mpq_ptr)mtbdd_getvalue(dd)));
+    MTBDD result = mtbdd_gmp(q);
+    mpq_clear(q);
+    return result;
+    (void)param;
+}
+
+/**
+ * The uniformized CTMC: one step is x' = x + (x*R - x*E) / lambda,
+ * with the operations on its leaf type (GMP leaves, or doubles)
+ */
+struct uniformized {
+    bool gmp;           // GMP leaves, otherwise doubles
+    Mtbdd rates;        // R on s,t
+    Mtbdd exit_rates;   // E on s
+    Mtbdd inv_lambda;   // 1/lambda
+    Bdd s_vars;
+
+    /* a leaf with <value> */
+    MTBDD make_leaf(double value) const
+    {
+        if (!gmp) return mtbdd_double(value);
+        mpq_t q;
+        mpq_init(q);
+        mpq_set_d(q, value);
+        MTBDD result = mtbdd_gmp(q);
+        mpq_clear(q);
+        return result;
+    }
+
+    Mtbdd plus(const Mtbdd &a, const Mtbdd &b) const
+    {
+        LACE_ME;
+        if (gmp) return gmp_plus(a.GetMTBDD(), b.GetMTBDD());
+        else return mtbdd_plus(a.GetMTBDD(), b.GetMTBDD());
+    }
+
+    Mtbdd minus(const Mtbdd &a, const Mtbdd &b) const
+    {
+        LACE_ME;
+        if (gmp) return gmp_minus(a.GetMTBDD(), b.GetMTBDD());
+        else return mtbdd_minus(a.GetMTBDD(), b.GetMTBDD());
+    }
+
+    Mtbdd times(const Mtbdd &a, const Mtbdd &b) const
+    {
+        LACE_ME;
+        if (gmp) return gmp_times(a.GetMTBDD(), b.GetMTBDD());
+        else return mtbdd_times(a.GetMTBDD(), b.GetMTBDD());
+    }
+
+    /* the sum, maximum and minimum of <a> over all states */
+    double sum(const Mtbdd &a) const
+    {
+        LACE_ME;
+        if (gmp) return leaf_value(Mtbdd(gmp_abstract_plus(a.GetMTBDD(), s_vars.GetBDD())).GetMTBDD());
+        else return leaf_value(Mtbdd(mtbdd_abstract_plus(a.GetMTBDD(), s_vars.GetBDD())).GetMTBDD());
+    }
+
+    double maximum(const Mtbdd &a) const
+    {
+        LACE_ME;
+        if (gmp) return leaf_value(Mtbdd(gmp_abstract_max(a.GetMTBDD(), s_vars.GetBDD())).GetMTBDD());
+        else return leaf_value(Mtbdd(mtbdd_abstract_max(a.GetMTBDD(), s_vars.GetBDD())).GetMTBDD());
+    }
+
+    double minimum(const Mtbdd &a) const
+    {
+        LACE_ME;
+        if (gmp) return leaf_value(Mtbdd(gmp_abstract_min(a.GetMTBDD(), s_vars.GetBDD())).GetMTBDD());
+        else return leaf_value(Mtbdd(mtbdd_abstract_min(a.GetMTBDD(), s_vars.GetBDD())).GetMTBDD());
+    }
+
+    Mtbdd step(const Mtbdd &x) const
+    {
+        LACE_ME;
+        Mtbdd in = sigref_matvec(rates.GetMTBDD(), x.GetMTBDD(), s_vars.GetBDD(), gmp);
+        Mtbdd next = plus(x, times(minus(in, times(x, exit_rates)), inv_lambda));
+        if (gmp) next = mtbdd_uapply(next.GetMTBDD(), TASK(round_gmp), 0);
+        return next;
+    }
+};
+
+AnalysisResult
+analyzeSymbolic(CTMC &ctmc, AnalysisMode mode, double time, double epsilon, size_t limit, int verbosity)
+{
+    LACE_ME;
+
+    uniformized chain;
+    chain.s_vars = ctmc.getVarS();
+    chain.rates = ctmc.getMarkovTransitions();
+    chain.gmp = has_gmp_leaves(chain.rates.GetMTBDD());
+    if (!chain.gmp) chain.rates = mtbdd_uapply(chain.rates.GetMTBDD(), TASK(fraction_to_double), 0);
+
+    /* The exit rates and the uniformization rate */
+    if (chain.gmp) chain.exit_rates = gmp_abstract_plus(chain.rates.GetMTBDD(), ctmc.getVarT().GetBDD());
+    else chain.exit_rates = mtbdd_abstract_plus(chain.rates.GetMTBDD(), ctmc.getVarT().GetBDD());
+    double max_exit = chain.maximum(chain.exit_rates);
+    double lambda = max_exit > 0 ? max_exit * 1.02 : 1.0;
+    chain.inv_lambda = chain.make_leaf(1.0 / lambda);
+
+    /* Start with the uniform distribution on the initial states */
+    Bdd init = ctmc.getInitialStates() * ctmc.getStates();
+    if (init == Bdd::bddZero()) init = ctmc.getStates();
+    double count = sylvan_satcount(init.GetBDD(), chain.s_vars.GetBDD());
+    Mtbdd x = chain.times(Mtbdd(init), chain.make_leaf(count > 0 ? 1.0 / count : 0.0));
+
+    AnalysisResult result;
+    result.mode = mode;
+    result.time = time;
+    result.iterations = 0;
+    result.converged = false;
+
+    double t_start_solve = wctime();
+    if (mode == analysis_steady) {
+        /* Power iteration of the uniformized chain */
+        double checkpoint_change = 0; // the largest change 1000 steps ago
+        while (!result.converged && result.iterations < limit) {
+            Mtbdd next = chain.step(x);
+            Mtbdd diff = chain.minus(next, x);
+            double change = fmax(chain.maximum(diff), -chain.minimum(diff));
+            double largest = chain.maximum(next);
+            x = next;
+            result.iterations++;
+            if (change <= epsilon * largest) result.converged = true;
+            if (result.converged || result.iterations % 1000 != 0) continue;
+            if (verbosity >= 1) {
+                INFO("Analysis: after iteration %zu, the largest change is %g.", result.iterations, change);
+            }
+            /* Stop early if the change does not decrease fast enough to converge within <limit> steps */
+            if (checkpoint_change > 0) {
+                double rate = pow(change / checkpoint_change, 1.0/1000);
+                if (rate >= 1.0) {
+                    INFO("Analysis: the change does not decrease after %zu steps, stopping; try the explicit solver (--steady-state).", result.iterations);
+                    break;
+                }
+                double needed = log(epsilon * largest / change) / log(rate);
+                if (result.iterations + needed > limit) {
+                    INFO("Analysis: at this rate, about %.0f more steps are needed, stopping; try the explicit solver (--steady-state).", needed);
+                    break;
+                }
+            }
+            checkpoint_change = change;
+        }
+        result.distribution = x;
+    } else {
+        /* Uniformization: the sum of the Poisson(lambda*time) weighted steps */
+        double q = lambda * time;
+        double total = 0;
+        Mtbdd distribution = mtbdd_false;
+        for (size_t k=0;; k++) {
+            double log_weight = -q - lgamma((double)k+1);
+            if (k > 0) log_weight += (double)k * log(q);
+            double weight = exp(log_weight);
+            if (weight > 0) distribution = chain.plus(distribution, chain.times(x, chain.make_leaf(weight)));
+            total += weight;
+            if (total >= 1.0 - epsilon) {
+                result.converged = true;
+                break;
+            }
+            if (result.iterations >= limit) break;
+            x = chain.step(x);
+            result.iterations++;
+            if (verbosity >= 1 && result.iterations % 1000 == 0) {
+                INFO("Analysis: after step %zu, the Poisson weight is %g.", result.iterations, total);
+            }
+        }
+        result.distribution = distribution;
+    }
+
+    if (result.converged) {
+        INFO("Analysis: converged after %zu steps in %.2f sec.", result.iterations, wctime()-t_start_solve);
+    } else {
+        INFO("Analysis: not converged after %zu steps in %.2f sec.", result.iterations, wctime()-t_start_solve);
+    }
+
+    /* The probability of "init" (the initial states that were used, see above) and of the labels
+       of the initial partition */
+    result.labels.push_back("init");
+    result.probabilities.push_back(chain.sum(chain.times(result.distribution, Mtbdd(init))));
+
+    std::vector<std::string> labels = ctmc.getLabels();
+    std::vector<std::vector<size_t>> partition_labels = ctmc.getInitialPartitionLabels();
+    std::vector<Bdd> partition = ctmc.getInitialPartition();
+    if (partition_labels.size() != partition.size()) partition_labels.clear();
+    for (size_t l=0; l<labels.size(); l++) {
+        Bdd set = Bdd::bddZero();
+        for (size_t i=0; i<partition_labels.size(); i++) {
+            for (size_t k : partition_labels[i]) if (k == l) set += partition[i];
+        }
+        result.labels.push_back(labels[l]);
+        result.probabilities.push_back(chain.sum(chain.times(result.distribution, Mtbdd(set))));
+    }
+
+    return result;
+}
+
+}
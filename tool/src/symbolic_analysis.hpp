@@ -0,0 +1,69 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include <systems.hpp>
+
+#ifndef SIGREF_SYMBOLIC_ANALYSIS_H
+#define SIGREF_SYMBOLIC_ANALYSIS_H
+
+namespace sigref {
+
+/**
+ * Symbolic analyses of a CTMC (--analysis)
+ */
+typedef enum {
+    analysis_none = 0,
+    analysis_steady = 1,
+    analysis_transient = 2,
+} AnalysisMode;
+
+/**
+ * The result of a symbolic analysis: the distribution and the probability of each label
+ */
+struct AnalysisResult {
+    AnalysisMode mode;
+    double time;                        // the time of the transient distribution
+    size_t iterations;                  // the number of multiplications with the rate matrix
+    bool converged;
+    sylvan::Mtbdd distribution;         // the distribution on the state variables
+    std::vector<std::string> labels;    // "init" and the labels of the CTMC
+    std::vector<double> probabilities;  // the probability of each label
+};
+
+/**
+ * Analyze <ctmc> with the distribution as an MTBDD on the state variables, starting from the
+ * uniform distribution on the initial states. Every step multiplies with the uniformized rate
+ * matrix (see sigref_matvec), so the states are never enumerated.
+ * - analysis_steady: power iteration until the largest change of a probability in one step is
+ *   below <epsilon> times the largest probability, or after <limit> steps. Every 1000 steps, the
+ *   iteration stops early if the decrease of the change over these steps shows that it would not
+ *   converge within <limit> steps.
+ * Without initial states, the analysis starts from all states, and the label "init" is all states.
+ * - analysis_transient: the distribution at <time> by uniformization, with the Poisson terms
+ *   until their total weight is at least 1-<epsilon>, or after <limit> steps.
+ * With GMP leaves, the products are exact and the distribution is rounded to doubles after
+ * every step, so the rationals stay small; fractions are converted to doubles.
+ * With <verbosity> 1 or more, reports the progress every 1000 steps.
+ * Must be called from a Lace task.
+ */
+AnalysisResult analyzeSymbolic(CTMC &ctmc, AnalysisMode mode, double time, double epsilon = 1e-8, size_t limit = 100000, int verbosity = 0);
+
+}
+
+#endif
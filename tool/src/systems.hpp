@@ -18,6 +18,7 @@
 #define __SYSTEMS__HPP__
 
 #include <map>
+#include <string>
 #include <vector>
 
 #include <sylvan.h>
@@ -32,12 +33,18 @@ class IMC;
 class StateSystem {
     friend class SystemParser;
     friend class BddLtsParser;
+    friend class PrismCtmcParser;
     friend class Minimizations;
+    friend class Composition;
 
     sylvan::Bdd states;
     sylvan::Bdd initialStates;
     std::vector<sylvan::Bdd> initialPartition;
 
+    // names of atomic propositions, and for each block of the initial partition the propositions that hold
+    std::vector<std::string> labels;
+    std::vector<std::vector<size_t>> initialPartitionLabels;
+
     sylvan::Bdd varS;
     sylvan::Bdd varT;
     sylvan::Bdd varA;
@@ -46,6 +53,8 @@ public:
     sylvan::Bdd getStates() const { return states; }
     sylvan::Bdd getInitialStates() const { return initialStates; }
     std::vector<sylvan::Bdd> getInitialPartition() const { return initialPartition; }
+    std::vector<std::string> getLabels() const { return labels; }
+    std::vector<std::vector<size_t>> getInitialPartitionLabels() const { return initialPartitionLabels; }
     sylvan::Bdd getVarS() const { return varS; }
     sylvan::Bdd getVarT() const { return varT; }
     sylvan::Bdd getVarA() const { return varA; }
@@ -56,18 +65,24 @@ class LTS: public StateSystem
     friend class SystemParser;
     friend class BddLtsParser;
     friend class Minimizations;
+    friend class Composition;
 
     std::vector<std::pair<sylvan::Bdd,sylvan::Bdd>> transitions;
     sylvan::Bdd tau;
 
+    // names of the actions by index, if the model has them
+    std::vector<std::string> actions;
+
 public:
     std::vector<std::pair<sylvan::Bdd,sylvan::Bdd>> getTransitions() const { return transitions; }
     sylvan::Bdd getTau() const { return tau; }
+    std::vector<std::string> getActions() const { return actions; }
 };
 
 class CTMC: public StateSystem
 {
     friend class SystemParser;
+    friend class PrismCtmcParser;
     friend class Minimizations;
 
     sylvan::Mtbdd markov_transitions;
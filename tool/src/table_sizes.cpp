@@ -0,0 +1,290 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <string>
+
+#include <sylvan.h>
+#include <sylvan_int.h>
+
+#include <getrss.h>
+#include <input_stream.hpp>
+#include <sigref.h>
+#include <table_sizes.hpp>
+
+namespace sigref {
+
+/* Bytes per entry of the nodes table and the operation cache (see sylvan_init_package) */
+static const size_t node_bytes = 24;
+static const size_t cache_bytes = 36;
+
+/* The peak number of nodes during minimization, relative to the number of nodes of the input */
+static const size_t peak_factor = 64;
+
+/**
+ * Helper: read the memory.max of the cgroup <path>, returns 0 if there is no limit
+ */
+static size_t
+cgroup_memory_max(const std::string &path)
+{
+    FILE *f = fopen(("/sys/fs/cgroup" + path + "/memory.max").c_str(), "r");
+    if (f == NULL) return 0;
+    unsigned long long value = 0;
+    if (fscanf(f, "%llu", &value) != 1) value = 0; // "max"
+    fclose(f);
+    return value;
+}
+
+size_t
+available_memory(const char **source)
+{
+    size_t result = 0;
+
+    /* Find the cgroup (v2) of the process, the line "0::<path>" */
+    std::string path;
+    FILE *f = fopen("/proc/self/cgroup", "r");
+    if (f != NULL) {
+        char line[4096];
+        while (fgets(line, sizeof(line), f) != NULL) {
+            if (strncmp(line, "0::", 3) != 0) continue;
+            path = line+3;
+            while (!path.empty() && (path.back() == '\n' || path.back() == '/')) path.pop_back();
+            break;
+        }
+        fclose(f);
+    }
+
+    /* The limit of a cgroup is also bounded by the limits of its parents */
+    if (f != NULL) {
+        for (;;) {
+            size_t limit = cgroup_memory_max(path);
+            if (limit != 0 && (result == 0 || limit < result)) result = limit;
+            if (path.empty()) break;
+            path.resize(path.rfind('/'));
+        }
+    }
+    if (result != 0 && source != NULL) *source = "cgroup";
+
+    /* Without a lower cgroup limit, use the memory that is available now */
+    f = fopen("/proc/meminfo", "r");
+    if (f != NULL) {
+        char line[256];
+        unsigned long long kb;
+        while (fgets(line, sizeof(line), f) != NULL) {
+            if (sscanf(line, "MemAvailable: %llu kB", &kb) != 1) continue;
+            if (result == 0 || kb*1024 < result) {
+                result = kb*1024;
+                if (source != NULL) *source = "meminfo";
+            }
+            break;
+        }
+        fclose(f);
+    }
+
+    return result;
+}
+
+size_t
+estimate_model_nodes(const char *filename)
+{
+    struct stat st;
+    if (stat(filename, &st) != 0) return 0;
+    size_t size = st.st_size;
+
+    /* Compressed models are about 5 times smaller */
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) return 0;
+    unsigned char magic[4] = {0, 0, 0, 0};
+    size_t n = fread(magic, 1, 4, f);
+    fclose(f);
+    if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) size *= 5;
+    if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) size *= 5;
+
+    /* A node takes 16 bytes in the binary .bdd format, and roughly 32 bytes in the text formats */
+    std::string name = InputStream::stripCompressionSuffix(filename);
+    bool binary = name.size() > 4 && name.compare(name.size()-4, 4, ".bdd") == 0;
+    return size / (binary ? 16 : 32);
+}
+
+TableSizes
+auto_table_sizes(size_t input_nodes, size_t memory)
+{
+    TableSizes sizes;
+
+    /* Largest tables (with the cache half the size of the nodes table) in 3/4 of the memory */
+    size_t budget = memory / 4 * 3;
+    int max = 10;
+    while (max < 40 && (node_bytes<<(max+1)) + (cache_bytes<<max) <= budget) max++;
+
+    /* Initial tables for the estimated peak number of nodes, at least 2^20 nodes */
+    size_t needed = input_nodes * peak_factor;
+    int initial = 20;
+    while (initial < 40 && (1ULL<<initial) < needed) initial++;
+    if (initial > max) initial = max;
+
+    sizes.tablesize = initial;
+    sizes.maxtablesize = max;
+    sizes.cachesize = initial > 10 ? initial-1 : 10;
+    sizes.maxcachesize = max > 10 ? max-1 : 10;
+    return sizes;
+}
+
+size_t
+parse_memory_size(const char *arg)
+{
+    char *end;
+    unsigned long long value = strtoull(arg, &end, 10);
+    if (end == arg) return 0;
+    int shift = 0;
+    switch (*end) {
+    case 'K': case 'k': shift = 10; end++; break;
+    case 'M': case 'm': shift = 20; end++; break;
+    case 'G': case 'g': shift = 30; end++; break;
+    case 'T': case 't': shift = 40; end++; break;
+    }
+    if (*end != '\0') return 0;
+    return value << shift;
+}
+
+/* The context of the memory limit policy, see attach_memory_limit */
+static sigref_context *attached = NULL;
+
+/* The operation cache is not shrunk below this number of entries */
+static const size_t min_cache_size = 1ULL<<16;
+
+static size_t
+table_bytes(size_t nodes_size, size_t cache_size)
+{
+    return nodes_size*node_bytes + cache_size*cache_bytes;
+}
+
+/**
+ * Garbage collection hook (replaces sylvan_gc_normal_resize): grow the tables within the memory limit.
+ */
+VOID_TASK_0(memory_limit_resize)
+{
+    sigref_context *ctx = attached;
+    if (ctx == NULL) {
+        CALL(sylvan_gc_normal_resize);
+        return;
+    }
+    const size_t memory_limit = ctx->options.memory_limit;
+    MemoryPressure pressure = (MemoryPressure)ctx->memory_pressure;
+
+    size_t nodes_size = llmsset_get_size(nodes);
+    size_t nodes_max = llmsset_get_max_size(nodes);
+    if (nodes_size >= nodes_max) return;
+
+    /* Like sylvan_gc_normal_resize, grow when the nodes table is more than half full */
+    size_t marked = llmsset_count_marked(nodes);
+    if (marked*2 <= nodes_size) return;
+    size_t new_size = nodes_size*2;
+    if (new_size > nodes_max) new_size = nodes_max;
+
+    /* When exhausted, use the remaining nodes table to finish the current iteration */
+    if (pressure == memory_exhausted) {
+        llmsset_set_size(nodes, new_size);
+        return;
+    }
+
+    /* Memory outside the tables (models, refinement data) also counts against the limit */
+    size_t cache_size = cache_getsize();
+    size_t tables = table_bytes(nodes_size, cache_size);
+    size_t rss = getCurrentRSS();
+    size_t other = rss > tables ? rss - tables : 0;
+    size_t budget = memory_limit > other ? memory_limit - other : 0;
+
+    if (table_bytes(new_size, cache_size) <= budget) {
+        llmsset_set_size(nodes, new_size);
+        /* Grow the operation cache as well, unless it was shrunk before */
+        size_t cache_max = cache_getmaxsize();
+        if (pressure == memory_ok && cache_size < cache_max && table_bytes(new_size, cache_size*2) <= budget) {
+            cache_setsize(cache_size*2 > cache_max ? cache_max : cache_size*2);
+        }
+        return;
+    }
+
+    /* First step: shrink the operation cache to make room for the nodes table */
+    size_t new_cache_size = cache_size;
+    while (new_cache_size > min_cache_size && table_bytes(new_size, new_cache_size) > budget) new_cache_size /= 2;
+    if (new_cache_size != cache_size) {
+        cache_setsize(new_cache_size);
+        if (pressure < memory_cache_shrunk) {
+            pressure = memory_cache_shrunk;
+            ctx->memory_pressure = ctx->memory_pressure_applied = pressure;
+        }
+        INFO("(GC) Memory limit: operation cache shrunk to %'zu entries.", new_cache_size);
+        if (table_bytes(new_size, new_cache_size) <= budget) {
+            llmsset_set_size(nodes, new_size);
+            return;
+        }
+    }
+
+    /* Next steps: taken by the refinement loop after the current iteration, one at a time.
+       If the nodes table is nearly full, there is no time for that, so stop right away. */
+    if (marked*8 > nodes_size*7) {
+        pressure = memory_exhausted;
+    } else if (pressure == ctx->memory_pressure_applied && pressure < memory_exhausted) {
+        pressure = (MemoryPressure)(pressure+1);
+    } else {
+        return;
+    }
+    ctx->memory_pressure = pressure;
+
+    if (pressure == memory_split_relations) {
+        INFO("(GC) Memory limit: splitting merged transition relations.");
+    } else if (pressure == memory_no_stats) {
+        INFO("(GC) Memory limit: disabling optional statistics.");
+    } else if (pressure == memory_exhausted) {
+        INFO("(GC) Memory limit exhausted: stopping after the current iteration.");
+        llmsset_set_size(nodes, new_size);
+    }
+}
+
+void
+attach_memory_limit(sigref_context *ctx)
+{
+    attached = ctx;
+    if (ctx->options.memory_limit != 0) sylvan_gc_hook_main(TASK(memory_limit_resize));
+    else sylvan_gc_hook_main(TASK(sylvan_gc_normal_resize));
+    ctx->memory_pressure = ctx->memory_pressure_applied = memory_ok;
+}
+
+void
+detach_memory_limit(sigref_context *ctx)
+{
+    if (attached != ctx) return;
+    attached = NULL;
+    sylvan_gc_hook_main(TASK(sylvan_gc_normal_resize));
+}
+
+MemoryPressure
+memory_pressure(sigref_context *ctx)
+{
+    return (MemoryPressure)ctx->memory_pressure;
+}
+
+void
+memory_pressure_applied(sigref_context *ctx)
+{
+    ctx->memory_pressure_applied = ctx->memory_pressure;
+}
+
+}
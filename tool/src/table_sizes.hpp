@@ -0,0 +1,100 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+
+#include <context.h>
+
+#ifndef SIGREF_TABLE_SIZES_H
+#define SIGREF_TABLE_SIZES_H
+
+namespace sigref {
+
+/**
+ * Sizes of the nodes table and the operation cache (as powers of 2), see sylvan_init_package.
+ */
+struct TableSizes {
+    int tablesize, maxtablesize, cachesize, maxcachesize;
+};
+
+/**
+ * Memory available to this process in bytes: the lowest memory.max of the cgroup (v2)
+ * of the process and its parents, or MemAvailable of /proc/meminfo, whichever is lower.
+ * Returns 0 if neither can be read. If <source> is not NULL, it is set to "cgroup" or "meminfo".
+ */
+size_t available_memory(const char **source = NULL);
+
+/**
+ * Estimate the number of decision diagram nodes of the (possibly compressed) model <filename>,
+ * from the size of the file. Returns 0 if the file cannot be read.
+ */
+size_t estimate_model_nodes(const char *filename);
+
+/**
+ * Choose table sizes for a model of <input_nodes> nodes with <memory> bytes available.
+ * The maximum sizes are the largest that fit in 3/4 of <memory>; the initial sizes are
+ * large enough for the estimated peak number of nodes, to avoid repeated growing.
+ */
+TableSizes auto_table_sizes(size_t input_nodes, size_t memory);
+
+/**
+ * Parse a number of bytes with an optional suffix K, M, G or T (powers of 1024).
+ * Returns 0 if <arg> is not valid.
+ */
+size_t parse_memory_size(const char *arg);
+
+/**
+ * Steps of the memory limit policy, in the order in which they are taken.
+ */
+enum MemoryPressure {
+    memory_ok,              // the tables grow as usual
+    memory_cache_shrunk,    // the operation cache was shrunk to make room for the nodes table
+    memory_split_relations, // merged transition relations are split again
+    memory_no_stats,        // optional statistics are skipped
+    memory_exhausted,       // refinement stops after the current iteration
+};
+
+/**
+ * Attach <ctx> to the garbage collection hook before a minimization. With options.memory_limit
+ * of <ctx> (bytes, 0 for no limit), the hook grows the nodes table and the operation cache only
+ * within the limit. When the nodes table must grow but cannot, the hook takes the next step of
+ * MemoryPressure, recorded in <ctx>. The refinement loops apply the steps after each iteration,
+ * see memory_pressure_applied. When the limit is exhausted, the nodes table may grow up to its
+ * maximum size, so the current iteration can finish instead of Sylvan aborting.
+ * Attaching returns <ctx> to memory_ok (a shrunk operation cache stays shrunk).
+ * Call after sylvan_init_package; <ctx> stays attached until another context is attached.
+ */
+void attach_memory_limit(sigref_context *ctx);
+
+/**
+ * Restore the default garbage collection hook, if <ctx> is attached (before freeing <ctx>).
+ */
+void detach_memory_limit(sigref_context *ctx);
+
+/**
+ * The current step of the memory limit policy of <ctx>.
+ */
+MemoryPressure memory_pressure(sigref_context *ctx);
+
+/**
+ * Report that the current step has been applied; the hook takes the next step only after
+ * this, unless the nodes table is nearly full.
+ */
+void memory_pressure_applied(sigref_context *ctx);
+
+}
+
+#endif
@@ -22,18 +22,44 @@
 #include <sigref_util.hpp>
 #include <writer.hpp>
 
+#include <algorithm>
+#include <cstddef> // to fix errors with gmp
+#include <gmp.h>
 #include <stdio.h>
+#include <string>
 #include <sylvan_stats.h>
 
 namespace sigref {
 
 using namespace sylvan;
 
+/**
+ * Helper: mark explicit output of a partition that is not stable (see stop_refinement)
+ */
+static void
+write_stable_note(sigref_context *ctx, FILE *f)
+{
+    if (ctx->stable) return;
+    if (ctx->bound != 0) fprintf(f, "; %zu-bounded: refinement stopped after %zu iterations, the blocks are coarser than bisimilarity\n", ctx->bound, ctx->bound);
+    else fprintf(f, "; not stable: refinement stopped early, the blocks are coarser than bisimilarity\n");
+}
+
+/**
+ * Helper: refuse to write a partition that is not stable to a format without comments
+ */
+static bool
+refuse_unstable(sigref_context *ctx, const char *filename)
+{
+    if (ctx->stable) return false;
+    fprintf(stderr, "Not writing '%s': the partition is not stable and this format cannot mark it, use explicit output!\n", filename);
+    return true;
+}
+
 /**
  * Write result using signatures
  */
 void
-writeSignatures(const char *filename, CTMC& ctmc)
+writeSignatures(sigref_context *ctx, const char *filename, CTMC& ctmc)
 {
     INFO("");
     INFO("Starting writing result (from signatures) to %s...", filename);
@@ -47,8 +73,8 @@ writeSignatures(const char *filename, CTMC& ctmc)
 
     /* Count number of blocks and transitions */
 
-    size_t n_blocks = count_blocks();
-    double n_transitions = CALL(count_transitions, 0, n_blocks, block_length);
+    size_t n_blocks = count_blocks(ctx);
+    double n_transitions = CALL(count_transitions, ctx, 0, n_blocks, ctx->block_length);
 
     fprintf(f, "; <number of blocks (1,2,...,N)>; <number of transitions>\n");
 
@@ -58,19 +84,19 @@ writeSignatures(const char *filename, CTMC& ctmc)
     fprintf(f, "; each transition: <from block> <to block> <rate>\n");
 
     for(size_t i=1; i<=n_blocks; i++) {
-        MTBDD sig = get_signature(i-1);
+        MTBDD sig = get_signature(ctx, i-1);
 
-        uint8_t arr[block_length];
-        assert((int)sylvan_set_count(block_variables) == block_length);
-        MTBDD leaf = mtbdd_enum_all_first(sig, block_variables, arr, NULL);
+        uint8_t arr[ctx->block_length];
+        assert((int)sylvan_set_count(ctx->block_variables) == ctx->block_length);
+        MTBDD leaf = mtbdd_enum_all_first(sig, ctx->block_variables, arr, NULL);
         while (leaf != mtbdd_false) {
             /* decode block */
             uint64_t to_block = 0;
-            for (int j=0; j<block_length; j++) if (arr[j] == 1) to_block |= 1ULL<<j;
+            for (int j=0; j<ctx->block_length; j++) if (arr[j] == 1) to_block |= 1ULL<<j;
             fprintf(f, "%zu %zu ", i, to_block);
             mtbdd_fprint_leaf(f, leaf);
             fprintf(f, "\n");
-            leaf = mtbdd_enum_all_next(sig, block_variables, arr, NULL);
+            leaf = mtbdd_enum_all_next(sig, ctx->block_variables, arr, NULL);
         }
     }
 
@@ -81,7 +107,7 @@ writeSignatures(const char *filename, CTMC& ctmc)
 }
 
 void
-writeSignatures(const char *filename, LTS& lts)
+writeSignatures(sigref_context *ctx, const char *filename, LTS& lts)
 {
     INFO("");
     INFO("Starting writing results (from signatures) to %s...", filename);
@@ -95,11 +121,11 @@ writeSignatures(const char *filename, LTS& lts)
 
     /* Count number of blocks and transitions */
 
-    size_t n_blocks = count_blocks();
+    size_t n_blocks = count_blocks(ctx);
     BDD action_variables = lts.getVarA().GetBDD();
     int action_length = sylvan_set_count(action_variables);
-    BDD vars = sylvan_and(action_variables, block_variables);
-    double n_transitions = CALL(count_transitions, 0, n_blocks, block_length + action_length);
+    BDD vars = sylvan_and(action_variables, ctx->block_variables);
+    double n_transitions = CALL(count_transitions, ctx, 0, n_blocks, ctx->block_length + action_length);
 
     fprintf(f, "; <number of blocks (1,2,...,N)>; <number of transitions>\n");
 
@@ -109,9 +135,9 @@ writeSignatures(const char *filename, LTS& lts)
     fprintf(f, "; each transition: <from block>, <to block>, <action>\n");
 
     for(size_t i=1; i<=n_blocks; i++) {
-        MTBDD sig = get_signature(i-1);
+        MTBDD sig = get_signature(ctx, i-1);
 
-        uint8_t arr[block_length];
+        uint8_t arr[ctx->block_length];
         MTBDD leaf = mtbdd_enum_all_first(sig, vars, arr, NULL);
         while (leaf != mtbdd_false) {
             /* decode action */
@@ -119,7 +145,7 @@ writeSignatures(const char *filename, LTS& lts)
             for (int j=0; j<action_length; j++) if (arr[j] == 1) action |= 1ULL<<j;
             /* decode block */
             uint64_t to_block = 0;
-            for (int j=0; j<block_length; j++) if (arr[action_length+j] == 1) to_block |= 1ULL<<j;
+            for (int j=0; j<ctx->block_length; j++) if (arr[action_length+j] == 1) to_block |= 1ULL<<j;
             fprintf(f, "%zu, %zu, %zu\n", i, to_block, action);
             leaf = mtbdd_enum_all_next(sig, vars, arr, NULL);
         }
@@ -131,7 +157,7 @@ writeSignatures(const char *filename, LTS& lts)
 }
 
 void
-writeExplicitOutput(const char *filename, CTMC& ctmc)
+writeExplicitOutput(sigref_context *ctx, const char *filename, CTMC& ctmc)
 {
     INFO("");
     INFO("Starting writing result to %s...", filename);
@@ -142,6 +168,8 @@ writeExplicitOutput(const char *filename, CTMC& ctmc)
         return;
     }
 
+    write_stable_note(ctx, f);
+
     LACE_ME;
 
     /* Count number of blocks and transitions */
@@ -201,7 +229,7 @@ writeExplicitOutput(const char *filename, CTMC& ctmc)
 }
 
 void
-writeExplicitOutput(const char *filename, LTS& lts)
+writeExplicitOutput(sigref_context *ctx, const char *filename, LTS& lts)
 {
     INFO("");
     INFO("Starting writing result to %s...", filename);
@@ -211,6 +239,8 @@ writeExplicitOutput(const char *filename, LTS& lts)
         return;
     }
 
+    write_stable_note(ctx, f);
+
     LACE_ME;
 
     /* Count number of blocks and transitions */
@@ -279,7 +309,7 @@ writeExplicitOutput(const char *filename, LTS& lts)
 }
 
 void
-writeExplicitOutput(const char *filename, IMC& imc)
+writeExplicitOutput(sigref_context *ctx, const char *filename, IMC& imc)
 {
     INFO("");
     INFO("Starting writing result to %s...", filename);
@@ -289,6 +319,8 @@ writeExplicitOutput(const char *filename, IMC& imc)
         return;
     }
 
+    write_stable_note(ctx, f);
+
     LACE_ME;
 
     /* Count number of blocks and transitions */
@@ -380,20 +412,22 @@ writeExplicitOutput(const char *filename, IMC& imc)
     INFO("Finished writing result to %s.", filename);
 }
 
-void
-writeSymbolicOutput(const char *filename, CTMC& ctmc)
+bool
+writeSymbolicOutput(sigref_context *ctx, const char *filename, CTMC& ctmc)
 {
+    if (refuse_unstable(ctx, filename)) return false;
+
     INFO("");
     INFO("Starting writing result to %s...", filename);
 
     FILE *f = fopen(filename, "w");
     if (f == NULL) {
         fprintf(stderr, "Cannot open file '%s'!\n", filename);
-        return;
+        return false;
     }
 
     int numS = 1;
-    int statebits = block_length;
+    int statebits = ctx->block_length;
     int numA = 0; // ctmc has no actions
     int n_initial_partitions = ctmc.getInitialPartition().size();
 
@@ -416,22 +450,25 @@ writeSymbolicOutput(const char *filename, CTMC& ctmc)
     fclose(f);
 
     INFO("Finished writing result to %s.", filename);
+    return true;
 }
 
-void
-writeSymbolicOutput(const char *filename, LTS& lts)
+bool
+writeSymbolicOutput(sigref_context *ctx, const char *filename, LTS& lts)
 {
+    if (refuse_unstable(ctx, filename)) return false;
+
     INFO("");
     INFO("Starting writing result to %s...", filename);
 
     FILE *f = fopen(filename, "w");
     if (f == NULL) {
         fprintf(stderr, "Cannot open file '%s'!\n", filename);
-        return;
+        return false;
     }
 
     int numS = 1;
-    int statebits = block_length;
+    int statebits = ctx->block_length;
     int numA = sylvan_set_count(lts.getVarA().GetBDD());
     int n_relations = lts.getTransitions().size();
     int n_initial_partitions = lts.getInitialPartition().size();
@@ -459,22 +496,25 @@ writeSymbolicOutput(const char *filename, LTS& lts)
     fclose(f);
 
     INFO("Finished writing result to %s.", filename);
+    return true;
 }
 
-void
-writeSymbolicOutput(const char *filename, IMC& imc)
+bool
+writeSymbolicOutput(sigref_context *ctx, const char *filename, IMC& imc)
 {
+    if (refuse_unstable(ctx, filename)) return false;
+
     INFO("");
     INFO("Starting writing result to %s...", filename);
 
     FILE *f = fopen(filename, "w");
     if (f == NULL) {
         fprintf(stderr, "Cannot open file '%s'!\n", filename);
-        return;
+        return false;
     }
 
     int numS = 1;
-    int statebits = block_length;
+    int statebits = ctx->block_length;
     int numA = sylvan_set_count(imc.getVarA().GetBDD());
     int n_relations = imc.getTransitions().size();
     int n_initial_partitions = imc.getInitialPartition().size();
@@ -503,6 +543,267 @@ writeSymbolicOutput(const char *filename, IMC& imc)
     fclose(f);
 
     INFO("Finished writing result to %s.", filename);
+    return true;
+}
+
+/**
+ * Helper: the rate of a leaf as a double (for PRISM, which reads floating point rates)
+ */
+static double
+leaf_to_double(MTBDD leaf)
+{
+    uint32_t type = mtbdd_gettype(leaf);
+    if (type == 1) return mtbdd_getdouble(leaf);
+    if (type == 2) return (double)mtbdd_getnumer(leaf) / (double)mtbdd_getdenom(leaf);
+    // otherwise a GMP leaf
+    return mpq_get_d((mpq_ptr)mtbdd_getvalue(leaf));
+}
+
+/**
+ * Helper: print the shortest representation that reads back as the same double
+ */
+static void
+fprint_rate(FILE *f, double value)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.15g", value);
+    if (strtod(buf, NULL) != value) snprintf(buf, sizeof(buf), "%.17g", value);
+    fputs(buf, f);
+}
+
+bool
+writePrismOutput(sigref_context *ctx, const char *filename, CTMC& ctmc)
+{
+    if (refuse_unstable(ctx, filename)) return false;
+
+    /* The block numbers of the states are decoded into 64-bit integers */
+    if (sylvan_set_count(ctmc.getVarS().GetBDD()) > 64) {
+        fprintf(stderr, "Not writing '%s': PRISM output needs a quotient with at most 64 state variables (-q block)!\n", filename);
+        return false;
+    }
+
+    std::string base = filename;
+    if (base.size() > 4 && base.compare(base.size()-4, 4, ".tra") == 0) base.resize(base.size()-4);
+
+    INFO("");
+    INFO("Starting writing result to %s.tra, %s.lab and %s.sta...", base.c_str(), base.c_str(), base.c_str());
+
+    FILE *f_tra = fopen((base + ".tra").c_str(), "w");
+    FILE *f_lab = fopen((base + ".lab").c_str(), "w");
+    FILE *f_sta = fopen((base + ".sta").c_str(), "w");
+    if (f_tra == NULL || f_lab == NULL || f_sta == NULL) {
+        fprintf(stderr, "Cannot open files '%s.tra', '%s.lab' and '%s.sta'!\n", base.c_str(), base.c_str(), base.c_str());
+        if (f_tra != NULL) fclose(f_tra);
+        if (f_lab != NULL) fclose(f_lab);
+        if (f_sta != NULL) fclose(f_sta);
+        return false;
+    }
+
+    LACE_ME;
+
+    BDD state_vars = ctmc.getVarS().GetBDD();
+    int state_length = sylvan_set_count(state_vars);
+
+    /* PRISM numbers states 0,1,...,N-1, in the order of their encoding (block number) */
+
+    std::vector<uint64_t> states;
+    {
+        uint8_t arr[state_length];
+        BDD set = ctmc.getStates().GetBDD();
+        MTBDD leaf = mtbdd_enum_all_first(set, state_vars, arr, NULL);
+        while (leaf != mtbdd_false) {
+            uint64_t block = 0;
+            for (int j=0; j<state_length; j++) if (arr[j] == 1) block |= 1ULL<<j;
+            states.push_back(block);
+            leaf = mtbdd_enum_all_next(set, state_vars, arr, NULL);
+        }
+    }
+    std::sort(states.begin(), states.end());
+    auto index_of = [&states](uint64_t block) {
+        return (size_t)(std::lower_bound(states.begin(), states.end(), block) - states.begin());
+    };
+
+    /* Transitions, sorted by source and target as PRISM requires */
+
+    struct transition { size_t from; size_t to; double rate; };
+    std::vector<transition> transitions;
+    {
+        MTBDD markov_trans = ctmc.getMarkovTransitions().GetMTBDD();
+        Bdd vars = ctmc.getVarS() * ctmc.getVarT();
+        uint8_t arr[state_length * 2];
+        MTBDD leaf = mtbdd_enum_all_first(markov_trans, vars.GetBDD(), arr, NULL);
+        while (leaf != mtbdd_false) {
+            uint64_t from_block = 0;
+            for (int j=0; j<state_length; j++) if (arr[j*2] == 1) from_block |= 1ULL<<j;
+            uint64_t to_block = 0;
+            for (int j=0; j<state_length; j++) if (arr[j*2+1] == 1) to_block |= 1ULL<<j;
+            transitions.push_back({index_of(from_block), index_of(to_block), leaf_to_double(leaf)});
+            leaf = mtbdd_enum_all_next(markov_trans, vars.GetBDD(), arr, NULL);
+        }
+    }
+    std::sort(transitions.begin(), transitions.end(), [](const transition& a, const transition& b) {
+        return a.from < b.from || (a.from == b.from && a.to < b.to);
+    });
+
+    fprintf(f_tra, "%zu %zu\n", states.size(), transitions.size());
+    for (transition &t : transitions) {
+        fprintf(f_tra, "%zu %zu ", t.from, t.to);
+        fprint_rate(f_tra, t.rate);
+        fprintf(f_tra, "\n");
+    }
+
+    /* Labels: "init" from the initial states, the other labels from the initial partition */
+
+    std::vector<std::string> labels = ctmc.getLabels();
+    std::vector<std::vector<size_t>> partition_labels = ctmc.getInitialPartitionLabels();
+    std::vector<Bdd> partition = ctmc.getInitialPartition();
+    if (partition_labels.size() != partition.size()) partition_labels.clear();
+
+    fprintf(f_lab, "0=\"init\"");
+    for (size_t i=0; i<labels.size(); i++) fprintf(f_lab, " %zu=\"%s\"", i+1, labels[i].c_str());
+    fprintf(f_lab, "\n");
+
+    std::vector<uint8_t> initial(states.size(), 0);
+    std::vector<size_t> state_block(states.size(), (size_t)-1);
+    {
+        uint8_t arr[state_length];
+        BDD set = ctmc.getInitialStates().GetBDD();
+        MTBDD leaf = mtbdd_enum_all_first(set, state_vars, arr, NULL);
+        while (leaf != mtbdd_false) {
+            uint64_t block = 0;
+            for (int j=0; j<state_length; j++) if (arr[j] == 1) block |= 1ULL<<j;
+            initial[index_of(block)] = 1;
+            leaf = mtbdd_enum_all_next(set, state_vars, arr, NULL);
+        }
+        for (size_t i=0; i<partition_labels.size(); i++) {
+            set = partition[i].GetBDD();
+            leaf = mtbdd_enum_all_first(set, state_vars, arr, NULL);
+            while (leaf != mtbdd_false) {
+                uint64_t block = 0;
+                for (int j=0; j<state_length; j++) if (arr[j] == 1) block |= 1ULL<<j;
+                state_block[index_of(block)] = i;
+                leaf = mtbdd_enum_all_next(set, state_vars, arr, NULL);
+            }
+        }
+    }
+
+    for (size_t s=0; s<states.size(); s++) {
+        bool has_init = initial[s];
+        bool has_labels = state_block[s] != (size_t)-1 && partition_labels[state_block[s]].size() > 0;
+        if (!has_init && !has_labels) continue;
+        fprintf(f_lab, "%zu:", s);
+        if (has_init) fprintf(f_lab, " 0");
+        if (has_labels) for (size_t l : partition_labels[state_block[s]]) fprintf(f_lab, " %zu", l+1);
+        fprintf(f_lab, "\n");
+    }
+
+    /* States: the block number of each state */
+
+    fprintf(f_sta, "(block)\n");
+    for (size_t s=0; s<states.size(); s++) fprintf(f_sta, "%zu:(%zu)\n", s, (size_t)states[s]);
+
+    fclose(f_tra);
+    fclose(f_lab);
+    fclose(f_sta);
+
+    INFO("Finished writing result to %s.tra, %s.lab and %s.sta.", base.c_str(), base.c_str(), base.c_str());
+    return true;
+}
+
+/**
+ * Write the stationary distribution <steady>: one line per state (block) with its probability
+ */
+void
+writeSteadyState(sigref_context *ctx, const char *filename, const SteadyState& steady)
+{
+    INFO("");
+    INFO("Starting writing stationary distribution to %s...", filename);
+
+    FILE *f = fopen(filename, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot open file '%s'!\n", filename);
+        return;
+    }
+
+    write_stable_note(ctx, f);
+
+    const char *methods[] = {"none", "jacobi", "gauss-seidel", "power"};
+    fprintf(f, "; stationary distribution (%s, %zu iterations%s)\n", methods[steady.method], steady.iterations,
+            steady.converged ? "" : ", not converged");
+    fprintf(f, "; each block: <block> <probability>\n");
+    for (size_t i=0; i<steady.states.size(); i++) {
+        fprintf(f, "%zu ", (size_t)steady.states[i]);
+        fprint_rate(f, steady.probabilities[i]);
+        fprintf(f, "\n");
+    }
+
+    fclose(f);
+
+    INFO("Finished writing stationary distribution to %s.", filename);
+}
+
+/**
+ * Write the result of a symbolic analysis <analysis>: one line per label with its probability
+ */
+void
+writeAnalysis(sigref_context *ctx, const char *filename, const AnalysisResult& analysis)
+{
+    INFO("");
+    INFO("Starting writing analysis to %s...", filename);
+
+    FILE *f = fopen(filename, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot open file '%s'!\n", filename);
+        return;
+    }
+
+    write_stable_note(ctx, f);
+
+    if (analysis.mode == analysis_steady) {
+        fprintf(f, "; steady state (power iteration, %zu steps%s)\n", analysis.iterations,
+                analysis.converged ? "" : ", not converged");
+    } else {
+        fprintf(f, "; transient probabilities at time %g (uniformization, %zu steps%s)\n", analysis.time,
+                analysis.iterations, analysis.converged ? "" : ", not converged");
+    }
+    fprintf(f, "; each label: \"<label>\" <probability>\n");
+    for (size_t i=0; i<analysis.labels.size(); i++) {
+        fprintf(f, "\"%s\" ", analysis.labels[i].c_str());
+        fprint_rate(f, analysis.probabilities[i]);
+        fprintf(f, "\n");
+    }
+
+    fclose(f);
+
+    INFO("Finished writing analysis to %s.", filename);
+}
+
+/**
+ * Write a (possibly unstable) partition: the number of blocks, the number of block variables,
+ * and the partition on (s',b) in Sylvan binary format
+ */
+void
+writePartition(sigref_context *ctx, const char *filename, BDD partition)
+{
+    INFO("");
+    INFO("Starting writing partition to %s...", filename);
+
+    FILE *f = fopen(filename, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot open file '%s'!\n", filename);
+        return;
+    }
+
+    uint64_t n_blocks = count_blocks(ctx);
+    fwrite(&n_blocks, sizeof(uint64_t), 1, f);
+    fwrite(&ctx->block_length, sizeof(int), 1, f);
+
+    LACE_ME;
+    mtbdd_writer_tobinary(f, &partition, 1);
+
+    fclose(f);
+
+    INFO("Finished writing partition to %s.", filename);
 }
 
 }
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <context.h>
+#include <steady_state.hpp>
+#include <symbolic_analysis.hpp>
 #include <systems.hpp>
 
 #ifndef SIGREF_WRITER_H
@@ -23,16 +26,30 @@ using namespace sylvan;
 
 namespace sigref {
 
-void writeSignatures(const char *filename, CTMC& ctmc);
-void writeSignatures(const char *filename, LTS& lts);
+/*
+ * The writers use the block encoding of <ctx> (the last partition computed with it), and mark
+ * the explicit output of a partition that is not stable. The symbolic (.bdd) and PRISM formats
+ * cannot be marked, so these writers refuse a partition that is not stable; they return false
+ * if nothing was written.
+ */
+
+void writeSignatures(sigref_context *ctx, const char *filename, CTMC& ctmc);
+void writeSignatures(sigref_context *ctx, const char *filename, LTS& lts);
+
+void writeExplicitOutput(sigref_context *ctx, const char* filename, CTMC &ctmc);
+void writeExplicitOutput(sigref_context *ctx, const char* filename, LTS &lts);
+void writeExplicitOutput(sigref_context *ctx, const char* filename, IMC &imc);
+
+bool writeSymbolicOutput(sigref_context *ctx, const char *filename, CTMC& ctmc);
+bool writeSymbolicOutput(sigref_context *ctx, const char *filename, LTS& ctmc);
+bool writeSymbolicOutput(sigref_context *ctx, const char *filename, IMC& imc);
+
+bool writePrismOutput(sigref_context *ctx, const char *filename, CTMC& ctmc);
 
-void writeExplicitOutput(const char* filename, CTMC &ctmc);
-void writeExplicitOutput(const char* filename, LTS &lts);
-void writeExplicitOutput(const char* filename, IMC &imc);
+void writeSteadyState(sigref_context *ctx, const char *filename, const SteadyState& steady);
+void writeAnalysis(sigref_context *ctx, const char *filename, const AnalysisResult& analysis);
 
-void writeSymbolicOutput(const char *filename, CTMC& ctmc);
-void writeSymbolicOutput(const char *filename, LTS& ctmc);
-void writeSymbolicOutput(const char *filename, IMC& imc);
+void writePartition(sigref_context *ctx, const char *filename, BDD partition);
 
 }
 
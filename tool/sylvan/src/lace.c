@@ -15,12 +15,14 @@
  */
 
 #include <errno.h> // for errno
+#include <inttypes.h> // for PRIu64
 #include <sched.h> // for sched_getaffinity
 #include <stdio.h>  // for fprintf
 #include <stdlib.h> // for memalign, malloc
 #include <string.h> // for memset
 #include <sys/mman.h> // for mprotect
 #include <sys/time.h> // for gettimeofday
+#include <time.h> // for clock_gettime
 #include <pthread.h>
 #include <unistd.h>
 #include <assert.h>
@@ -56,6 +58,33 @@ static WorkerP **workers_p;
 // set to 0 when quitting
 static int lace_quits = 0;
 
+/**
+ * Tracing (see lace_trace_start)
+ */
+#define LACE_TRACE_DEPTH 32
+
+typedef struct
+{
+    uint64_t start, end;
+    const char *name;
+    uint64_t attempts;
+} lace_trace_span_t;
+
+typedef struct
+{
+    lace_trace_span_t *spans;
+    size_t count;
+    size_t dropped;
+    int depth; // open spans of the application
+    uint64_t open_start[LACE_TRACE_DEPTH];
+    const char *open_name[LACE_TRACE_DEPTH];
+} __attribute__((aligned(LINE_SIZE))) lace_trace_t;
+
+int lace_tracing = 0;
+static lace_trace_t *traces = NULL; // one for each worker
+static size_t trace_capacity = 0;
+static uint64_t trace_t0;
+
 // for storing private Worker data
 #ifdef __linux__ // use gcc thread-local storage (i.e. __thread variables)
 static __thread WorkerP *current_worker;
@@ -66,6 +95,7 @@ static pthread_attr_t worker_attr;
 
 static pthread_cond_t wait_until_done = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t wait_until_done_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int main_done = 0; // set when the main task of lace_startup returns, under wait_until_done_mutex
 
 struct lace_worker_init
 {
@@ -289,6 +319,7 @@ lace_init_worker(int worker, size_t dq_size)
         w->stack_trigger = 0;
     }
     w->rng = (((uint64_t)rand())<<32 | rand());
+    w->trace_task = 0;
 
 #if LACE_COUNT_EVENTS
     // Reset counters
@@ -460,6 +491,133 @@ rng(uint32_t *seed, int max)
     return next % max;
 }
 
+uint64_t
+lace_trace_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Helper: store a span in the buffer of worker <w>
+ */
+static void
+trace_store(WorkerP *w, const char *name, uint64_t start, uint64_t end, uint64_t attempts)
+{
+    lace_trace_t *tr = &traces[w->worker];
+    if (tr->count == trace_capacity) {
+        tr->dropped++;
+        return;
+    }
+    lace_trace_span_t *s = &tr->spans[tr->count];
+    s->start = start;
+    s->end = end;
+    s->name = name;
+    s->attempts = attempts;
+    tr->count++;
+}
+
+void
+lace_trace_record(WorkerP *w, const char *name, uint64_t start, uint64_t end, uint64_t attempts)
+{
+    if (!lace_tracing || traces == NULL || end - start < LACE_TRACE_MIN_SPAN) return;
+    trace_store(w, name, start, end, attempts);
+}
+
+/**
+ * Helper for lace_steal_loop: record the idle span since *idle_start, ending at <end>
+ */
+static void
+trace_idle(WorkerP *w, uint64_t *idle_start, uint64_t *attempts, uint64_t end)
+{
+    if (*idle_start != 0 && end > *idle_start) lace_trace_record(w, "idle", *idle_start, end, *attempts);
+    *idle_start = 0;
+    *attempts = 0;
+}
+
+int
+lace_trace_start(size_t capacity)
+{
+    if (traces == NULL) {
+        if (posix_memalign((void**)&traces, LINE_SIZE, n_workers * sizeof(lace_trace_t)) != 0) {
+            traces = NULL;
+            return 0;
+        }
+        memset(traces, 0, n_workers * sizeof(lace_trace_t));
+        for (int i=0; i<n_workers; i++) {
+            // pages are only used when spans are recorded
+            void *spans = mmap(0, capacity * sizeof(lace_trace_span_t), PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+            if (spans == MAP_FAILED) {
+                for (int j=0; j<i; j++) munmap(traces[j].spans, capacity * sizeof(lace_trace_span_t));
+                free(traces);
+                traces = NULL;
+                return 0;
+            }
+            traces[i].spans = (lace_trace_span_t*)spans;
+        }
+        trace_capacity = capacity;
+    } else {
+        for (int i=0; i<n_workers; i++) traces[i].count = traces[i].dropped = traces[i].depth = 0;
+    }
+    trace_t0 = lace_trace_now();
+    compiler_barrier();
+    lace_tracing = 1;
+    return 1;
+}
+
+void
+lace_trace_stop(FILE *file)
+{
+    lace_tracing = 0;
+    if (traces == NULL) return;
+    compiler_barrier();
+
+    size_t dropped = 0;
+    fprintf(file, "{\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Lace\"}}");
+    for (int i=0; i<n_workers; i++) {
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}", i, i);
+        lace_trace_t *tr = &traces[i];
+        for (size_t k=0; k<tr->count; k++) {
+            lace_trace_span_t *s = &tr->spans[k];
+            if (s->start < trace_t0) continue;
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                    s->name, i, (s->start-trace_t0)/1000.0, (s->end-s->start)/1000.0);
+            if (s->attempts != 0) fprintf(file, ",\"args\":{\"steal_attempts\":%"PRIu64"}", s->attempts);
+            fputc('}', file);
+        }
+        dropped += tr->dropped;
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_spans\":%zu}}\n", dropped);
+}
+
+void
+lace_trace_begin(const char *name)
+{
+    WorkerP *w = lace_get_worker();
+    if (!lace_tracing || traces == NULL || w == NULL) return;
+    lace_trace_t *tr = &traces[w->worker];
+    if (tr->depth < LACE_TRACE_DEPTH) {
+        tr->open_start[tr->depth] = lace_trace_now();
+        tr->open_name[tr->depth] = name;
+    }
+    tr->depth++;
+}
+
+void
+lace_trace_end()
+{
+    WorkerP *w = lace_get_worker();
+    if (traces == NULL || w == NULL) return;
+    lace_trace_t *tr = &traces[w->worker];
+    if (tr->depth == 0) return;
+    tr->depth--;
+    if (lace_tracing && tr->depth < LACE_TRACE_DEPTH) {
+        trace_store(w, tr->open_name[tr->depth], tr->open_start[tr->depth], lace_trace_now(), 0);
+    }
+}
+
 VOID_TASK_IMPL_0(lace_steal_random)
 {
     Worker *victim = workers[(__lace_worker->worker + 1 + rng(&__lace_worker->seed, n_workers-1)) % n_workers];
@@ -504,7 +662,11 @@ lace_main_wrapper(void *arg)
     lace_time_event(self, 1);
     main_cb(self, self->dq, arg);
     lace_exit();
+
+    pthread_mutex_lock(&wait_until_done_mutex);
+    main_done = 1;
     pthread_cond_broadcast(&wait_until_done);
+    pthread_mutex_unlock(&wait_until_done_mutex);
 
     return NULL;
 }
@@ -526,7 +688,12 @@ VOID_TASK_IMPL_1(lace_steal_loop, int*, quit)
     unsigned int n = n_workers;
     int i=0;
 
+    // start and number of steal attempts of the current idle span (if tracing)
+    uint64_t idle_start = 0, attempts = 0;
+
     while(*(volatile int*)quit == 0) {
+        if (unlikely(lace_tracing) && idle_start == 0) idle_start = lace_trace_now();
+
         // Select victim
         if( i>0 ) {
             i--;
@@ -540,13 +707,18 @@ VOID_TASK_IMPL_1(lace_steal_loop, int*, quit)
         }
 
         PR_COUNTSTEALS(__lace_worker, CTR_steal_tries);
+        attempts++;
         Worker *res = lace_steal(__lace_worker, __lace_dq_head, *victim);
         if (res == LACE_STOLEN) {
             PR_COUNTSTEALS(__lace_worker, CTR_steals);
+            trace_idle(__lace_worker, &idle_start, &attempts, __lace_worker->trace_task);
         } else if (res == LACE_BUSY) {
             PR_COUNTSTEALS(__lace_worker, CTR_steal_busy);
         }
 
+        if (unlikely(idle_start != 0 && *(Task* volatile *)&lace_newframe.t != NULL)) {
+            trace_idle(__lace_worker, &idle_start, &attempts, lace_trace_now());
+        }
         YIELD_NEWFRAME();
 
         if (must_suspend) {
@@ -556,6 +728,8 @@ VOID_TASK_IMPL_1(lace_steal_loop, int*, quit)
             } while (__lace_worker->enabled == 0);
         }
     }
+
+    trace_idle(__lace_worker, &idle_start, &attempts, lace_trace_now());
 }
 
 static void*
@@ -739,11 +913,12 @@ lace_startup(size_t stacksize, lace_startup_cb cb, void *arg)
 
     if (cb != 0) {
         main_cb = cb;
+        main_done = 0;
         lace_spawn_worker(0, stacksize, lace_main_wrapper, arg);
 
-        // Suspend this thread until cb returns
+        // Suspend this thread until cb returns (it may have returned already)
         pthread_mutex_lock(&wait_until_done_mutex);
-        pthread_cond_wait(&wait_until_done, &wait_until_done_mutex);
+        while (!main_done) pthread_cond_wait(&wait_until_done, &wait_until_done_mutex);
         pthread_mutex_unlock(&wait_until_done_mutex);
     } else {
         // use this thread as worker and return control
@@ -897,6 +1072,14 @@ void lace_exit()
     lace_barrier_destroy();
     pthread_barrier_destroy(&suspend_barrier);
 
+    // free the buffers of lace_trace
+    lace_tracing = 0;
+    if (traces != NULL) {
+        for (int i=0; i<n_workers; i++) munmap(traces[i].spans, trace_capacity * sizeof(lace_trace_span_t));
+        free(traces);
+        traces = NULL;
+    }
+
 #if LACE_COUNT_EVENTS
     lace_count_report_file(stderr);
 #endif
@@ -928,6 +1111,8 @@ lace_exec_in_new_frame(WorkerP *__lace_worker, Task *__lace_dq_head, Task *root)
         __lace_worker->allstolen = 1;
     }
 
+    uint64_t trace_start = unlikely(lace_tracing) ? lace_trace_now() : 0;
+
     // wait until all workers are ready
     lace_barrier();
 
@@ -938,6 +1123,12 @@ lace_exec_in_new_frame(WorkerP *__lace_worker, Task *__lace_dq_head, Task *root)
     // wait until all workers are back (else they may steal from previous frame)
     lace_barrier();
 
+    if (unlikely(trace_start != 0)) {
+        // new frames run lace_steal_loop_root and lace_steal_loop, see lace_do_newframe
+        int newframe = root->f == (__typeof__(root->f))lace_steal_loop_WRAP || root->f == (__typeof__(root->f))lace_steal_loop_root_WRAP;
+        lace_trace_record(__lace_worker, newframe ? "newframe" : "together", trace_start, lace_trace_now(), 0);
+    }
+
     // restore tail, split, allstolen
     {
         Worker *wt = __lace_worker->_public;
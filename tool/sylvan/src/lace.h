@@ -56,6 +56,10 @@ extern "C" {
 #define LACE_COUNT_EVENTS (LACE_PIE_TIMES || LACE_COUNT_TASKS || LACE_COUNT_STEALS || LACE_COUNT_SPLITS)
 #endif
 
+#ifndef LACE_TRACE_MIN_SPAN /* Shortest span of Lace itself recorded by lace_trace (in ns) */
+#define LACE_TRACE_MIN_SPAN 1000
+#endif
+
 /* Typical cacheline size of system architectures */
 #ifndef LINE_SIZE
 #define LINE_SIZE 64
@@ -217,6 +221,7 @@ typedef struct _WorkerP {
     int16_t worker;             // what is my worker id?
     uint8_t allstolen;          // my allstolen
     volatile int8_t enabled;    // if this worker is enabled
+    uint64_t trace_task;        // start of the last stolen task (if tracing)
 
 #if LACE_COUNT_EVENTS
     uint64_t ctr[CTR_MAX];      // counters
@@ -326,6 +331,33 @@ Task *lace_get_head(WorkerP *);
  */
 void lace_exit();
 
+/**
+ * Runtime tracing of the workers, written as Chrome trace-event JSON (chrome://tracing, Perfetto).
+ * Every worker records spans for stolen tasks ("task"), for searching work in the steal loop
+ * ("idle", with the number of steal attempts), for leapfrogging while a stolen task is not done
+ * ("leap", with the number of steal attempts), for new frames ("newframe", "together"),
+ * and spans of the application (lace_trace_begin, lace_trace_end).
+ * Spans of Lace shorter than LACE_TRACE_MIN_SPAN are not recorded.
+ *
+ * lace_trace_start starts tracing with room for <capacity> spans per worker (further spans are
+ * dropped); returns 0 if the memory cannot be allocated.
+ * lace_trace_stop stops tracing and writes all spans to <file>; call it when no tasks are running.
+ */
+int lace_trace_start(size_t capacity);
+void lace_trace_stop(FILE *file);
+
+/**
+ * Begin and end a span of the application on the current worker. Spans can be nested.
+ * The name is not copied, so it must be a string constant (without quotes or backslashes).
+ */
+void lace_trace_begin(const char *name);
+void lace_trace_end();
+
+/* Internal tracing functions (used by lace_steal and lace_leapfrog) */
+extern int lace_tracing;
+uint64_t lace_trace_now();
+void lace_trace_record(WorkerP *w, const char *name, uint64_t start, uint64_t end, uint64_t attempts);
+
 #define LACE_STOLEN   ((Worker*)0)
 #define LACE_BUSY     ((Worker*)1)
 #define LACE_NOWORK   ((Worker*)2)
@@ -500,7 +532,10 @@ lace_steal(WorkerP *self, Task *__dq_head, Worker *victim)
                 Task *t = &victim->dq[ts.ts.tail];
                 t->thief = self->_public;
                 lace_time_event(self, 1);
+                uint64_t trace_start = unlikely(lace_tracing) ? lace_trace_now() : 0;
                 t->f(self, __dq_head, t);
+                if (unlikely(trace_start != 0)) lace_trace_record(self, "task", trace_start, lace_trace_now(), 0);
+                self->trace_task = trace_start;
                 lace_time_event(self, 2);
                 t->thief = THIEF_COMPLETED;
                 lace_time_event(self, 8);
@@ -563,10 +598,14 @@ lace_leapfrog(WorkerP *__lace_worker, Task *__lace_dq_head)
         /* PRE-LEAP: increase head again */
         __lace_dq_head += 1;
 
+        uint64_t trace_start = unlikely(lace_tracing) ? lace_trace_now() : 0;
+        uint64_t trace_attempts = 0;
+
         /* Now leapfrog */
         int attempts = 32;
         while (thief != THIEF_COMPLETED) {
             PR_COUNTSTEALS(__lace_worker, CTR_leap_tries);
+            trace_attempts++;
             Worker *res = lace_steal(__lace_worker, __lace_dq_head, thief);
             if (res == LACE_NOWORK) {
                 YIELD_NEWFRAME();
@@ -580,6 +619,8 @@ lace_leapfrog(WorkerP *__lace_worker, Task *__lace_dq_head)
             thief = t->thief;
         }
 
+        if (unlikely(trace_start != 0)) lace_trace_record(__lace_worker, "leap", trace_start, lace_trace_now(), trace_attempts);
+
         /* POST-LEAP: really pop the finished task */
         /*            no need to decrease __lace_dq_head, since it is a local variable */
         compiler_barrier();
@@ -25,19 +25,11 @@
 #include <sys/mman.h> // for mmap
 
 #include <llmsset.h>
+#include <sylvan_numa.h>
+#include <sylvan_pages.h>
 #include <sylvan_stats.h>
 #include <tls.h>
 
-#ifndef USE_HWLOC
-#define USE_HWLOC 0
-#endif
-
-#if USE_HWLOC
-#include <hwloc.h>
-
-static hwloc_topology_t topo;
-#endif
-
 #ifndef MAP_ANONYMOUS
 #define MAP_ANONYMOUS MAP_ANON
 #endif
@@ -70,6 +62,7 @@ claim_data_bucket(const llmsset_t dbs)
                 if (v != 0xffffffffffffffffLL) {
                     int j = __builtin_clzll(~v);
                     *ptr |= (0x8000000000000000LL>>j);
+                    if (dbs->scratch) dbs->bitmaps[8 * my_region + i] |= (0x8000000000000000LL>>j);
                     return (8 * my_region + i) * 64 + j;
                 }
                 i++;
@@ -97,6 +90,7 @@ restart:
             if (cas(ptr, v, v|mask)) break;
             else goto restart;
         }
+        if (dbs->scratch) __sync_fetch_and_add(&dbs->scratch_regions, 1);
         SET_THREAD_LOCAL(my_region, my_region);
     }
 }
@@ -300,11 +294,6 @@ llmsset_rehash_bucket(const llmsset_t dbs, uint64_t d_idx)
 llmsset_t
 llmsset_create(size_t initial_size, size_t max_size)
 {
-#if USE_HWLOC
-    hwloc_topology_init(&topo);
-    hwloc_topology_load(topo);
-#endif
-
     llmsset_t dbs = NULL;
     if (posix_memalign((void**)&dbs, LINE_SIZE, sizeof(struct llmsset)) != 0) {
         fprintf(stderr, "llmsset_create: Unable to allocate memory!\n");
@@ -342,19 +331,23 @@ llmsset_create(size_t initial_size, size_t max_size)
     /* This implementation of "resizable hash table" allocates the max_size table in virtual memory,
        but only uses the "actual size" part in real memory */
 
-    dbs->table = (uint64_t*)mmap(0, dbs->max_size * 8, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    dbs->data = (uint8_t*)mmap(0, dbs->max_size * 16, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    dbs->table = (uint64_t*)pages_map(dbs->max_size * 8, 1);
+    dbs->data = (uint8_t*)pages_map(dbs->max_size * 16, 0);
 
     /* Also allocate bitmaps. Each region is 64*8 = 512 buckets.
        Overhead of bitmap1: 1 bit per 4096 bucket.
        Overhead of bitmap2: 1 bit per bucket.
-       Overhead of bitmapc: 1 bit per bucket. */
+       Overhead of bitmapc: 1 bit per bucket.
+       Overhead of bitmapp: 1 bit per bucket.
+       Overhead of bitmaps: 1 bit per bucket. */
 
-    dbs->bitmap1 = (uint64_t*)mmap(0, dbs->max_size / (512*8), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    dbs->bitmap2 = (uint64_t*)mmap(0, dbs->max_size / 8, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    dbs->bitmapc = (uint64_t*)mmap(0, dbs->max_size / 8, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    dbs->bitmap1 = (uint64_t*)pages_map(dbs->max_size / (512*8), 1);
+    dbs->bitmap2 = (uint64_t*)pages_map(dbs->max_size / 8, 0);
+    dbs->bitmapc = (uint64_t*)pages_map(dbs->max_size / 8, 0);
+    dbs->bitmapp = (uint64_t*)pages_map(dbs->max_size / 8, 0);
+    dbs->bitmaps = (uint64_t*)pages_map(dbs->max_size / 8, 0);
 
-    if (dbs->table == (uint64_t*)-1 || dbs->data == (uint8_t*)-1 || dbs->bitmap1 == (uint64_t*)-1 || dbs->bitmap2 == (uint64_t*)-1 || dbs->bitmapc == (uint64_t*)-1) {
+    if (dbs->table == NULL || dbs->data == NULL || dbs->bitmap1 == NULL || dbs->bitmap2 == NULL || dbs->bitmapc == NULL || dbs->bitmapp == NULL || dbs->bitmaps == NULL) {
         fprintf(stderr, "llmsset_create: Unable to allocate memory: %s!\n", strerror(errno));
         exit(1);
     }
@@ -363,17 +356,17 @@ llmsset_create(size_t initial_size, size_t max_size)
     madvise(dbs->table, dbs->max_size * 8, MADV_RANDOM);
 #endif
 
-#if USE_HWLOC
-    hwloc_set_area_membind(topo, dbs->table, dbs->max_size * 8, hwloc_topology_get_allowed_cpuset(topo), HWLOC_MEMBIND_INTERLEAVE, 0);
-    hwloc_set_area_membind(topo, dbs->data, dbs->max_size * 16, hwloc_topology_get_allowed_cpuset(topo), HWLOC_MEMBIND_FIRSTTOUCH, 0);
-    hwloc_set_area_membind(topo, dbs->bitmap1, dbs->max_size / (512*8), hwloc_topology_get_allowed_cpuset(topo), HWLOC_MEMBIND_INTERLEAVE, 0);
-    hwloc_set_area_membind(topo, dbs->bitmap2, dbs->max_size / 8, hwloc_topology_get_allowed_cpuset(topo), HWLOC_MEMBIND_FIRSTTOUCH, 0);
-    hwloc_set_area_membind(topo, dbs->bitmapc, dbs->max_size / 8, hwloc_topology_get_allowed_cpuset(topo), HWLOC_MEMBIND_FIRSTTOUCH, 0);
-#endif
+    numa_touch_area(dbs->table, dbs->table_size * 8);
+    numa_touch_area(dbs->bitmap2, dbs->table_size / 8);
 
     // forbid first two positions (index 0 and 1)
     dbs->bitmap2[0] = 0xc000000000000000LL;
 
+    dbs->bitmapf = NULL;
+    dbs->pinned = 0;
+    dbs->scratch = 0;
+    dbs->scratch_regions = 0;
+
     dbs->hash_cb = NULL;
     dbs->equals_cb = NULL;
     dbs->create_cb = NULL;
@@ -393,11 +386,13 @@ llmsset_create(size_t initial_size, size_t max_size)
 void
 llmsset_free(llmsset_t dbs)
 {
-    munmap(dbs->table, dbs->max_size * 8);
-    munmap(dbs->data, dbs->max_size * 16);
-    munmap(dbs->bitmap1, dbs->max_size / (512*8));
-    munmap(dbs->bitmap2, dbs->max_size / 8);
-    munmap(dbs->bitmapc, dbs->max_size / 8);
+    pages_unmap(dbs->table, dbs->max_size * 8);
+    pages_unmap(dbs->data, dbs->max_size * 16);
+    pages_unmap(dbs->bitmap1, dbs->max_size / (512*8));
+    pages_unmap(dbs->bitmap2, dbs->max_size / 8);
+    pages_unmap(dbs->bitmapc, dbs->max_size / 8);
+    pages_unmap(dbs->bitmapp, dbs->max_size / 8);
+    pages_unmap(dbs->bitmaps, dbs->max_size / 8);
     free(dbs);
 }
 
@@ -407,44 +402,47 @@ VOID_TASK_IMPL_1(llmsset_clear, llmsset_t, dbs)
     CALL(llmsset_clear_hashes, dbs);
 }
 
+/**
+ * Helper: release all claimed regions
+ */
+static void
+clear_regions(const llmsset_t dbs)
+{
+    pages_clear(dbs->bitmap1, dbs->max_size / (512*8), 1);
+}
+
+/**
+ * Helper: unmark all buckets
+ */
+static void
+clear_marks(const llmsset_t dbs)
+{
+    pages_clear(dbs->bitmap2, dbs->max_size / 8, 0);
+    numa_touch_area(dbs->bitmap2, dbs->table_size / 8);
+}
+
 VOID_TASK_IMPL_1(llmsset_clear_data, llmsset_t, dbs)
 {
-    if (mmap(dbs->bitmap1, dbs->max_size / (512*8), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != (void*)-1) {
-#if USE_HWLOC
-        hwloc_set_area_membind(topo, dbs->bitmap1, dbs->max_size / (512*8), hwloc_topology_get_allowed_cpuset(topo), HWLOC_MEMBIND_INTERLEAVE, 0);
-#endif
-    } else {
-        memset(dbs->bitmap1, 0, dbs->max_size / (512*8));
-    }
+    clear_regions(dbs);
+    clear_marks(dbs);
 
-    if (mmap(dbs->bitmap2, dbs->max_size / 8, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != (void*)-1) {
-#if USE_HWLOC
-        hwloc_set_area_membind(topo, dbs->bitmap2, dbs->max_size / 8, hwloc_topology_get_allowed_cpuset(topo), HWLOC_MEMBIND_FIRSTTOUCH, 0);
-#endif
-    } else {
-        memset(dbs->bitmap2, 0, dbs->max_size / 8);
-    }
+    // pinned buckets stay marked (buckets are only pinned below the current table size)
+    if (dbs->pinned) memcpy(dbs->bitmap2, dbs->bitmapp, dbs->table_size / 8);
 
     // forbid first two positions (index 0 and 1)
-    dbs->bitmap2[0] = 0xc000000000000000LL;
+    dbs->bitmap2[0] |= 0xc000000000000000LL;
 
     TOGETHER(llmsset_reset_region);
 }
 
 VOID_TASK_IMPL_1(llmsset_clear_hashes, llmsset_t, dbs)
 {
-    // just reallocate...
-    if (mmap(dbs->table, dbs->max_size * 8, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != (void*)-1) {
+    // just reallocate... (or the expensive fallback, memset)
+    pages_clear(dbs->table, dbs->max_size * 8, 1);
 #if defined(madvise) && defined(MADV_RANDOM)
-        madvise(dbs->table, sizeof(uint64_t[dbs->max_size]), MADV_RANDOM);
-#endif
-#if USE_HWLOC
-        hwloc_set_area_membind(topo, dbs->table, sizeof(uint64_t[dbs->max_size]), hwloc_topology_get_allowed_cpuset(topo), HWLOC_MEMBIND_INTERLEAVE, 0);
+    madvise(dbs->table, sizeof(uint64_t[dbs->max_size]), MADV_RANDOM);
 #endif
-    } else {
-        // reallocate failed... expensive fallback
-        memset(dbs->table, 0, dbs->max_size * 8);
-    }
+    numa_touch_area(dbs->table, dbs->table_size * 8);
 }
 
 int
@@ -467,6 +465,274 @@ llmsset_mark(const llmsset_t dbs, uint64_t index)
     }
 }
 
+int
+llmsset_pin(const llmsset_t dbs, uint64_t index)
+{
+    volatile uint64_t *ptr = dbs->bitmapp + (index/64);
+    uint64_t mask = 0x8000000000000000LL >> (index&63);
+    for (;;) {
+        uint64_t v = *ptr;
+        if (v & mask) return 0;
+        if (cas(ptr, v, v|mask)) {
+            dbs->pinned = 1;
+            return 1;
+        }
+    }
+}
+
+void
+llmsset_unpin_all(const llmsset_t dbs)
+{
+    if (!dbs->pinned) return;
+    pages_clear(dbs->bitmapp, dbs->max_size / 8, 0);
+    dbs->pinned = 0;
+}
+
+void
+llmsset_scratch_begin(const llmsset_t dbs)
+{
+    dbs->scratch = 1;
+    __sync_synchronize();
+}
+
+void
+llmsset_scratch_end(const llmsset_t dbs)
+{
+    if (!dbs->scratch) return;
+    dbs->scratch = 0;
+    __sync_synchronize();
+    pages_clear(dbs->bitmaps, dbs->max_size / 8, 0);
+    dbs->scratch_regions = 0;
+}
+
+VOID_TASK_3(llmsset_scratch_unmark_par, llmsset_t, dbs, size_t, first, size_t, count)
+{
+    if (count > 64) {
+        SPAWN(llmsset_scratch_unmark_par, dbs, first, count/2);
+        CALL(llmsset_scratch_unmark_par, dbs, first + count/2, count - count/2);
+        SYNC(llmsset_scratch_unmark_par);
+    } else {
+        for (size_t k=first; k<first+count; k++) {
+            dbs->bitmap2[k] &= ~(dbs->bitmaps[k] & ~dbs->bitmapp[k]);
+        }
+    }
+}
+
+VOID_TASK_IMPL_1(llmsset_scratch_unmark, llmsset_t, dbs)
+{
+    CALL(llmsset_scratch_unmark_par, dbs, 0, dbs->table_size / 64);
+    // forbid first two positions (index 0 and 1)
+    dbs->bitmap2[0] |= 0xc000000000000000LL;
+}
+
+VOID_TASK_3(llmsset_scratch_release_par, llmsset_t, dbs, size_t, first, size_t, count)
+{
+    if (count > 64) {
+        SPAWN(llmsset_scratch_release_par, dbs, first, count/2);
+        CALL(llmsset_scratch_release_par, dbs, first + count/2, count - count/2);
+        SYNC(llmsset_scratch_release_par);
+    } else {
+        for (size_t k=first; k<first+count; k++) {
+            // unmarked scratch buckets with custom data
+            uint64_t dead = dbs->bitmaps[k] & ~dbs->bitmap2[k] & dbs->bitmapc[k];
+            while (dead != 0) {
+                int j = __builtin_clzll(dead);
+                uint64_t mask = 0x8000000000000000LL >> j;
+                uint64_t *d_ptr = ((uint64_t*)dbs->data) + 2*(k*64+j);
+                dbs->destroy_cb(d_ptr[0], d_ptr[1]);
+                dbs->bitmapc[k] &= ~mask;
+                dead &= ~mask;
+            }
+            dbs->bitmaps[k] = 0;
+        }
+    }
+}
+
+VOID_TASK_IMPL_1(llmsset_scratch_release, llmsset_t, dbs)
+{
+    if (dbs->destroy_cb != NULL) {
+        CALL(llmsset_scratch_release_par, dbs, 0, dbs->table_size / 64);
+    } else {
+        memset(dbs->bitmaps, 0, dbs->table_size / 8);
+    }
+    dbs->scratch_regions = 0;
+
+    clear_regions(dbs);
+    TOGETHER(llmsset_reset_region);
+}
+
+VOID_TASK_IMPL_1(llmsset_compact_begin, llmsset_t, dbs)
+{
+    clear_regions(dbs);
+    clear_marks(dbs);
+
+    // forbid first two positions (index 0 and 1)
+    dbs->bitmap2[0] |= 0xc000000000000000LL;
+
+    TOGETHER(llmsset_reset_region);
+}
+
+void
+llmsset_compact_fix(const llmsset_t dbs)
+{
+    dbs->bitmapf = (uint64_t*)mmap(0, dbs->max_size / 8, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (dbs->bitmapf == (uint64_t*)-1) {
+        fprintf(stderr, "llmsset_compact: Unable to allocate memory: %s!\n", strerror(errno));
+        exit(1);
+    }
+    memcpy(dbs->bitmapf, dbs->bitmap2, dbs->table_size / 8);
+    if (dbs->pinned) {
+        for (size_t k=0; k<dbs->table_size/64; k++) dbs->bitmap2[k] |= dbs->bitmapp[k];
+    }
+}
+
+/**
+ * Helper: store the key of every bucket in words first..first+count-1 that moves in map,
+ * and return the largest key
+ */
+TASK_5(uint32_t, llmsset_compact_keys, llmsset_t, dbs, llmsset_key_cb, key_cb, uint64_t*, map, size_t, first, size_t, count)
+{
+    if (count > 64) {
+        SPAWN(llmsset_compact_keys, dbs, key_cb, map, first, count/2);
+        uint32_t right = CALL(llmsset_compact_keys, dbs, key_cb, map, first + count/2, count - count/2);
+        uint32_t left = SYNC(llmsset_compact_keys);
+        return left > right ? left : right;
+    }
+
+    uint32_t result = 0;
+    for (size_t k=first; k<first+count; k++) {
+        uint64_t moving = dbs->bitmap2[k] & ~dbs->bitmapf[k];
+        while (moving != 0) {
+            int j = __builtin_clzll(moving);
+            moving &= ~(0x8000000000000000LL >> j);
+            uint64_t *d_ptr = ((uint64_t*)dbs->data) + 2*(k*64+j);
+            uint32_t key = key_cb(d_ptr[0], d_ptr[1]);
+            map[k*64+j] = key;
+            if (key > result) result = key;
+        }
+    }
+    return result;
+}
+
+/**
+ * Helper: copy the marked buckets in words first..first+count-1 to their new index in the data
+ * array of <to> and set their bits in the bitmaps of <to>
+ */
+VOID_TASK_5(llmsset_compact_move, llmsset_t, dbs, uint64_t*, map, llmsset_t, to, size_t, first, size_t, count)
+{
+    if (count > 64) {
+        SPAWN(llmsset_compact_move, dbs, map, to, first, count/2);
+        CALL(llmsset_compact_move, dbs, map, to, first + count/2, count - count/2);
+        SYNC(llmsset_compact_move);
+        return;
+    }
+
+    for (size_t k=first; k<first+count; k++) {
+        uint64_t marked = dbs->bitmap2[k];
+        while (marked != 0) {
+            int j = __builtin_clzll(marked);
+            uint64_t mask = 0x8000000000000000LL >> j;
+            marked &= ~mask;
+            uint64_t d_idx = map[k*64+j];
+            memcpy(to->data + 16*d_idx, dbs->data + 16*(k*64+j), 16);
+            uint64_t d_mask = 0x8000000000000000LL >> (d_idx & 63);
+            __sync_fetch_and_or(to->bitmap2 + d_idx/64, d_mask);
+            if (dbs->bitmapc[k] & mask) __sync_fetch_and_or(to->bitmapc + d_idx/64, d_mask);
+            if (dbs->bitmapp[k] & mask) __sync_fetch_and_or(to->bitmapp + d_idx/64, d_mask);
+        }
+    }
+}
+
+TASK_IMPL_2(uint64_t*, llmsset_compact, llmsset_t, dbs, llmsset_key_cb, key_cb)
+{
+    CALL(llmsset_destroy_unmarked, dbs);
+
+    const size_t words = dbs->table_size / 64;
+    uint64_t *map = (uint64_t*)mmap(0, dbs->table_size * 8, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == (uint64_t*)-1) {
+        fprintf(stderr, "llmsset_compact: Unable to allocate memory: %s!\n", strerror(errno));
+        exit(1);
+    }
+
+    /* Count the moving buckets of every key, giving the first rank of every key */
+    uint32_t max_key = CALL(llmsset_compact_keys, dbs, key_cb, map, 0, words);
+    size_t *first_rank = (size_t*)calloc((size_t)max_key + 2, sizeof(size_t));
+    size_t moving = 0;
+    for (size_t k=0; k<words; k++) {
+        uint64_t bits = dbs->bitmap2[k] & ~dbs->bitmapf[k];
+        while (bits != 0) {
+            int j = __builtin_clzll(bits);
+            bits &= ~(0x8000000000000000LL >> j);
+            first_rank[map[k*64+j]+1]++;
+            moving++;
+        }
+    }
+    for (size_t key=0; key<=max_key; key++) first_rank[key+1] += first_rank[key];
+
+    /* The new index of the bucket of rank r is the r-th index that is not fixed */
+    uint64_t *slots = (uint64_t*)malloc(sizeof(uint64_t) * (moving+1));
+    size_t n_slots = 0;
+    for (size_t i=0; n_slots<moving; i++) {
+        if (!llmsset_is_fixed(dbs, i)) slots[n_slots++] = i;
+    }
+
+    /* Assign the new indices, in the order of the keys and then of the current index */
+    for (size_t k=0; k<words; k++) {
+        uint64_t marked = dbs->bitmap2[k];
+        while (marked != 0) {
+            int j = __builtin_clzll(marked);
+            uint64_t mask = 0x8000000000000000LL >> j;
+            marked &= ~mask;
+            const size_t i = k*64+j;
+            if (dbs->bitmapf[k] & mask) map[i] = i;
+            else map[i] = slots[first_rank[map[i]]++];
+        }
+    }
+    free(slots);
+    free(first_rank);
+
+    /* Move the buckets to a new data array */
+    struct llmsset to;
+    to.data = (uint8_t*)pages_map(dbs->max_size * 16, 0);
+    to.bitmap2 = (uint64_t*)pages_map(dbs->max_size / 8, 0);
+    to.bitmapc = (uint64_t*)pages_map(dbs->max_size / 8, 0);
+    to.bitmapp = (uint64_t*)pages_map(dbs->max_size / 8, 0);
+    if (to.data == NULL || to.bitmap2 == NULL || to.bitmapc == NULL || to.bitmapp == NULL) {
+        fprintf(stderr, "llmsset_compact: Unable to allocate memory: %s!\n", strerror(errno));
+        exit(1);
+    }
+    numa_touch_area(to.bitmap2, dbs->table_size / 8);
+    CALL(llmsset_compact_move, dbs, map, &to, 0, words);
+
+    pages_unmap(dbs->data, dbs->max_size * 16);
+    pages_unmap(dbs->bitmap2, dbs->max_size / 8);
+    pages_unmap(dbs->bitmapc, dbs->max_size / 8);
+    pages_unmap(dbs->bitmapp, dbs->max_size / 8);
+    dbs->data = to.data;
+    dbs->bitmap2 = to.bitmap2;
+    dbs->bitmapc = to.bitmapc;
+    dbs->bitmapp = to.bitmapp;
+
+    // moved scratch buckets are no longer recorded as scratch buckets
+    if (dbs->scratch) {
+        memset(dbs->bitmaps, 0, dbs->table_size / 8);
+        dbs->scratch_regions = 0;
+    }
+
+    clear_regions(dbs);
+    TOGETHER(llmsset_reset_region);
+
+    return map;
+}
+
+void
+llmsset_compact_end(const llmsset_t dbs, uint64_t *map)
+{
+    munmap(map, dbs->table_size * 8);
+    munmap(dbs->bitmapf, dbs->max_size / 8);
+    dbs->bitmapf = NULL;
+}
+
 TASK_3(int, llmsset_rehash_par, llmsset_t, dbs, size_t, first, size_t, count)
 {
     if (count > 512) {
@@ -536,6 +802,16 @@ TASK_IMPL_1(size_t, llmsset_count_marked, llmsset_t, dbs)
     return CALL(llmsset_count_marked_par, dbs, 0, dbs->table_size);
 }
 
+size_t
+llmsset_numa_distribution(const llmsset_t dbs, size_t *counts, int n)
+{
+    size_t table_counts[n];
+    size_t result = numa_area_distribution(dbs->data, dbs->table_size * 16, 2048, counts, n);
+    result += numa_area_distribution(dbs->table, dbs->table_size * 8, 2048, table_counts, n);
+    for (int i=0; i<n; i++) counts[i] += table_counts[i];
+    return result;
+}
+
 VOID_TASK_3(llmsset_destroy_par, llmsset_t, dbs, size_t, first, size_t, count)
 {
     if (count > 1024) {
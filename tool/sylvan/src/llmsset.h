@@ -57,6 +57,7 @@ typedef uint64_t (*llmsset_hash_cb)(uint64_t, uint64_t, uint64_t);
 typedef int (*llmsset_equals_cb)(uint64_t, uint64_t, uint64_t, uint64_t);
 typedef void (*llmsset_create_cb)(uint64_t *, uint64_t *);
 typedef void (*llmsset_destroy_cb)(uint64_t, uint64_t);
+typedef uint32_t (*llmsset_key_cb)(uint64_t, uint64_t);
 
 typedef struct llmsset
 {
@@ -65,6 +66,12 @@ typedef struct llmsset
     uint64_t          *bitmap1;     // ownership bitmap (per 512 buckets)
     uint64_t          *bitmap2;     // bitmap for "contains data"
     uint64_t          *bitmapc;     // bitmap for "use custom functions"
+    uint64_t          *bitmapp;     // bitmap for "pinned" (kept by garbage collection)
+    uint64_t          *bitmaps;     // bitmap for "scratch" (claimed in scratch mode)
+    uint64_t          *bitmapf;     // bitmap for "fixed" (not moved by compaction), only during compaction
+    int               pinned;       // nonzero if some buckets are pinned
+    volatile int      scratch;      // nonzero in scratch mode
+    size_t            scratch_regions; // number of regions claimed in scratch mode
     size_t            max_size;     // maximum size of the hash table (for resizing)
     size_t            table_size;   // size of the hash table (number of slots) --> power of 2!
 #if LLMSSET_MASK
@@ -190,12 +197,106 @@ TASK_DECL_1(int, llmsset_rehash, llmsset_t);
  */
 int llmsset_rehash_bucket(const llmsset_t dbs, uint64_t d_idx);
 
+/**
+ * Pin the bucket <index>: clearing the data (garbage collection) keeps it as marked, so the bucket
+ * is never freed and marking stops at it. Returns 1 if the bucket was not pinned before.
+ */
+int llmsset_pin(const llmsset_t dbs, uint64_t index);
+
+/**
+ * Unpin all buckets; they are kept by the next garbage collection only if they are marked.
+ */
+void llmsset_unpin_all(const llmsset_t dbs);
+
+/**
+ * Scratch mode: the buckets that are claimed in scratch mode are recorded, so they can be freed
+ * together with llmsset_scratch_unmark and llmsset_scratch_release, without clearing the other
+ * buckets. Buckets that exist before llmsset_scratch_begin may not refer to scratch buckets,
+ * which holds as long as all buckets created in scratch mode are scratch buckets.
+ * llmsset_scratch_end leaves scratch mode; the scratch buckets become normal buckets.
+ */
+void llmsset_scratch_begin(const llmsset_t dbs);
+void llmsset_scratch_end(const llmsset_t dbs);
+
+/**
+ * The number of buckets in the regions claimed since scratch mode began or since the last
+ * llmsset_scratch_release (an upper bound of the number of scratch buckets).
+ */
+static inline size_t
+llmsset_scratch_size(const llmsset_t dbs)
+{
+    return dbs->scratch_regions * 512;
+}
+
+/**
+ * Unmark all scratch buckets that are not pinned. Marking (llmsset_mark) then only visits
+ * scratch buckets, as all other buckets are still marked.
+ */
+VOID_TASK_DECL_1(llmsset_scratch_unmark, llmsset_t);
+#define llmsset_scratch_unmark(dbs) CALL(llmsset_scratch_unmark, dbs)
+
+/**
+ * After marking: nonzero if <index> is a scratch bucket that llmsset_scratch_release frees
+ */
+static inline int
+llmsset_scratch_isdead(const llmsset_t dbs, uint64_t index)
+{
+    if (index >= dbs->table_size) return 0;
+    const uint64_t mask = 0x8000000000000000LL >> (index & 63);
+    return (dbs->bitmaps[index/64] & ~dbs->bitmap2[index/64] & mask) ? 1 : 0;
+}
+
+/**
+ * After marking: free the unmarked scratch buckets (calling the destroy callback for custom
+ * buckets), make the marked scratch buckets normal buckets and reset the claimed regions.
+ * The hashes must be cleared and rehashed afterwards.
+ */
+VOID_TASK_DECL_1(llmsset_scratch_release, llmsset_t);
+#define llmsset_scratch_release(dbs) CALL(llmsset_scratch_release, dbs)
+
+/**
+ * Compaction moves the marked buckets to the start of the table, in the order of a key of their
+ * data, so buckets with the same key are stored together. It is a garbage collection in steps:
+ * - llmsset_compact_begin unmarks all buckets, also the pinned buckets;
+ * - after marking the buckets that must keep their index, llmsset_compact_fix records them as
+ *   fixed and marks the pinned buckets;
+ * - after marking the other buckets that are kept, llmsset_compact frees the unmarked buckets
+ *   with custom data and moves the marked buckets that are not fixed, in the order of
+ *   key_cb(a, b) and then of their index, around the fixed buckets. The data array is replaced.
+ *   It returns the new index map[i] of every marked bucket i (map[i] = i if i is fixed).
+ *   In scratch mode, all kept buckets are no longer scratch buckets afterwards;
+ * - the caller updates the indices stored in the buckets and elsewhere, then calls
+ *   llmsset_compact_end and clears and rehashes the hashes.
+ */
+VOID_TASK_DECL_1(llmsset_compact_begin, llmsset_t);
+#define llmsset_compact_begin(dbs) CALL(llmsset_compact_begin, dbs)
+void llmsset_compact_fix(const llmsset_t dbs);
+TASK_DECL_2(uint64_t*, llmsset_compact, llmsset_t, llmsset_key_cb);
+#define llmsset_compact(dbs, key_cb) CALL(llmsset_compact, dbs, key_cb)
+void llmsset_compact_end(const llmsset_t dbs, uint64_t *map);
+
+/**
+ * During compaction: nonzero if bucket <index> keeps its index
+ */
+static inline int
+llmsset_is_fixed(const llmsset_t dbs, uint64_t index)
+{
+    return (dbs->bitmapf[index/64] & (0x8000000000000000LL >> (index & 63))) ? 1 : 0;
+}
+
 /**
  * Retrieve number of marked buckets.
  */
 TASK_DECL_1(size_t, llmsset_count_marked, llmsset_t);
 #define llmsset_count_marked(dbs) CALL(llmsset_count_marked, dbs)
 
+/**
+ * Count the sampled resident pages of the used part of the data array and the hash array on every
+ * NUMA domain (counts[i] for domain i < n), see numa_area_distribution.
+ * Returns the number of sampled resident pages.
+ */
+size_t llmsset_numa_distribution(const llmsset_t dbs, size_t *counts, int n);
+
 /**
  * During garbage collection, this method calls the destroy callback
  * for all 'custom' data that is not kept.
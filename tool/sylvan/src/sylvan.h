@@ -34,6 +34,8 @@
 #include <tls.h>
 
 #include <sylvan_common.h>
+#include <sylvan_numa.h>
+#include <sylvan_pages.h>
 #include <sylvan_stats.h>
 #include <sylvan_mtbdd.h>
 #include <sylvan_bdd.h>
@@ -20,13 +20,11 @@
 #include <stdint.h> // for uint32_t etc
 #include <stdlib.h> // for exit
 #include <string.h> // for strerror
-#include <sys/mman.h> // for mmap
 
+#include <lace.h>
 #include <sylvan_cache.h>
-
-#ifndef MAP_ANONYMOUS
-#define MAP_ANONYMOUS MAP_ANON
-#endif
+#include <sylvan_numa.h>
+#include <sylvan_pages.h>
 
 #ifndef compiler_barrier
 #define compiler_barrier() { asm volatile("" ::: "memory"); }
@@ -40,6 +38,7 @@
  * This cache is designed to store a,b,c->res, with a,b,c,res 64-bit integers.
  *
  * Each cache bucket takes 32 bytes, 2 per cache line.
+ * With CACHE_COST, the 2 buckets of a set are in the same cache line.
  * Each cache status bucket takes 4 bytes, 16 per cache line.
  * Therefore, size 2^N = 36*(2^N) bytes.
  */
@@ -59,7 +58,8 @@ static size_t             cache_mask;         // cache_size-1
 static cache_entry_t      cache_table;
 static uint32_t*          cache_status;
 
-static uint64_t           next_opid;
+/* not reset by cache_create, as operation identifiers must survive cache_clear and cache_setsize */
+static uint64_t           next_opid = 512LL << 40;
 
 uint64_t
 cache_next_opid()
@@ -70,6 +70,133 @@ cache_next_opid()
 // status: 0x80000000 - bitlock
 //         0x7fff0000 - hash (part of the 64-bit hash not used to position)
 //         0x0000ffff - tag (every put increases tag field)
+// with CACHE_COST:
+//         0x7ff00000 - hash
+//         0x000f0000 - cost
+
+#if CACHE_COST
+#define CACHE_WAYS      2
+#define CACHE_HASH_MASK 0x7ff00000
+#define CACHE_COST_MASK 0x000f0000
+#else
+#define CACHE_WAYS      1
+#define CACHE_HASH_MASK 0x7fff0000
+#endif
+
+static cache_cost_cb cache_cost = NULL;
+
+void
+cache_set_cost_cb(cache_cost_cb cb)
+{
+    cache_cost = cb;
+}
+
+/**
+ * Regions: region i has <sets> sets from bucket <first>, and gets <share> percent of the cache
+ * (region 0 gets the rest). Not reset by cache_create, like the operation identifiers.
+ */
+typedef struct cache_region
+{
+    size_t first;
+    size_t sets;
+    unsigned share;
+} cache_region_t;
+
+static int                cache_region_count = 1;
+static cache_region_t     cache_regions[CACHE_MAX_REGIONS];
+static uint8_t            cache_op_regions[CACHE_MAX_OPS];
+
+/* gets and hits of every region, per worker (CACHE_MAX_REGIONS*2 counters each) */
+static uint64_t*          cache_region_counts = NULL;
+static int                cache_region_workers = 0;
+
+void
+cache_set_regions(int n, const unsigned *shares)
+{
+    if (n < 1 || n > CACHE_MAX_REGIONS) {
+        fprintf(stderr, "cache_set_regions: between 1 and %d regions!\n", CACHE_MAX_REGIONS);
+        exit(1);
+    }
+    unsigned total = 0;
+    for (int i=1; i<n; i++) {
+        cache_regions[i].share = shares[i];
+        total += shares[i];
+    }
+    if (total >= 100) {
+        fprintf(stderr, "cache_set_regions: regions 1..%d must leave part of the cache for region 0!\n", n-1);
+        exit(1);
+    }
+    cache_regions[0].share = 100 - total;
+    cache_region_count = n;
+
+    // the counts restart
+    free(cache_region_counts);
+    cache_region_counts = NULL;
+    cache_region_workers = 0;
+}
+
+void
+cache_set_op_region(uint64_t opid, int region)
+{
+    const uint64_t op = opid >> 40;
+    if (op < CACHE_MAX_OPS) cache_op_regions[op] = region;
+}
+
+/* Region of the operation of the key <a> (the operation identifier is in bits 40..62) */
+static inline int
+cache_op_region(uint64_t a)
+{
+    const uint64_t op = (a >> 40) & 0x7fffff;
+    const int region = op < CACHE_MAX_OPS ? cache_op_regions[op] : 0;
+    return region < cache_region_count ? region : 0;
+}
+
+/* Divide the sets of the cache over the regions */
+static void
+cache_regions_layout(void)
+{
+    const size_t sets = cache_size / CACHE_WAYS;
+    size_t used = 0;
+    for (int i=1; i<cache_region_count; i++) {
+        cache_regions[i].sets = sets * cache_regions[i].share / 100;
+        if (cache_regions[i].sets == 0) cache_regions[i].sets = 1;
+        used += cache_regions[i].sets;
+    }
+    cache_regions[0].first = 0;
+    cache_regions[0].sets = sets - used;
+    for (int i=1; i<cache_region_count; i++) {
+        cache_regions[i].first = cache_regions[i-1].first + cache_regions[i-1].sets * CACHE_WAYS;
+    }
+}
+
+/* Index of the first bucket of the set of <hash> */
+static inline size_t
+cache_set_index(uint64_t hash)
+{
+#if CACHE_MASK
+    return hash & cache_mask & ~(uint64_t)(CACHE_WAYS-1);
+#else
+    return (hash % (cache_size / CACHE_WAYS)) * CACHE_WAYS;
+#endif
+}
+
+/* Index of the first bucket of the set of <hash> in <region> (the low 32 bits select the set) */
+static inline size_t
+cache_region_set_index(int region, uint64_t hash)
+{
+    const cache_region_t *r = cache_regions + region;
+    return r->first + (((hash & 0xffffffff) * r->sets) >> 32) * CACHE_WAYS;
+}
+
+static inline void
+cache_region_count_get(int region, int hit)
+{
+    WorkerP *w = lace_get_worker();
+    if (w == NULL || cache_region_counts == NULL || w->worker >= cache_region_workers) return;
+    uint64_t *counts = cache_region_counts + (size_t)w->worker * 2 * CACHE_MAX_REGIONS;
+    counts[2*region]++;
+    counts[2*region+1] += hit;
+}
 
 /* Rotating 64-bit FNV-1a hash */
 static uint64_t
@@ -84,50 +211,81 @@ cache_hash(uint64_t a, uint64_t b, uint64_t c)
     return hash;
 }
 
+static inline int
+cache_lookup(size_t first, uint64_t hash, uint64_t a, uint64_t b, uint64_t c, uint64_t *res)
+{
+    for (int i=0; i<CACHE_WAYS; i++) {
+        volatile uint32_t *s_bucket = cache_status + first + i;
+        cache_entry_t bucket = cache_table + first + i;
+        const uint32_t s = *s_bucket;
+        compiler_barrier();
+        // skip if locked
+        if (s & 0x80000000) continue;
+        // skip if different hash
+        if ((s ^ (hash>>32)) & CACHE_HASH_MASK) continue;
+        // skip if key different
+        if (bucket->a != a || bucket->b != b || bucket->c != c) continue;
+        *res = bucket->res;
+        compiler_barrier();
+        // abort if status field changed after compiler_barrier()
+        return *s_bucket == s ? 1 : 0;
+    }
+    return 0;
+}
+
 int
 cache_get(uint64_t a, uint64_t b, uint64_t c, uint64_t *res)
 {
     const uint64_t hash = cache_hash(a, b, c);
-#if CACHE_MASK
-    volatile uint32_t *s_bucket = cache_status + (hash & cache_mask);
-    cache_entry_t bucket = cache_table + (hash & cache_mask);
-#else
-    volatile uint32_t *s_bucket = cache_status + (hash % cache_size);
-    cache_entry_t bucket = cache_table + (hash % cache_size);
-#endif
-    const uint32_t s = *s_bucket;
-    compiler_barrier();
-    // abort if locked
-    if (s & 0x80000000) return 0;
-    // abort if different hash
-    if ((s ^ (hash>>32)) & 0x7fff0000) return 0;
-    // abort if key different
-    if (bucket->a != a || bucket->b != b || bucket->c != c) return 0;
-    *res = bucket->res;
-    compiler_barrier();
-    // abort if status field changed after compiler_barrier()
-    return *s_bucket == s ? 1 : 0;
+    if (cache_region_count > 1) {
+        const int region = cache_op_region(a);
+        const int hit = cache_lookup(cache_region_set_index(region, hash), hash, a, b, c, res);
+        cache_region_count_get(region, hit);
+        return hit;
+    }
+    return cache_lookup(cache_set_index(hash), hash, a, b, c, res);
 }
 
 int
 cache_put(uint64_t a, uint64_t b, uint64_t c, uint64_t res)
 {
     const uint64_t hash = cache_hash(a, b, c);
-#if CACHE_MASK
-    volatile uint32_t *s_bucket = cache_status + (hash & cache_mask);
-    cache_entry_t bucket = cache_table + (hash & cache_mask);
+    const size_t first = cache_region_count > 1 ? cache_region_set_index(cache_op_region(a), hash) : cache_set_index(hash);
+    const uint32_t hash_mask = (hash>>32) & CACHE_HASH_MASK;
+#if CACHE_COST
+    volatile uint32_t *s_set = cache_status + first;
+    const uint32_t s0 = s_set[0], s1 = s_set[1];
+    // abort if locked
+    if ((s0 | s1) & 0x80000000) return 0;
+    // replace the entry with the same key, else an empty entry, else the entry with the lowest cost
+    // (ties are broken by the hash); the cost of the other entry decreases (aging)
+    int victim;
+    if ((s0 & CACHE_HASH_MASK) == hash_mask && cache_table[first].a == a && cache_table[first].b == b && cache_table[first].c == c) victim = 0;
+    else if ((s1 & CACHE_HASH_MASK) == hash_mask && cache_table[first+1].a == a && cache_table[first+1].b == b && cache_table[first+1].c == c) victim = 1;
+    else if (s0 == 0) victim = 0;
+    else if (s1 == 0) victim = 1;
+    else if ((s0 & CACHE_COST_MASK) != (s1 & CACHE_COST_MASK)) victim = (s0 & CACHE_COST_MASK) < (s1 & CACHE_COST_MASK) ? 0 : 1;
+    else victim = (hash >> 63) ? 1 : 0;
+    const uint32_t s_other = victim ? s0 : s1;
+    if (s_other & CACHE_COST_MASK) cas(s_set + 1 - victim, s_other, s_other - 0x00010000);
+    volatile uint32_t *s_bucket = s_set + victim;
+    cache_entry_t bucket = cache_table + first + victim;
+    const uint32_t s = victim ? s1 : s0;
+    uint32_t cost = cache_cost != NULL ? cache_cost(a) : 0;
+    if (cost > 15) cost = 15;
+    // use cas to claim bucket
+    const uint32_t new_s = ((s+1) & 0x0000ffff) | hash_mask | (cost << 16);
 #else
-    volatile uint32_t *s_bucket = cache_status + (hash % cache_size);
-    cache_entry_t bucket = cache_table + (hash % cache_size);
-#endif
+    volatile uint32_t *s_bucket = cache_status + first;
+    cache_entry_t bucket = cache_table + first;
     const uint32_t s = *s_bucket;
     // abort if locked
     if (s & 0x80000000) return 0;
     // abort if hash identical -> no: in iscasmc this occasionally causes timeouts?!
-    const uint32_t hash_mask = (hash>>32) & 0x7fff0000;
     // if ((s & 0x7fff0000) == hash_mask) return 0;
     // use cas to claim bucket
     const uint32_t new_s = ((s+1) & 0x0000ffff) | hash_mask;
+#endif
     if (!cas(s_bucket, s, new_s | 0x80000000)) return 0;
     // cas succesful: write data
     bucket->a = a;
@@ -162,22 +320,32 @@ cache_create(size_t _cache_size, size_t _max_size)
         exit(1);
     }
 
-    cache_table = (cache_entry_t)mmap(0, cache_max * sizeof(struct cache_entry), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    cache_status = (uint32_t*)mmap(0, cache_max * sizeof(uint32_t), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    cache_table = (cache_entry_t)pages_map(cache_max * sizeof(struct cache_entry), 0);
+    cache_status = (uint32_t*)pages_map(cache_max * sizeof(uint32_t), 0);
 
-    if (cache_table == (cache_entry_t)-1 || cache_status == (uint32_t*)-1) {
+    if (cache_table == NULL || cache_status == NULL) {
         fprintf(stderr, "cache_create: Unable to allocate memory: %s!\n", strerror(errno));
         exit(1);
     }
 
-    next_opid = 512LL << 40;
+    numa_touch_area(cache_table, cache_size * sizeof(struct cache_entry));
+    numa_touch_area(cache_status, cache_size * sizeof(uint32_t));
+
+    if (cache_region_count > 1) {
+        cache_regions_layout();
+        if (cache_region_counts == NULL) {
+            cache_region_workers = lace_workers();
+            cache_region_counts = (uint64_t*)calloc((size_t)cache_region_workers * 2 * CACHE_MAX_REGIONS, sizeof(uint64_t));
+            if (cache_region_counts == NULL) cache_region_workers = 0;
+        }
+    }
 }
 
 void
 cache_free()
 {
-    munmap(cache_table, cache_max * sizeof(struct cache_entry));
-    munmap(cache_status, cache_max * sizeof(uint32_t));
+    pages_unmap(cache_table, cache_max * sizeof(struct cache_entry));
+    pages_unmap(cache_status, cache_max * sizeof(uint32_t));
 }
 
 void
@@ -188,6 +356,23 @@ cache_clear()
     cache_create(cache_size, cache_max);
 }
 
+void
+cache_clear_dead(size_t first, size_t count, int (*dead)(void *ctx, uint64_t index), void *ctx)
+{
+    const uint64_t mask = 0x000000ffffffffff;
+    for (size_t i=first; i<first+count; i++) {
+        cache_entry_t bucket = cache_table + i;
+        // the fourth node of cache_put4 is packed into the high bits of b and c
+        uint64_t d4 = ((bucket->b >> 40) & 0xfffff) | (((bucket->c >> 40) & 0xfffff) << 20);
+        if (dead(ctx, bucket->a & mask) || dead(ctx, bucket->b & mask) || dead(ctx, bucket->c & mask) ||
+            dead(ctx, bucket->res & mask) || dead(ctx, d4)) {
+            // no operation has all bits of the operation identifier set
+            bucket->a = 0xffffffffffffffffLL;
+            cache_status[i] = 0;
+        }
+    }
+}
+
 void
 cache_setsize(size_t size)
 {
@@ -219,3 +404,30 @@ cache_getmaxsize()
 {
     return cache_max;
 }
+
+int
+cache_get_region_count()
+{
+    return cache_region_count;
+}
+
+size_t
+cache_region_stats(int region, uint64_t *gets, uint64_t *hits)
+{
+    *gets = *hits = 0;
+    for (int w=0; w<cache_region_workers; w++) {
+        *gets += cache_region_counts[(size_t)w * 2 * CACHE_MAX_REGIONS + 2*region];
+        *hits += cache_region_counts[(size_t)w * 2 * CACHE_MAX_REGIONS + 2*region + 1];
+    }
+    return region < cache_region_count ? cache_regions[region].sets * CACHE_WAYS : 0;
+}
+
+size_t
+cache_numa_distribution(size_t *counts, int n)
+{
+    size_t status_counts[n];
+    size_t result = numa_area_distribution(cache_table, cache_size * sizeof(struct cache_entry), 2048, counts, n);
+    result += numa_area_distribution(cache_status, cache_size * sizeof(uint32_t), 2048, status_counts, n);
+    for (int i=0; i<n; i++) counts[i] += status_counts[i];
+    return result;
+}
@@ -30,6 +30,22 @@ extern "C" {
 #define CACHE_MASK 1
 #endif
 
+/**
+ * With CACHE_COST, the cache is 2-way set associative and cache_put replaces the entry of the set
+ * with the lowest approximate recomputation cost (see cache_set_cost_cb).
+ * Off by default (cmake option SYLVAN_CACHE_COST): the cost is only recovered on some models,
+ * and every cache_put then reads the node of its first key.
+ */
+#ifndef CACHE_COST
+#define CACHE_COST 0
+#endif
+
+/**
+ * Maximum number of regions of the cache, and of operation identifiers that can be assigned to a region
+ */
+#define CACHE_MAX_REGIONS 8
+#define CACHE_MAX_OPS 1024
+
 /**
  * Operation cache
  *
@@ -57,6 +73,31 @@ typedef struct cache_entry *cache_entry_t;
 int cache_get(uint64_t a, uint64_t b, uint64_t c, uint64_t *res);
 int cache_put(uint64_t a, uint64_t b, uint64_t c, uint64_t res);
 
+/**
+ * Set the function that gives the approximate cost (0..15) of recomputing the result for the
+ * first key <a> (the decision diagram and the operation identifier). Without it, every entry has cost 0.
+ * Entries of higher cost survive more puts to their set: the cost of the entry that is not replaced
+ * decreases by 1, so old expensive entries are eventually replaced.
+ */
+typedef uint32_t (*cache_cost_cb)(uint64_t a);
+void cache_set_cost_cb(cache_cost_cb cb);
+
+/**
+ * Partition the cache into <n> regions, so the operations of one region cannot evict the entries of
+ * another region. Region i (1..n-1) gets shares[i] percent of the cache and region 0 gets the rest
+ * (shares[0] is ignored). Every operation is in region 0, unless it is assigned to another region
+ * with cache_set_op_region. Call before sylvan_init_package; with n=1 (the default), there are no regions.
+ */
+void cache_set_regions(int n, const unsigned *shares);
+void cache_set_op_region(uint64_t opid, int region);
+int cache_get_region_count(void);
+
+/**
+ * Obtain the number of cache_get calls of the operations of <region> and how many were hits, by the
+ * Lace workers since the start. Returns the number of buckets of the region.
+ */
+size_t cache_region_stats(int region, uint64_t *gets, uint64_t *hits);
+
 /**
  * Helper function to get next 'operation id' (during initialization of modules)
  */
@@ -115,6 +156,14 @@ void cache_free(void);
 
 void cache_clear(void);
 
+/**
+ * Remove the entries first..first+count-1 that may refer to a node for which dead(ctx, index)
+ * is nonzero. Every value of an entry is treated as a possible node (also as packed by
+ * cache_put4), so entries may be removed needlessly, but never kept wrongly.
+ * Not thread-safe with cache_get and cache_put.
+ */
+void cache_clear_dead(size_t first, size_t count, int (*dead)(void *ctx, uint64_t index), void *ctx);
+
 void cache_setsize(size_t size);
 
 size_t cache_getused(void);
@@ -123,6 +172,12 @@ size_t cache_getsize(void);
 
 size_t cache_getmaxsize(void);
 
+/**
+ * Count the sampled resident pages of the cache on every NUMA domain (counts[i] for domain i < n),
+ * see numa_area_distribution. Returns the number of sampled resident pages.
+ */
+size_t cache_numa_distribution(size_t *counts, int n);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
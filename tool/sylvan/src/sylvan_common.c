@@ -53,6 +53,17 @@ sylvan_gc_disable()
  */
 static volatile int gc;
 
+/**
+ * The number of garbage collections (including compactions) so far
+ */
+static size_t gc_count = 0;
+
+size_t
+sylvan_gc_count()
+{
+    return gc_count;
+}
+
 /**
  * Structures for the marking mechanisms
  */
@@ -218,8 +229,10 @@ VOID_TASK_IMPL_0(sylvan_gc_normal_resize)
  */
 VOID_TASK_0(sylvan_gc_go)
 {
+    gc_count++;
     sylvan_stats_count(SYLVAN_GC_COUNT);
     sylvan_timer_start(SYLVAN_GC);
+    lace_trace_begin("gc");
 
     // call pre gc hooks
     for (gc_hook_entry_t e = pregc_list; e != NULL; e = e->next) {
@@ -233,18 +246,25 @@ VOID_TASK_0(sylvan_gc_go)
      */
     CALL(sylvan_clear_cache);
 
+    lace_trace_begin("gc mark");
     CALL(sylvan_clear_and_mark);
+    lace_trace_end();
 
     // call hooks for resizing and all that
+    lace_trace_begin("gc resize");
     WRAP(main_hook);
+    lace_trace_end();
 
+    lace_trace_begin("gc rehash");
     CALL(sylvan_rehash_all);
+    lace_trace_end();
 
     // call post gc hooks
     for (gc_hook_entry_t e = postgc_list; e != NULL; e = e->next) {
         WRAP(e->cb);
     }
 
+    lace_trace_end();
     sylvan_timer_stop(SYLVAN_GC);
 }
 
@@ -265,6 +285,136 @@ VOID_TASK_IMPL_0(sylvan_gc)
     }
 }
 
+/**
+ * Compacting garbage collection: nodes that are reachable from other roots than the protected
+ * references are marked first, and keep their index
+ */
+VOID_TASK_0(sylvan_compact_go)
+{
+    gc_count++;
+    sylvan_stats_count(SYLVAN_GC_COUNT);
+    sylvan_timer_start(SYLVAN_GC);
+    lace_trace_begin("compact");
+
+    for (gc_hook_entry_t e = pregc_list; e != NULL; e = e->next) {
+        WRAP(e->cb);
+    }
+
+    CALL(sylvan_clear_cache);
+
+    lace_trace_begin("compact mark");
+    llmsset_compact_begin(nodes);
+    for (gc_hook_entry_t e = mark_list; e != NULL; e = e->next) {
+        if (e->cb != TASK(mtbdd_gc_mark_protected)) WRAP(e->cb);
+    }
+    llmsset_compact_fix(nodes);
+    CALL(mtbdd_gc_mark_protected);
+    lace_trace_end();
+
+    lace_trace_begin("compact move");
+    uint64_t *map = llmsset_compact(nodes, mtbdd_compact_key);
+    CALL(mtbdd_compact_relocate, map);
+    llmsset_compact_end(nodes, map);
+    lace_trace_end();
+
+    lace_trace_begin("compact rehash");
+    CALL(sylvan_rehash_all);
+    lace_trace_end();
+
+    for (gc_hook_entry_t e = postgc_list; e != NULL; e = e->next) {
+        WRAP(e->cb);
+    }
+
+    lace_trace_end();
+    sylvan_timer_stop(SYLVAN_GC);
+}
+
+VOID_TASK_IMPL_0(sylvan_compact)
+{
+    if (gc_enabled) {
+        if (cas(&gc, 0, 1)) {
+            NEWFRAME(sylvan_compact_go);
+            gc = 0;
+        } else {
+            /* wait for new frame to appear */
+            while (*(Task* volatile*)&(lace_newframe.t) == 0) {}
+            lace_yield(__lace_worker, __lace_dq_head);
+        }
+    }
+}
+
+static int
+scratch_isdead(void *dbs, uint64_t index)
+{
+    return llmsset_scratch_isdead((llmsset_t)dbs, index);
+}
+
+/**
+ * Remove the cache entries first..first+count-1 that refer to scratch nodes that are freed
+ */
+VOID_TASK_2(sylvan_scratch_clear_cache, size_t, first, size_t, count)
+{
+    if (count > 4096) {
+        SPAWN(sylvan_scratch_clear_cache, first, count/2);
+        CALL(sylvan_scratch_clear_cache, first + count/2, count - count/2);
+        SYNC(sylvan_scratch_clear_cache);
+    } else {
+        cache_clear_dead(first, count, scratch_isdead, nodes);
+    }
+}
+
+/**
+ * Free the unreferenced scratch nodes: mark from the roots, which only visits scratch nodes.
+ * Unlike garbage collection, this keeps the cache entries of the nodes that are not freed.
+ */
+VOID_TASK_0(sylvan_scratch_discard_go)
+{
+    lace_trace_begin("scratch discard");
+
+    llmsset_scratch_unmark(nodes);
+    for (gc_hook_entry_t e = mark_list; e != NULL; e = e->next) {
+        WRAP(e->cb);
+    }
+    CALL(sylvan_scratch_clear_cache, 0, cache_getsize());
+    llmsset_scratch_release(nodes);
+
+    CALL(sylvan_rehash_all);
+
+    lace_trace_end();
+}
+
+VOID_TASK_IMPL_0(sylvan_scratch_discard)
+{
+    if (gc_enabled) {
+        if (cas(&gc, 0, 1)) {
+            NEWFRAME(sylvan_scratch_discard_go);
+            gc = 0;
+        } else {
+            /* wait for new frame to appear */
+            while (*(Task* volatile*)&(lace_newframe.t) == 0) {}
+            lace_yield(__lace_worker, __lace_dq_head);
+        }
+    }
+}
+
+void
+sylvan_scratch_begin(void)
+{
+    llmsset_scratch_begin(nodes);
+}
+
+void
+sylvan_scratch_end(void)
+{
+    llmsset_scratch_end(nodes);
+}
+
+size_t
+sylvan_scratch_size(void)
+{
+    return llmsset_scratch_size(nodes);
+}
+
 /**
  * The unique table
  */
@@ -101,6 +101,23 @@ VOID_TASK_DECL_2(sylvan_table_usage, size_t*, size_t*);
 VOID_TASK_DECL_0(sylvan_gc);
 #define sylvan_gc() (CALL(sylvan_gc))
 
+/**
+ * Compacting garbage collection: garbage collection that also moves the nodes to the start of
+ * the nodes table, ordered by variable, so the nodes of every variable are stored together.
+ * Only the nodes of protected references (mtbdd_protect) move, and the protected references are
+ * updated; the nodes of other roots (mtbdd_ref, the internal references of operations and
+ * custom mark functions) keep their index. As copies of protected references are not updated,
+ * call this only between operations, when every MTBDD that is used later is protected or
+ * referenced. Requires sylvan_init_mtbdd.
+ */
+VOID_TASK_DECL_0(sylvan_compact);
+#define sylvan_compact() (CALL(sylvan_compact))
+
+/**
+ * The number of garbage collections so far, including compactions.
+ */
+size_t sylvan_gc_count(void);
+
 /**
  * Enable or disable garbage collection.
  *
@@ -118,6 +135,23 @@ void sylvan_gc_disable(void);
  */
 #define sylvan_gc_test() YIELD_NEWFRAME()
 
+/**
+ * Scratch nodes: all nodes that are created between sylvan_scratch_begin and sylvan_scratch_end
+ * are scratch nodes. sylvan_scratch_discard frees the scratch nodes that are not referenced, with
+ * the marking mechanisms of garbage collection; as the other nodes stay marked, only referenced
+ * scratch nodes are visited. This is meant for the intermediate results of one step of a long
+ * computation, which are garbage after the step. Unlike garbage collection, it only removes the
+ * cache entries of freed nodes, and it does not resize the tables or call the gc hooks.
+ * The remaining scratch nodes become normal nodes.
+ * sylvan_scratch_size is the number of nodes that were created in scratch mode since the last
+ * discard (an upper bound).
+ */
+void sylvan_scratch_begin(void);
+void sylvan_scratch_end(void);
+size_t sylvan_scratch_size(void);
+VOID_TASK_DECL_0(sylvan_scratch_discard);
+#define sylvan_scratch_discard() (CALL(sylvan_scratch_discard))
+
 /**
  * Clear the operation cache.
  */
@@ -50,9 +50,10 @@ gmp_hash(const uint64_t v, const uint64_t seed)
     uint64_t hash = seed;
     mp_limb_t *limbs;
 
-    // hash "numerator" limbs
+    // hash "numerator" limbs (the size of a negative numerator is negative)
     limbs = x[0]._mp_num._mp_d;
-    for (int i=0; i<x[0]._mp_num._mp_size; i++) {
+    if (x[0]._mp_num._mp_size < 0) hash = rotl64(hash ^ 1, 47) * prime;
+    for (int i=0; i<(int)mpz_size(mpq_numref(x)); i++) {
         hash = hash ^ limbs[i];
         hash = rotl64(hash, 47);
         hash = hash * prime;
@@ -109,6 +109,26 @@ VOID_TASK_IMPL_1(mtbdd_gc_mark_rec, MDD, mtbdd)
     }
 }
 
+TASK_IMPL_1(size_t, mtbdd_pin, MTBDD, mtbdd)
+{
+    if (mtbdd == mtbdd_true) return 0;
+    if (mtbdd == mtbdd_false) return 0;
+
+    if (!llmsset_pin(nodes, MTBDD_STRIPMARK(mtbdd))) return 0;
+
+    mtbddnode_t n = MTBDD_GETNODE(mtbdd);
+    if (mtbddnode_isleaf(n)) return 1;
+    SPAWN(mtbdd_pin, mtbddnode_getlow(n));
+    size_t high = CALL(mtbdd_pin, mtbddnode_gethigh(n));
+    return 1 + high + SYNC(mtbdd_pin);
+}
+
+void
+mtbdd_unpin_all(void)
+{
+    llmsset_unpin_all(nodes);
+}
+
 /**
  * External references
  */
@@ -176,7 +196,7 @@ VOID_TASK_0(mtbdd_gc_mark_external_refs)
     }
 }
 
-VOID_TASK_0(mtbdd_gc_mark_protected)
+VOID_TASK_IMPL_0(mtbdd_gc_mark_protected)
 {
     // iterate through refs hash table, mark all found
     size_t count=0;
@@ -191,6 +211,59 @@ VOID_TASK_0(mtbdd_gc_mark_protected)
     }
 }
 
+uint32_t
+mtbdd_compact_key(uint64_t a, uint64_t b)
+{
+    struct mtbddnode n = {a, b};
+    return mtbddnode_isleaf(&n) ? 0 : mtbddnode_getvariable(&n) + 1;
+}
+
+/**
+ * Helper: map the children of the moved nodes in words first..first+count-1 of the nodes table
+ */
+VOID_TASK_3(mtbdd_compact_relocate_par, uint64_t*, map, size_t, first, size_t, count)
+{
+    if (count > 64) {
+        SPAWN(mtbdd_compact_relocate_par, map, first, count/2);
+        CALL(mtbdd_compact_relocate_par, map, first + count/2, count - count/2);
+        SYNC(mtbdd_compact_relocate_par);
+        return;
+    }
+
+    for (size_t k=first; k<first+count; k++) {
+        // fixed nodes only have fixed children
+        uint64_t moved = nodes->bitmap2[k] & ~nodes->bitmapf[k];
+        while (moved != 0) {
+            int j = __builtin_clzll(moved);
+            moved &= ~(0x8000000000000000LL >> j);
+            mtbddnode_t n = MTBDD_GETNODE((k*64+j));
+            if (mtbddnode_isleaf(n)) continue;
+            n->a = (n->a & ~0x000000ffffffffffLL) | map[n->a & 0x000000ffffffffff];
+            n->b = (n->b & ~0x000000ffffffffffLL) | map[n->b & 0x000000ffffffffff];
+        }
+    }
+}
+
+VOID_TASK_IMPL_1(mtbdd_compact_relocate, uint64_t*, map)
+{
+    CALL(mtbdd_compact_relocate_par, map, 0, nodes->table_size / 64);
+
+    // a reference can be protected more than once, so first compute all new values
+    size_t count = protect_count(&mtbdd_protected);
+    MTBDD **refs = (MTBDD**)malloc(sizeof(MTBDD*) * (count+1));
+    MTBDD *values = (MTBDD*)malloc(sizeof(MTBDD) * (count+1));
+    size_t n = 0;
+    uint64_t *it = protect_iter(&mtbdd_protected, 0, mtbdd_protected.refs_size);
+    while (it != NULL && n < count) {
+        refs[n] = (MTBDD*)protect_next(&mtbdd_protected, &it, mtbdd_protected.refs_size);
+        values[n] = (*refs[n] & ~0x000000ffffffffffLL) | map[*refs[n] & 0x000000ffffffffff];
+        n++;
+    }
+    for (size_t i=0; i<n; i++) *refs[i] = values[i];
+    free(refs);
+    free(values);
+}
+
 /* Infrastructure for internal markings */
 DECLARE_THREAD_LOCAL(mtbdd_refs_key, mtbdd_refs_internal_t);
 
@@ -380,9 +453,41 @@ void mtbdd_custom_set_read_binary(uint32_t type, mtbdd_read_binary_cb read_binar
 
 static int mtbdd_initialized = 0;
 
+/**
+ * Approximate cost of recomputing a cache entry of an operation on the node <a>: the recursion on a
+ * node near the root of the variable order is larger, so the cost decreases linearly from
+ * MTBDD_COST_MAX for variable 0 to 1 for the last variable of the range (see
+ * mtbdd_set_cache_cost_vars). Nodes on variables below the range and leaves have cost 0.
+ * Reading the node is cheap, as the operation that computed the result read it as well.
+ * For keys that are not nodes, the cost is arbitrary, which only affects the replacement.
+ */
+#define MTBDD_COST_MAX 15
+#define MTBDD_COST_VARS 64 // default range, e.g. 32 interleaved state and next-state variables
+
+static uint32_t mtbdd_cost_vars = MTBDD_COST_VARS;
+
+void
+mtbdd_set_cache_cost_vars(uint32_t vars)
+{
+    mtbdd_cost_vars = vars != 0 ? vars : MTBDD_COST_VARS;
+}
+
+static uint32_t
+mtbdd_cache_cost(uint64_t a)
+{
+    const uint64_t index = a & 0x000000ffffffffff;
+    if (index < 2 || index >= llmsset_get_size(nodes)) return 0;
+    mtbddnode_t n = MTBDD_GETNODE(index);
+    if (mtbddnode_isleaf(n)) return 0;
+    const uint64_t var = mtbddnode_getvariable(n);
+    const uint64_t vars = mtbdd_cost_vars;
+    return var < vars ? MTBDD_COST_MAX - (uint32_t)(var * MTBDD_COST_MAX / vars) : 0;
+}
+
 static void
 mtbdd_quit()
 {
+    cache_set_cost_cb(NULL);
     refs_free(&mtbdd_refs);
     if (mtbdd_protected_created) {
         protect_free(&mtbdd_protected);
@@ -404,6 +509,7 @@ sylvan_init_mtbdd()
     mtbdd_initialized = 1;
 
     sylvan_register_quit(mtbdd_quit);
+    cache_set_cost_cb(mtbdd_cache_cost);
     sylvan_gc_add_mark(TASK(mtbdd_gc_mark_external_refs));
     sylvan_gc_add_mark(TASK(mtbdd_gc_mark_protected));
 
@@ -3135,7 +3241,7 @@ mtbdd_sha2_rec(MTBDD dd, SHA256_CTX *ctx)
             uint64_t value = mtbddnode_getvalue(node);
             if (type < cl_registry_count) {
                 customleaf_t *c = cl_registry + type;
-                if (c->hash_cb != NULL) value = c->hash_cb(value, value);
+                if (c->hash_cb != NULL) value = c->hash_cb(value, 14695981039346656037LLU);
             }
             SHA256_Update(ctx, (void*)&value, sizeof(uint64_t));
         } else {
@@ -3351,6 +3457,7 @@ TASK_IMPL_1(uint64_t*, mtbdd_reader_readbinary, FILE*, in)
     }
 
     uint64_t *arr = malloc(sizeof(uint64_t)*(nodecount+1));
+    arr[0] = mtbdd_false; /* identifier 0 is the false terminal (and true, with the complement mark) */
     for (size_t i=1; i<=nodecount; i++) {
         struct mtbddnode node;
         if (fread(&node, sizeof(struct mtbddnode), 1, in) != 1) {
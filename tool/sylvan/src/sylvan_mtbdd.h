@@ -126,6 +126,15 @@ typedef MTBDD MTBDDMAP;
  */
 void sylvan_init_mtbdd(void);
 
+/**
+ * Set the range of variables (0..<vars>-1) over which the approximate cost of recomputing an entry
+ * of the operation cache (see cache_set_cost_cb) decreases, from the root of the variable order.
+ * Nodes on variables below this range, which start small recursions, get the lowest cost.
+ * Typically the number of variables of the state space; 0 restores the default (64).
+ * Has no effect unless Sylvan is built with CACHE_COST.
+ */
+void mtbdd_set_cache_cost_vars(uint32_t vars);
+
 /**
  * Create a MTBDD terminal of type <type> and value <value>.
  * For custom types, the value could be a pointer to some external struct.
@@ -908,6 +917,29 @@ void mtbdd_custom_set_read_binary(uint32_t type, mtbdd_read_binary_cb read_binar
 VOID_TASK_DECL_1(mtbdd_gc_mark_rec, MTBDD);
 #define mtbdd_gc_mark_rec(mtbdd) CALL(mtbdd_gc_mark_rec, mtbdd)
 
+/**
+ * Pin the nodes of <mtbdd> in the nodes table (see llmsset_pin). Garbage collection keeps pinned
+ * nodes without marking them, and marking stops at them, until mtbdd_unpin_all is called.
+ * Use this for MTBDDs that are used during a long computation, such as transition relations.
+ * Returns the number of nodes that were not pinned before.
+ */
+TASK_DECL_1(size_t, mtbdd_pin, MTBDD);
+#define mtbdd_pin(mtbdd) CALL(mtbdd_pin, mtbdd)
+
+/**
+ * Unpin all nodes; they are kept by garbage collection only if they are referenced.
+ */
+void mtbdd_unpin_all(void);
+
+/**
+ * For compaction (sylvan_compact): mark the nodes of the protected references, the key that
+ * orders the nodes (leaves first, then by variable), and update the moved nodes and the
+ * protected references, where map[i] is the new index of node i.
+ */
+VOID_TASK_DECL_0(mtbdd_gc_mark_protected);
+uint32_t mtbdd_compact_key(uint64_t a, uint64_t b);
+VOID_TASK_DECL_1(mtbdd_compact_relocate, uint64_t*);
+
 /**
  * Default external referencing. During garbage collection, MTBDDs marked with mtbdd_ref will
  * be kept in the forest.
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h> // for pthread_once
+#include <stdint.h>
+#include <unistd.h> // for sysconf
+
+#include <lace.h>
+#include <sylvan_numa.h>
+
+#ifndef USE_HWLOC
+#define USE_HWLOC 0
+#endif
+
+#if USE_HWLOC
+#include <hwloc.h>
+
+static hwloc_topology_t topo;
+#endif
+
+static numa_policy_t numa_policy = numa_default;
+static pthread_once_t numa_once = PTHREAD_ONCE_INIT;
+
+static void
+numa_init(void)
+{
+#if USE_HWLOC
+    hwloc_topology_init(&topo);
+    hwloc_topology_load(topo);
+#endif
+}
+
+void
+sylvan_set_numa_policy(numa_policy_t policy)
+{
+    numa_policy = policy;
+}
+
+numa_policy_t
+sylvan_get_numa_policy()
+{
+    return numa_policy;
+}
+
+int
+numa_domain_count()
+{
+#if USE_HWLOC
+    pthread_once(&numa_once, numa_init);
+    int count = hwloc_get_nbobjs_by_type(topo, HWLOC_OBJ_NODE);
+    return count > 0 ? count : 1;
+#else
+    return 1;
+#endif
+}
+
+void
+numa_bind_area(void *area, size_t size, int interleave)
+{
+#if USE_HWLOC
+    pthread_once(&numa_once, numa_init);
+    if (numa_policy == numa_interleave) interleave = 1;
+    else if (numa_policy == numa_owner) interleave = 0;
+    hwloc_membind_policy_t policy = interleave ? HWLOC_MEMBIND_INTERLEAVE : HWLOC_MEMBIND_FIRSTTOUCH;
+    hwloc_set_area_membind(topo, area, size, hwloc_topology_get_allowed_cpuset(topo), policy, 0);
+#else
+    (void)area;
+    (void)size;
+    (void)interleave;
+#endif
+}
+
+/**
+ * Write the first byte of every page of part <LACE_WORKER_ID> of <size> bytes at <area>
+ */
+VOID_TASK_2(numa_touch_part, char*, area, size_t, size)
+{
+    const size_t page = sysconf(_SC_PAGESIZE);
+    const size_t n = lace_workers(), id = LACE_WORKER_ID;
+    size_t first = (size / n * id) & ~(page-1);
+    size_t end = id == n-1 ? size : (size / n * (id+1)) & ~(page-1);
+    for (size_t i=first; i<end; i+=page) ((volatile char*)area)[i] = 0;
+}
+
+void
+numa_touch_area(void *area, size_t size)
+{
+    if (numa_policy != numa_owner) return;
+    LACE_ME;
+    TOGETHER(numa_touch_part, (char*)area, size);
+}
+
+size_t
+numa_area_distribution(const void *area, size_t size, size_t samples, size_t *counts, int n)
+{
+    for (int i=0; i<n; i++) counts[i] = 0;
+#if USE_HWLOC && HWLOC_API_VERSION >= 0x00020000
+    pthread_once(&numa_once, numa_init);
+    const size_t page = sysconf(_SC_PAGESIZE);
+    size_t pages = (size + page - 1) / page;
+    if (pages == 0 || samples == 0) return 0;
+    size_t step = pages > samples ? pages / samples : 1;
+
+    size_t resident = 0;
+    hwloc_nodeset_t nodeset = hwloc_bitmap_alloc();
+    for (size_t p=0; p<pages; p+=step) {
+        const char *addr = (const char*)area + p*page;
+        if (hwloc_get_area_memlocation(topo, addr, page, nodeset, HWLOC_MEMBIND_BYNODESET) != 0) {
+            hwloc_bitmap_free(nodeset);
+            for (int i=0; i<n; i++) counts[i] = 0;
+            return 0;
+        }
+        if (hwloc_bitmap_iszero(nodeset)) continue; // not resident
+        resident++;
+        for (int i=0; i<n; i++) {
+            hwloc_obj_t obj = hwloc_get_obj_by_type(topo, HWLOC_OBJ_NODE, i);
+            if (obj != NULL && hwloc_bitmap_isset(nodeset, obj->os_index)) {
+                counts[i]++;
+                break;
+            }
+        }
+    }
+    hwloc_bitmap_free(nodeset);
+    return resident;
+#else
+    (void)area;
+    (void)size;
+    (void)samples;
+    return 0;
+#endif
+}
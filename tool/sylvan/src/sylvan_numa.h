@@ -0,0 +1,80 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_config.h>
+
+#include <stddef.h> // for size_t
+
+#ifndef SYLVAN_NUMA_H
+#define SYLVAN_NUMA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Placement of the nodes table and the operation cache on the NUMA domains.
+ * - numa_default: the hash array of the nodes table is interleaved over the domains (with hwloc),
+ *   the other arrays are on the domain of the worker that first writes a page;
+ * - numa_interleave: all arrays are interleaved over the domains (with hwloc);
+ * - numa_owner: all arrays are on the domain of the worker that first writes a page, and after
+ *   every (re)allocation of the hash array, the marks of the nodes table and the operation cache,
+ *   worker i of n first writes part i of n of their used part. The data array is written by the
+ *   worker that claims a region, and worker i claims regions from the start of part i (llmsset),
+ *   so new nodes are mostly on the domain of the worker that creates them.
+ * Without hwloc, numa_interleave is the same as numa_default.
+ */
+typedef enum {
+    numa_default = 0,
+    numa_interleave = 1,
+    numa_owner = 2,
+} numa_policy_t;
+
+/**
+ * Set the placement of the nodes table and the operation cache. Call before sylvan_init_package.
+ */
+void sylvan_set_numa_policy(numa_policy_t policy);
+numa_policy_t sylvan_get_numa_policy(void);
+
+/**
+ * Number of NUMA domains (1 without hwloc)
+ */
+int numa_domain_count(void);
+
+/**
+ * For the tables: set the policy of the pages of <size> bytes at <area>, which is newly mapped.
+ * With numa_default, <interleave> says if the area is interleaved.
+ */
+void numa_bind_area(void *area, size_t size, int interleave);
+
+/**
+ * For the tables: with numa_owner, let every worker first write its part of the first <size>
+ * bytes at <area>, which is newly mapped (thus zero). Must be called from a Lace worker.
+ */
+void numa_touch_area(void *area, size_t size);
+
+/**
+ * Sample at most <samples> pages of the first <size> bytes at <area> and count the resident pages on
+ * every domain (counts[i] for domain i < n). Returns the number of sampled pages that are resident,
+ * or 0 if the domains of pages cannot be obtained.
+ */
+size_t numa_area_distribution(const void *area, size_t size, size_t samples, size_t *counts, int n);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
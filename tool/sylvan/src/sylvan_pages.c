@@ -0,0 +1,227 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <inttypes.h> // for SCNxPTR
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h> // for mmap, madvise
+
+#include <sylvan_numa.h>
+#include <sylvan_pages.h>
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+static pages_policy_t pages_policy = pages_normal;
+
+/**
+ * The arrays mapped with pages_map, for pages_huge_bytes
+ */
+typedef struct pages_area
+{
+    char *area;
+    size_t size;
+    int hugetlb;
+} pages_area_t;
+
+#define PAGES_AREAS 64
+
+static pages_area_t areas[PAGES_AREAS];
+static pthread_mutex_t areas_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void
+sylvan_set_huge_pages(pages_policy_t policy)
+{
+    pages_policy = policy;
+}
+
+pages_policy_t
+sylvan_get_huge_pages()
+{
+    return pages_policy;
+}
+
+/**
+ * The size of the explicit huge pages, from /proc/meminfo (2 MB if not available)
+ */
+static size_t
+pages_huge_size(void)
+{
+    static size_t huge_size = 0;
+    if (huge_size != 0) return huge_size;
+
+    size_t size = 2048*1024;
+    FILE *f = fopen("/proc/meminfo", "r");
+    if (f != NULL) {
+        char line[256];
+        size_t kb;
+        while (fgets(line, sizeof(line), f) != NULL) {
+            if (sscanf(line, "Hugepagesize: %zu kB", &kb) == 1 && kb != 0) {
+                size = kb*1024;
+                break;
+            }
+        }
+        fclose(f);
+    }
+    huge_size = size;
+    return size;
+}
+
+static pages_area_t*
+pages_find(void *area)
+{
+    for (int i=0; i<PAGES_AREAS; i++) if (areas[i].area == area) return areas+i;
+    return NULL;
+}
+
+/**
+ * Map normal pages at <area> (fixed if not NULL) and advise transparent huge pages
+ */
+static void*
+pages_map_normal(void *area, size_t size)
+{
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | (area != NULL ? MAP_FIXED : 0);
+    void *res = mmap(area, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (res == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+    if (pages_policy != pages_normal) madvise(res, size, MADV_HUGEPAGE);
+#endif
+    return res;
+}
+
+void*
+pages_map(size_t size, int interleave)
+{
+    void *res = NULL;
+    int hugetlb = 0;
+
+#ifdef MAP_HUGETLB
+    const size_t huge = pages_huge_size();
+    if (pages_policy == pages_hugetlb && size >= huge) {
+        size_t rounded = (size + huge - 1) & ~(huge - 1);
+        res = mmap(0, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (res == MAP_FAILED) res = NULL;
+        else hugetlb = 1;
+    }
+#endif
+
+    if (res == NULL) res = pages_map_normal(NULL, size);
+    if (res == NULL) return NULL;
+
+    numa_bind_area(res, size, interleave);
+
+    pthread_mutex_lock(&areas_lock);
+    pages_area_t *a = pages_find(NULL);
+    if (a != NULL) {
+        a->area = (char*)res;
+        a->size = size;
+        a->hugetlb = hugetlb;
+    }
+    pthread_mutex_unlock(&areas_lock);
+
+    return res;
+}
+
+void
+pages_clear(void *area, size_t size, int interleave)
+{
+    pthread_mutex_lock(&areas_lock);
+    pages_area_t *a = pages_find(area);
+    int hugetlb = a != NULL && a->hugetlb;
+    pthread_mutex_unlock(&areas_lock);
+
+    if (hugetlb) {
+        // explicit huge pages are not mapped again, as the pool may be empty by now
+        if (madvise(area, size, MADV_DONTNEED) != 0) memset(area, 0, size);
+    } else {
+        if (pages_map_normal(area, size) != area) memset(area, 0, size);
+        else numa_bind_area(area, size, interleave);
+    }
+}
+
+void
+pages_unmap(void *area, size_t size)
+{
+    pthread_mutex_lock(&areas_lock);
+    pages_area_t *a = pages_find(area);
+    if (a != NULL) {
+        if (a->hugetlb) {
+            const size_t huge = pages_huge_size();
+            size = (size + huge - 1) & ~(huge - 1);
+        }
+        a->area = NULL;
+    }
+    pthread_mutex_unlock(&areas_lock);
+
+    munmap(area, size);
+}
+
+size_t
+pages_huge_bytes(size_t *resident, size_t *hugetlb)
+{
+    if (resident != NULL) *resident = 0;
+    if (hugetlb != NULL) *hugetlb = 0;
+
+    pthread_mutex_lock(&areas_lock);
+
+    if (hugetlb != NULL) {
+        for (int i=0; i<PAGES_AREAS; i++) if (areas[i].area != NULL && areas[i].hugetlb) *hugetlb += areas[i].size;
+    }
+
+    FILE *f = fopen("/proc/self/smaps", "r");
+    if (f == NULL) {
+        pthread_mutex_unlock(&areas_lock);
+        return 0;
+    }
+
+    size_t huge = 0, res = 0;
+    size_t overlap = 0, vma_size = 1; // overlap of the current VMA with the arrays
+    char line[256];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        uintptr_t start, end;
+        size_t kb;
+        char field[64];
+        if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " ", &start, &end) == 2 && strchr(line, '-') < strchr(line, ' ')) {
+            overlap = 0;
+            vma_size = end > start ? end - start : 1;
+            for (int i=0; i<PAGES_AREAS; i++) {
+                if (areas[i].area == NULL) continue;
+                uintptr_t a_start = (uintptr_t)areas[i].area, a_end = a_start + areas[i].size;
+                uintptr_t lo = a_start > start ? a_start : start, hi = a_end < end ? a_end : end;
+                if (lo < hi) overlap += hi - lo;
+            }
+        } else if (overlap != 0 && sscanf(line, "%63[^:]: %zu kB", field, &kb) == 2) {
+            // scale by the part of the VMA that belongs to the arrays
+            size_t bytes = (size_t)((double)kb * 1024 * overlap / vma_size);
+            if (strcmp(field, "AnonHugePages") == 0 || strcmp(field, "Private_Hugetlb") == 0 || strcmp(field, "Shared_Hugetlb") == 0) {
+                huge += bytes;
+                if (strcmp(field, "AnonHugePages") != 0) res += bytes;
+            } else if (strcmp(field, "Rss") == 0) {
+                res += bytes;
+            }
+        }
+    }
+    fclose(f);
+
+    pthread_mutex_unlock(&areas_lock);
+
+    if (resident != NULL) *resident = res;
+    return huge;
+}
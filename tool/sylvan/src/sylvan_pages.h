@@ -0,0 +1,76 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sylvan_config.h>
+
+#include <stddef.h> // for size_t
+
+#ifndef SYLVAN_PAGES_H
+#define SYLVAN_PAGES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Backing of the large arrays (the nodes table, the operation cache) by huge pages:
+ * - pages_normal: normal pages;
+ * - pages_transparent: transparent huge pages (madvise MADV_HUGEPAGE), which the kernel uses
+ *   where it can allocate them;
+ * - pages_hugetlb: explicit huge pages (mmap MAP_HUGETLB) from the pool of the kernel, for arrays
+ *   of at least one huge page; arrays that do not fit in the pool get transparent huge pages.
+ * Explicit huge pages are reserved for the whole array when it is mapped.
+ */
+typedef enum {
+    pages_normal = 0,
+    pages_transparent = 1,
+    pages_hugetlb = 2,
+} pages_policy_t;
+
+/**
+ * Set the backing of the arrays that are mapped after this call. Call before sylvan_init_package.
+ */
+void sylvan_set_huge_pages(pages_policy_t policy);
+pages_policy_t sylvan_get_huge_pages(void);
+
+/**
+ * Map <size> bytes of zeroed memory with the huge page backing and the NUMA placement
+ * (numa_bind_area with <interleave>). Returns NULL if unable.
+ */
+void *pages_map(size_t size, int interleave);
+
+/**
+ * Zero the <size> bytes at <area>, which was mapped with pages_map, by mapping new pages.
+ */
+void pages_clear(void *area, size_t size, int interleave);
+
+/**
+ * Unmap the <size> bytes at <area>, which was mapped with pages_map.
+ */
+void pages_unmap(void *area, size_t size);
+
+/**
+ * The number of bytes of the arrays mapped with pages_map that are backed by huge pages, from
+ * /proc/self/smaps (0 if not available). Sets <resident> to the number of resident bytes of these
+ * arrays, and <hugetlb> to the number of bytes of arrays with explicit huge pages.
+ */
+size_t pages_huge_bytes(size_t *resident, size_t *hugetlb);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif
@@ -23,6 +23,23 @@
 
 #include <sylvan_int.h>
 
+/**
+ * Names of the custom operations (see sylvan_stats_register_op)
+ */
+static const char *custom_op_names[SYLVAN_MAX_CUSTOM_OPS];
+static int custom_op_count = 0;
+
+int
+sylvan_stats_register_op(const char *name)
+{
+    if (custom_op_count == SYLVAN_MAX_CUSTOM_OPS) {
+        fprintf(stderr, "sylvan_stats: Too many custom operations!\n");
+        exit(1);
+    }
+    custom_op_names[custom_op_count] = name;
+    return custom_op_count++;
+}
+
 #if SYLVAN_STATS
 
 #ifdef __ELF__
@@ -46,7 +63,7 @@ static hwloc_topology_t topo;
 struct
 {
     int type; /* 0 for print line, 1 for simple counter, 2 for operation with CACHED and CACHEDPUT */
-              /* 3 for timer, 4 for report table data */
+              /* 3 for timer, 4 for report table data, 5 for custom operations, 6 for custom timers */
     int id;
     const char *key;
 } sylvan_report_info[] =
@@ -106,10 +123,12 @@ struct
     {2, LDD_ZIP, "LDD zip"},
     {2, LDD_RELPROD_UNION, "LDD relprod_union"},
     {2, LDD_PROJECT_MINUS, "LDD project_minus"},
+    {5, 0, NULL}, /* trigger to report custom operations */
 
     {0, 0, "Garbage collection"},
     {1, SYLVAN_GC_COUNT, "GC executions"},
     {3, SYLVAN_GC, "Total time spent"},
+    {6, 0, NULL}, /* trigger to report timers of custom operations */
 
     {-1, -1, NULL},
 };
@@ -149,6 +168,7 @@ VOID_TASK_0(sylvan_stats_reset_perthread)
 
 VOID_TASK_IMPL_0(sylvan_stats_init)
 {
+    custom_op_count = 0;
 #ifndef __ELF__
     pthread_key_create(&sylvan_stats_key, NULL);
 #endif
@@ -275,6 +295,26 @@ sylvan_stats_report(FILE *target)
             to_h(36ULL * cache_getsize(), buf);
             to_h(36ULL * cache_getmaxsize(), buf2);
             fprintf(target, "%-20s %s (max real) of %s (allocated virtual memory).\n", "Memory (cache)", buf, buf2);
+        } else if (type == 5) {
+            for (int op=0; op<custom_op_count; op++) {
+                int c = SYLVAN_CUSTOM_OP(op);
+                if (totals.counters[c] > 0) {
+                    fprintf(target, "%-20s %'-16"PRIu64 " %'-16"PRIu64" %'-16"PRIu64 "\n", custom_op_names[op], totals.counters[c], totals.counters[c+1], totals.counters[c+2]);
+                }
+            }
+        } else if (type == 6) {
+            int header = 0;
+            for (int op=0; op<custom_op_count; op++) {
+                int t = SYLVAN_CUSTOM_TIMER(op);
+                if (totals.timers[t] > 0) {
+                    if (!header) {
+                        if (color) fprintf(target, WHITE "\nTime in custom operations\n" NC);
+                        else fprintf(target, "\nTime in custom operations\n");
+                        header = 1;
+                    }
+                    fprintf(target, "%-20s %'.6Lf sec.\n", custom_op_names[op], (long double)totals.timers[t]/1000000000);
+                }
+            }
         }
         i++;
     }
@@ -284,6 +324,7 @@ sylvan_stats_report(FILE *target)
 
 VOID_TASK_IMPL_0(sylvan_stats_init)
 {
+    custom_op_count = 0;
 }
 
 VOID_TASK_IMPL_0(sylvan_stats_reset)
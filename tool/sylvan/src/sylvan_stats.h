@@ -27,6 +27,9 @@ extern "C" {
 
 #define OPCOUNTER(NAME) NAME, NAME ## _CACHEDPUT, NAME ## _CACHED
 
+/* Maximum number of custom operations, see sylvan_stats_register_op */
+#define SYLVAN_MAX_CUSTOM_OPS 32
+
 typedef enum {
     /* Creating nodes */
     BDD_NODES_CREATED,
@@ -84,6 +87,10 @@ typedef enum {
     OPCOUNTER(LDD_RELPROD_UNION),
     OPCOUNTER(LDD_PROJECT_MINUS),
 
+    /* Custom operations (3 counters each, as OPCOUNTER) */
+    SYLVAN_CUSTOM_OPS,
+    SYLVAN_CUSTOM_OPS_END = SYLVAN_CUSTOM_OPS + 3*SYLVAN_MAX_CUSTOM_OPS - 1,
+
     /* Other counters */
     SYLVAN_GC_COUNT,
     LLMSSET_LOOKUP,
@@ -94,6 +101,8 @@ typedef enum {
 typedef enum
 {
     SYLVAN_GC,
+    SYLVAN_CUSTOM_TIMERS,
+    SYLVAN_CUSTOM_TIMERS_END = SYLVAN_CUSTOM_TIMERS + SYLVAN_MAX_CUSTOM_OPS - 1,
     SYLVAN_TIMER_COUNTER
 } Sylvan_Timers;
 
@@ -129,6 +138,19 @@ VOID_TASK_DECL_1(sylvan_stats_snapshot, sylvan_stats_t*);
  */
 void sylvan_stats_report(FILE* target);
 
+/**
+ * Register a custom operation, e.g. of a tool that implements its own operations on Sylvan.
+ * Returns the index of the operation, for the counters and the timer below.
+ * Custom operations are reported by sylvan_stats_report after the operations of Sylvan.
+ * Registrations are cleared by sylvan_stats_init (called by sylvan_init_package).
+ */
+int sylvan_stats_register_op(const char *name);
+
+#define SYLVAN_CUSTOM_OP(index) (SYLVAN_CUSTOM_OPS + 3*(index))
+#define SYLVAN_CUSTOM_OP_CACHEDPUT(index) (SYLVAN_CUSTOM_OPS + 3*(index) + 1)
+#define SYLVAN_CUSTOM_OP_CACHED(index) (SYLVAN_CUSTOM_OPS + 3*(index) + 2)
+#define SYLVAN_CUSTOM_TIMER(index) (SYLVAN_CUSTOM_TIMERS + (index))
+
 #if SYLVAN_STATS
 
 #ifdef __MACH__
@@ -143,6 +143,247 @@ int test_gc(int threads)
     return 0;
 }
 
+int test_pin(int threads)
+{
+    LACE_ME;
+    int N_pinned = 16;
+    BDD pinned[N_pinned];
+    char* hashes[N_pinned];
+    char* hashes2[N_pinned];
+    int i,j;
+    for (i=0;i<N_pinned;i++) {
+        pinned[i] = make_random(0, 10);
+        hashes[i] = (char*)malloc(80);
+        hashes2[i] = (char*)malloc(80);
+        sylvan_getsha(pinned[i], hashes[i]);
+        mtbdd_pin(pinned[i]);
+        sylvan_deref(pinned[i]);
+    }
+    test_assert(sylvan_count_refs() == 0);
+    // pinned nodes survive garbage collection without references
+    for (j=0;j<10*threads;j++) {
+        CALL(gctest_fill, 6, 5);
+        for (i=0;i<N_pinned;i++) {
+            sylvan_test_isbdd(pinned[i]);
+            sylvan_getsha(pinned[i], hashes2[i]);
+            test_assert(strcmp(hashes[i], hashes2[i]) == 0);
+        }
+    }
+    // after unpinning, they are freed
+    sylvan_gc();
+    size_t filled = llmsset_count_marked(nodes);
+    mtbdd_unpin_all();
+    sylvan_gc();
+    test_assert(llmsset_count_marked(nodes) < filled);
+    for (i=0;i<N_pinned;i++) {
+        free(hashes[i]);
+        free(hashes2[i]);
+    }
+    return 0;
+}
+
+int test_scratch()
+{
+    LACE_ME;
+    char hash_before[80], hash_kept[80], hash_and[80], hash[80];
+    BDD before = make_random(0, 10);
+    sylvan_getsha(before, hash_before);
+
+    sylvan_scratch_begin();
+    uint64_t saved_seed = seed;
+    BDD kept = make_random(0, 10);
+    sylvan_getsha(kept, hash_kept);
+    sylvan_getsha(sylvan_and(before, kept), hash_and); // freed, but in the cache
+    CALL(gctest_fill, 2, 5);
+
+    // unreferenced scratch nodes are freed, the others are kept
+    size_t filled = llmsset_count_marked(nodes);
+    sylvan_scratch_discard();
+    test_assert(llmsset_count_marked(nodes) < filled);
+    sylvan_test_isbdd(before);
+    sylvan_getsha(before, hash);
+    test_assert(strcmp(hash, hash_before) == 0);
+    sylvan_test_isbdd(kept);
+    sylvan_getsha(kept, hash);
+    test_assert(strcmp(hash, hash_kept) == 0);
+
+    // the nodes are still unique
+    seed = saved_seed;
+    BDD again = make_random(0, 10);
+    test_assert(again == kept);
+    sylvan_deref(again);
+
+    // the cache does not return freed nodes, also when their buckets are reused
+    CALL(gctest_fill, 2, 5);
+    BDD conj = sylvan_and(before, kept);
+    sylvan_test_isbdd(conj);
+    sylvan_getsha(conj, hash);
+    test_assert(strcmp(hash, hash_and) == 0);
+    sylvan_scratch_end();
+
+    // kept scratch nodes are normal nodes
+    sylvan_gc();
+    sylvan_test_isbdd(kept);
+    sylvan_getsha(kept, hash);
+    test_assert(strcmp(hash, hash_kept) == 0);
+
+    sylvan_deref(kept);
+    sylvan_deref(before);
+    return 0;
+}
+
+/* Nodes that are moved by compaction are stored in the order of their variables */
+static int
+test_compact_order(BDD bdd, int moved)
+{
+    if (sylvan_isconst(bdd)) return 1;
+    BDD children[2] = {sylvan_low(bdd), sylvan_high(bdd)};
+    for (int i=0; i<2; i++) {
+        if (sylvan_isconst(children[i])) continue;
+        if (moved && (children[i] & 0x000000ffffffffff) <= (bdd & 0x000000ffffffffff)) return 0;
+        if (!test_compact_order(children[i], moved)) return 0;
+    }
+    return 1;
+}
+
+int test_compact()
+{
+    LACE_ME;
+    char hash_p[80], hash_r[80], hash[80];
+
+    // p is only protected (moves), r is referenced (keeps its index), with other variables
+    uint64_t saved_seed;
+    BDD p;
+    do {
+        saved_seed = seed;
+        p = make_random(0, 10);
+        sylvan_deref(p);
+    } while (sylvan_isconst(p));
+    sylvan_protect(&p);
+    BDD r = make_random(20, 30);
+    sylvan_getsha(p, hash_p);
+    sylvan_getsha(r, hash_r);
+    CALL(gctest_fill, 2, 5);
+    mtbdd_pin(p);
+
+    BDD r_before = r;
+    size_t gcs = sylvan_gc_count();
+    sylvan_compact();
+    test_assert(sylvan_gc_count() == gcs + 1);
+    test_assert(r == r_before);
+    sylvan_test_isbdd(p);
+    sylvan_test_isbdd(r);
+    sylvan_getsha(p, hash);
+    test_assert(strcmp(hash, hash_p) == 0);
+    sylvan_getsha(r, hash);
+    test_assert(strcmp(hash, hash_r) == 0);
+    test_assert(test_compact_order(p, 1));
+
+    // the nodes are still unique, also after garbage collection of the pinned nodes
+    seed = saved_seed;
+    BDD again = make_random(0, 10);
+    test_assert(again == p);
+    sylvan_deref(again);
+    sylvan_gc();
+    sylvan_test_isbdd(p);
+    mtbdd_unpin_all();
+    sylvan_gc();
+    sylvan_getsha(p, hash);
+    test_assert(strcmp(hash, hash_p) == 0);
+
+    sylvan_unprotect(&p);
+    sylvan_deref(r);
+    return 0;
+}
+
+int test_numa()
+{
+    LACE_ME;
+    char hash_before[80], hash[80];
+    BDD before = make_random(0, 10);
+    sylvan_getsha(before, hash_before);
+    CALL(gctest_fill, 2, 5);
+    sylvan_gc();
+    sylvan_getsha(before, hash);
+    test_assert(strcmp(hash, hash_before) == 0);
+
+    // with numa_owner, the workers write the hash array after garbage collection
+    int n = numa_domain_count();
+    size_t counts[n];
+    size_t size = llmsset_get_size(nodes) * 8;
+    size_t pages = (size + sysconf(_SC_PAGESIZE) - 1) / sysconf(_SC_PAGESIZE);
+    size_t sampled = numa_area_distribution(nodes->table, size, pages, counts, n);
+    if (sampled != 0) test_assert(sampled == pages);
+    size_t total = 0;
+    for (int i=0; i<n; i++) total += counts[i];
+    test_assert(total == sampled);
+    test_assert(llmsset_numa_distribution(nodes, counts, n) >= sampled);
+
+    sylvan_deref(before);
+    return 0;
+}
+
+int test_huge_pages()
+{
+    LACE_ME;
+    char hash_before[80], hash[80];
+    BDD before = make_random(0, 10);
+    sylvan_getsha(before, hash_before);
+    CALL(gctest_fill, 2, 5);
+    sylvan_gc();
+    sylvan_getsha(before, hash);
+    test_assert(strcmp(hash, hash_before) == 0);
+
+    // without a pool of huge pages, the arrays fall back to transparent huge pages
+    size_t resident, hugetlb;
+    size_t huge = pages_huge_bytes(&resident, &hugetlb);
+    test_assert(huge <= resident);
+    test_assert(resident >= llmsset_get_size(nodes) * 8 || resident == 0);
+
+    // clearing an array gives zeroed memory
+    size_t size = 4LL<<20;
+    char *area = (char*)pages_map(size, 0);
+    test_assert(area != NULL);
+    for (size_t i=0; i<size; i+=4096) area[i] = 1;
+    pages_clear(area, size, 0);
+    for (size_t i=0; i<size; i+=4096) test_assert(area[i] == 0);
+    pages_unmap(area, size);
+
+    sylvan_deref(before);
+    return 0;
+}
+
+int test_cache_regions()
+{
+    LACE_ME;
+
+    // the conjunctions are in region 1, the other operations in region 0
+    cache_set_op_region(CACHE_BDD_AND, 1);
+    test_assert(cache_get_region_count() == 2);
+
+    for (int k=0; k<10; k++) {
+        BDD a = make_random(0, 12);
+        BDD b = make_random(0, 12);
+        BDD c = sylvan_ref(sylvan_and(a, b));
+        test_assert(c == sylvan_and(a, b));
+        test_assert(c == sylvan_ite(a, b, sylvan_false));
+        test_assert(sylvan_xor(a, b) == sylvan_not(sylvan_equiv(a, b)));
+        sylvan_deref(a);
+        sylvan_deref(b);
+        sylvan_deref(c);
+    }
+
+    uint64_t gets, hits;
+    size_t buckets = cache_region_stats(1, &gets, &hits);
+    test_assert(buckets > 0 && buckets < cache_getsize());
+    test_assert(gets > 0 && hits > 0 && hits <= gets);
+    test_assert(buckets + cache_region_stats(0, &gets, &hits) == cache_getsize());
+    test_assert(gets > 0 && hits <= gets);
+
+    cache_set_op_region(CACHE_BDD_AND, 0);
+    return 0;
+}
+
 TASK_2(MDD, random_ldd, int, depth, int, count)
 {
     uint32_t n[depth];
@@ -333,6 +574,67 @@ int runtests(int threads)
     sylvan_quit();
     printf(LGREEN "success" NC "!\n");
 
+    printf(NC "Testing pinned nodes... ");
+    fflush(stdout);
+    sylvan_init_package(1LL<<14, 1LL<<14, 1LL<<20, 1LL<<20);
+    sylvan_init_bdd();
+    sylvan_gc_enable();
+    if (test_pin(threads)) return 1;
+    sylvan_quit();
+    printf(LGREEN "success" NC "!\n");
+
+    printf(NC "Testing scratch nodes... ");
+    fflush(stdout);
+    sylvan_init_package(1LL<<14, 1LL<<14, 1LL<<20, 1LL<<20);
+    sylvan_init_bdd();
+    sylvan_gc_enable();
+    if (test_scratch()) return 1;
+    sylvan_quit();
+    printf(LGREEN "success" NC "!\n");
+
+    printf(NC "Testing compaction... ");
+    fflush(stdout);
+    sylvan_init_package(1LL<<14, 1LL<<14, 1LL<<20, 1LL<<20);
+    sylvan_init_bdd();
+    sylvan_gc_enable();
+    if (test_compact()) return 1;
+    sylvan_quit();
+    printf(LGREEN "success" NC "!\n");
+
+    printf(NC "Testing NUMA placement... ");
+    fflush(stdout);
+    sylvan_set_numa_policy(numa_owner);
+    sylvan_init_package(1LL<<20, 1LL<<20, 1LL<<20, 1LL<<20);
+    sylvan_init_bdd();
+    sylvan_gc_enable();
+    if (test_numa()) return 1;
+    sylvan_quit();
+    sylvan_set_numa_policy(numa_default);
+    printf(LGREEN "success" NC "!\n");
+
+    printf(NC "Testing huge pages... ");
+    fflush(stdout);
+    sylvan_set_huge_pages(pages_hugetlb);
+    sylvan_init_package(1LL<<20, 1LL<<20, 1LL<<20, 1LL<<20);
+    sylvan_init_bdd();
+    sylvan_gc_enable();
+    if (test_huge_pages()) return 1;
+    sylvan_quit();
+    sylvan_set_huge_pages(pages_normal);
+    printf(LGREEN "success" NC "!\n");
+
+    printf(NC "Testing cache regions... ");
+    fflush(stdout);
+    const unsigned shares[2] = {0, 25};
+    cache_set_regions(2, shares);
+    sylvan_init_package(1LL<<20, 1LL<<20, 1LL<<16, 1LL<<16);
+    sylvan_init_bdd();
+    sylvan_gc_enable();
+    if (test_cache_regions()) return 1;
+    sylvan_quit();
+    cache_set_regions(1, shares);
+    printf(LGREEN "success" NC "!\n");
+
     lace_exit();
     return 0;
 }
@@ -11,6 +11,7 @@
 
 #include "llmsset.h"
 #include "sylvan.h"
+#include "sylvan_int.h"
 #include "test_assert.h"
 
 __thread uint64_t seed = 1;
@@ -453,6 +454,25 @@ test_ldd()
     return 0;
 }
 
+int
+test_cache()
+{
+    uint64_t opid = cache_next_opid();
+    uint64_t result;
+    test_assert(cache_put3(opid, 1, 2, 3, 4));
+    test_assert(cache_get3(opid, 1, 2, 3, &result) && result == 4);
+
+    // clearing the cache must not reuse operation identifiers
+    cache_clear();
+    test_assert(!cache_get3(opid, 1, 2, 3, &result));
+    test_assert(cache_next_opid() != opid);
+
+    cache_setsize(cache_getsize());
+    test_assert(cache_next_opid() != opid);
+
+    return 0;
+}
+
 int runtests()
 {
     // we are not testing garbage collection
@@ -465,6 +485,7 @@ int runtests()
     for (int j=0;j<10;j++) if (test_operators()) return 1;
 
     if (test_ldd()) return 1;
+    if (test_cache()) return 1;
 
     return 0;
 }
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2016 Tom van Dijk, Johannes Kepler University Linz
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Tests of the steady-state solvers and the symbolic analysis on the quotients of the CTMCs
+ * in the models directory
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include <cstddef> // to fix errors with gmp
+#include <string>
+
+#include <algorithm>
+#include <map>
+
+#include <gmp.h>
+#include <libsigref.hpp>
+#include <parse_prism.hpp>
+#include <parse_xml.hpp>
+#include <steady_state.hpp>
+#include <symbolic_analysis.hpp>
+
+#include "test_assert.h"
+
+using namespace sigref;
+
+static std::string models;
+static std::string test_models;
+
+/**
+ * Helper: read the CTMC <name> from the models directory and replace it by its quotient
+ */
+static CTMC
+read_quotient(Context &context, const char *name)
+{
+    SystemParser reader((models + "/" + name).c_str(), 0, mpq_type);
+    CTMC ctmc = *reader.getCTMC();
+    context.quotient(ctmc, context.partition(ctmc));
+    return ctmc;
+}
+
+/**
+ * On an irreducible CTMC, all methods converge to the same distribution
+ */
+static int
+test_irreducible(const char *name)
+{
+    Context context;
+    CTMC ctmc = read_quotient(context, name);
+
+    SteadyState power = solveSteadyState(ctmc, steady_power, 1e-10);
+    test_assert(power.converged);
+    test_assert(power.method == steady_power);
+
+    SteadyStateMethod methods[] = {steady_jacobi, steady_gauss_seidel};
+    for (SteadyStateMethod method : methods) {
+        SteadyState steady = solveSteadyState(ctmc, method, 1e-10);
+        test_assert(steady.converged);
+        test_assert(steady.method == method);
+        test_assert(steady.states == power.states);
+        double sum = 0;
+        for (size_t i=0; i<steady.states.size(); i++) {
+            test_assert(fabs(steady.probabilities[i] - power.probabilities[i]) < 1e-6);
+            sum += steady.probabilities[i];
+        }
+        test_assert(fabs(sum - 1.0) < 1e-9);
+    }
+    return 0;
+}
+
+/**
+ * On the cycle 0 -> 1 -> 2 -> 0 with rates 1, 2 and 3 (cycle3.tra), Jacobi without relaxation
+ * rotates the distribution forever; the stationary distribution is (6, 3, 2)/11
+ */
+static int
+test_periodic()
+{
+    Context context;
+    PrismCtmcParser parser((test_models + "/cycle3.tra").c_str(), mpq_type);
+    CTMC ctmc = *parser.getCTMC();
+    context.quotient(ctmc, context.partition(ctmc));
+
+    SteadyStateMethod methods[] = {steady_jacobi, steady_gauss_seidel, steady_power};
+    for (SteadyStateMethod method : methods) {
+        SteadyState steady = solveSteadyState(ctmc, method, 1e-12);
+        test_assert(steady.converged);
+        test_assert(steady.probabilities.size() == 3);
+        std::vector<double> p = steady.probabilities;
+        std::sort(p.begin(), p.end());
+        test_assert(fabs(p[0] - 2.0/11) < 1e-9);
+        test_assert(fabs(p[1] - 3.0/11) < 1e-9);
+        test_assert(fabs(p[2] - 6.0/11) < 1e-9);
+    }
+    return 0;
+}
+
+/**
+ * With absorbing states, every method uses power iteration, which converges although the
+ * probabilities of the transient states decay towards 0
+ */
+static int
+test_absorbing(const char *name)
+{
+    Context context;
+    CTMC ctmc = read_quotient(context, name);
+
+    SteadyState steady = solveSteadyState(ctmc, steady_jacobi);
+    test_assert(steady.converged);
+    test_assert(steady.method == steady_power);
+    return 0;
+}
+
+/**
+ * Helper: the value of a leaf of a distribution as a double
+ */
+static double
+leaf_to_double(MTBDD leaf)
+{
+    uint32_t type = mtbdd_gettype(leaf);
+    if (type == 1) return mtbdd_getdouble(leaf);
+    if (type == 2) return (double)mtbdd_getnumer(leaf) / (double)mtbdd_getdenom(leaf);
+    return mpq_get_d((mpq_ptr)mtbdd_getvalue(leaf));
+}
+
+/**
+ * The symbolic steady-state analysis gives the same distribution as the explicit solver,
+ * and "init" is the set of initial states that was used (all states if there are none)
+ */
+static int
+test_analysis(const std::string &filename, bool has_initial)
+{
+    Context context;
+    SystemParser reader(filename.c_str(), 0, mpq_type);
+    CTMC ctmc = *reader.getCTMC();
+    context.quotient(ctmc, context.partition(ctmc));
+    test_assert((ctmc.getInitialStates() != sylvan::Bdd::bddZero()) == has_initial);
+
+    SteadyState steady = solveSteadyState(ctmc, steady_power, 1e-10);
+    test_assert(steady.converged);
+    AnalysisResult analysis = analyzeSymbolic(ctmc, analysis_steady, 0, 1e-10);
+    test_assert(analysis.converged);
+
+    /* Decode the states of the distribution, as the explicit solver does */
+    BDD s_vars = ctmc.getVarS().GetBDD();
+    int state_length = sylvan_set_count(s_vars);
+    std::map<uint64_t, double> distribution;
+    uint8_t arr[state_length];
+    MTBDD dd = analysis.distribution.GetMTBDD();
+    MTBDD leaf = mtbdd_enum_all_first(dd, s_vars, arr, NULL);
+    while (leaf != mtbdd_false) {
+        uint64_t state = 0;
+        for (int j=0; j<state_length; j++) if (arr[j] == 1) state |= 1ULL<<j;
+        distribution[state] = leaf_to_double(leaf);
+        leaf = mtbdd_enum_all_next(dd, s_vars, arr, NULL);
+    }
+    for (size_t i=0; i<steady.states.size(); i++) {
+        test_assert(fabs(distribution[steady.states[i]] - steady.probabilities[i]) < 1e-6);
+    }
+
+    test_assert(analysis.labels.size() > 0 && analysis.labels[0] == "init");
+    if (!has_initial) test_assert(fabs(analysis.probabilities[0] - 1.0) < 1e-9);
+    return 0;
+}
+
+static int
+runtests()
+{
+    printf("Testing the steady state of cycle3.tra...\n");
+    if (test_periodic()) return 1;
+
+    const char *irreducible[] = {"polling-02.xctmc", "polling-03.xctmc", "polling-04.xctmc"};
+    for (const char *name : irreducible) {
+        printf("Testing the steady state of %s...\n", name);
+        if (test_irreducible(name)) return 1;
+    }
+
+    printf("Testing the steady state of cycling-2.xctmc...\n");
+    if (test_absorbing("cycling-2.xctmc")) return 1;
+
+    printf("Testing the symbolic analysis of polling-02.xctmc...\n");
+    if (test_analysis(models + "/polling-02.xctmc", true)) return 1;
+
+    printf("Testing the symbolic analysis of polling-02-noinit.xctmc...\n");
+    if (test_analysis(test_models + "/polling-02-noinit.xctmc", false)) return 1;
+
+    return 0;
+}
+
+static int result = 1;
+
+VOID_TASK_1(main_lace, void*, arg)
+{
+    initialize(20, 22, 18, 20);
+    result = runtests();
+    sylvan_quit();
+    (void)arg;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <models directory> <test models directory>\n", argv[0]);
+        return 1;
+    }
+    models = argv[1];
+    test_models = argv[2];
+
+    lace_init(1, 1024*1024*16);
+    lace_startup(0, TASK(main_lace), NULL);
+    return result;
+}